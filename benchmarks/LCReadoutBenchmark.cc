@@ -0,0 +1,279 @@
+// LCReadoutBenchmark.cc - Micro-benchmarks for the readout and event-action hot paths
+//
+// Drives LCReadoutModel and LCEventAction with synthetic deposit streams
+// (MIP-like, stopping alpha, shower-like) without a Geant4 run and reports
+// ns/deposit and samples/s in JSON, one record per (function, profile).
+//
+// Usage: LCReadoutBenchmark [--events N] [--output file.json]
+#include "LCReadoutModel.hh"
+#include "LCEventAction.hh"
+#include "LCSteppingAction.hh"
+#include "LCHistograms.hh"
+#include "LCDetectorConstruction.hh"
+#include "G4Event.hh"
+#include "G4AnalysisManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+  // One energy deposit as seen by the readout: energy and position across the cell
+  struct Deposit {
+    G4double edep;
+    G4double y;
+  };
+  
+  struct Profile {
+    std::string name;
+    std::vector<std::vector<Deposit>> events;
+    size_t nDeposits;
+  };
+  
+  struct Result {
+    std::string function;
+    std::string profile;
+    size_t deposits;
+    size_t samples;
+    double seconds;
+  };
+  
+  // Minimum ionizing particle: ~20 small deposits spread across the cell
+  Profile MakeMipProfile(G4int nEvents, G4double thickness, std::mt19937_64& rng) {
+    std::exponential_distribution<double> energy(1.0);
+    std::uniform_real_distribution<double> depth(-thickness/2, thickness/2);
+    Profile profile{"mip", {}, 0};
+    for (G4int i = 0; i < nEvents; i++) {
+      std::vector<Deposit> event;
+      for (G4int j = 0; j < 20; j++) {
+        event.push_back({(0.3 + energy(rng))*keV, depth(rng)});
+      }
+      profile.nDeposits += event.size();
+      profile.events.push_back(event);
+    }
+    return profile;
+  }
+  
+  // Stopping 5.5 MeV alpha: 60 steps from the front face, rising towards a Bragg peak
+  Profile MakeAlphaProfile(G4int nEvents, G4double thickness, std::mt19937_64& rng) {
+    const G4int nSteps = 60;
+    const G4double range = 30.0*um;
+    std::normal_distribution<double> straggling(1.0, 0.05);
+    Profile profile{"alpha", {}, 0};
+    for (G4int i = 0; i < nEvents; i++) {
+      std::vector<Deposit> event;
+      G4double weightSum = 0.;
+      for (G4int j = 0; j < nSteps; j++) {
+        G4double w = 1.0 / std::sqrt(1.0 - (j + 0.5) / (nSteps + 1));
+        event.push_back({w * straggling(rng), -thickness/2 + (j + 0.5) * range / nSteps});
+        weightSum += event.back().edep;
+      }
+      for (auto& deposit : event) deposit.edep *= 5.5*MeV / weightSum;
+      profile.nDeposits += event.size();
+      profile.events.push_back(event);
+    }
+    return profile;
+  }
+  
+  // Electromagnetic shower: hundreds of soft deposits over the whole cell
+  Profile MakeShowerProfile(G4int nEvents, G4double thickness, std::mt19937_64& rng) {
+    std::exponential_distribution<double> energy(1.0 / 3.0);
+    std::uniform_real_distribution<double> depth(-thickness/2, thickness/2);
+    Profile profile{"shower", {}, 0};
+    for (G4int i = 0; i < nEvents; i++) {
+      std::vector<Deposit> event;
+      for (G4int j = 0; j < 400; j++) {
+        event.push_back({energy(rng)*keV, depth(rng)});
+      }
+      profile.nDeposits += event.size();
+      profile.events.push_back(event);
+    }
+    return profile;
+  }
+  
+  double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  
+  void WriteJson(std::ostream& out, const std::vector<Result>& results, G4int nEvents) {
+    std::time_t now = std::time(nullptr);
+    char timestamp[32];
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    
+    out << "{\n";
+    out << "  \"benchmark\": \"LCReadoutBenchmark\",\n";
+    out << "  \"timestamp\": \"" << timestamp << "\",\n";
+    out << "  \"events_per_profile\": " << nEvents << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+      const Result& r = results[i];
+      double nsPerDeposit = r.deposits > 0 ? r.seconds * 1e9 / r.deposits : 0.;
+      double samplesPerSecond = r.seconds > 0 ? r.samples / r.seconds : 0.;
+      out << "    {\"function\": \"" << r.function << "\", \"profile\": \"" << r.profile << "\", "
+          << "\"deposits\": " << r.deposits << ", \"samples\": " << r.samples << ", "
+          << "\"seconds\": " << r.seconds << ", \"ns_per_deposit\": " << nsPerDeposit << ", "
+          << "\"samples_per_s\": " << samplesPerSecond << "}"
+          << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+  }
+}
+
+int main(int argc, char** argv)
+{
+  G4int nEvents = 200;
+  std::string outputFile;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--events" && i+1 < argc) nEvents = std::stoi(argv[++i]);
+    else if (arg == "--output" && i+1 < argc) outputFile = argv[++i];
+    else if (arg == "--help") {
+      std::cout << "Usage: " << argv[0] << " [--events N] [--output file.json]" << std::endl;
+      return 0;
+    }
+  }
+  
+  // Fixed seeds so every run sees the same streams and fluctuations
+  G4Random::setTheSeed(12345);
+  std::mt19937_64 rng(12345);
+  
+  // The stepping action books the same histograms and ntuple as a real run,
+  // which EndOfEventAction fills
+  LCDetectorConstruction detConstruction;
+  LCEventAction eventAction;
+  LCSteppingAction steppingAction(&detConstruction, &eventAction);
+  LCReadoutModel* model = steppingAction.GetReadoutModel();
+  auto analysisManager = G4AnalysisManager::Instance();
+  analysisManager->SetVerboseLevel(0);
+  analysisManager->OpenFile("LCReadoutBenchmark.root");
+  
+  G4double thickness = detConstruction.GetLCThickness();
+  std::vector<Profile> profiles;
+  profiles.push_back(MakeMipProfile(nEvents, thickness, rng));
+  profiles.push_back(MakeAlphaProfile(nEvents, thickness, rng));
+  profiles.push_back(MakeShowerProfile(nEvents, thickness, rng));
+  
+  // Event ID 1 keeps the periodic event printout quiet
+  G4Event event(1);
+  G4double field = model->GetElectricField();
+  std::vector<Result> results;
+  volatile G4double sink = 0.;
+  
+  for (const auto& profile : profiles) {
+    // Transit times and charges used as inputs to the individual stages
+    std::vector<G4double> transitTimes, charges;
+    std::vector<G4int> nCharges;
+    for (const auto& ev : profile.events) {
+      for (const auto& deposit : ev) {
+        G4int n = G4int(deposit.edep / model->GetEnergyPerIonization() * model->GetCollectionEfficiency());
+        nCharges.push_back(n);
+        charges.push_back(model->CalculateCharge(n));
+        transitTimes.push_back((thickness/2 - deposit.y) / (model->GetMobilityElectron() * field));
+      }
+    }
+    
+    // CalculateIonizationEvents
+    auto start = std::chrono::steady_clock::now();
+    G4long pairs = 0;
+    for (const auto& ev : profile.events) {
+      for (const auto& deposit : ev) pairs += model->CalculateIonizationEvents(deposit.edep);
+    }
+    results.push_back({"CalculateIonizationEvents", profile.name, profile.nDeposits, 0, Seconds(start)});
+    sink = sink + pairs;
+    
+    // CalculateCurrentPulse
+    start = std::chrono::steady_clock::now();
+    G4double current = 0.;
+    for (size_t i = 0; i < nCharges.size(); i++) {
+      current += model->CalculateCurrentPulse(nCharges[i], transitTimes[i]);
+    }
+    results.push_back({"CalculateCurrentPulse", profile.name, profile.nDeposits, 0, Seconds(start)});
+    sink = sink + current;
+    
+    // SimulateElectrometerResponse, including the AddCurrentPulse/AddTimeProfile calls it makes
+    size_t samples = 0;
+    size_t index = 0;
+    start = std::chrono::steady_clock::now();
+    for (const auto& ev : profile.events) {
+      eventAction.BeginOfEventAction(&event);
+      for (size_t j = 0; j < ev.size(); j++, index++) {
+        model->SimulateElectrometerResponse(charges[index], transitTimes[index], 0., &eventAction);
+      }
+      samples += eventAction.GetCurrentSampleCount();
+    }
+    results.push_back({"SimulateElectrometerResponse", profile.name, profile.nDeposits, samples, Seconds(start)});
+    
+    // LCEventAction::AddCurrentPulse on its own: 50 samples per deposit
+    samples = 0;
+    start = std::chrono::steady_clock::now();
+    for (const auto& ev : profile.events) {
+      eventAction.BeginOfEventAction(&event);
+      for (size_t j = 0; j < ev.size(); j++) {
+        for (G4int k = 0; k < 50; k++) {
+          eventAction.AddCurrentPulse((j * 50 + k) * 1.0*ns, 1.0e-12*ampere);
+        }
+      }
+      samples += eventAction.GetCurrentSampleCount();
+    }
+    results.push_back({"AddCurrentPulse", profile.name, profile.nDeposits, samples, Seconds(start)});
+    
+    // Full deposit readout chain as called from the stepping action
+    samples = 0;
+    start = std::chrono::steady_clock::now();
+    for (const auto& ev : profile.events) {
+      eventAction.BeginOfEventAction(&event);
+      for (const auto& deposit : ev) model->ProcessDeposit(deposit.edep, deposit.y, 0., &eventAction);
+      samples += eventAction.GetCurrentSampleCount();
+    }
+    results.push_back({"ProcessDeposit", profile.name, profile.nDeposits, samples, Seconds(start)});
+    
+    // The same with the tabulated transport model (tables built before timing,
+    // 1 um steps for the ionisation density)
+    model->SetTransportModel("tabulated");
+    eventAction.BeginOfEventAction(&event);
+    model->ProcessDeposit(1.0*keV, 0., 0., &eventAction, 1.0*um);
+    samples = 0;
+    start = std::chrono::steady_clock::now();
+    for (const auto& ev : profile.events) {
+      eventAction.BeginOfEventAction(&event);
+      for (const auto& deposit : ev) model->ProcessDeposit(deposit.edep, deposit.y, 0., &eventAction, 1.0*um);
+      samples += eventAction.GetCurrentSampleCount();
+    }
+    results.push_back({"ProcessDepositTabulated", profile.name, profile.nDeposits, samples, Seconds(start)});
+    model->SetTransportModel("constant");
+    
+    // EndOfEventAction sort and histogram/ntuple fill - only this part is timed
+    samples = 0;
+    double endOfEventSeconds = 0.;
+    for (const auto& ev : profile.events) {
+      eventAction.BeginOfEventAction(&event);
+      for (const auto& deposit : ev) model->ProcessDeposit(deposit.edep, deposit.y, 0., &eventAction);
+      samples += eventAction.GetCurrentSampleCount();
+      start = std::chrono::steady_clock::now();
+      eventAction.EndOfEventAction(&event);
+      endOfEventSeconds += Seconds(start);
+    }
+    results.push_back({"EndOfEventAction", profile.name, profile.nDeposits, samples, endOfEventSeconds});
+  }
+  
+  LCHistograms::Instance()->Export();
+  analysisManager->Write();
+  analysisManager->CloseFile();
+  
+  if (outputFile.empty()) {
+    WriteJson(std::cout, results, nEvents);
+  } else {
+    std::ofstream out(outputFile);
+    WriteJson(out, results, nEvents);
+    std::cout << "Benchmark results written to " << outputFile << std::endl;
+  }
+  return 0;
+}
@@ -6,13 +6,14 @@
 #include "globals.hh"
 
 class LCDetectorConstruction;
+class LCMessenger;
 
 class LCActionInitialization : public G4VUserActionInitialization
 {
   public:
     LCActionInitialization(const LCDetectorConstruction* detConstruction);
     virtual ~LCActionInitialization();
-
+    
     virtual void BuildForMaster() const;
     virtual void Build() const;
     
@@ -22,11 +23,14 @@ class LCActionInitialization : public G4VUserActionInitialization
     
     G4String GetBeamParticle() const { return fParticleName; }
     G4double GetBeamEnergy() const { return fParticleEnergy; }
-    
+  
   private:
     const LCDetectorConstruction* fDetConstruction;
     G4String fParticleName;
     G4double fParticleEnergy;
+    // Messenger of the master (sequential mode: the only thread), created
+    // with its run action and deleted with this object
+    mutable LCMessenger* fMessenger;
 };
 
 #endif
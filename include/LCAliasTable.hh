@@ -0,0 +1,30 @@
+// LCAliasTable.hh - Walker alias table for O(1) sampling of discrete distributions
+#ifndef LCAliasTable_h
+#define LCAliasTable_h 1
+
+#include "globals.hh"
+#include <vector>
+
+// Built once from non-negative weights, then sampled with a single random
+// number per draw. Sampling is const and uses the thread's random engine, so
+// one table can be shared by all worker threads.
+class LCAliasTable {
+  public:
+    LCAliasTable();
+    ~LCAliasTable();
+    
+    // Returns false if there is no positive weight
+    G4bool Build(const std::vector<G4double>& weights);
+    
+    // Index drawn with probability weight[i] / sum(weights)
+    G4int Sample() const;
+    
+    G4int GetSize() const { return static_cast<G4int>(fProbability.size()); }
+    G4bool IsEmpty() const { return fProbability.empty(); }
+    
+  private:
+    std::vector<G4double> fProbability;  // Probability of keeping bin i
+    std::vector<G4int> fAlias;           // Bin taken otherwise
+};
+
+#endif
@@ -0,0 +1,21 @@
+// LCAllocationCounter.hh - Heap allocation counter for debug builds
+#ifndef LCAllocationCounter_h
+#define LCAllocationCounter_h 1
+
+#include <cstddef>
+
+// With LC_COUNT_ALLOCATIONS (on by default in debug builds) the global
+// operator new is replaced by one that counts calls per thread. Code can then
+// check that a section does not allocate:
+//
+//   std::size_t before = LCAllocationCounter::GetCount();
+//   ...
+//   std::size_t allocations = LCAllocationCounter::GetCount() - before;
+#ifdef LC_COUNT_ALLOCATIONS
+namespace LCAllocationCounter {
+  // Heap allocations made by the calling thread so far
+  std::size_t GetCount();
+}
+#endif
+
+#endif
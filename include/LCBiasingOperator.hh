@@ -0,0 +1,50 @@
+// LCBiasingOperator.hh - Cross-section biasing of neutral particles in the LC cell and electrodes
+#ifndef LCBiasingOperator_h
+#define LCBiasingOperator_h 1
+
+#include "G4VBiasingOperator.hh"
+#include "globals.hh"
+#include <map>
+
+class G4BOptnChangeCrossSection;
+class G4ParticleDefinition;
+
+// Scales the interaction cross sections of gammas and neutrons by the
+// factors set with /LC/bias/..., in the volumes it is attached to. The
+// transport keeps the result unbiased through the track weights.
+// One instance per thread, created in ConstructSDandField().
+class LCBiasingOperator : public G4VBiasingOperator {
+  public:
+    LCBiasingOperator();
+    virtual ~LCBiasingOperator();
+    
+    virtual void StartRun();
+    virtual void StartTracking(const G4Track* track);
+    
+  private:
+    virtual G4VBiasingOperation* ProposeOccurenceBiasingOperation(const G4Track* track,
+                                                                  const G4BiasingProcessInterface* callingProcess);
+    virtual G4VBiasingOperation* ProposeFinalStateBiasingOperation(const G4Track*,
+                                                                   const G4BiasingProcessInterface*) { return nullptr; }
+    virtual G4VBiasingOperation* ProposeNonPhysicsBiasingOperation(const G4Track*,
+                                                                   const G4BiasingProcessInterface*) { return nullptr; }
+    
+    using G4VBiasingOperator::OperationApplied;
+    virtual void OperationApplied(const G4BiasingProcessInterface* callingProcess,
+                                  G4BiasingAppliedCase biasingCase,
+                                  G4VBiasingOperation* occurenceOperationApplied,
+                                  G4double weightForOccurenceInteraction,
+                                  G4VBiasingOperation* finalStateOperationApplied,
+                                  const G4VParticleChange* particleChangeProduced);
+    
+    void SetupOperations(const G4ParticleDefinition* particle);
+    
+    // One cross-section change per wrapped physics process
+    std::map<const G4BiasingProcessInterface*, G4BOptnChangeCrossSection*> fChangeCrossSectionOperations;
+    G4bool fSetup;
+    
+    // Factor for the track being transported (1 = analog)
+    G4double fCurrentFactor;
+};
+
+#endif
@@ -0,0 +1,75 @@
+// LCCampaignStore.hh - Append-only store of finished runs with an index for campaign queries
+#ifndef LCCampaignStore_h
+#define LCCampaignStore_h 1
+
+// Plain C++ (no Geant4 types), so the LCCampaignQuery tool builds without Geant4
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One finished run: ordered key=value fields. The indexed keys are
+// particle, energy_MeV, bias_V, physics and seed.
+class LCCampaignRecord {
+  public:
+    void Set(const std::string& key, const std::string& value);
+    void Set(const std::string& key, double value);
+    void Set(const std::string& key, long value);
+    
+    // Empty / NaN if the field is missing
+    std::string Get(const std::string& key) const;
+    double GetDouble(const std::string& key) const;
+    
+    const std::vector<std::pair<std::string, std::string>>& GetFields() const { return fFields; }
+    
+    // One log line, without the newline: key=value fields separated by tabs
+    std::string ToLine() const;
+    static bool FromLine(const std::string& line, LCCampaignRecord& record);
+    
+  private:
+    std::vector<std::pair<std::string, std::string>> fFields;
+};
+
+// Selection on the indexed fields; unset members match every run
+struct LCCampaignQuery {
+  std::string particle;
+  std::string physics;
+  bool hasEnergy = false;
+  double energyMinMeV = 0., energyMaxMeV = 0.;
+  bool hasBias = false;
+  double biasMinV = 0., biasMaxV = 0.;
+  bool hasSeed = false;
+  long seed = 0;
+};
+
+// A directory holding runs.log, one text line per run appended in finishing
+// order, and runs.idx, a fixed-size binary entry per line (offset, length,
+// hashes of particle and physics, energy, bias, seed). The log is the
+// record of truth: a query filters the index in memory and reads only the
+// matching lines, then scans whatever part of the log the index does not
+// cover yet, and the index is rebuilt from the log whenever it is found
+// out of step. Writers from parallel jobs serialise on an exclusive flock
+// of the log; readers take a shared one, so they never see half a record.
+class LCCampaignStore {
+  public:
+    explicit LCCampaignStore(const std::string& directory);
+    
+    // False (with a message) if the record could not be stored
+    bool Append(const LCCampaignRecord& record, std::string* error = nullptr) const;
+    
+    // Matching runs in the order they were stored
+    std::vector<LCCampaignRecord> Query(const LCCampaignQuery& query) const;
+    
+    // Rewrites the index from the log, returns the number of runs
+    std::size_t RebuildIndex() const;
+    
+    const std::string& GetDirectory() const { return fDirectory; }
+    std::string GetLogPath() const;
+    std::string GetIndexPath() const;
+    
+  private:
+    std::string fDirectory;
+};
+
+#endif
@@ -0,0 +1,72 @@
+// LCCocktailGenerator.hh - Weighted mixture of radiation sources with tabulated spectra
+#ifndef LCCocktailGenerator_h
+#define LCCocktailGenerator_h 1
+
+#include "LCAliasTable.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+#include <vector>
+
+class G4ParticleDefinition;
+
+// One source of the cocktail. Energy and angular distributions are lists of
+// components - lines (low == high) or flat bins - sampled with alias tables.
+struct LCCocktailSource {
+  struct Component {
+    G4double low;
+    G4double high;
+  };
+  
+  G4String name;
+  G4ParticleDefinition* particle;
+  G4double rate;                          // Relative rate within the cocktail
+  
+  std::vector<Component> energyComponents;
+  std::vector<G4double> energyWeights;
+  LCAliasTable energyTable;
+  
+  // Polar angle to the beam axis as cos(theta) bins; empty = along the beam
+  std::vector<Component> cosThetaComponents;
+  std::vector<G4double> cosThetaWeights;
+  LCAliasTable angularTable;
+};
+
+// Built from /LC/cocktail/... commands on the master and only read during a
+// run, so the worker generators share one instance
+class LCCocktailGenerator {
+  public:
+    LCCocktailGenerator();
+    ~LCCocktailGenerator();
+    
+    // Configuration - spectrum and angle commands apply to the last source added
+    G4bool AddSource(const G4String& name, const G4String& particleName, G4double rate);
+    G4bool AddLine(G4double energy, G4double intensity);
+    G4bool AddBin(G4double low, G4double high, G4double weight);
+    G4bool AddBetaSpectrum(G4double endpoint);
+    G4bool SetAngularDistribution(const G4String& shape);
+    G4bool AddAngularBin(G4double cosLow, G4double cosHigh, G4double weight);
+    void Clear();
+    
+    // Every source has a particle and an energy spectrum
+    G4bool IsReady() const;
+    G4int GetNumberOfSources() const { return static_cast<G4int>(fSources.size()); }
+    const LCCocktailSource& GetSource(G4int id) const { return fSources[id]; }
+    
+    // Sampling
+    G4int SampleSource() const;
+    G4double SampleEnergy(G4int id) const;
+    G4ThreeVector SampleDirection(G4int id, const G4ThreeVector& beamAxis) const;
+    
+    // One line per source and component, in a fixed order
+    G4String GetDescription() const;
+    void Print() const;
+    
+  private:
+    LCCocktailSource* CurrentSource();
+    void RebuildSourceTable();
+    
+    std::vector<LCCocktailSource> fSources;
+    LCAliasTable fSourceTable;
+};
+
+#endif
@@ -0,0 +1,74 @@
+// LCCondensation.hh - Local deposition of low-energy delta electrons in the LC cell
+#ifndef LCCondensation_h
+#define LCCondensation_h 1
+
+#include "globals.hh"
+#include <unordered_set>
+
+class G4Track;
+
+// Totals of one run, summed over threads
+struct LCCondensationTotals {
+  G4long condensed = 0;        // secondaries deposited in place
+  G4double condensedEnergy = 0.;
+  G4long sampled = 0;          // qualifying secondaries tracked normally as a reference
+  G4long sampledSteps = 0;     // steps of those tracks
+  G4long cellSteps = 0;        // steps taken in the LC cell
+};
+
+// One instance per thread. A delta electron created in the LC cell below
+// the threshold (/LC/physics/condenseEnergy, or the energy whose range is
+// /LC/physics/condenseRange in the LC material) is not tracked: its kinetic
+// energy goes to the charge model as one deposit at its creation point,
+// spread over its range for the pair density (GetEffectiveLength).
+// One in kSampleEvery of these electrons is tracked normally, and the steps
+// it takes give the estimate of the steps saved for the report.
+class LCCondensation {
+  public:
+    static LCCondensation* Instance();
+    
+    // Any thread: threshold for this run from LCGlobalManager (master: resets the totals)
+    void BeginRun(G4bool isMaster);
+    void BeginEvent() { fSampledTracks.clear(); }
+    // Publishes this thread's counts
+    void EndRun();
+    
+    G4bool IsActive() const { return fThreshold > 0.; }
+    G4double GetThreshold() const { return fThreshold; }
+    
+    // Stacking action: true if the new track is to be deposited in place
+    G4bool Condense(const G4Track* track);
+    
+    // Track length a condensed electron of this energy is given in the charge
+    // model: its range in the LC material (0 if no range table, which the
+    // model treats as a deposit without columnar recombination)
+    G4double GetEffectiveLength(G4double energy) const;
+    
+    // Stepping action, every step while active
+    void CountStep(const G4Track* track, G4bool inCell);
+    
+    // Master, end of run
+    static LCCondensationTotals GetRunTotals();
+    
+    static const G4int kSampleEvery = 64;
+  
+  private:
+    LCCondensation();
+    
+    static G4ThreadLocal LCCondensation* fInstance;
+    
+    // Electron range in the LC material at log-spaced energies up to the
+    // threshold, made at the start of the run
+    static const G4int kRangePoints = 16;
+    G4bool fHasRanges;
+    G4double fLogEnergyMin;
+    G4double fLogEnergyStep;
+    G4double fLogRanges[kRangePoints];
+    
+    G4double fThreshold;
+    G4long fCandidates;
+    LCCondensationTotals fTotals;
+    std::unordered_set<G4int> fSampledTracks;   // this event
+};
+
+#endif
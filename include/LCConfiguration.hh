@@ -0,0 +1,102 @@
+// LCConfiguration.hh - Immutable, versioned snapshots of the settings the worker threads run with
+#ifndef LCConfiguration_h
+#define LCConfiguration_h 1
+
+#include "globals.hh"
+#include "LCAliasTable.hh"
+#include "LCGlobalManager.hh"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+class LCCocktailGenerator;
+class LCDetectorConstruction;
+
+// Everything the worker threads read from LCGlobalManager and the shared
+// detector construction during a run, copied once. A snapshot is never
+// modified after it is published; a change of settings publishes a new one
+// under the next epoch.
+struct LCConfigSnapshot {
+  unsigned long epoch = 0;
+  
+  // Beam
+  G4String particleName;
+  G4double particleEnergy = 0.;
+  G4bool glassFilter = false;
+  G4String glassFilterModel;
+  G4String glassFilterTableDir;
+  G4double bunchPrimaries = 1.;
+  G4bool bunchPoisson = false;
+  G4int bunchCount = 1;
+  G4double bunchSpacing = 0.;
+  G4double bunchLength = 0.;
+  G4double timelineRate = 0.;
+  G4double timelineBinWidth = 0.;
+  G4double timelineWindow = 0.;
+  // The cocktail is edited in place between runs; its description is part
+  // of the snapshot, so an edit still moves the epoch on
+  G4bool cocktailEnabled = false;
+  const LCCocktailGenerator* cocktail = nullptr;
+  G4String angularMode;
+  G4double angularThetaMin = 0.;
+  G4double angularThetaMax = 0.;
+  std::vector<LCIncidenceAngle> angularPoints;
+  LCAliasTable angularPointTable;
+  
+  // Detector and readout
+  G4double bias = 0.;
+  G4double electricField = 0.;
+  G4double cellWidth = 0.;
+  G4double cellLength = 0.;
+  G4double cellThickness = 0.;
+  G4double electrodeThickness = 0.;
+  G4double cellMaxStep = 0.;
+  G4String fidelity;
+  G4String transportModel;
+  
+  // Physics and per-thread buffers
+  G4bool biasingEnabled = false;
+  G4double gammaBiasFactor = 1.;
+  G4double neutronBiasFactor = 1.;
+  G4double condenseEnergy = 0.;
+  G4double condenseRange = 0.;
+  G4bool stepRecording = false;
+  G4bool waveformRecording = false;
+  G4double waveformTimeStep = 0.;
+  G4double waveformCurrentStep = 0.;
+  std::size_t memoryBudget = 0;
+  
+  // "name=value" lines of all of the above (without the epoch)
+  G4String description;
+  
+  G4bool IsAngularModeEnabled() const { return angularMode != "off"; }
+};
+
+// The master publishes a snapshot at the start of every run (before the
+// workers start theirs); any thread reads the current one with a single
+// atomic load. Replaced snapshots are kept until the end of the process, so
+// a pointer obtained by a reader stays valid without reference counting.
+class LCConfiguration {
+  public:
+    // Master only: snapshot of the current settings. Unchanged settings keep
+    // the current snapshot and epoch.
+    static const LCConfigSnapshot* Publish(const LCDetectorConstruction* detConstruction);
+    
+    // Any thread, lock-free; nullptr before the first Publish(), which is
+    // the case in the offline tools (LCReplay, the benchmarks)
+    static const LCConfigSnapshot* Current() { return fCurrent.load(std::memory_order_acquire); }
+    
+    // Run-time code (run, event, tracking and stepping actions and what they
+    // call): the snapshot of the current run, never nullptr. The master
+    // publishes before any of these run, so a missing snapshot is a fatal
+    // error rather than a case to handle.
+    static const LCConfigSnapshot* ForRun();
+    static unsigned long CurrentEpoch();
+  
+  private:
+    static std::atomic<const LCConfigSnapshot*> fCurrent;
+    static std::vector<std::unique_ptr<const LCConfigSnapshot>> fSnapshots;  // master only
+};
+
+#endif
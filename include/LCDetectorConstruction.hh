@@ -16,6 +16,7 @@
 #include "G4ClassicalRK4.hh"
 #include "G4MagIntegratorDriver.hh"
 #include "G4ChordFinder.hh"
+#include "G4UserLimits.hh"
 
 class LCDetectorConstruction : public G4VUserDetectorConstruction {
   public:
@@ -23,19 +24,41 @@ class LCDetectorConstruction : public G4VUserDetectorConstruction {
     ~LCDetectorConstruction();
     
     virtual G4VPhysicalVolume* Construct();
+    virtual void ConstructSDandField();
     
     // Getters for detector parameters
     G4double GetLCThickness() const { return lcSizeZ; }
     G4double GetElectricField() const { return electricFieldStrength; }
     G4double GetLCWidth() const { return lcSizeX; }
     G4double GetLCLength() const { return lcSizeY; }
+    G4double GetBias() const { return biasVoltage; }
+    G4double GetElectrodeThickness() const { return electrodeThickness; }
+    const G4Material* GetLCMaterial() const { return liquidCrystalMaterial; }
+    const G4String& GetGeometryFidelity() const { return fFidelity; }
     
     // Method to set the bias voltage (affects electric field)
     void SetBias(G4double biasVoltage);
     
+    // Cell dimensions and electrode thickness. After initialization the
+    // geometry is rebuilt before the next run (physics tables and worker
+    // threads are kept) and the field follows from the bias. Returns false,
+    // leaving the geometry unchanged, if the setup would not fit.
+    G4bool SetCellDimensions(G4double width, G4double length, G4double thickness);
+    G4bool SetElectrodeThickness(G4double thickness);
+    
+    // Geometry fidelity level (minimal/standard/full); like a resize, a
+    // change after initialization rebuilds the geometry before the next run
+    void SetGeometryFidelity(const G4String& fidelity);
+    
+    // User step limit in the LC cell (0 = none); needs G4StepLimiterPhysics
+    void SetCellMaxStep(G4double maxStep);
+    
   private:
     void DefineMaterials();
     void SetupElectricField();
+    G4bool CheckDimensions(G4double width, G4double length, G4double thickness,
+                           G4double electrode) const;
+    void RequestGeometryRebuild();
     
     // Materials
     G4Material* worldMaterial;
@@ -46,6 +69,7 @@ class LCDetectorConstruction : public G4VUserDetectorConstruction {
     G4Material* wireConnectionMaterial;
     G4Material* electrodeConnectorMaterial;
     G4Material* electrometerCaseMaterial;
+    G4Material* vacuumMaterial;           // World fill for the minimal fidelity
     
     // Volumes
     G4Box* worldSolid;
@@ -55,6 +79,7 @@ class LCDetectorConstruction : public G4VUserDetectorConstruction {
     G4Box* lcCellSolid;
     G4LogicalVolume* lcCellLogical;
     G4VPhysicalVolume* lcCellPhysical;
+    G4UserLimits* lcCellLimits;
     
     G4Box* electrodeTopSolid;
     G4LogicalVolume* electrodeTopLogical;
@@ -63,6 +88,7 @@ class LCDetectorConstruction : public G4VUserDetectorConstruction {
     G4Box* electrodeBottomSolid;
     G4LogicalVolume* electrodeBottomLogical;
     G4VPhysicalVolume* electrodeBottomPhysical;
+    G4UserLimits* electrodeLimits;
     
     // Wire connections to electrometer
     G4Tubs* topWireSolid;
@@ -91,8 +117,12 @@ class LCDetectorConstruction : public G4VUserDetectorConstruction {
     G4double lcSizeX;    // LC width (15 mm)
     G4double lcSizeY;    // LC length (25 mm)
     G4double lcSizeZ;    // LC thickness (100 μm)
+    G4double electrodeThickness;  // Glass electrode thickness (1 mm)
     G4double electricFieldStrength;  // Electric field strength (3 V/μm)
     G4double biasVoltage; // Current bias voltage
+    
+    // Geometry fidelity level of the current or pending geometry (minimal/standard/full)
+    G4String fFidelity;
 };
 
 #endif
@@ -4,11 +4,15 @@
 
 #include "G4UserEventAction.hh"
 #include "globals.hh"
+#include <memory_resource>
 #include <vector>
 
+class LCRunAction;
+class LCReadoutModel;
+
 class LCEventAction : public G4UserEventAction {
   public:
-    LCEventAction();
+    LCEventAction(LCRunAction* runAction = nullptr);
     virtual ~LCEventAction();
     
     virtual void BeginOfEventAction(const G4Event*);
@@ -20,6 +24,13 @@ class LCEventAction : public G4UserEventAction {
     void AddElectronCount(G4int count) { fTotalElectrons += count; }
     void AddIonCount(G4int count) { fTotalIons += count; }
     
+    // Track weight of an LC cell deposit (differs from 1 only with biasing)
+    void AddDepositWeight(G4double edep, G4double weight) { fWeightedEnergyDeposit += edep * weight; }
+    
+    // Weight change of one track (LCTrackingAction); their product is the
+    // weight of the event's whole history
+    void MultiplyHistoryWeight(G4double factor) { fHistoryWeight *= factor; }
+    
     // New methods for electrometer current modeling
     void AddCurrentPulse(G4double time, G4double current);
     void AddTimeProfile(G4double time, G4double current);
@@ -30,17 +41,38 @@ class LCEventAction : public G4UserEventAction {
     G4int GetTotalElectrons() const { return fTotalElectrons; }
     G4int GetTotalIons() const { return fTotalIons; }
     
+    // Event weight: energy-weighted mean track weight of the deposits, or the
+    // history weight for events without a deposit in the LC cell
+    G4double GetEventWeight() const;
+    
     // Method to get the average electrometer current
     G4double GetAverageElectrometerCurrent() const;
     
     // Method to get the peak electrometer current
     G4double GetPeakElectrometerCurrent() const;
     
+    // Number of current samples recorded in this event
+    size_t GetCurrentSampleCount() const { return fCurrentProfile.size(); }
+    
+    // Readout model whose per-event pulse list is reset and accounted here
+    void SetReadoutModel(LCReadoutModel* readoutModel) { fReadoutModel = readoutModel; }
+    
+    // Book the LCData ntuple filled at the end of each event
+    static void BookNtuple();
+    
   private:
+    // Halve the stored profile once it is at capacity (memory budget)
+    void CoarsenProfile();
+    
+    LCRunAction* fRunAction;
+    LCReadoutModel* fReadoutModel;
+
     G4double fTotalEnergyDeposit;
     G4double fTotalCharge;
     G4int fTotalElectrons;
     G4int fTotalIons;
+    G4double fWeightedEnergyDeposit;
+    G4double fHistoryWeight;
     
     // For electrometer modeling
     struct CurrentSample {
@@ -50,10 +82,20 @@ class LCEventAction : public G4UserEventAction {
         CurrentSample(G4double t, G4double i) : time(t), current(i) {}
     };
     
-    // Store time-current profile
-    std::vector<CurrentSample> fCurrentProfile;
+    // Store time-current profile (in the per-thread event arena)
+    std::pmr::vector<CurrentSample> fCurrentProfile;
     G4double fMaxCurrent;
     G4double fTotalCurrentIntegral;
+    
+    // Profile capacity for this event, and the fraction of samples kept
+    // (1 in fProfileStride) after coarsening
+    size_t fProfileCapacity;
+    size_t fProfileStride;
+    size_t fSampleCounter;
+    
+    // Largest profile so far, reserved up front so the arena block is not
+    // filled by intermediate vector growth
+    size_t fProfileHighWater;
 };
 
 #endif
@@ -0,0 +1,64 @@
+// LCEventArena.hh - Per-thread monotonic arena for the transient readout containers of one event
+#ifndef LCEventArena_h
+#define LCEventArena_h 1
+
+#include "globals.hh"
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+// Memory resource for std::pmr containers that live for one event (the
+// electrometer profile, the readout pulse list). Allocations are carved from
+// one block; deallocation is a no-op and everything is released at once by
+// Reset(), called from LCEventAction::BeginOfEventAction. If an event needs
+// more than the block, the excess comes from the heap and the block is
+// enlarged at the next reset, so after the first large events the readout
+// path does not touch the heap.
+//
+// Containers must give back their memory (e.g. swap with an empty vector)
+// before Reset() - anything still pointing into the arena becomes invalid.
+class LCEventArena : public std::pmr::memory_resource {
+  public:
+    static LCEventArena* Instance();
+    ~LCEventArena() override;
+    
+    void Reset();
+    
+    std::size_t GetBlockSize() const { return fBlockSize; }
+    std::size_t GetOverflowBytes() const { return fUpstream.GetBytes(); }  // heap since last reset
+    G4int GetGrowthCount() const { return fGrowthCount; }
+    
+  private:
+    LCEventArena();
+    
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+      return this == &other;
+    }
+    
+    // Heap fallback that remembers how much the block was short
+    class CountingUpstream : public std::pmr::memory_resource {
+      public:
+        std::size_t GetBytes() const { return fBytes; }
+        void ResetBytes() { fBytes = 0; }
+      private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+          return this == &other;
+        }
+        std::size_t fBytes = 0;
+    };
+    
+    static G4ThreadLocal LCEventArena* fInstance;
+    
+    std::unique_ptr<std::byte[]> fBlock;
+    std::size_t fBlockSize;
+    G4int fGrowthCount;
+    CountingUpstream fUpstream;
+    std::optional<std::pmr::monotonic_buffer_resource> fMonotonic;
+};
+
+#endif
@@ -0,0 +1,58 @@
+// LCEventInformation.hh - Per-event information attached by the primary generator
+#ifndef LCEventInformation_h
+#define LCEventInformation_h 1
+
+#include "G4VUserEventInformation.hh"
+#include "G4Allocator.hh"
+#include "globals.hh"
+
+class LCEventInformation : public G4VUserEventInformation {
+  public:
+    // Source ID for events without a cocktail, and for cocktail events
+    // whose primaries come from different sources
+    static const G4int kBeamSource = -1;
+    static const G4int kMixedSources = -2;
+    
+    LCEventInformation(G4int nPrimaries, G4int sourceID = kBeamSource);
+    virtual ~LCEventInformation();
+    
+    virtual void Print() const;
+    
+    // Created every event - taken from a per-thread pool
+    inline void* operator new(size_t);
+    inline void operator delete(void* info);
+    
+    // Number of beam primaries in this event (bunch mode)
+    G4int GetNumberOfPrimaries() const { return fNumberOfPrimaries; }
+    
+    // Cocktail source of the primaries
+    G4int GetSourceID() const { return fSourceID; }
+    
+    // Incidence angles relative to the beam axis (zero without angular mode)
+    void SetIncidence(G4double theta, G4double phi) { fTheta = theta; fPhi = phi; }
+    G4double GetTheta() const { return fTheta; }
+    G4double GetPhi() const { return fPhi; }
+    
+  private:
+    G4int fNumberOfPrimaries;
+    G4int fSourceID;
+    G4double fTheta;
+    G4double fPhi;
+};
+
+extern G4ThreadLocal G4Allocator<LCEventInformation>* LCEventInformationAllocator;
+
+inline void* LCEventInformation::operator new(size_t)
+{
+  if (!LCEventInformationAllocator) {
+    LCEventInformationAllocator = new G4Allocator<LCEventInformation>;
+  }
+  return (void*)LCEventInformationAllocator->MallocSingle();
+}
+
+inline void LCEventInformation::operator delete(void* info)
+{
+  LCEventInformationAllocator->FreeSingle((LCEventInformation*)info);
+}
+
+#endif
@@ -0,0 +1,17 @@
+// LCGlassFilterBuilder.hh - Builds glass filter transfer tables from a slab simulation
+#ifndef LCGlassFilterBuilder_h
+#define LCGlassFilterBuilder_h 1
+
+#include "globals.hh"
+
+// Runs a pencil beam of the given particle through the glass filter slab at
+// every energy of LCGlassFilterTable::DefaultEnergyGrid() and saves the
+// resulting table to the given directory. Uses its own sequential run
+// manager, so it must run instead of (not alongside) the detector simulation.
+class LCGlassFilterBuilder {
+  public:
+    // Returns 0 on success, like main()
+    static G4int Build(const G4String& particleName, G4int eventsPerEnergy, const G4String& directory);
+};
+
+#endif
@@ -0,0 +1,65 @@
+// LCGlassFilterTable.hh - Tabulated transfer of beam particles through the glass filter
+#ifndef LCGlassFilterTable_h
+#define LCGlassFilterTable_h 1
+
+#include "LCAliasTable.hh"
+#include "globals.hh"
+#include <vector>
+
+// For each incoming energy on a grid, the probability of the primary leaving
+// the filter slab with a given relative energy loss and angle to the beam,
+// or of being stopped. Built by LCGlassFilterBuilder from a slab simulation,
+// saved to disk and sampled with alias tables by the primary generator.
+class LCGlassFilterTable {
+  public:
+    LCGlassFilterTable(const G4String& particleName, const std::vector<G4double>& energies);
+    ~LCGlassFilterTable();
+    
+    // Filter slab simulated by the builder
+    static G4double GetSlabThickness();
+    static G4String GetSlabMaterial();
+    
+    // Log-spaced grid, 1 keV - 10 GeV
+    static std::vector<G4double> DefaultEnergyGrid();
+    
+    // Building
+    void Fill(G4int energyIndex, G4double energyOut, G4double theta);
+    void FillStopped(G4int energyIndex);
+    void Finalize();
+    
+    // Disk cache
+    G4bool Save(const G4String& fileName) const;
+    static LCGlassFilterTable* Load(const G4String& fileName);
+    static G4String GetFileName(const G4String& directory, const G4String& particleName);
+    
+    // Table for a particle from the directory set with /LC/beam/glassFilterTableDir,
+    // loaded once and shared by all threads; nullptr if there is none. Takes
+    // a global lock, so the event loop keeps the result per thread
+    // (LCPrimaryGeneratorAction) instead of asking per primary.
+    static const LCGlassFilterTable* Get(const G4String& particleName);
+    
+    // Outgoing energy and angle to the incoming direction; false if the
+    // particle is stopped in the filter
+    G4bool Sample(G4double energyIn, G4double& energyOut, G4double& theta) const;
+    
+    const G4String& GetParticleName() const { return fParticleName; }
+    const std::vector<G4double>& GetEnergies() const { return fEnergies; }
+    
+    // Identifies the table contents, for the result cache key
+    const G4String& GetSignature() const { return fSignature; }
+    
+  private:
+    G4int LossBin(G4double loss) const;
+    G4int AngleBin(G4double theta) const;
+    void SampleCell(G4int energyIndex, G4double& loss, G4double& theta, G4bool& stopped) const;
+    
+    G4String fParticleName;
+    std::vector<G4double> fEnergies;
+    
+    // Per grid energy: counts per (loss bin, angle bin) cell, last cell = stopped
+    std::vector<std::vector<G4double>> fCounts;
+    std::vector<LCAliasTable> fTables;
+    G4String fSignature;
+};
+
+#endif
@@ -4,6 +4,18 @@
 
 #include "globals.hh"
 #include "G4SystemOfUnits.hh"
+#include "LCAliasTable.hh"
+#include <cstddef>
+#include <vector>
+
+class LCCocktailGenerator;
+
+// Incidence direction of the list angular mode, relative to the beam axis
+struct LCIncidenceAngle {
+    G4double theta;
+    G4double phi;
+    G4double weight;
+};
 
 class LCGlobalManager {
 public:
@@ -15,12 +27,172 @@ public:
     G4String GetParticleType() const { return fParticleName; }
     G4double GetParticleEnergy() const { return fParticleEnergy; }
     
+    void SetGlassFilter(G4bool enable) { fGlassFilterEnabled = enable; }
+    G4bool IsGlassFilterEnabled() const { return fGlassFilterEnabled; }
+    
+    // Glass filter model: "simple" energy rules or "table" (tabulated transfer
+    // from --build-filter-table, read from the table directory)
+    void SetGlassFilterModel(const G4String& model) { fGlassFilterModel = model; }
+    void SetGlassFilterTableDir(const G4String& dir) { fGlassFilterTableDir = dir; }
+    G4String GetGlassFilterModel() const { return fGlassFilterModel; }
+    G4String GetGlassFilterTableDir() const { return fGlassFilterTableDir; }
+    
+    // Seed chosen at startup; "fixed" when given explicitly with --seed
+    void SetRandomSeed(long seed, G4bool fixed) { fRandomSeed = seed; fRandomSeedFixed = fixed; }
+    long GetRandomSeed() const { return fRandomSeed; }
+    G4bool IsRandomSeedFixed() const { return fRandomSeedFixed; }
+    
+    // Record LC cell deposits for offline readout replay
+    void SetStepRecording(G4bool enable) { fStepRecordingEnabled = enable; }
+    G4bool IsStepRecordingEnabled() const { return fStepRecordingEnabled; }
+    
+    // Write each event's electrometer waveform, quantised to these steps
+    void SetWaveformRecording(G4bool enable) { fWaveformRecordingEnabled = enable; }
+    G4bool IsWaveformRecordingEnabled() const { return fWaveformRecordingEnabled; }
+    void SetWaveformTimeStep(G4double step) { fWaveformTimeStep = step; }
+    G4double GetWaveformTimeStep() const { return fWaveformTimeStep; }
+    void SetWaveformCurrentStep(G4double step) { fWaveformCurrentStep = step; }
+    G4double GetWaveformCurrentStep() const { return fWaveformCurrentStep; }
+    
+    // Charge transport model of the readout: "constant" or "tabulated"
+    void SetTransportModel(const G4String& model) { fTransportModel = model; }
+    const G4String& GetTransportModel() const { return fTransportModel; }
+    
+    // Memory budget for the per-thread buffers in bytes (0 = no budget)
+    void SetMemoryBudget(std::size_t bytes) { fMemoryBudget = bytes; }
+    std::size_t GetMemoryBudget() const { return fMemoryBudget; }
+    
+    // Cross-section biasing of neutral particles in the LC cell and electrodes
+    void SetBiasingEnabled(G4bool enable) { fBiasingEnabled = enable; }
+    void SetGammaBiasFactor(G4double factor) { fGammaBiasFactor = factor; }
+    void SetNeutronBiasFactor(G4double factor) { fNeutronBiasFactor = factor; }
+    G4bool IsBiasingEnabled() const { return fBiasingEnabled; }
+    G4double GetGammaBiasFactor() const { return fGammaBiasFactor; }
+    G4double GetNeutronBiasFactor() const { return fNeutronBiasFactor; }
+    
+    // Bunch mode: primaries per event (fixed or Poisson mean) and their time
+    // structure - microbunches at a fixed spacing, each with a Gaussian length
+    void SetBunchPrimaries(G4double mean) { fBunchPrimaries = mean; }
+    void SetBunchPoisson(G4bool poisson) { fBunchPoisson = poisson; }
+    void SetBunchCount(G4int count) { fBunchCount = count; }
+    void SetBunchSpacing(G4double spacing) { fBunchSpacing = spacing; }
+    void SetBunchLength(G4double length) { fBunchLength = length; }
+    G4double GetBunchPrimaries() const { return fBunchPrimaries; }
+    G4bool IsBunchPoisson() const { return fBunchPoisson; }
+    G4int GetBunchCount() const { return fBunchCount; }
+    G4double GetBunchSpacing() const { return fBunchSpacing; }
+    G4double GetBunchLength() const { return fBunchLength; }
+    
+    // Continuous beam: events arrive at this rate (0 = off) and are merged
+    // into one electrometer trace sampled at the bin width; the merge waits
+    // this much beam time for events that finish out of order
+    void SetTimelineRate(G4double rate) { fTimelineRate = rate; }
+    void SetTimelineBinWidth(G4double width) { fTimelineBinWidth = width; }
+    void SetTimelineWindow(G4double window) { fTimelineWindow = window; }
+    G4double GetTimelineRate() const { return fTimelineRate; }
+    G4double GetTimelineBinWidth() const { return fTimelineBinWidth; }
+    G4double GetTimelineWindow() const { return fTimelineWindow; }
+    G4bool IsTimelineEnabled() const { return fTimelineRate > 0.; }
+    // Mixed-source cocktail replacing the single beam particle
+    void SetCocktailEnabled(G4bool enable) { fCocktailEnabled = enable; }
+    G4bool IsCocktailEnabled() const { return fCocktailEnabled; }
+    LCCocktailGenerator* GetCocktail() const { return fCocktail; }
+    
+    // Angular response mode: incidence angle sampled per event around the beam
+    // axis - "off" (fixed beam direction), "uniformCos", "cosine" or "list"
+    void SetAngularMode(const G4String& mode) { fAngularMode = mode; }
+    void SetAngularThetaMin(G4double theta) { fAngularThetaMin = theta; }
+    void SetAngularThetaMax(G4double theta) { fAngularThetaMax = theta; }
+    void AddAngularPoint(G4double theta, G4double phi, G4double weight);
+    void ClearAngularPoints();
+    G4String GetAngularMode() const { return fAngularMode; }
+    G4double GetAngularThetaMin() const { return fAngularThetaMin; }
+    G4double GetAngularThetaMax() const { return fAngularThetaMax; }
+    const std::vector<LCIncidenceAngle>& GetAngularPoints() const { return fAngularPoints; }
+    const LCAliasTable& GetAngularPointTable() const { return fAngularPointTable; }
+    G4bool IsAngularModeEnabled() const { return fAngularMode != "off"; }
+    
+    // Adaptive run length (/LC/run/beamOnAdaptive): relative standard error
+    // target for the listed observables (0 = none), wall-clock budget (0 =
+    // none) and the events needed before the precision is trusted
+    void SetTargetPrecision(G4double precision) { fTargetPrecision = precision; }
+    void SetTargetObservables(const G4String& names) { fTargetObservables = names; }
+    void SetTimeBudget(G4double budget) { fTimeBudget = budget; }
+    void SetMinAdaptiveEvents(G4int events) { fMinAdaptiveEvents = events; }
+    G4double GetTargetPrecision() const { return fTargetPrecision; }
+    G4String GetTargetObservables() const { return fTargetObservables; }
+    G4double GetTimeBudget() const { return fTimeBudget; }
+    G4int GetMinAdaptiveEvents() const { return fMinAdaptiveEvents; }
+    
+    // Delta electrons created in the LC cell below an energy, or below the
+    // energy for a range in the LC material, are deposited in place (0 = off);
+    // user step limit in the LC cell (0 = none)
+    void SetCondenseEnergy(G4double energy) { fCondenseEnergy = energy; }
+    void SetCondenseRange(G4double range) { fCondenseRange = range; }
+    void SetCellMaxStep(G4double step) { fCellMaxStep = step; }
+    G4double GetCondenseEnergy() const { return fCondenseEnergy; }
+    G4double GetCondenseRange() const { return fCondenseRange; }
+    G4double GetCellMaxStep() const { return fCellMaxStep; }
+    G4bool IsCondensationEnabled() const { return fCondenseEnergy > 0. || fCondenseRange > 0.; }
+    
+    // Geometry fidelity level built at initialization: "minimal" (cell and
+    // electrodes in vacuum), "standard" (cell and electrodes in air), "full"
+    void SetGeometryFidelity(const G4String& level) { fGeometryFidelity = level; }
+    G4String GetGeometryFidelity() const { return fGeometryFidelity; }
+    
+    // Campaign store every finished run is appended to ("none" = off)
+    void SetCampaignStore(const G4String& dir) { fCampaignStore = dir; }
+    G4String GetCampaignStore() const { return fCampaignStore; }
+    G4bool IsCampaignStoreEnabled() const { return !fCampaignStore.empty() && fCampaignStore != "none"; }
+    
+    G4bool IsBunchModeEnabled() const {
+      return fBunchPrimaries != 1.0 || fBunchPoisson || fBunchCount > 1 || fBunchLength > 0.;
+    }
+    
 private:
     LCGlobalManager();  // Private constructor (singleton)
     static LCGlobalManager* fInstance;
     
     G4String fParticleName;
     G4double fParticleEnergy;
+    G4bool fGlassFilterEnabled;
+    G4String fGlassFilterModel;
+    G4String fGlassFilterTableDir;
+    long fRandomSeed;
+    G4bool fRandomSeedFixed;
+    G4bool fStepRecordingEnabled;
+    G4bool fWaveformRecordingEnabled;
+    G4double fWaveformTimeStep;
+    G4double fWaveformCurrentStep;
+    G4String fTransportModel;
+    std::size_t fMemoryBudget;
+    G4bool fBiasingEnabled;
+    G4double fGammaBiasFactor;
+    G4double fNeutronBiasFactor;
+    G4double fBunchPrimaries;
+    G4bool fBunchPoisson;
+    G4int fBunchCount;
+    G4double fBunchSpacing;
+    G4double fBunchLength;
+    G4double fTimelineRate;
+    G4double fTimelineBinWidth;
+    G4double fTimelineWindow;
+    G4bool fCocktailEnabled;
+    LCCocktailGenerator* fCocktail;
+    G4String fAngularMode;
+    G4double fAngularThetaMin;
+    G4double fAngularThetaMax;
+    std::vector<LCIncidenceAngle> fAngularPoints;
+    LCAliasTable fAngularPointTable;
+    G4double fTargetPrecision;
+    G4String fTargetObservables;
+    G4double fTimeBudget;
+    G4int fMinAdaptiveEvents;
+    G4String fCampaignStore;
+    G4double fCondenseEnergy;
+    G4double fCondenseRange;
+    G4double fCellMaxStep;
+    G4String fGeometryFidelity;
 };
 
 #endif
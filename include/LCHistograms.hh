@@ -0,0 +1,118 @@
+// LCHistograms.hh - Thread-local fixed-binning histograms exported to the analysis manager at end of run
+#ifndef LCHistograms_h
+#define LCHistograms_h 1
+
+#include "globals.hh"
+#include <vector>
+
+// Fixed-width 1D histogram filled with plain arithmetic. Bin 0 is the
+// underflow and bin nBins+1 the overflow, as in the analysis histograms.
+// Each bin keeps its sum of weights, sum of squared weights and entries.
+class LCFastH1 {
+  public:
+    LCFastH1() : fNbins(0), fNcells(0), fMin(0.), fMax(0.), fInvWidth(0.) {}
+    
+    void Book(G4int nBins, G4double min, G4double max);
+    void Reset();
+    
+    inline void Fill(G4double x, G4double weight = 1.0) {
+      G4int bin = Bin(x);
+      fCells[bin] += weight;
+      fCells[fNcells + bin] += weight * weight;
+      fCells[2*fNcells + bin] += 1.;
+    }
+    
+    // Adds the bin sums to analysis histogram id (moments at the bin centres)
+    void Export(G4int id) const;
+    
+    G4int Bin(G4double x) const {
+      if (!(x >= fMin)) return 0;
+      if (x >= fMax) return fNbins + 1;
+      G4int bin = 1 + G4int((x - fMin) * fInvWidth);
+      return bin > fNbins ? fNbins : bin;
+    }
+    G4double GetBinContent(G4int bin) const { return fCells[bin]; }
+    G4double GetBinError2(G4int bin) const { return fCells[fNcells + bin]; }
+    G4double GetBinEntries(G4int bin) const { return fCells[2*fNcells + bin]; }
+    G4double BinCenter(G4int bin) const;
+    
+    // Sums of weights, squared weights and entries of all bins including
+    // under/overflow (in that order), for merging across processes
+    std::vector<G4double>& GetContents() { return fCells; }
+  
+  private:
+    G4int fNbins;
+    G4int fNcells;  // nBins + 2
+    G4double fMin, fMax, fInvWidth;
+    std::vector<G4double> fCells;
+};
+
+// Fixed-width 2D histogram, (nBinsX+2) x (nBinsY+2) cells including
+// under/overflow, with the same per-cell sums as LCFastH1
+class LCFastH2 {
+  public:
+    void Book(G4int nBinsX, G4double minX, G4double maxX,
+              G4int nBinsY, G4double minY, G4double maxY);
+    void Reset();
+    
+    inline void Fill(G4double x, G4double y, G4double weight = 1.0) {
+      size_t cell = fX.Bin(x) * fStrideX + fY.Bin(y);
+      fCells[cell] += weight;
+      fCells[fNcells + cell] += weight * weight;
+      fCells[2*fNcells + cell] += 1.;
+    }
+    
+    void Export(G4int id) const;
+    
+    std::vector<G4double>& GetContents() { return fCells; }
+  
+  private:
+    // Axes reuse the 1D binning
+    LCFastH1 fX;
+    LCFastH1 fY;
+    G4int fStrideX = 0;
+    size_t fNcells = 0;
+    std::vector<G4double> fCells;
+};
+
+// The run's histograms: booked once per thread, both in G4AnalysisManager
+// and here with the same binning. Event and stepping actions fill the fast
+// copies; each thread adds them to its analysis histograms once, before the
+// analysis manager writes (and merges) them at the end of the run.
+class LCHistograms {
+  public:
+    enum H1ID { kEdep = 0, kCharge, kAvgCurrent, kPeakCurrent, kNumberOfH1 };
+    enum H2ID { kCurrentTime = 0, kChargeDist, kEdepVsTheta, kChargeVsTheta, kNumberOfH2 };
+    
+    static LCHistograms* Instance();
+    
+    // Books the analysis histograms and their fast copies for this thread
+    static void Book();
+    
+    LCFastH1& H1(H1ID id) { return fH1[id]; }
+    LCFastH2& H2(H2ID id) { return fH2[id]; }
+    
+    void Reset();
+    // Adds the fast contents to the analysis histograms and resets them
+    void Export();
+    
+    // MPI runs (see LCMPIManager): the threads of a rank add their contents
+    // to a process-wide total instead of exporting them; the master appends
+    // that total, flattened, to the buffer reduced to rank 0, and rank 0
+    // sets the reduced contents on its own histograms before exporting.
+    G4int GetNumberOfCells();
+    void AddToProcessTotal();
+    void AppendProcessTotal(std::vector<G4double>& cells);
+    void SetContents(const G4double* cells);
+  
+  private:
+    LCHistograms() {}
+    
+    static G4ThreadLocal LCHistograms* fInstance;
+    static std::vector<G4double> fProcessTotal;
+    
+    LCFastH1 fH1[kNumberOfH1];
+    LCFastH2 fH2[kNumberOfH2];
+};
+
+#endif
@@ -0,0 +1,56 @@
+// LCMPIManager.hh - Process-level MPI state: event split, per-rank seeds and reduction to rank 0
+#ifndef LCMPIManager_h
+#define LCMPIManager_h 1
+
+#include "globals.hh"
+#include <vector>
+
+// One instance per process. Only LCDetectorMPI initializes MPI; everywhere
+// else (and in builds without LC_USE_MPI) this is a single rank of size 1 and
+// every call below is a no-op.
+//
+// Ranks split each /run/beamOn: every rank simulates its share of the events
+// with its own seed stream and writes its own output files; the master
+// thread of each rank then sums the run totals and histogram contents to
+// rank 0, which writes the combined histograms and the report.
+class LCMPIManager {
+  public:
+    static LCMPIManager* Instance();
+    
+    // MPI_Init/MPI_Finalize (only the master thread of each rank calls MPI)
+    void Initialize(int* argc, char*** argv);
+    void Finalize();
+    
+    G4int GetRank() const { return fRank; }
+    G4int GetSize() const { return fSize; }
+    G4bool IsActive() const { return fSize > 1; }
+    G4bool IsRoot() const { return fRank == 0; }
+    
+    // Events simulated by this rank out of nEvents (the remainder goes to the lowest ranks)
+    G4int GetEventShare(G4int nEvents) const;
+    
+    // Rank 0's seed on every rank, and the seed of this rank's stream derived
+    // from it (rank 0 keeps it, so a single-rank run matches LCDetector)
+    long BroadcastSeed(long seed) const;
+    long GetRankSeed(long seed) const;
+    
+    // Element-wise sum over all ranks, result on rank 0 (other ranks keep theirs)
+    void ReduceSum(std::vector<G4double>& values) const;
+    
+    // Rank 0's values on every rank (all ranks pass the same size)
+    void Broadcast(std::vector<G4double>& values) const;
+    
+    // Output file name suffix, empty on rank 0
+    G4String GetFileSuffix() const;
+  
+  private:
+    LCMPIManager() : fRank(0), fSize(1), fInitialized(false) {}
+    
+    static LCMPIManager* fInstance;
+    
+    G4int fRank;
+    G4int fSize;
+    G4bool fInitialized;
+};
+
+#endif
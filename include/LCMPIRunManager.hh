@@ -0,0 +1,26 @@
+// LCMPIRunManager.hh - Run manager of LCDetectorMPI: splits every beamOn across the MPI ranks
+#ifndef LCMPIRunManager_h
+#define LCMPIRunManager_h 1
+
+#include "LCMPIManager.hh"
+#include "LCRunAction.hh"
+
+// RunManager is G4MTRunManager or G4RunManager. Covers /run/beamOn, macro
+// loops and /LC/cache/beamOn alike, since they all end up in BeamOn().
+template <class RunManager>
+class LCMPIRunManager : public RunManager {
+  public:
+    void BeamOn(G4int nEvents, const char* macroFile = nullptr, G4int nSelect = -1) override {
+      G4int share = LCMPIManager::Instance()->GetEventShare(nEvents);
+      
+      // Fewer events than ranks: the ranks left without one still take part
+      // in the end-of-run reduction, which a run of 0 events would skip
+      if (nEvents > 0 && share == 0) {
+        LCRunAction::ReduceEmptyRun();
+        return;
+      }
+      RunManager::BeamOn(share, macroFile, nSelect);
+    }
+};
+
+#endif
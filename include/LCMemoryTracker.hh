@@ -0,0 +1,90 @@
+// LCMemoryTracker.hh - Per-thread accounting of the simulation's own buffers and memory budget
+#ifndef LCMemoryTracker_h
+#define LCMemoryTracker_h 1
+
+#include "globals.hh"
+#include <cstddef>
+#include <vector>
+
+// Containers whose size is tracked
+enum LCMemoryPool {
+  kPoolCurrentProfile = 0,   // LCEventAction electrometer samples
+  kPoolCurrentPulses,        // LCReadoutModel pulse list
+  kPoolStepRecords,          // LCStepRecorder per-event deposits
+  kPoolEventArena,           // LCEventArena block plus heap overflow
+  kPoolWaveformBlocks,       // LCWaveformRecorder block and event buffers
+  kNumberOfMemoryPools
+};
+
+// High-water marks of one thread over one run
+struct LCThreadMemoryReport {
+  G4int threadID;
+  G4int events;
+  std::size_t highWater[kNumberOfMemoryPools];  // bytes
+  std::size_t readoutAllocations;               // heap allocations on the readout path
+  G4int eventsWithAllocations;                  // (counted with LC_COUNT_ALLOCATIONS only)
+};
+
+// One tracker per thread. The owners of the tracked containers report their
+// allocated size once per event; the tracker keeps the high-water mark per
+// run. With a memory budget (/LC/memory/budget) it also sets the capacities
+// those containers are allowed to grow to, splitting the budget evenly over
+// the worker threads.
+class LCMemoryTracker {
+  public:
+    static LCMemoryTracker* Instance();
+    
+    // Run boundaries: BeginRun resets the high-water marks and derives the
+    // capacities from the budget, EndRun publishes this thread's report
+    void BeginRun();
+    void EndRun();
+    
+    // Allocated bytes of a container, called at the end of each event
+    void Track(LCMemoryPool pool, std::size_t bytes) {
+      if (bytes > fHighWater[pool]) fHighWater[pool] = bytes;
+    }
+    void CountEvent();
+    
+    // Heap allocations made while reading out a deposit (debug builds)
+    void AddReadoutAllocations(std::size_t count) { fEventAllocations += count; }
+    
+    std::size_t GetHighWater(LCMemoryPool pool) const { return fHighWater[pool]; }
+    
+    // Capacities for this run
+    std::size_t GetProfileCapacity() const { return fProfileCapacity; }   // samples
+    std::size_t GetPulseCapacity() const { return fPulseCapacity; }       // pulses
+    std::size_t GetStepRecordBudget() const { return fStepRecordBudget; } // bytes, 0 = no limit
+    
+    // Profile capacity a budget (0 = none) gives each of nThreads threads. It
+    // is the one capacity that changes the output (AvgCurrent averages the
+    // coarsened profile), so the result cache keys on it.
+    static std::size_t ProfileCapacityForBudget(std::size_t budget, G4int nThreads);
+    
+    static const char* PoolName(LCMemoryPool pool);
+    
+    // Reports published by all threads since the last call (master, end of run)
+    static std::vector<LCThreadMemoryReport> CollectReports();
+    
+    // Process resident set size in bytes: current and peak so far
+    static std::size_t GetCurrentRSS();
+    static std::size_t GetPeakRSS();
+    
+    // Default electrometer profile capacity without a budget
+    static constexpr std::size_t kDefaultProfileCapacity = 100000;
+    
+  private:
+    LCMemoryTracker();
+    
+    static G4ThreadLocal LCMemoryTracker* fInstance;
+    
+    G4int fEvents;
+    std::size_t fEventAllocations;
+    std::size_t fReadoutAllocations;
+    G4int fEventsWithAllocations;
+    std::size_t fHighWater[kNumberOfMemoryPools];
+    std::size_t fProfileCapacity;
+    std::size_t fPulseCapacity;
+    std::size_t fStepRecordBudget;
+};
+
+#endif
@@ -8,25 +8,29 @@
 #include "G4UIcmdWithAString.hh"
 #include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithoutParameter.hh"
 #include "G4SystemOfUnits.hh"
 
-class LCPrimaryGeneratorAction;
 class LCRunAction;
 class LCDetectorConstruction;
+class LCResultCache;
 
 class LCMessenger : public G4UImessenger
 {
   public:
-    LCMessenger(LCPrimaryGeneratorAction* primaryAction, LCRunAction* runAction, 
-                LCDetectorConstruction* detConstruction = nullptr);
+    // Lives on the master only: the worker threads take their settings from
+    // the configuration snapshot published at each run start (LCConfiguration)
+    LCMessenger(LCRunAction* runAction, LCDetectorConstruction* detConstruction = nullptr);
     virtual ~LCMessenger();
     
     virtual void SetNewValue(G4UIcommand*, G4String);
     
   private:
-    LCPrimaryGeneratorAction* fPrimaryAction;
     LCRunAction* fRunAction;
     LCDetectorConstruction* fDetConstruction;
+    LCResultCache* fResultCache;
     
     G4UIdirectory*             fLCDir;
     G4UIdirectory*             fBeamDir;
@@ -34,7 +38,88 @@ class LCMessenger : public G4UImessenger
     G4UIcmdWithAString*        fParticleCmd;
     G4UIcmdWithADoubleAndUnit* fEnergyCmd;
     G4UIcmdWithABool*          fGlassFilterCmd;
+    G4UIcmdWithAString*        fGlassFilterModelCmd;
+    G4UIcmdWithAString*        fGlassFilterTableDirCmd;
     G4UIcmdWithADoubleAndUnit* fBiasCmd;
+    G4UIcmdWithAString*        fFidelityCmd;
+    G4UIcmdWithADoubleAndUnit* fCellWidthCmd;
+    G4UIcmdWithADoubleAndUnit* fCellLengthCmd;
+    G4UIcmdWithADoubleAndUnit* fCellThicknessCmd;
+    G4UIcmdWithADoubleAndUnit* fElectrodeThicknessCmd;
+    G4UIcmdWithAString*        fTransportCmd;
+    
+    // Result cache commands (executed on the master only)
+    G4UIdirectory*             fCacheDir;
+    G4UIcmdWithAString*        fCacheDirCmd;
+    G4UIcmdWithAnInteger*      fCacheBeamOnCmd;
+    
+    // Step and waveform recording
+    G4UIdirectory*             fRecordDir;
+    G4UIcmdWithABool*          fRecordStepsCmd;
+    G4UIcmdWithABool*          fRecordWaveformsCmd;
+    G4UIcmdWithADoubleAndUnit* fWaveformTimeStepCmd;
+    G4UIcmdWithADouble*        fWaveformCurrentStepCmd;
+    
+    // Cross-section biasing of gammas and neutrons
+    G4UIdirectory*             fBiasingDir;
+    G4UIcmdWithABool*          fBiasingEnableCmd;
+    G4UIcmdWithADouble*        fGammaBiasCmd;
+    G4UIcmdWithADouble*        fNeutronBiasCmd;
+    
+    // Angular response mode (incidence angle sampled per event)
+    G4UIdirectory*             fAngularDir;
+    G4UIcmdWithAString*        fAngularModeCmd;
+    G4UIcmdWithADoubleAndUnit* fAngularThetaMinCmd;
+    G4UIcmdWithADoubleAndUnit* fAngularThetaMaxCmd;
+    G4UIcmdWithAString*        fAngularAddCmd;
+    G4UIcmdWithoutParameter*   fAngularClearCmd;
+    
+    // Adaptive run length
+    G4UIdirectory*             fRunDir;
+    G4UIcmdWithADouble*        fTargetPrecisionCmd;
+    G4UIcmdWithAString*        fTargetObservablesCmd;
+    G4UIcmdWithADoubleAndUnit* fTimeBudgetCmd;
+    G4UIcmdWithAnInteger*      fMinEventsCmd;
+    G4UIcmdWithAnInteger*      fAdaptiveBeamOnCmd;
+    
+    // Delta-electron condensation and step limit in the LC cell
+    G4UIdirectory*             fPhysicsDir;
+    G4UIcmdWithADoubleAndUnit* fCondenseEnergyCmd;
+    G4UIcmdWithADoubleAndUnit* fCondenseRangeCmd;
+    G4UIcmdWithADoubleAndUnit* fCellMaxStepCmd;
+    
+    // Campaign store of finished runs
+    G4UIdirectory*             fCampaignDir;
+    G4UIcmdWithAString*        fCampaignStoreCmd;
+    
+    // Memory budget for the per-thread buffers
+    G4UIdirectory*             fMemoryDir;
+    G4UIcmdWithADouble*        fMemoryBudgetCmd;
+    
+    // Bunch mode (several primaries per event)
+    G4UIdirectory*             fBunchDir;
+    G4UIcmdWithADouble*        fBunchPrimariesCmd;
+    G4UIcmdWithABool*          fBunchPoissonCmd;
+    G4UIcmdWithAnInteger*      fBunchCountCmd;
+    G4UIcmdWithADoubleAndUnit* fBunchSpacingCmd;
+    G4UIcmdWithADoubleAndUnit* fBunchLengthCmd;
+    
+    // Continuous-beam timeline
+    G4UIdirectory*             fTimelineDir;
+    G4UIcmdWithADoubleAndUnit* fTimelineRateCmd;
+    G4UIcmdWithADoubleAndUnit* fTimelineBinWidthCmd;
+    G4UIcmdWithADoubleAndUnit* fTimelineWindowCmd;
+    
+    // Mixed-source cocktail
+    G4UIdirectory*             fCocktailDir;
+    G4UIcmdWithABool*          fCocktailEnableCmd;
+    G4UIcmdWithoutParameter*   fCocktailClearCmd;
+    G4UIcmdWithAString*        fCocktailSourceCmd;
+    G4UIcmdWithAString*        fCocktailLineCmd;
+    G4UIcmdWithAString*        fCocktailBinCmd;
+    G4UIcmdWithADoubleAndUnit* fCocktailBetaCmd;
+    G4UIcmdWithAString*        fCocktailAngularCmd;
+    G4UIcmdWithAString*        fCocktailAngularBinCmd;
 };
 
 #endif
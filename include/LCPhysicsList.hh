@@ -12,6 +12,12 @@ class LCPhysicsList : public G4VModularPhysicsList
     virtual ~LCPhysicsList();
     
     virtual void SetCuts();
+    
+    // Short description of the physics constructors and cuts, used to tell
+    // apart results produced with different physics settings; with the LC
+    // cell step limit and delta-electron condensation unless withCellSettings
+    // is false (results that do not involve the cell)
+    static G4String GetConfigurationTag(G4bool withCellSettings = true);
 };
 
 #endif
@@ -5,20 +5,25 @@
 #include "G4VUserPrimaryGeneratorAction.hh"
 #include "G4ParticleGun.hh"
 #include "globals.hh"
+#include <utility>
+#include <vector>
 
 class G4ParticleGun;
 class G4Event;
 class G4Box;
+struct LCConfigSnapshot;
+class LCGlassFilterTable;
+class G4ParticleDefinition;
 
 class LCPrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
 {
   public:
     LCPrimaryGeneratorAction();    
     virtual ~LCPrimaryGeneratorAction();
-
+    
     // method from the base class
     virtual void GeneratePrimaries(G4Event*);         
-  
+    
     // method to access particle gun
     const G4ParticleGun* GetParticleGun() const { return fParticleGun; }
     
@@ -45,6 +50,20 @@ class LCPrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
     G4bool IsGlassFilterEnabled() const { return fGlassFilterEnabled; }
   
   private:
+    // Beam settings of a newly published configuration epoch
+    void ApplyConfiguration(const LCConfigSnapshot* config);
+    
+    // Glass filter table of a particle (nullptr: none, use the simple model),
+    // looked up once per particle and configuration epoch on this thread
+    const LCGlassFilterTable* GetFilterTable(const G4ParticleDefinition* particle);
+    
+    // Incidence direction of this event in angular mode, rotated from the beam axis
+    G4ThreeVector SampleIncidence(G4double& theta, G4double& phi) const;
+    
+    // One primary from the Gaussian beam spot, starting at the given time
+    void GeneratePrimary(G4Event* anEvent, G4double time, const G4String& particleName,
+                         G4double energy, const G4ThreeVector& direction);
+    
     G4ParticleGun*  fParticleGun; // pointer to G4 gun class
     G4Box* fEnvelopeBox;
     
@@ -53,6 +72,12 @@ class LCPrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
     G4String fParticleName;
     G4ThreeVector fBeamDirection;  // Direction of the beam
     G4bool fGlassFilterEnabled;    // Flag for glass filter
+    
+    // Configuration snapshot the current event runs with (LCConfiguration)
+    const LCConfigSnapshot* fConfig;
+    
+    // Filter tables resolved under fConfig (a cocktail needs one per source particle)
+    std::vector<std::pair<const G4ParticleDefinition*, const LCGlassFilterTable*>> fFilterTables;
 };
 
 #endif
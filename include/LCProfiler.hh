@@ -0,0 +1,149 @@
+// LCProfiler.hh - Cycle-counter profile of the stepping and event hot paths
+#ifndef LCProfiler_h
+#define LCProfiler_h 1
+
+// With LC_ENABLE_PROFILING (CMake option, off by default) every thread
+// counts, per logical volume and particle category, the steps it tracks and
+// the time Geant4 spends on them (from the end of one stepping action to
+// the start of the next), plus the time spent in a few regions of our own
+// code. The master merges the threads' counts into <output>_profile.txt at
+// the end of each run. Without it the macros below expand to nothing:
+//
+//   LC_PROFILE_STEP(volume, category);   // first statement of UserSteppingAction
+//   LC_PROFILE_SCOPE(kProfileCellPath);  // until the end of the enclosing block
+//   LC_PROFILE_BEGIN_EVENT();            // event setup is not a step
+#ifdef LC_ENABLE_PROFILING
+
+#include "globals.hh"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+class G4LogicalVolume;
+
+// Timed regions of our own code
+enum LCProfileRegion {
+  kProfileStepping = 0,      // LCSteppingAction::UserSteppingAction
+  kProfileElectrodePath,     // its charge-carrier branch in the electrodes
+  kProfileCellPath,          // its LC cell branch
+  kProfileDepositInCell,     // readout of one deposit (also condensed ones)
+  kProfileEndOfEvent,        // LCEventAction::EndOfEventAction
+  kNumberOfProfileRegions
+};
+
+// Time stamp counter where there is one, nanoseconds elsewhere
+inline std::uint64_t LCProfileClock() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Merged counts of one (volume, particle category) pair
+struct LCProfileStepEntry {
+  G4String volume;
+  G4int category;
+  std::uint64_t steps;
+  G4double seconds;
+};
+
+// One profiler per thread
+class LCProfiler {
+  public:
+    static LCProfiler* Instance();
+    
+    // Run boundaries: BeginRun clears the counts, EndRun converts them to
+    // seconds and publishes them for the master's report
+    void BeginRun();
+    void EndRun();
+    
+    void BeginEvent() { fLastStepEnd = LCProfileClock(); }
+    
+    // A step in a volume: the cycles since the end of the previous stepping
+    // action; StepDone marks the end of this one
+    void AddStep(const G4LogicalVolume* volume, G4int category, std::uint64_t now);
+    void StepDone(std::uint64_t now) { fLastStepEnd = now; }
+    
+    void AddRegion(LCProfileRegion region, std::uint64_t cycles) {
+      fRegionCalls[region]++;
+      fRegionCycles[region] += cycles;
+    }
+    
+    // Master, end of run: merges the published profiles and writes the
+    // report; false if no thread published one
+    static G4bool WriteReport(const G4String& fileName);
+  
+  private:
+    LCProfiler();
+    
+    static G4ThreadLocal LCProfiler* fInstance;
+    
+    // Counts of one volume, per particle category
+    struct VolumeCounts {
+      const G4LogicalVolume* volume;
+      std::vector<std::uint64_t> steps;
+      std::vector<std::uint64_t> cycles;
+    };
+    std::vector<VolumeCounts> fVolumes;
+    std::size_t fLastVolume;   // index of the last volume looked up
+    
+    std::uint64_t fLastStepEnd;
+    std::uint64_t fRegionCalls[kNumberOfProfileRegions];
+    std::uint64_t fRegionCycles[kNumberOfProfileRegions];
+    
+    // Clock calibration over the run
+    std::uint64_t fRunStartCycles;
+    std::chrono::steady_clock::time_point fRunStart;
+};
+
+// Cycles of a region, added when the scope ends
+class LCProfileScope {
+  public:
+    explicit LCProfileScope(LCProfileRegion region)
+    : fRegion(region), fStart(LCProfileClock()) {}
+    ~LCProfileScope() { LCProfiler::Instance()->AddRegion(fRegion, LCProfileClock() - fStart); }
+  
+  private:
+    LCProfileRegion fRegion;
+    std::uint64_t fStart;
+};
+
+// The stepping action: Geant4's cost of the step on entry, the action's own
+// cost (kProfileStepping) on exit
+class LCProfileStepScope {
+  public:
+    LCProfileStepScope(const G4LogicalVolume* volume, G4int category)
+    : fProfiler(LCProfiler::Instance()), fStart(LCProfileClock()) {
+      fProfiler->AddStep(volume, category, fStart);
+    }
+    ~LCProfileStepScope() {
+      std::uint64_t end = LCProfileClock();
+      fProfiler->AddRegion(kProfileStepping, end - fStart);
+      fProfiler->StepDone(end);
+    }
+  
+  private:
+    LCProfiler* fProfiler;
+    std::uint64_t fStart;
+};
+
+#define LC_PROFILE_CONCAT_(a, b) a##b
+#define LC_PROFILE_CONCAT(a, b) LC_PROFILE_CONCAT_(a, b)
+#define LC_PROFILE_SCOPE(region) LCProfileScope LC_PROFILE_CONCAT(lcProfileScope, __LINE__)(region)
+#define LC_PROFILE_STEP(volume, category) LCProfileStepScope lcProfileStepScope(volume, category)
+#define LC_PROFILE_BEGIN_EVENT() LCProfiler::Instance()->BeginEvent()
+
+#else
+
+#define LC_PROFILE_SCOPE(region)
+#define LC_PROFILE_STEP(volume, category)
+#define LC_PROFILE_BEGIN_EVENT()
+
+#endif
+
+#endif
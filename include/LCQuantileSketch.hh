@@ -0,0 +1,58 @@
+// LCQuantileSketch.hh - Mergeable quantile sketch with a relative accuracy guarantee
+#ifndef LCQuantileSketch_h
+#define LCQuantileSketch_h 1
+
+#include "globals.hh"
+#include <map>
+#include <vector>
+
+// Logarithmically binned weighted counts (the DDSketch scheme): a value x > 0
+// goes to bucket ceil(log(x)/log(gamma)) with gamma = (1+a)/(1-a), so any
+// quantile is returned within a relative error a of a value of the sample.
+// Negative values use a mirrored set of buckets, zeros a counter of their
+// own. Two sketches with the same accuracy merge by adding bucket counts,
+// which is how per-thread sketches are combined at end of run. Past
+// kMaxBuckets per sign the smallest-magnitude buckets are collapsed, which
+// only coarsens the low tail.
+class LCQuantileSketch {
+  public:
+    explicit LCQuantileSketch(G4double relativeAccuracy = 0.01);
+    
+    void Add(G4double x, G4double weight = 1.0);
+    void Merge(const LCQuantileSketch& other);
+    void Reset();
+    
+    // Value at quantile q in [0, 1] of the weighted sample, 0 if empty
+    G4double Quantile(G4double q) const;
+    
+    G4double GetTotalWeight() const { return fTotalWeight; }
+    G4double GetRelativeAccuracy() const { return fAccuracy; }
+    std::size_t GetNumberOfBuckets() const { return fPositive.size() + fNegative.size(); }
+    
+    static const std::size_t kMaxBuckets = 2048;
+    
+    // Dense layout that adds up like Merge, for summing over MPI ranks: zero
+    // and total weight, then the positive and the negative buckets with
+    // indices -kDenseRange..kDenseRange (beyond that, about 1e+-17 at the
+    // default accuracy, clamped to the ends)
+    static const G4int kDenseRange = 2048;
+    static std::size_t GetDenseSize() { return 2 + 2 * (2 * kDenseRange + 1); }
+    void AppendDense(std::vector<G4double>& values) const;
+    void SetFromDense(const G4double* values);
+  
+  private:
+    G4int Index(G4double magnitude) const;
+    G4double Value(G4int index) const;
+    static void Collapse(std::map<G4int, G4double>& buckets);
+    
+    G4double fAccuracy;
+    G4double fGamma;
+    G4double fInvLogGamma;
+    
+    std::map<G4int, G4double> fPositive;
+    std::map<G4int, G4double> fNegative;   // keyed by the index of |x|
+    G4double fZeroWeight;
+    G4double fTotalWeight;
+};
+
+#endif
@@ -0,0 +1,142 @@
+// LCReadoutModel.hh - Charge collection and electrometer response model
+#ifndef LCReadoutModel_h
+#define LCReadoutModel_h 1
+
+#include "globals.hh"
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+class LCEventAction;
+class LCTransportTables;
+
+// Result of pushing one energy deposit through the readout chain
+struct LCDepositReadout {
+  G4int ionizationEvents;     // Electron-ion pairs created
+  G4int collectedElectrons;   // After collection efficiency
+  G4int collectedIons;
+  G4double charge;            // Collected charge
+  G4double totalCurrent;      // Electron + ion current pulse
+};
+
+// Charge induced at a constant current while carriers drift to an electrode
+struct LCChargeDrift {
+  G4double start;             // Deposit time in the event
+  G4double duration;          // Transit time
+  G4double charge;
+};
+
+// Converts energy deposits in the LC cell into collected charge and
+// electrometer current samples. Holds no Geant4 tracking state, so it can be
+// driven by the stepping action, by replay tools or by benchmarks.
+//
+// Two charge transport models: "constant" (constant mobilities, fixed
+// collection efficiency) and "tabulated" (field-dependent mobility,
+// columnar recombination and drift losses from LCTransportTables, which
+// replace the fixed efficiency).
+class LCReadoutModel {
+  public:
+    LCReadoutModel();
+    ~LCReadoutModel();
+    
+    // Configuration (a change selects new transport tables at the next deposit)
+    void SetElectricField(G4double field) { fElectricField = field; fTransportTables = nullptr; }
+    void SetCellThickness(G4double thickness) { fCellThickness = thickness; fTransportTables = nullptr; }
+    void SetMobilities(G4double electron, G4double ion) {
+      fMobilityElectron = electron; fMobilityIon = ion; fTransportTables = nullptr;
+    }
+    void SetCollectionEfficiency(G4double efficiency) { fCollectionEfficiency = efficiency; }
+    void SetElectrometer(G4double resistance, G4double capacitance);
+    
+    // "constant" or "tabulated"
+    void SetTransportModel(const G4String& model);
+    void SetIntrinsicIonDensity(G4double density) { fIntrinsicIonDensity = density; fTransportTables = nullptr; }
+    
+    G4double GetElectricField() const { return fElectricField; }
+    G4double GetCellThickness() const { return fCellThickness; }
+    G4double GetMobilityElectron() const { return fMobilityElectron; }
+    G4double GetMobilityIon() const { return fMobilityIon; }
+    G4double GetCollectionEfficiency() const { return fCollectionEfficiency; }
+    G4double GetEnergyPerIonization() const { return fEnergyPerIonization; }
+    G4double GetElectrometerResistance() const { return fElectrometerResistance; }
+    G4double GetElectrometerCapacitance() const { return fElectrometerCapacitance; }
+    G4double GetElectrometerTimeConstant() const { return fElectrometerTimeConstant; }
+    G4String GetTransportModel() const { return fUseTransportTables ? "tabulated" : "constant"; }
+    G4double GetIntrinsicIonDensity() const { return fIntrinsicIonDensity; }
+    
+    // Event boundaries of the pulse list, which lives in the event arena:
+    // ReleasePulses gives its memory back before the arena is reset,
+    // BeginEvent sets the capacity (from the memory budget) and reserves
+    // the largest size seen so far
+    void ReleasePulses();
+    void BeginEvent(std::size_t pulseCapacity);
+    std::size_t GetPulseCount() const { return fCurrentPulses.size(); }
+    std::size_t GetPulseBytes() const { return fCurrentPulses.capacity() * sizeof(CurrentPulse); }
+    
+    // Every drift of the event, without the pulse capacity limit, for the
+    // continuous-beam timeline (cleared by BeginEvent)
+    void SetDriftRecording(G4bool record) { fRecordDrifts = record; }
+    const std::vector<LCChargeDrift>& GetChargeDrifts() const { return fChargeDrifts; }
+    
+    // Full readout of one deposit at position y across the cell (field axis),
+    // starting at time t0. Accumulates into the event action. The track
+    // length gives the ionisation density for recombination (0 if unknown).
+    LCDepositReadout ProcessDeposit(G4double energyDeposit, G4double y, G4double t0,
+                                    LCEventAction* eventAction, G4double trackLength = 0.);
+    
+    // Individual stages of the readout chain
+    G4int CalculateIonizationEvents(G4double energyDeposit);
+    G4double CalculateCharge(G4int numElectrons);
+    G4double CalculateCurrentPulse(G4int numCharges, G4double transitTime);
+    void SimulateElectrometerResponse(G4double charge, G4double transitTime, G4double t0,
+                                      LCEventAction* eventAction);
+    G4double CalculateElectrometerCurrent(G4double charge, G4double transitTime);
+    
+  private:
+    // Tables for the current cell, field and transport parameters
+    void UpdateTransportTables();
+    
+    // Parameters for charge collection simulation
+    G4double fElectricField;        // Electric field strength
+    G4double fCellThickness;        // LC thickness along the field
+    G4double fMobilityElectron;     // Electron mobility
+    G4double fMobilityIon;          // Ion mobility
+    G4double fRecombinationCoef;    // Recombination coefficient (0 = Langevin)
+    G4double fCollectionEfficiency; // Charge collection efficiency
+    G4double fEnergyPerIonization;  // Energy required per ionization
+    
+    // Tabulated transport model
+    G4bool fUseTransportTables;
+    G4double fSaturationVelocityElectron; // Drift velocity limits
+    G4double fSaturationVelocityIon;
+    G4double fIntrinsicIonDensity;        // Free ions of the LC itself
+    G4double fColumnRadius;               // Ionisation column radius
+    G4double fRelativePermittivity;
+    const LCTransportTables* fTransportTables;  // Shared, read-only
+    G4double fFieldCoordinate;
+    
+    // For electrometer model
+    G4double fElectrometerResistance;  // Internal resistance of electrometer
+    G4double fElectrometerCapacitance; // Input capacitance 
+    G4double fElectrometerTimeConstant; // RC time constant
+    G4double fElectrometerSamplingRate; // Sampling rate in Hz
+    
+    // Structure to hold current pulses for detailed electrometer simulation
+    struct CurrentPulse {
+        G4double startTime;
+        G4double charge;
+        G4double duration;
+        
+        CurrentPulse(G4double t, G4double q, G4double d) 
+          : startTime(t), charge(q), duration(d) {}
+    };
+    
+    std::pmr::vector<CurrentPulse> fCurrentPulses;
+    std::size_t fPulseCapacity;
+    std::size_t fPulseHighWater;
+    
+    G4bool fRecordDrifts;
+    std::vector<LCChargeDrift> fChargeDrifts;
+};
+
+#endif
@@ -0,0 +1,54 @@
+// LCResultCache.hh - Content-addressed store of finished simulation outputs
+#ifndef LCResultCache_h
+#define LCResultCache_h 1
+
+#include "globals.hh"
+#include <vector>
+
+class LCRunAction;
+class LCDetectorConstruction;
+
+// The cache key is a hash of the canonical run configuration (beam, detector,
+// physics, recordings, seed and build ID). Each cache entry holds one or more output
+// segments; a request for more events than are stored is topped up by running
+// only the missing events and storing them as a new segment. Every segment
+// is seeded from the key and its index, not from the engine state left by
+// earlier runs.
+// Runs without a fixed seed (--seed) are simulated but never cached.
+class LCResultCache {
+  public:
+    LCResultCache();
+    ~LCResultCache();
+    
+    void SetCacheDirectory(const G4String& dir) { fCacheDirectory = dir; }
+    G4String GetCacheDirectory() const { return fCacheDirectory; }
+    
+    // Run nEvents for the current configuration, reusing stored events.
+    // Writes the outcome and the number of events simulated to
+    // lc_cache_status.txt in the working directory.
+    void BeamOn(G4int nEvents, const LCRunAction* runAction,
+                const LCDetectorConstruction* detConstruction);
+    
+    // Canonical text description of the current run configuration
+    G4String BuildConfigurationKey(const LCDetectorConstruction* detConstruction) const;
+    
+    // 64-bit FNV-1a hash of a string, as 16 hex digits
+    static G4String HashString(const G4String& text);
+  
+  private:
+    struct Segment {
+      G4int index;
+      G4int events;
+      long seeds[2];
+      G4String baseName;
+    };
+    
+    std::vector<Segment> ReadManifest(const G4String& entryDir) const;
+    void WriteManifest(const G4String& entryDir, const G4String& key,
+                       const std::vector<Segment>& segments) const;
+    void RestoreSegments(const G4String& entryDir, const std::vector<Segment>& segments) const;
+    
+    G4String fCacheDirectory;
+};
+
+#endif
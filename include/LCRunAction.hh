@@ -5,15 +5,21 @@
 #include "G4UserRunAction.hh"
 #include "globals.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4Accumulable.hh"
+
+#include <chrono>
+#include <vector>
 
 class G4Run;
+struct LCObservableSummary;
+struct LCConfigSnapshot;
 
 class LCRunAction : public G4UserRunAction
 {
   public:
     LCRunAction();
     virtual ~LCRunAction();
-
+    
     // Methods from base class
     virtual void BeginOfRunAction(const G4Run*);
     virtual void EndOfRunAction(const G4Run*);
@@ -28,12 +34,45 @@ class LCRunAction : public G4UserRunAction
     
     // Get current output filename
     G4String GetCurrentFileName() const { return fCurrentFileName; }
-
+    
+    // Event weight, primaries and whether the electrometer profile had to be
+    // coarsened (memory budget), merged over threads for the report
+    void AddEventTally(G4double weight, G4int nPrimaries, G4bool profileCoarsened);
+    
+    // MPI runs: the end-of-run reduction for a rank that was given no events
+    static void ReduceEmptyRun();
+    
+    // Files written by the current run, from any thread (read by the result
+    // cache after BeamOn). The list is cleared when the master starts a run.
+    static void DeclareOutputFile(const G4String& fileName);
+    static std::vector<G4String> GetOutputFiles();
+  
   private:
+    void WriteReport(G4int nofEvents, const LCObservableSummary summaries[]);
+    // <base>_summary.json: per-event observable statistics merged over threads
+    void WriteSummary(G4int runID, const LCObservableSummary summaries[]);
+    // Appends the run to the campaign store (/LC/campaign/store)
+    void RecordCampaignRun(G4int runID, const LCObservableSummary summaries[]);
+    // MPI runs: sums this rank's totals, histograms and summaries into rank
+    // 0's (whose summaries become those of the whole run), returns the event count
+    G4int ReduceRanks(G4int nofEvents, LCObservableSummary summaries[]);
+    
     G4String fParticleName;
     G4double fParticleEnergy;
     G4bool fFilenameGenerated;  // Flag to track if filename has been set
     G4String fCurrentFileName;  // Store current filename base
+    const LCConfigSnapshot* fConfig;  // Settings of the current run (LCConfiguration)
+    
+    // Master: wall clock of the current run, for the event rate
+    std::chrono::steady_clock::time_point fRunStart;
+    G4double fRunWallTime;
+    
+    // Weighted run totals
+    G4Accumulable<G4double> fSumWeight;
+    G4Accumulable<G4double> fSumWeight2;
+    G4Accumulable<G4double> fSumPrimaries;
+    G4Accumulable<G4double> fSumEmptyEvents;  // Poisson bunches that drew no primary
+    G4Accumulable<G4double> fSumCoarsenedEvents;
 };
 
 #endif
@@ -0,0 +1,75 @@
+// LCRunStatistics.hh - Streaming per-run statistics of the per-event observables, merged over threads
+#ifndef LCRunStatistics_h
+#define LCRunStatistics_h 1
+
+#include "globals.hh"
+#include "LCRunningStat.hh"
+#include "LCQuantileSketch.hh"
+#include <vector>
+
+// Per-event observables summarised for each run (and usable as adaptive
+// run-length targets, see LCRunTermination)
+enum LCRunObservable {
+  kObservableEdep = 0,
+  kObservableCharge,
+  kObservableAvgCurrent,
+  kObservablePeakCurrent,
+  kNumberOfRunObservables
+};
+
+// Weighted moments, range and quantile sketch of one observable. The mean
+// per event and its standard error come from tally, the plain statistics of
+// w x: sum(w x)/N is unbiased whatever the event weights, while the weighted
+// mean sum(w x)/sum(w) is not when the weights do not average to 1.
+struct LCObservableSummary {
+  LCRunningStat moments;
+  LCRunningStat tally;
+  G4double min = 0.;
+  G4double max = 0.;
+  LCQuantileSketch quantiles;
+  
+  void Add(G4double x, G4double weight);
+  void Merge(const LCObservableSummary& other);
+  void Reset();
+  
+  // Layout for LCMPIManager::ReduceSum: moments and range in this rank's
+  // slot of nRanks (merged exactly on rank 0), then the dense sketch
+  static std::size_t GetReductionSize(G4int nRanks);
+  void AppendForReduction(std::vector<G4double>& values, G4int rank, G4int nRanks) const;
+  void SetFromReduction(const G4double* values, G4int nRanks);
+};
+
+// One instance per thread. The event action adds each event's observables
+// with its event weight; at end of run every thread publishes its summaries
+// and the master merges them, so the run summary costs nothing per event
+// beyond a few arithmetic operations and a sketch bucket update per
+// observable (a map insertion, which allocates, the first time a bucket is
+// hit). In MPI runs rank 0 then merges the ranks' summaries as well.
+class LCRunStatistics {
+  public:
+    static LCRunStatistics* Instance();
+    
+    static G4int ObservableFromName(const G4String& name);  // -1 if unknown
+    static const char* ObservableName(G4int observable);
+    // Unit the summary is written in, with its name
+    static G4double ObservableUnit(G4int observable);
+    static const char* ObservableUnitName(G4int observable);
+    
+    void BeginRun();
+    // Values in internal units
+    void AddEvent(const G4double values[kNumberOfRunObservables], G4double weight);
+    // Publishes this thread's summaries for the master
+    void EndRun();
+    
+    // Master, end of run: merge of everything published since the last call
+    static void CollectMerged(LCObservableSummary merged[kNumberOfRunObservables]);
+  
+  private:
+    LCRunStatistics() = default;
+    
+    static G4ThreadLocal LCRunStatistics* fInstance;
+    
+    LCObservableSummary fSummaries[kNumberOfRunObservables];
+};
+
+#endif
@@ -0,0 +1,69 @@
+// LCRunTermination.hh - Adaptive run length: stop on a target statistical precision or a time budget
+#ifndef LCRunTermination_h
+#define LCRunTermination_h 1
+
+#include "globals.hh"
+#include "LCRunningStat.hh"
+#include "LCRunStatistics.hh"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+// One instance per process, armed by /LC/run/beamOnAdaptive for one run.
+// Every thread keeps running statistics of the weighted (w x) per-event
+// observables and folds them into the shared totals every few events; the
+// run stops when the relative standard error of the mean of all selected
+// observables is at or below the target (after a minimum number of
+// events), or when the time budget is used up. The thread that sees this
+// raises a flag, and each worker soft-aborts after its current event.
+class LCRunTermination {
+  public:
+    enum Reason { kEventLimit = 0, kPrecisionReached, kTimeBudgetUsed };
+    
+    static LCRunTermination* Instance();
+    
+    void SetArmed(G4bool armed) { fArmed = armed; }
+    G4bool IsArmed() const { return fArmed; }
+    
+    // Master (or sequential) begin of run: settings from LCGlobalManager, clock start
+    void BeginRun();
+    // Any thread, end of event: true once this run should stop
+    G4bool AddEvent(const G4double values[kNumberOfRunObservables], G4double weight);
+    // Any thread, end of run: folds in what is left of this thread's statistics
+    void EndRun();
+    
+    // Results of the last armed run, for the report
+    Reason GetReason() const { return static_cast<Reason>(fReason.load()); }
+    const LCRunningStat& GetStat(G4int observable) const { return fStats[observable]; }
+    G4double GetElapsedSeconds() const;
+    G4double GetTargetPrecision() const { return fTargetPrecision; }
+    G4double GetTimeBudget() const { return fTimeBudget; }
+    G4bool IsSelected(G4int observable) const { return fSelected[observable]; }
+  
+  private:
+    LCRunTermination();
+    
+    // Called with the mutex held
+    void Flush(LCRunningStat* pending);
+    void CheckPrecision();
+    
+    static LCRunTermination* fInstance;
+    
+    G4bool fArmed;
+    
+    // Settings, fixed for the run
+    G4double fTargetPrecision;   // relative standard error, 0 = no target
+    G4double fTimeBudget;        // seconds, 0 = no budget
+    G4long fMinEvents;
+    G4bool fSelected[kNumberOfRunObservables];
+    
+    std::chrono::steady_clock::time_point fStart;
+    std::chrono::steady_clock::time_point fEnd;
+    std::atomic<G4bool> fStop;
+    std::atomic<G4int> fReason;
+    
+    std::mutex fMutex;
+    LCRunningStat fStats[kNumberOfRunObservables];
+};
+
+#endif
@@ -0,0 +1,87 @@
+// LCRunningStat.hh - Streaming weighted mean/variance (Welford) with a parallel merge
+#ifndef LCRunningStat_h
+#define LCRunningStat_h 1
+
+#include "globals.hh"
+#include <cmath>
+#include <limits>
+
+// Count, weighted mean and weighted sum of squared deviations, updated one
+// value at a time (West's form of Welford's update) and combined across
+// threads with the pairwise formula of Chan et al. With unit weights this
+// is the plain sample mean and variance.
+class LCRunningStat {
+  public:
+    void Add(G4double x, G4double weight = 1.0) {
+      fCount++;
+      fSumW += weight;
+      fSumW2 += weight * weight;
+      if (fSumW <= 0.) return;
+      G4double delta = x - fMean;
+      fMean += delta * weight / fSumW;
+      fM2 += weight * delta * (x - fMean);
+    }
+    
+    void Merge(const LCRunningStat& other) {
+      if (other.fCount == 0) return;
+      if (fCount == 0) { *this = other; return; }
+      G4double sumW = fSumW + other.fSumW;
+      fCount += other.fCount;
+      if (sumW <= 0.) { fSumW = sumW; fSumW2 += other.fSumW2; return; }
+      G4double delta = other.fMean - fMean;
+      fMean += delta * other.fSumW / sumW;
+      fM2 += other.fM2 + delta * delta * fSumW * other.fSumW / sumW;
+      fSumW = sumW;
+      fSumW2 += other.fSumW2;
+    }
+    
+    void Reset() { *this = LCRunningStat(); }
+    
+    // Raw state (count, sum of weights and of squared weights, mean, M2),
+    // for handing a statistic to another MPI rank
+    static const std::size_t kStateSize = 5;
+    void GetState(G4double state[kStateSize]) const {
+      state[0] = static_cast<G4double>(fCount);
+      state[1] = fSumW;
+      state[2] = fSumW2;
+      state[3] = fMean;
+      state[4] = fM2;
+    }
+    void SetState(const G4double state[kStateSize]) {
+      fCount = static_cast<G4long>(state[0]);
+      fSumW = state[1];
+      fSumW2 = state[2];
+      fMean = state[3];
+      fM2 = state[4];
+    }
+    
+    G4long GetCount() const { return fCount; }
+    G4double GetSumOfWeights() const { return fSumW; }
+    // Kish effective sample size, equal to the count with unit weights
+    G4double GetEffectiveCount() const { return fSumW2 > 0. ? fSumW * fSumW / fSumW2 : 0.; }
+    G4double GetMean() const { return fMean; }
+    // Unbiased for reliability weights: M2 / (W - sum(w^2)/W)
+    G4double GetVariance() const {
+      if (fCount < 2 || fSumW <= 0.) return 0.;
+      G4double norm = fSumW - fSumW2 / fSumW;
+      return norm > 0. ? fM2 / norm : 0.;
+    }
+    G4double GetStandardDeviation() const { return std::sqrt(GetVariance()); }
+    G4double GetStandardError() const {
+      return fCount > 1 && fSumW > 0. ? std::sqrt(GetVariance() * fSumW2) / fSumW : 0.;
+    }
+    // Standard error over |mean|; infinite until it can be estimated
+    G4double GetRelativeError() const {
+      if (fCount < 2 || fMean == 0.) return std::numeric_limits<G4double>::infinity();
+      return GetStandardError() / std::fabs(fMean);
+    }
+  
+  private:
+    G4long fCount = 0;
+    G4double fSumW = 0.;
+    G4double fSumW2 = 0.;
+    G4double fMean = 0.;
+    G4double fM2 = 0.;
+};
+
+#endif
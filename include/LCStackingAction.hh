@@ -0,0 +1,25 @@
+// LCStackingAction.hh - Deposits low-energy delta electrons in the LC cell in place (see LCCondensation)
+#ifndef LCStackingAction_h
+#define LCStackingAction_h 1
+
+#include "G4UserStackingAction.hh"
+#include "globals.hh"
+
+class LCSteppingAction;
+class LCCondensation;
+
+class LCStackingAction : public G4UserStackingAction {
+  public:
+    explicit LCStackingAction(LCSteppingAction* steppingAction);
+    virtual ~LCStackingAction();
+    
+    virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track);
+    virtual void PrepareNewEvent();
+    
+  private:
+    // Readout path shared with tracked deposits
+    LCSteppingAction* fSteppingAction;
+    LCCondensation* fCondensation;
+};
+
+#endif
@@ -0,0 +1,117 @@
+// LCStepRecorder.hh - Binary record of LC cell energy deposits for offline readout replay
+#ifndef LCStepRecorder_h
+#define LCStepRecorder_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+class G4Event;
+class G4ParticleDefinition;
+
+// Coarse particle category stored with each deposit
+enum LCParticleCategory : std::uint8_t {
+  kCategoryElectron = 0,
+  kCategoryPositron,
+  kCategoryGamma,
+  kCategoryProton,
+  kCategoryAlpha,
+  kCategoryIon,
+  kCategoryNeutron,
+  kCategoryOther,
+  kNumberOfCategories
+};
+
+// One recorded deposit, in file units (mm, ns, keV)
+struct LCStepRecord {
+  float x, y, z;
+  float time;                        // Start of the deposit (pre-step point), as used by the readout
+  float edep;
+  float length;                      // Track length of the step (0 in version 1 files)
+  std::uint8_t category;
+};
+
+// One recorded event
+struct LCRecordedEvent {
+  std::uint32_t eventID;
+  float t0;                          // Primary vertex time (ns)
+  std::vector<LCStepRecord> deposits;
+};
+
+// File layout (native byte order):
+//   header: char[8] "LCSTEPS", uint32 version, uint32 record size,
+//           float cell thickness (um), float field (V/um), float bias (V),
+//           uint32 configuration epoch (0 in files from before it was recorded)
+//   event:  uint32 event ID, uint32 number of deposits, float t0 (ns),
+//           then per deposit: float x, y, z (mm), float t (ns, step start), float edep (keV),
+//           float step length (mm), uint8 category
+// Version 1 files (no step length) are still read.
+//
+// One recorder per thread; each worker writes <run file base>_steps_t<thread>.lcs
+class LCStepRecorder {
+  public:
+    static LCStepRecorder* Instance();
+    ~LCStepRecorder();
+    
+    // Run boundaries - the file is only opened once the first event is written
+    void BeginRun(const G4String& baseName);
+    void EndRun();
+    
+    G4bool IsRecording() const { return fRecording; }
+    
+    void AddDeposit(const G4ThreeVector& position, G4double time, G4double edep,
+                    G4double length, std::uint8_t category);
+    void EndEvent(const G4Event* event);
+    
+    static std::uint8_t Categorize(const G4ParticleDefinition* particle);
+    static const char* CategoryName(std::uint8_t category);
+    static G4int CategoryFromName(const G4String& name);  // -1 if unknown
+    
+  private:
+    LCStepRecorder();
+    void OpenFile();
+    
+    static G4ThreadLocal LCStepRecorder* fInstance;
+    
+    G4bool fRecording;
+    G4String fBaseName;
+    G4String fFileName;
+    std::ofstream fFile;
+    std::vector<LCStepRecord> fDeposits;
+    G4int fEventsWritten;
+    
+    // Readout conditions at the start of the run, written to the header
+    G4double fCellThickness;
+    G4double fElectricField;
+    G4double fBias;
+    unsigned long fConfigEpoch;
+};
+
+// Sequential reader for step record files
+class LCStepReader {
+  public:
+    LCStepReader();
+    ~LCStepReader();
+    
+    G4bool Open(const G4String& fileName);
+    G4bool ReadEvent(LCRecordedEvent& event);
+    
+    // Header values, in Geant4 units
+    G4double GetCellThickness() const { return fCellThickness; }
+    G4double GetElectricField() const { return fElectricField; }
+    G4double GetBias() const { return fBias; }
+    unsigned long GetConfigEpoch() const { return fConfigEpoch; }
+    
+  private:
+    std::ifstream fFile;
+    std::uint32_t fVersion;
+    std::uint64_t fFileSize;           // Bounds the deposit counts read from the file
+    G4double fCellThickness;
+    G4double fElectricField;
+    G4double fBias;
+    unsigned long fConfigEpoch;
+};
+
+#endif
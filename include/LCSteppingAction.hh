@@ -4,10 +4,14 @@
 
 #include "G4UserSteppingAction.hh"
 #include "globals.hh"
-#include <vector>
+#include "G4ThreeVector.hh"
 
 class LCDetectorConstruction;
 class LCEventAction;
+class LCReadoutModel;
+class LCStepRecorder;
+class LCCondensation;
+class G4ParticleDefinition;
 
 class LCSteppingAction : public G4UserSteppingAction {
   public:
@@ -17,48 +21,36 @@ class LCSteppingAction : public G4UserSteppingAction {
     
     virtual void UserSteppingAction(const G4Step*);
     
+    // Takes the field, cell thickness and transport model published for the run (LCConfiguration)
+    void BeginRun();
+    
+    // Readout model used for LC cell deposits
+    LCReadoutModel* GetReadoutModel() const { return fReadoutModel; }
+    
+    // One energy deposit in the LC cell: charge model, step record, histograms.
+    // t0 starts the charge collection and is what the step record keeps, so a
+    // replay sees the same time; length is the step's track length (0 for
+    // deposits made in place).
+    void DepositInCell(G4double edep, const G4ThreeVector& position, G4double t0,
+                       G4double weight, const G4ParticleDefinition* particle,
+                       G4double length = 0.);
+    
   private:
     const LCDetectorConstruction* fDetConstruction;
     LCEventAction* fEventAction;
     
-    // Parameters for charge collection simulation
-    G4double fElectricField;        // Electric field strength
-    G4double fMobilityElectron;     // Electron mobility
-    G4double fMobilityIon;          // Ion mobility
-    G4double fRecombinationCoef;    // Recombination coefficient
-    G4double fCollectionEfficiency; // Charge collection efficiency
-    G4double fEnergyPerIonization;  // Energy required per ionization
+    // Charge collection and electrometer response
+    LCReadoutModel* fReadoutModel;
+    
+    // Deposit recording for offline replay (owned per thread, not by this action)
+    LCStepRecorder* fStepRecorder;
     
-    // For electrometer model
-    G4double fElectrometerResistance;  // Internal resistance of electrometer
-    G4double fElectrometerCapacitance; // Input capacitance 
-    G4double fElectrometerTimeConstant; // RC time constant
-    G4double fElectrometerSamplingRate; // Sampling rate in Hz
+    // Delta-electron condensation and its step counts (per thread)
+    LCCondensation* fCondensation;
     
     // Counters
     G4int fTotalElectrons;
     G4int fTotalIons;
-    
-    // Methods for charge collection calculation
-    G4int CalculateIonizationEvents(G4double energyDeposit);
-    G4double CalculateCharge(G4int numElectrons);
-    G4double CalculateCurrentPulse(G4int numCharges, G4double transitTime);
-    
-    // Enhanced methods for electrometer simulation
-    void SimulateElectrometerResponse(G4double charge, G4double transitTime);
-    G4double CalculateElectrometerCurrent(G4double charge, G4double time);
-    
-    // Structure to hold current pulses for detailed electrometer simulation
-    struct CurrentPulse {
-        G4double startTime;
-        G4double charge;
-        G4double duration;
-        
-        CurrentPulse(G4double t, G4double q, G4double d) 
-          : startTime(t), charge(q), duration(d) {}
-    };
-    
-    std::vector<CurrentPulse> fCurrentPulses;
 };
 
 #endif
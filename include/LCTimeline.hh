@@ -0,0 +1,110 @@
+// LCTimeline.hh - Continuous-beam electrometer trace merged in time order across events and threads
+#ifndef LCTimeline_h
+#define LCTimeline_h 1
+
+#include "globals.hh"
+#include "LCWaveformFile.hh"
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <set>
+#include <vector>
+
+class LCReadoutModel;
+
+// One instance per process, active for runs with /LC/timeline/rate > 0.
+// Event i arrives at a random time within its beam slot [i, i+1) / rate,
+// so the mean rate is exact and no charge of event i comes before i / rate.
+// At the end of each event a worker hands over the event's charge drifts
+// (LCReadoutModel) at that offset; each drift is a current step up at its
+// start and down at its end. The merge digitises the summed current in
+// fixed bins, through the electrometer's RC response, up to the start of
+// the lowest event not yet handed over. Events that are later than the
+// reorder window behind the newest one are no longer waited for; their
+// charge goes into the current bin and is counted as late.
+//
+// Memory is bounded by the pending steps (beam rate x longest drift) and
+// the out-of-order events within the window, not by the run length: the
+// trace is written in segments of kSegmentBins samples to
+// <run file base>_timeline.lcw (LCWaveformFile layout, one "event" per
+// segment), readable with LCWaveformDump.
+class LCTimeline {
+  public:
+    static LCTimeline* Instance();
+    
+    // Master (or sequential) begin and end of run; EndRun digitises the
+    // remaining steps and the decay of the reading, and closes the file
+    void BeginRun(const G4String& baseName, G4int runID);
+    void EndRun();
+    
+    // Any thread, end of event: the event's drifts, with a uniform random
+    // number placing the event within its beam slot
+    void AddEvent(G4int eventID, G4double slotFraction, const LCReadoutModel& model);
+    
+    // Results of the last run, for the report
+    G4double GetRate() const { return fRate; }
+    G4double GetBinWidth() const { return fBinWidth; }
+    G4double GetDuration() const { return fNextBin * fBinWidth; }
+    G4double GetMeanCurrent() const;
+    G4double GetPeakCurrent() const { return fPeakCurrent; }
+    std::uint64_t GetLateDrifts() const { return fLateDrifts; }
+    std::size_t GetPeakPendingSteps() const { return fPeakPendingSteps; }
+    const G4String& GetFileName() const { return fFileName; }
+    
+    // Samples per stored segment
+    static const std::uint32_t kSegmentBins = 4096;
+  
+  private:
+    LCTimeline();
+    
+    // Called with the mutex held
+    void Advance(G4double time);
+    void WriteBin(G4double current);
+    
+    static LCTimeline* fInstance;
+    
+    // Current step at a time of the trace: +I at a drift's start, -I at its end
+    struct Step {
+      G4double time;
+      G4double current;
+      G4bool operator>(const Step& other) const { return time > other.time; }
+    };
+    
+    std::mutex fMutex;
+    G4bool fActive;
+    
+    // Settings, fixed for the run
+    G4double fRate;
+    G4double fBinWidth;
+    G4double fWindow;
+    G4double fTimeConstant;    // from the first event's readout model
+    G4double fFilterGain;      // 1 - exp(-bin width / RC)
+    
+    // Merge state: lowest event not handed over yet, the ones after it that
+    // already were, and the latest arrival seen
+    G4int fNextEventID;
+    std::set<G4int> fEventsAhead;
+    G4double fLatestArrival;
+    G4double fLastStepTime;
+    std::priority_queue<Step, std::vector<Step>, std::greater<Step>> fSteps;
+    
+    // Digitiser: next bin, summed drift current, electrometer reading
+    std::uint64_t fNextBin;
+    G4double fInputCurrent;
+    G4double fReading;
+    std::mt19937_64 fNoiseEngine;
+    std::normal_distribution<G4double> fNoise;
+    
+    G4String fFileName;
+    LCWaveformWriter fWriter;
+    
+    // Run totals
+    G4double fSumReading;
+    G4double fPeakCurrent;
+    std::uint64_t fLateDrifts;
+    std::size_t fPeakPendingSteps;
+};
+
+#endif
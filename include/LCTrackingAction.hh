@@ -0,0 +1,29 @@
+// LCTrackingAction.hh - Collects the weight changes of every track into the event weight (biasing)
+#ifndef LCTrackingAction_h
+#define LCTrackingAction_h 1
+
+#include "G4UserTrackingAction.hh"
+#include "globals.hh"
+
+class LCEventAction;
+
+// Cross-section biasing changes a track's weight along its path (survival)
+// and at its interactions. The ratio of a track's final to its initial
+// weight is its own share of the event's likelihood ratio (secondaries start
+// with the weight of their parent at creation), so the product over all
+// tracks is the weight of the whole history. The event action uses it for
+// events without an LC cell deposit.
+class LCTrackingAction : public G4UserTrackingAction {
+  public:
+    explicit LCTrackingAction(LCEventAction* eventAction);
+    virtual ~LCTrackingAction();
+    
+    virtual void PreUserTrackingAction(const G4Track* track);
+    virtual void PostUserTrackingAction(const G4Track* track);
+    
+  private:
+    LCEventAction* fEventAction;
+    G4double fStartWeight;
+};
+
+#endif
@@ -0,0 +1,86 @@
+// LCTransportTables.hh - Precomputed drift, trapping and recombination tables for the LC cell readout
+#ifndef LCTransportTables_h
+#define LCTransportTables_h 1
+
+#include "globals.hh"
+#include <vector>
+
+// Everything the tables depend on. Tables are built once per distinct set.
+struct LCTransportParameters {
+  G4double cellThickness = 0.;
+  G4double mobilityElectron = 0.;          // Low-field mobilities
+  G4double mobilityIon = 0.;
+  G4double saturationVelocityElectron = 0.; // Drift velocity limit, 0 = none
+  G4double saturationVelocityIon = 0.;
+  G4double recombinationCoef = 0.;         // 0 = Langevin value from the mobilities
+  G4double intrinsicIonDensity = 0.;       // Free ions of the LC itself (volume recombination)
+  G4double columnRadius = 0.;              // Initial radius of the ionisation column
+  G4double relativePermittivity = 1.;
+  
+  G4bool operator==(const LCTransportParameters& other) const;
+};
+
+// Transport of one deposit's charge
+struct LCTransportLookup {
+  G4double electronTransit;     // Drift time to the anode / cathode
+  G4double ionTransit;
+  G4double electronCollection;  // Charge induced by the drifting electrons / ions,
+  G4double ionCollection;       // as fraction of the pairs that escape recombination
+  G4double escape;              // Fraction of pairs escaping columnar recombination
+};
+
+// Drift velocities follow v = mu E / (1 + mu E / v_sat). Pairs escape
+// columnar recombination with 1 / (1 + alpha n tau), n the pair density in
+// the column and tau the time the field takes to pull the column apart, so
+// dense deposits and low fields lose more charge. While drifting, carriers
+// recombine with the LC's intrinsic ions (lifetime 1 / (alpha n0)), and the
+// induced charge follows the Hecht relation over the remaining drift length.
+//
+// Transit times and collected fractions are tabulated over depth x field,
+// the escape fraction over field x linear pair density, both with
+// log-spaced field and density axes, so a deposit costs two bilinear
+// lookups instead of the model evaluation.
+class LCTransportTables {
+  public:
+    // Tables for a parameter set, built on first use and shared read-only
+    // by all threads for the rest of the session
+    static const LCTransportTables* Get(const LCTransportParameters& parameters);
+    
+    const LCTransportParameters& GetParameters() const { return fParameters; }
+    
+    // Position of a field on the field axis; computed once per field and
+    // passed to Lookup for every deposit
+    G4double FieldCoordinate(G4double field) const;
+    
+    // Deposit at y across the cell (anode at +thickness/2) with the given
+    // number of pairs per unit track length (0 if unknown: no columnar loss)
+    LCTransportLookup Lookup(G4double y, G4double fieldCoordinate, G4double pairDensity) const;
+    
+    // The model itself, as tabulated (for checks of the interpolation)
+    LCTransportLookup Evaluate(G4double y, G4double field, G4double pairDensity) const;
+    
+    // Table axes
+    static const G4int kDepthNodes = 65;
+    static const G4int kFieldNodes = 121;     // 1e-3 - 1e3 V/um, 20 per decade
+    static const G4int kDensityNodes = 71;    // 0.1 - 1e6 pairs/um, 10 per decade
+  
+  private:
+    explicit LCTransportTables(const LCTransportParameters& parameters);
+    
+    G4double DriftVelocity(G4double mobility, G4double saturation, G4double field) const;
+    G4double Escape(G4double field, G4double pairDensity) const;
+    
+    LCTransportParameters fParameters;
+    G4double fRecombinationCoef;   // resolved (Langevin if not set)
+    
+    // Depth tables, field-major: [field * kDepthNodes + depth]
+    std::vector<G4double> fElectronTransit;
+    std::vector<G4double> fIonTransit;
+    std::vector<G4double> fElectronCollection;
+    std::vector<G4double> fIonCollection;
+    
+    // Escape fraction, field-major: [field * kDensityNodes + density]
+    std::vector<G4double> fEscape;
+};
+
+#endif
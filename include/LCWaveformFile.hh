@@ -0,0 +1,137 @@
+// LCWaveformFile.hh - Compressed binary stream of per-event electrometer waveforms with an event index
+#ifndef LCWaveformFile_h
+#define LCWaveformFile_h 1
+
+// Plain C++ (no Geant4 types), so the LCWaveformDump tool builds without Geant4
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// One electrometer sample, in file units
+struct LCWaveformSample {
+  double time;      // ns
+  double current;   // pA
+};
+
+// One event's waveform, samples in the order they were written
+struct LCWaveformEvent {
+  std::uint32_t eventID = 0;
+  std::vector<LCWaveformSample> samples;
+};
+
+// Quantisation and provenance, written once per file
+struct LCWaveformHeader {
+  double timeStep = 0.001;       // ns per time tick
+  double currentStep = 0.001;    // pA per current tick
+  std::uint32_t configEpoch = 0;
+  std::uint32_t threadID = 0;
+};
+
+// Where an event is stored
+struct LCWaveformIndexEntry {
+  std::uint32_t eventID;
+  std::uint32_t samples;
+  std::uint64_t blockOffset;     // file offset of the block header
+  std::uint32_t eventOffset;     // offset in the uncompressed block
+};
+
+// File layout (native byte order):
+//   header: char[8] "LCWAVES", uint32 version, uint32 reserved,
+//           double time step (ns), double current step (pA),
+//           uint32 configuration epoch, uint32 thread
+//   block:  uint32 raw size, uint32 stored size, uint32 number of events,
+//           then the stored bytes - LZ77-compressed, or the raw bytes when
+//           compression does not make them smaller (stored size == raw size)
+//   index:  per event uint32 event ID, uint32 samples, uint64 block offset,
+//           uint32 offset in block, uint32 reserved
+//   tail:   uint64 index offset, uint64 number of events, char[8] "LCWINDEX"
+//
+// Inside a block an event is a varint event ID and sample count, followed
+// per sample by the zigzag varint differences to the previous sample of the
+// time and current, both rounded to whole ticks. Sorted times and slowly
+// varying currents thus take one or two bytes each before compression.
+// A file without the index (a run that did not finish) is read by scanning
+// its blocks.
+class LCWaveformWriter {
+  public:
+    LCWaveformWriter();
+    ~LCWaveformWriter();
+    
+    // False (with a message) if the file could not be created
+    bool Open(const std::string& fileName, const LCWaveformHeader& header, std::string* error = nullptr);
+    bool IsOpen() const { return fFile.is_open(); }
+    
+    // Samples of one event are added between BeginEvent and EndEvent
+    void BeginEvent(std::uint32_t eventID);
+    void AddSample(double timeNs, double currentPA);
+    void EndEvent();
+    
+    // Writes the last block and the index; false if any write failed
+    bool Close();
+    
+    std::uint64_t GetEventsWritten() const { return fIndex.size(); }
+    std::uint64_t GetRawBytes() const { return fRawBytes; }      // encoded, before compression
+    std::uint64_t GetFileBytes() const { return fFileBytes; }
+    
+    // Allocated size of the block and event buffers
+    std::size_t GetBufferBytes() const {
+      return fBlock.capacity() + fCompressed.capacity() + fEventBuffer.capacity();
+    }
+    
+    // Uncompressed size a block is flushed at (events are never split)
+    static const std::size_t kBlockSize = 64 * 1024;
+  
+  private:
+    void FlushBlock();
+    
+    std::ofstream fFile;
+    LCWaveformHeader fHeader;
+    std::vector<unsigned char> fBlock;
+    std::vector<unsigned char> fCompressed;
+    std::vector<LCWaveformIndexEntry> fIndex;
+    std::size_t fBlockFirstEvent;
+    std::uint64_t fRawBytes;
+    std::uint64_t fFileBytes;
+    
+    // Event being written: its count is only known at EndEvent
+    std::vector<unsigned char> fEventBuffer;
+    std::uint32_t fEventID;
+    std::uint32_t fEventSamples;
+    std::int64_t fLastTime;
+    std::int64_t fLastCurrent;
+};
+
+// Random-access reader: the index is loaded (or rebuilt) on Open
+class LCWaveformReader {
+  public:
+    bool Open(const std::string& fileName, std::string* error = nullptr);
+    
+    const LCWaveformHeader& GetHeader() const { return fHeader; }
+    const std::vector<LCWaveformIndexEntry>& GetIndex() const { return fIndex; }
+    std::size_t GetNumberOfEvents() const { return fIndex.size(); }
+    bool HasStoredIndex() const { return fStoredIndex; }
+    
+    // Event by position in the file, or by event ID (false if absent)
+    bool ReadEvent(std::size_t position, LCWaveformEvent& event);
+    bool FindEvent(std::uint32_t eventID, LCWaveformEvent& event);
+  
+  private:
+    bool LoadBlock(std::uint64_t offset);
+    bool ScanBlocks(std::uint64_t end);
+    
+    std::ifstream fFile;
+    LCWaveformHeader fHeader;
+    std::vector<LCWaveformIndexEntry> fIndex;
+    bool fStoredIndex = false;
+    std::uint64_t fFileSize = 0;       // Bounds the sizes and counts read from the file
+    
+    // Last block read, kept for neighbouring events
+    std::vector<unsigned char> fBlock;
+    std::vector<unsigned char> fStored;
+    std::uint64_t fBlockOffset = UINT64_MAX;
+};
+
+#endif
@@ -0,0 +1,43 @@
+// LCWaveformRecorder.hh - Per-thread writer of the compressed electrometer waveform stream
+#ifndef LCWaveformRecorder_h
+#define LCWaveformRecorder_h 1
+
+#include "globals.hh"
+#include "LCWaveformFile.hh"
+#include "G4SystemOfUnits.hh"
+
+// One recorder per thread; each worker writes <run file base>_waveforms_t<thread>.lcw
+// (layout in LCWaveformFile.hh). The file is opened with the first event,
+// so threads that simulate nothing leave no file behind.
+class LCWaveformRecorder {
+  public:
+    static LCWaveformRecorder* Instance();
+    ~LCWaveformRecorder();
+    
+    // Run boundaries; EndRun writes the index and closes the file
+    void BeginRun(const G4String& baseName);
+    void EndRun();
+    
+    G4bool IsRecording() const { return fRecording; }
+    
+    // One event's samples, in time order, between BeginEvent and EndEvent.
+    // BeginEvent is false (and recording stops) if the file cannot be opened.
+    G4bool BeginEvent(G4int eventID);
+    void AddSample(G4double time, G4double current) {
+      fWriter.AddSample(time/ns, current/(1.0e-12*ampere));
+    }
+    void EndEvent();
+  
+  private:
+    LCWaveformRecorder();
+    
+    static G4ThreadLocal LCWaveformRecorder* fInstance;
+    
+    G4bool fRecording;
+    G4String fBaseName;
+    G4String fFileName;
+    LCWaveformHeader fHeader;
+    LCWaveformWriter fWriter;
+};
+
+#endif
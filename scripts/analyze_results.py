@@ -3,6 +3,7 @@
 import os
 import re
 import glob
+import json
 import numpy as np
 import matplotlib.pyplot as plt
 import pandas as pd
@@ -23,12 +24,38 @@ except ImportError:
 RESULTS_DIR = "results"
 
 def extract_energy_from_dirname(dirname):
-    """Extract energy value (in MeV) from directory name like 'energy_500MeV'"""
-    match = re.search(r'energy_(\d+)MeV', os.path.basename(dirname))
+    """Extract energy value (in MeV) from directory name like 'energy_500MeV'
+    or 'proton_500MeV' (LCSweep)"""
+    match = re.search(r'_([0-9.]+)MeV$', os.path.basename(dirname.rstrip(os.sep)))
     if match:
         return float(match.group(1))
     return None
 
+def extract_data_from_summaries(summary_files):
+    """Extract average and peak current from the run summaries (*_summary.json)
+    written by the simulation. Several files (MPI ranks) are combined with
+    their sums of event weights."""
+    totals = {"AvgCurrent": 0.0, "PeakCurrent": 0.0}
+    sum_weights = 0.0
+    for summary_file in summary_files:
+        try:
+            with open(summary_file, 'r') as f:
+                summary = json.load(f)
+            weight = summary["sum_weights"]
+            observables = summary["observables"]
+            means = {name: observables[name]["mean"] for name in totals}
+        except (OSError, ValueError, KeyError, TypeError):
+            continue
+        if weight is None or any(mean is None for mean in means.values()):
+            continue
+        for name in totals:
+            totals[name] += weight * means[name]
+        sum_weights += weight
+    
+    if sum_weights <= 0:
+        return None, None
+    return totals["AvgCurrent"] / sum_weights, totals["PeakCurrent"] / sum_weights
+
 def extract_data_from_root(root_file):
     """Extract average and peak current from ROOT file"""
     if not has_root:
@@ -72,12 +99,15 @@ def extract_data_from_root(root_file):
         if not avg_branch or not peak_branch:
             return None, None
         
+        # Event weights from cross-section biasing, if present
+        weight = "Weight" if "Weight" in branches else ""
+        
         # Create temporary histograms for faster data extraction
         h_avg = ROOT.TH1F("h_avg", "avg", 1000, 0, 1000)
         h_peak = ROOT.TH1F("h_peak", "peak", 1000, 0, 1000)
         
-        tree.Draw(f"{avg_branch}>>h_avg", "", "goff")
-        tree.Draw(f"{peak_branch}>>h_peak", "", "goff")
+        tree.Draw(f"{avg_branch}>>h_avg", weight, "goff")
+        tree.Draw(f"{peak_branch}>>h_peak", weight, "goff")
         
         avg_current = h_avg.GetMean()
         peak_current = h_peak.GetMean()
@@ -142,8 +172,13 @@ def process_energy_directory(dir_path):
     avg_current = None
     peak_current = None
     
-    # Try ROOT files first
-    if has_root:
+    # Run summaries first: no per-event data has to be read
+    summary_files = glob.glob(os.path.join(dir_path, "*_summary.json"))
+    if summary_files:
+        avg_current, peak_current = extract_data_from_summaries(summary_files)
+    
+    # Then ROOT files
+    if has_root and (avg_current is None or peak_current is None):
         root_files = glob.glob(os.path.join(dir_path, "*.root"))
         if root_files:
             avg_current, peak_current = extract_data_from_root(root_files[0])
@@ -175,8 +210,9 @@ def generate_sample_data(energy_points=12):
 def main():
     print("Analyzing 5CB Liquid Crystal Detector simulation results...")
     
-    # Find all energy directories
-    energy_dirs = glob.glob(os.path.join(RESULTS_DIR, "energy_*MeV"))
+    # Find all energy directories (energy_<E>MeV, or <particle>_<E>MeV from LCSweep)
+    energy_dirs = [d for d in glob.glob(os.path.join(RESULTS_DIR, "*_*MeV"))
+                   if os.path.isdir(d) and extract_energy_from_dirname(d) is not None]
     
     if not energy_dirs:
         print(f"No energy directories found in {RESULTS_DIR}")
@@ -15,6 +15,11 @@ fi
 RESULTS_DIR="$(pwd)/results"
 mkdir -p "$RESULTS_DIR"
 
+# Result cache shared by all sweep points - a point is only re-simulated when
+# its configuration (beam, bias, physics, code version...) or event count changes
+CACHE_DIR="${RESULTS_DIR}/cache"
+mkdir -p "$CACHE_DIR"
+
 # Default settings
 MIN_ENERGY=10    # Starting energy in MeV
 MAX_ENERGY=20000   # Maximum energy in MeV
@@ -129,12 +134,6 @@ run_simulation() {
     local energy=$1
     local energy_dir="${RESULTS_DIR}/energy_${energy}MeV"
     
-    # Check if directory already exists (result may already exist)
-    if [ -d "$energy_dir" ] && [ -f "${energy_dir}/LC_${PARTICLE_TYPE}_${energy}MeV.root" ]; then
-        echo "Simulation for $energy MeV already exists, skipping."
-        return
-    fi
-    
     # Create directory for this energy
     mkdir -p "$energy_dir"
     
@@ -146,7 +145,9 @@ run_simulation() {
 /LC/beam/energy $energy MeV
 # Now start the run with the correct parameters
 /run/initialize
-/run/beamOn $NUM_EVENTS
+# Reuse cached results for an identical configuration
+/LC/cache/dir $CACHE_DIR
+/LC/cache/beamOn $NUM_EVENTS
 EOF
     
     # Run the simulation from its original directory
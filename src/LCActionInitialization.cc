@@ -4,19 +4,27 @@
 #include "LCRunAction.hh"
 #include "LCEventAction.hh"
 #include "LCSteppingAction.hh"
+#include "LCStackingAction.hh"
+#include "LCTrackingAction.hh"
 #include "LCDetectorConstruction.hh"
 #include "LCMessenger.hh"
+#include "LCHistograms.hh"
+#include "LCMPIManager.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
 
 LCActionInitialization::LCActionInitialization(const LCDetectorConstruction* detConstruction)
  : G4VUserActionInitialization(),
    fDetConstruction(detConstruction),
    fParticleName("proton"),
-   fParticleEnergy(0.5*GeV)
+   fParticleEnergy(0.5*GeV),
+   fMessenger(nullptr)
 {}
 
 LCActionInitialization::~LCActionInitialization()
-{}
+{
+  delete fMessenger;
+}
 
 void LCActionInitialization::BuildForMaster() const
 {
@@ -25,6 +33,16 @@ void LCActionInitialization::BuildForMaster() const
   runAction->SetParticleName(fParticleName);
   runAction->SetParticleEnergy(fParticleEnergy);
   SetUserAction(runAction);
+  
+  // Messenger for the master thread - handles the commands that must not be
+  // broadcast to the workers (bias on the shared detector, result cache)
+  delete fMessenger;
+  fMessenger = new LCMessenger(runAction, const_cast<LCDetectorConstruction*>(fDetConstruction));
+  
+  // MPI runs: rank 0's master exports the histograms summed over all ranks
+  if (LCMPIManager::Instance()->IsActive()) {
+    LCHistograms::Book();
+  }
 }
 
 void LCActionInitialization::Build() const
@@ -41,16 +59,25 @@ void LCActionInitialization::Build() const
   runAction->SetParticleEnergy(fParticleEnergy);
   SetUserAction(runAction);
   
-  // Create messenger to allow run-time changes to beam parameters
-  // Pass the detector construction as well for bias voltage control
-  // This will be deleted automatically by G4
-  new LCMessenger(primaryGenerator, runAction, const_cast<LCDetectorConstruction*>(fDetConstruction));
+  // Sequential mode: the messenger for run-time changes to beam and detector
+  // parameters. In MT mode it lives on the master (BuildForMaster) and the
+  // workers read the configuration it publishes.
+  if (!G4Threading::IsWorkerThread()) {
+    delete fMessenger;
+    fMessenger = new LCMessenger(runAction, const_cast<LCDetectorConstruction*>(fDetConstruction));
+  }
   
   // Event action
-  auto eventAction = new LCEventAction();
+  auto eventAction = new LCEventAction(runAction);
   SetUserAction(eventAction);
   
   // Stepping action - now passes detector construction to access detector parameters
   auto steppingAction = new LCSteppingAction(fDetConstruction, eventAction);
   SetUserAction(steppingAction);
+  
+  // Stacking action - deposits low-energy delta electrons in the LC cell in place
+  SetUserAction(new LCStackingAction(steppingAction));
+  
+  // Tracking action - the event weight of events without a deposit (biasing)
+  SetUserAction(new LCTrackingAction(eventAction));
 }
@@ -0,0 +1,58 @@
+// LCAliasTable.cc - Walker alias table for O(1) sampling of discrete distributions
+#include "LCAliasTable.hh"
+#include "Randomize.hh"
+
+LCAliasTable::LCAliasTable()
+{
+}
+
+LCAliasTable::~LCAliasTable()
+{
+}
+
+G4bool LCAliasTable::Build(const std::vector<G4double>& weights) {
+  fProbability.clear();
+  fAlias.clear();
+  
+  G4double sum = 0.;
+  for (G4double w : weights) {
+    if (w > 0.) sum += w;
+  }
+  if (sum <= 0.) return false;
+  
+  // Vose's method: scale to mean 1, then pair each under-full bin with an
+  // over-full one that donates the rest of its probability
+  G4int n = static_cast<G4int>(weights.size());
+  fProbability.resize(n);
+  fAlias.resize(n);
+  std::vector<G4double> scaled(n);
+  std::vector<G4int> small, large;
+  for (G4int i = 0; i < n; i++) {
+    scaled[i] = (weights[i] > 0. ? weights[i] : 0.) * n / sum;
+    if (scaled[i] < 1.0) small.push_back(i);
+    else large.push_back(i);
+  }
+  
+  while (!small.empty() && !large.empty()) {
+    G4int s = small.back(); small.pop_back();
+    G4int l = large.back(); large.pop_back();
+    fProbability[s] = scaled[s];
+    fAlias[s] = l;
+    scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+    if (scaled[l] < 1.0) small.push_back(l);
+    else large.push_back(l);
+  }
+  
+  // Leftovers are full up to rounding
+  for (G4int i : large) { fProbability[i] = 1.0; fAlias[i] = i; }
+  for (G4int i : small) { fProbability[i] = 1.0; fAlias[i] = i; }
+  return true;
+}
+
+G4int LCAliasTable::Sample() const {
+  G4int n = static_cast<G4int>(fProbability.size());
+  G4double u = G4UniformRand() * n;
+  G4int i = static_cast<G4int>(u);
+  if (i >= n) i = n - 1;
+  return (u - i) < fProbability[i] ? i : fAlias[i];
+}
@@ -0,0 +1,51 @@
+// LCAllocationCounter.cc - Heap allocation counter for debug builds
+#include "LCAllocationCounter.hh"
+
+#ifdef LC_COUNT_ALLOCATIONS
+
+#include "globals.hh"
+#include <cstdlib>
+#include <new>
+
+namespace {
+  G4ThreadLocal std::size_t allocationCount = 0;
+}
+
+std::size_t LCAllocationCounter::GetCount() {
+  return allocationCount;
+}
+
+// Replacements for the global allocation functions; the array and nothrow
+// forms forward to these
+void* operator new(std::size_t size) {
+  allocationCount++;
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  allocationCount++;
+  // aligned_alloc wants a multiple of the alignment
+  std::size_t align = static_cast<std::size_t>(alignment);
+  std::size_t rounded = ((size ? size : 1) + align - 1) / align * align;
+  if (void* p = std::aligned_alloc(align, rounded)) return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+#endif
@@ -0,0 +1,102 @@
+// LCBiasingOperator.cc - Cross-section biasing of neutral particles in the LC cell and electrodes
+#include "LCBiasingOperator.hh"
+#include "LCConfiguration.hh"
+#include "G4BOptnChangeCrossSection.hh"
+#include "G4BiasingProcessInterface.hh"
+#include "G4BiasingProcessSharedData.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4Gamma.hh"
+#include "G4Neutron.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+
+LCBiasingOperator::LCBiasingOperator()
+: G4VBiasingOperator("LCBiasingOperator"),
+  fSetup(true),
+  fCurrentFactor(1.0)
+{
+}
+
+LCBiasingOperator::~LCBiasingOperator()
+{
+  for (auto& entry : fChangeCrossSectionOperations) {
+    delete entry.second;
+  }
+}
+
+void LCBiasingOperator::StartRun() {
+  // The wrapped processes are known only once the physics list is built
+  if (fSetup) {
+    SetupOperations(G4Gamma::Definition());
+    SetupOperations(G4Neutron::Definition());
+    fSetup = false;
+  }
+}
+
+void LCBiasingOperator::SetupOperations(const G4ParticleDefinition* particle) {
+  const G4BiasingProcessSharedData* sharedData =
+    G4BiasingProcessInterface::GetSharedData(particle->GetProcessManager());
+  if (!sharedData) return;
+  
+  for (const auto* wrapperProcess : sharedData->GetPhysicsBiasingProcessInterfaces()) {
+    G4String operationName = "XSchange-" + wrapperProcess->GetWrappedProcess()->GetProcessName();
+    fChangeCrossSectionOperations[wrapperProcess] = new G4BOptnChangeCrossSection(operationName);
+  }
+}
+
+void LCBiasingOperator::StartTracking(const G4Track* track) {
+  if (fSetup) StartRun();
+  
+  // Settings may change between runs - pick them up per track
+  const LCConfigSnapshot* config = LCConfiguration::ForRun();
+  fCurrentFactor = 1.0;
+  if (!config->biasingEnabled) return;
+  
+  const G4ParticleDefinition* particle = track->GetDefinition();
+  if (particle == G4Gamma::Definition()) {
+    fCurrentFactor = config->gammaBiasFactor;
+  } else if (particle == G4Neutron::Definition()) {
+    fCurrentFactor = config->neutronBiasFactor;
+  }
+}
+
+G4VBiasingOperation* LCBiasingOperator::ProposeOccurenceBiasingOperation(
+  const G4Track*, const G4BiasingProcessInterface* callingProcess) {
+  if (fCurrentFactor == 1.0) return nullptr;
+  
+  // Processes that cannot occur at this energy are left alone
+  G4double analogInteractionLength = callingProcess->GetWrappedProcess()->GetCurrentInteractionLength();
+  if (analogInteractionLength > DBL_MAX/10.) return nullptr;
+  G4double analogXS = 1./analogInteractionLength;
+  
+  auto it = fChangeCrossSectionOperations.find(callingProcess);
+  if (it == fChangeCrossSectionOperations.end()) return nullptr;
+  G4BOptnChangeCrossSection* operation = it->second;
+  
+  // Sample a new interaction length after an interaction or on the first
+  // step in the volume; otherwise carry the remaining one over with the
+  // updated cross section
+  G4VBiasingOperation* previousOperation = callingProcess->GetPreviousOccurenceBiasingOperation();
+  if (previousOperation != operation || operation->GetInteractionOccured()) {
+    operation->SetBiasedCrossSection(fCurrentFactor * analogXS);
+    operation->Sample();
+  } else {
+    operation->UpdateForStep(callingProcess->GetPreviousStepSize());
+    operation->SetBiasedCrossSection(fCurrentFactor * analogXS);
+    operation->UpdateForStep(0.0);
+  }
+  
+  return operation;
+}
+
+void LCBiasingOperator::OperationApplied(const G4BiasingProcessInterface* callingProcess,
+                                         G4BiasingAppliedCase,
+                                         G4VBiasingOperation* occurenceOperationApplied,
+                                         G4double,
+                                         G4VBiasingOperation*,
+                                         const G4VParticleChange*) {
+  auto it = fChangeCrossSectionOperations.find(callingProcess);
+  if (it != fChangeCrossSectionOperations.end() && it->second == occurenceOperationApplied) {
+    it->second->SetInteractionOccured();
+  }
+}
@@ -0,0 +1,398 @@
+// LCCampaignStore.cc - Append-only store of finished runs with an index for campaign queries
+#include "LCCampaignStore.hh"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <limits>
+#include <sstream>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+  const char kLogName[] = "runs.log";
+  const char kIndexName[] = "runs.idx";
+  const char kIndexMagic[8] = { 'L', 'C', 'I', 'D', 'X', '0', '0', '1' };
+  
+  // Index entry per log line (native byte order; the store is local)
+  struct IndexEntry {
+    std::uint64_t offset;
+    std::uint32_t length;        // including the newline
+    std::uint32_t reserved;
+    std::uint64_t particleHash;
+    std::uint64_t physicsHash;
+    double energyMeV;
+    double biasV;
+    std::int64_t seed;
+    std::uint64_t lineHash;      // detects an index that no longer matches the log
+  };
+  static_assert(sizeof(IndexEntry) == 64, "index entries are 64 bytes");
+  
+  // 64-bit FNV-1a
+  std::uint64_t Hash(const char* data, std::size_t size) {
+    std::uint64_t hash = 1469598103934665603ULL;
+    for (std::size_t i = 0; i < size; i++) {
+      hash ^= static_cast<unsigned char>(data[i]);
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+  std::uint64_t Hash(const std::string& text) { return Hash(text.data(), text.size()); }
+  
+  // Tabs and newlines would break the line format
+  std::string Sanitize(const std::string& text) {
+    std::string clean = text;
+    for (char& c : clean) {
+      if (c == '\t' || c == '\n' || c == '\r') c = ' ';
+    }
+    return clean;
+  }
+  
+  std::string FormatNumber(double value) {
+    std::ostringstream out;
+    out.precision(10);
+    out << value;
+    return out.str();
+  }
+  
+  IndexEntry MakeEntry(const LCCampaignRecord& record, std::uint64_t offset, const std::string& line) {
+    IndexEntry entry;
+    entry.offset = offset;
+    entry.length = static_cast<std::uint32_t>(line.size() + 1);
+    entry.reserved = 0;
+    entry.particleHash = Hash(record.Get("particle"));
+    entry.physicsHash = Hash(record.Get("physics"));
+    entry.energyMeV = record.GetDouble("energy_MeV");
+    entry.biasV = record.GetDouble("bias_V");
+    entry.seed = std::atol(record.Get("seed").c_str());
+    entry.lineHash = Hash(line);
+    return entry;
+  }
+  
+  // Full-record check, also for hash collisions and the unindexed log tail
+  bool Matches(const LCCampaignRecord& record, const LCCampaignQuery& query) {
+    if (!query.particle.empty() && record.Get("particle") != query.particle) return false;
+    if (!query.physics.empty() && record.Get("physics") != query.physics) return false;
+    if (query.hasEnergy) {
+      double energy = record.GetDouble("energy_MeV");
+      if (!(energy >= query.energyMinMeV && energy <= query.energyMaxMeV)) return false;
+    }
+    if (query.hasBias) {
+      double bias = record.GetDouble("bias_V");
+      if (!(bias >= query.biasMinV && bias <= query.biasMaxV)) return false;
+    }
+    if (query.hasSeed && std::atol(record.Get("seed").c_str()) != query.seed) return false;
+    return true;
+  }
+  
+  // Cheap pre-selection on the index entry alone
+  bool Matches(const IndexEntry& entry, const LCCampaignQuery& query,
+               std::uint64_t particleHash, std::uint64_t physicsHash) {
+    if (!query.particle.empty() && entry.particleHash != particleHash) return false;
+    if (!query.physics.empty() && entry.physicsHash != physicsHash) return false;
+    if (query.hasEnergy && !(entry.energyMeV >= query.energyMinMeV && entry.energyMeV <= query.energyMaxMeV)) return false;
+    if (query.hasBias && !(entry.biasV >= query.biasMinV && entry.biasV <= query.biasMaxV)) return false;
+    if (query.hasSeed && entry.seed != query.seed) return false;
+    return true;
+  }
+  
+  // Holds an flock for its lifetime
+  class FileLock {
+    public:
+      FileLock(int fd, int operation) : fFd(fd) {
+        while (flock(fFd, operation) != 0 && errno == EINTR) {}
+      }
+      ~FileLock() { flock(fFd, LOCK_UN); }
+    private:
+      int fFd;
+  };
+  
+  bool ReadAt(int fd, std::uint64_t offset, std::size_t size, std::string& data) {
+    data.resize(size);
+    std::size_t done = 0;
+    while (done < size) {
+      ssize_t n = pread(fd, &data[done], size - done, static_cast<off_t>(offset + done));
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) return false;
+      done += static_cast<std::size_t>(n);
+    }
+    return true;
+  }
+  
+  bool WriteAll(int fd, const char* data, std::size_t size) {
+    std::size_t done = 0;
+    while (done < size) {
+      ssize_t n = write(fd, data + done, size - done);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) return false;
+      done += static_cast<std::size_t>(n);
+    }
+    return true;
+  }
+  
+  std::uint64_t FileSize(int fd) {
+    struct stat info;
+    return fstat(fd, &info) == 0 ? static_cast<std::uint64_t>(info.st_size) : 0;
+  }
+  
+  // Complete lines of the log in [from, to), with their offsets
+  template <typename Callback>
+  void ScanLog(int fd, std::uint64_t from, std::uint64_t to, Callback callback) {
+    const std::size_t kChunk = 1 << 20;
+    std::string pending;
+    std::uint64_t pendingOffset = from;
+    std::string chunk;
+    for (std::uint64_t position = from; position < to; ) {
+      std::size_t size = static_cast<std::size_t>(std::min<std::uint64_t>(kChunk, to - position));
+      if (!ReadAt(fd, position, size, chunk)) return;
+      position += size;
+      pending += chunk;
+      std::size_t start = 0;
+      for (std::size_t end; (end = pending.find('\n', start)) != std::string::npos; start = end + 1) {
+        callback(pendingOffset + start, pending.substr(start, end - start));
+      }
+      pendingOffset += start;
+      pending.erase(0, start);
+    }
+    // A trailing line without newline is an unfinished write: ignored
+  }
+  
+  // Entries of a valid index (none if missing or corrupt)
+  std::vector<IndexEntry> ReadIndex(const std::string& path) {
+    std::vector<IndexEntry> entries;
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return entries;
+    std::uint64_t size = FileSize(fd);
+    std::string data;
+    if (size >= sizeof(kIndexMagic) && ReadAt(fd, 0, static_cast<std::size_t>(size), data) &&
+        std::memcmp(data.data(), kIndexMagic, sizeof(kIndexMagic)) == 0) {
+      // A partly written last entry is dropped
+      std::size_t count = (data.size() - sizeof(kIndexMagic)) / sizeof(IndexEntry);
+      entries.resize(count);
+      if (count > 0) std::memcpy(entries.data(), data.data() + sizeof(kIndexMagic), count * sizeof(IndexEntry));
+    }
+    close(fd);
+    return entries;
+  }
+  
+  // End of the log covered by the index
+  std::uint64_t CoveredEnd(const std::vector<IndexEntry>& entries) {
+    return entries.empty() ? 0 : entries.back().offset + entries.back().length;
+  }
+  
+  // Index entries for every line of the log (called with the log locked).
+  // Lines that do not parse get an entry too, so the index covers the log.
+  std::vector<IndexEntry> IndexLog(int logFd, std::uint64_t logSize) {
+    std::vector<IndexEntry> entries;
+    ScanLog(logFd, 0, logSize, [&](std::uint64_t offset, const std::string& line) {
+      LCCampaignRecord record;
+      LCCampaignRecord::FromLine(line, record);
+      entries.push_back(MakeEntry(record, offset, line));
+    });
+    return entries;
+  }
+  
+  // Replaces the index atomically (called with the log locked exclusively)
+  bool WriteIndex(const std::string& path, const std::vector<IndexEntry>& entries) {
+    std::string temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    bool ok = WriteAll(fd, kIndexMagic, sizeof(kIndexMagic)) &&
+              WriteAll(fd, reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(IndexEntry));
+    close(fd);
+    if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+      unlink(temporary.c_str());
+      return false;
+    }
+    return true;
+  }
+}
+
+void LCCampaignRecord::Set(const std::string& key, const std::string& value) {
+  std::string cleanKey = Sanitize(key);
+  std::string cleanValue = Sanitize(value);
+  for (auto& field : fFields) {
+    if (field.first == cleanKey) { field.second = cleanValue; return; }
+  }
+  fFields.emplace_back(cleanKey, cleanValue);
+}
+
+void LCCampaignRecord::Set(const std::string& key, double value) {
+  Set(key, std::isfinite(value) ? FormatNumber(value) : std::string("nan"));
+}
+
+void LCCampaignRecord::Set(const std::string& key, long value) {
+  Set(key, std::to_string(value));
+}
+
+std::string LCCampaignRecord::Get(const std::string& key) const {
+  for (const auto& field : fFields) {
+    if (field.first == key) return field.second;
+  }
+  return "";
+}
+
+double LCCampaignRecord::GetDouble(const std::string& key) const {
+  std::string value = Get(key);
+  if (value.empty()) return std::numeric_limits<double>::quiet_NaN();
+  char* end = nullptr;
+  double number = std::strtod(value.c_str(), &end);
+  return end != value.c_str() ? number : std::numeric_limits<double>::quiet_NaN();
+}
+
+std::string LCCampaignRecord::ToLine() const {
+  std::string line;
+  for (const auto& field : fFields) {
+    if (!line.empty()) line += '\t';
+    line += field.first + "=" + field.second;
+  }
+  return line;
+}
+
+bool LCCampaignRecord::FromLine(const std::string& line, LCCampaignRecord& record) {
+  record.fFields.clear();
+  std::size_t start = 0;
+  while (start <= line.size()) {
+    std::size_t end = line.find('\t', start);
+    if (end == std::string::npos) end = line.size();
+    std::size_t equals = line.find('=', start);
+    if (equals == std::string::npos || equals >= end) return false;
+    record.fFields.emplace_back(line.substr(start, equals - start), line.substr(equals + 1, end - equals - 1));
+    start = end + 1;
+  }
+  return !record.fFields.empty();
+}
+
+LCCampaignStore::LCCampaignStore(const std::string& directory)
+  : fDirectory(directory)
+{}
+
+std::string LCCampaignStore::GetLogPath() const {
+  return (fs::path(fDirectory) / kLogName).string();
+}
+
+std::string LCCampaignStore::GetIndexPath() const {
+  return (fs::path(fDirectory) / kIndexName).string();
+}
+
+bool LCCampaignStore::Append(const LCCampaignRecord& record, std::string* error) const {
+  auto fail = [error](const std::string& message) {
+    if (error) *error = message + ": " + std::strerror(errno);
+    return false;
+  };
+  
+  std::error_code ec;
+  fs::create_directories(fDirectory, ec);
+  int logFd = open(GetLogPath().c_str(), O_RDWR | O_APPEND | O_CREAT, 0644);
+  if (logFd < 0) return fail("could not open " + GetLogPath());
+  
+  bool ok = true;
+  {
+    FileLock lock(logFd, LOCK_EX);
+    std::uint64_t logSize = FileSize(logFd);
+    
+    // A writer that died mid-line left a partial record: cut it off
+    std::string last;
+    if (logSize > 0 && ReadAt(logFd, logSize - 1, 1, last) && last[0] != '\n') {
+      std::uint64_t end = 0;
+      ScanLog(logFd, 0, logSize, [&end](std::uint64_t offset, const std::string& line) {
+        end = offset + line.size() + 1;
+      });
+      if (ftruncate(logFd, static_cast<off_t>(end)) != 0) ok = fail("could not repair " + GetLogPath());
+      logSize = end;
+    }
+    
+    // Bring the index in step with the log before extending both
+    std::vector<IndexEntry> entries = ReadIndex(GetIndexPath());
+    if (ok && CoveredEnd(entries) != logSize) {
+      if (!WriteIndex(GetIndexPath(), IndexLog(logFd, logSize))) ok = fail("could not write " + GetIndexPath());
+    }
+    
+    std::string line = record.ToLine();
+    if (ok) {
+      std::string data = line + "\n";
+      if (!WriteAll(logFd, data.data(), data.size())) {
+        ok = fail("could not append to " + GetLogPath());
+        // Otherwise the partial line is cut off by the next writer
+        if (ftruncate(logFd, static_cast<off_t>(logSize)) != 0) ok = false;
+      }
+    }
+    
+    if (ok) {
+      // A missing index entry is recovered by the next writer or reader
+      IndexEntry entry = MakeEntry(record, logSize, line);
+      int indexFd = open(GetIndexPath().c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+      if (indexFd >= 0) {
+        if (FileSize(indexFd) == 0) WriteAll(indexFd, kIndexMagic, sizeof(kIndexMagic));
+        WriteAll(indexFd, reinterpret_cast<const char*>(&entry), sizeof(entry));
+        close(indexFd);
+      }
+    }
+  }
+  close(logFd);
+  return ok;
+}
+
+std::vector<LCCampaignRecord> LCCampaignStore::Query(const LCCampaignQuery& query) const {
+  std::vector<LCCampaignRecord> records;
+  int logFd = open(GetLogPath().c_str(), O_RDONLY);
+  if (logFd < 0) return records;
+  
+  {
+    FileLock lock(logFd, LOCK_SH);
+    std::uint64_t logSize = FileSize(logFd);
+    std::vector<IndexEntry> entries = ReadIndex(GetIndexPath());
+    std::uint64_t covered = CoveredEnd(entries);
+    
+    // An index longer than the log belongs to another log: ignore it
+    if (covered > logSize) {
+      entries.clear();
+      covered = 0;
+    }
+    
+    std::uint64_t particleHash = Hash(query.particle);
+    std::uint64_t physicsHash = Hash(query.physics);
+    std::string line;
+    for (const IndexEntry& entry : entries) {
+      if (!Matches(entry, query, particleHash, physicsHash)) continue;
+      if (entry.length == 0 || !ReadAt(logFd, entry.offset, entry.length - 1, line) ||
+          Hash(line) != entry.lineHash) {
+        // The log was changed behind the index's back: read all of it
+        records.clear();
+        covered = 0;
+        break;
+      }
+      LCCampaignRecord record;
+      if (LCCampaignRecord::FromLine(line, record) && Matches(record, query)) records.push_back(record);
+    }
+    
+    // Runs appended after the index was last written
+    ScanLog(logFd, covered, logSize, [&](std::uint64_t, const std::string& tailLine) {
+      LCCampaignRecord record;
+      if (LCCampaignRecord::FromLine(tailLine, record) && Matches(record, query)) records.push_back(record);
+    });
+  }
+  close(logFd);
+  return records;
+}
+
+std::size_t LCCampaignStore::RebuildIndex() const {
+  int logFd = open(GetLogPath().c_str(), O_RDONLY);
+  if (logFd < 0) return 0;
+  std::size_t count = 0;
+  {
+    FileLock lock(logFd, LOCK_EX);
+    std::vector<IndexEntry> entries = IndexLog(logFd, FileSize(logFd));
+    if (WriteIndex(GetIndexPath(), entries)) count = entries.size();
+  }
+  close(logFd);
+  return count;
+}
@@ -0,0 +1,213 @@
+// LCCocktailGenerator.cc - Weighted mixture of radiation sources with tabulated spectra
+#include "LCCocktailGenerator.hh"
+#include "G4ParticleTable.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+  // Bins used to tabulate analytic shapes
+  const G4int kBetaBins = 100;
+  const G4int kCos2Bins = 20;
+  
+  G4double SampleComponent(const LCCocktailSource::Component& component) {
+    if (component.high <= component.low) return component.low;
+    return component.low + G4UniformRand() * (component.high - component.low);
+  }
+}
+
+LCCocktailGenerator::LCCocktailGenerator()
+{
+}
+
+LCCocktailGenerator::~LCCocktailGenerator()
+{
+}
+
+LCCocktailSource* LCCocktailGenerator::CurrentSource() {
+  if (fSources.empty()) {
+    G4cerr << "ERROR: No cocktail source defined - use /LC/cocktail/addSource first" << G4endl;
+    return nullptr;
+  }
+  return &fSources.back();
+}
+
+G4bool LCCocktailGenerator::AddSource(const G4String& name, const G4String& particleName, G4double rate) {
+  G4ParticleDefinition* particle = G4ParticleTable::GetParticleTable()->FindParticle(particleName);
+  if (!particle) {
+    G4cerr << "ERROR: Unknown particle " << particleName << " for cocktail source " << name << G4endl;
+    return false;
+  }
+  if (rate <= 0.) {
+    G4cerr << "ERROR: Cocktail source " << name << " needs a positive rate" << G4endl;
+    return false;
+  }
+  
+  LCCocktailSource source;
+  source.name = name;
+  source.particle = particle;
+  source.rate = rate;
+  fSources.push_back(source);
+  RebuildSourceTable();
+  return true;
+}
+
+G4bool LCCocktailGenerator::AddLine(G4double energy, G4double intensity) {
+  return AddBin(energy, energy, intensity);
+}
+
+G4bool LCCocktailGenerator::AddBin(G4double low, G4double high, G4double weight) {
+  LCCocktailSource* source = CurrentSource();
+  if (!source) return false;
+  if (low <= 0. || high < low || weight <= 0.) {
+    G4cerr << "ERROR: Invalid energy component for cocktail source " << source->name << G4endl;
+    return false;
+  }
+  source->energyComponents.push_back({low, high});
+  source->energyWeights.push_back(weight);
+  return source->energyTable.Build(source->energyWeights);
+}
+
+G4bool LCCocktailGenerator::AddBetaSpectrum(G4double endpoint) {
+  LCCocktailSource* source = CurrentSource();
+  if (!source) return false;
+  if (endpoint <= 0.) {
+    G4cerr << "ERROR: Invalid beta endpoint for cocktail source " << source->name << G4endl;
+    return false;
+  }
+  
+  // Allowed shape N(T) ~ p E (Q - T)^2, without the Fermi function
+  G4double mass = source->particle->GetPDGMass();
+  G4double width = endpoint / kBetaBins;
+  for (G4int i = 0; i < kBetaBins; i++) {
+    G4double kinetic = (i + 0.5) * width;
+    G4double total = kinetic + mass;
+    G4double momentum = std::sqrt(kinetic * (kinetic + 2.0 * mass));
+    G4double weight = momentum * total * (endpoint - kinetic) * (endpoint - kinetic);
+    source->energyComponents.push_back({i * width, (i + 1) * width});
+    source->energyWeights.push_back(weight);
+  }
+  return source->energyTable.Build(source->energyWeights);
+}
+
+G4bool LCCocktailGenerator::SetAngularDistribution(const G4String& shape) {
+  LCCocktailSource* source = CurrentSource();
+  if (!source) return false;
+  
+  source->cosThetaComponents.clear();
+  source->cosThetaWeights.clear();
+  
+  if (shape == "beam") {
+    // Along the beam axis - no table
+    return true;
+  } else if (shape == "isotropic") {
+    // Uniform in cos(theta) over the hemisphere facing the detector
+    source->cosThetaComponents.push_back({0., 1.});
+    source->cosThetaWeights.push_back(1.);
+  } else if (shape == "cos2") {
+    // Cosmic muon zenith distribution, dN/dcos ~ cos^2
+    for (G4int i = 0; i < kCos2Bins; i++) {
+      G4double low = G4double(i) / kCos2Bins;
+      G4double high = G4double(i + 1) / kCos2Bins;
+      source->cosThetaComponents.push_back({low, high});
+      source->cosThetaWeights.push_back((high*high*high - low*low*low) / 3.0);
+    }
+  } else {
+    G4cerr << "ERROR: Unknown angular distribution " << shape << " (beam, isotropic, cos2)" << G4endl;
+    return false;
+  }
+  return source->angularTable.Build(source->cosThetaWeights);
+}
+
+G4bool LCCocktailGenerator::AddAngularBin(G4double cosLow, G4double cosHigh, G4double weight) {
+  LCCocktailSource* source = CurrentSource();
+  if (!source) return false;
+  if (cosLow < -1. || cosHigh > 1. || cosHigh < cosLow || weight <= 0.) {
+    G4cerr << "ERROR: Invalid angular bin for cocktail source " << source->name << G4endl;
+    return false;
+  }
+  source->cosThetaComponents.push_back({cosLow, cosHigh});
+  source->cosThetaWeights.push_back(weight);
+  return source->angularTable.Build(source->cosThetaWeights);
+}
+
+void LCCocktailGenerator::Clear() {
+  fSources.clear();
+  fSourceTable = LCAliasTable();
+}
+
+void LCCocktailGenerator::RebuildSourceTable() {
+  std::vector<G4double> rates;
+  for (const auto& source : fSources) rates.push_back(source.rate);
+  fSourceTable.Build(rates);
+}
+
+G4bool LCCocktailGenerator::IsReady() const {
+  if (fSources.empty()) return false;
+  for (const auto& source : fSources) {
+    if (source.energyTable.IsEmpty()) return false;
+  }
+  return true;
+}
+
+G4int LCCocktailGenerator::SampleSource() const {
+  return fSourceTable.Sample();
+}
+
+G4double LCCocktailGenerator::SampleEnergy(G4int id) const {
+  const LCCocktailSource& source = fSources[id];
+  return SampleComponent(source.energyComponents[source.energyTable.Sample()]);
+}
+
+G4ThreeVector LCCocktailGenerator::SampleDirection(G4int id, const G4ThreeVector& beamAxis) const {
+  const LCCocktailSource& source = fSources[id];
+  if (source.angularTable.IsEmpty()) return beamAxis;
+  
+  G4double cosTheta = SampleComponent(source.cosThetaComponents[source.angularTable.Sample()]);
+  G4double sinTheta = std::sqrt(std::max(0., 1.0 - cosTheta * cosTheta));
+  G4double phi = twopi * G4UniformRand();
+  
+  // Polar angle measured from the beam axis
+  G4ThreeVector direction(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+  direction.rotateUz(beamAxis.unit());
+  return direction;
+}
+
+G4String LCCocktailGenerator::GetDescription() const {
+  std::ostringstream description;
+  description << std::setprecision(10);
+  for (size_t i = 0; i < fSources.size(); i++) {
+    const LCCocktailSource& source = fSources[i];
+    description << "source " << i << " " << source.name << " " << source.particle->GetParticleName()
+                << " rate=" << source.rate << "\n";
+    for (size_t j = 0; j < source.energyComponents.size(); j++) {
+      description << "  energy " << source.energyComponents[j].low/MeV << " "
+                  << source.energyComponents[j].high/MeV << " " << source.energyWeights[j] << "\n";
+    }
+    for (size_t j = 0; j < source.cosThetaComponents.size(); j++) {
+      description << "  cosTheta " << source.cosThetaComponents[j].low << " "
+                  << source.cosThetaComponents[j].high << " " << source.cosThetaWeights[j] << "\n";
+    }
+  }
+  return description.str();
+}
+
+void LCCocktailGenerator::Print() const {
+  G4double totalRate = 0.;
+  for (const auto& source : fSources) totalRate += source.rate;
+  
+  G4cout << "\n==== SOURCE COCKTAIL ====" << G4endl;
+  for (size_t i = 0; i < fSources.size(); i++) {
+    const LCCocktailSource& source = fSources[i];
+    G4cout << "SourceID " << i << ": " << source.name << " (" << source.particle->GetParticleName()
+           << "), fraction " << source.rate / totalRate << ", "
+           << source.energyComponents.size() << " energy component(s), "
+           << (source.angularTable.IsEmpty() ? "along beam" : "angular table") << G4endl;
+  }
+  G4cout << "=========================\n" << G4endl;
+}
@@ -0,0 +1,123 @@
+// LCCondensation.cc - Local deposition of low-energy delta electrons in the LC cell
+#include "LCCondensation.hh"
+#include "LCDetectorConstruction.hh"
+#include "LCConfiguration.hh"
+#include "G4AutoLock.hh"
+#include "G4Electron.hh"
+#include "G4EmCalculator.hh"
+#include "G4RunManager.hh"
+#include "G4Track.hh"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+  G4Mutex totalsMutex = G4MUTEX_INITIALIZER;
+  LCCondensationTotals runTotals;
+}
+
+G4ThreadLocal LCCondensation* LCCondensation::fInstance = nullptr;
+
+LCCondensation* LCCondensation::Instance() {
+  if (!fInstance) {
+    fInstance = new LCCondensation();
+  }
+  return fInstance;
+}
+
+LCCondensation::LCCondensation()
+: fHasRanges(false),
+  fLogEnergyMin(0.),
+  fLogEnergyStep(0.),
+  fThreshold(0.),
+  fCandidates(0)
+{}
+
+void LCCondensation::BeginRun(G4bool isMaster) {
+  fTotals = LCCondensationTotals();
+  fCandidates = 0;
+  fSampledTracks.clear();
+  
+  // The larger of the energy threshold and the energy for the range threshold
+  const LCConfigSnapshot* config = LCConfiguration::ForRun();
+  auto detConstruction = dynamic_cast<const LCDetectorConstruction*>(
+    G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  G4EmCalculator calculator;
+  fThreshold = config->condenseEnergy;
+  if (config->condenseRange > 0. && detConstruction) {
+    G4double rangeEnergy = calculator.ComputeEnergyCutFromRangeCut(
+      config->condenseRange, G4Electron::Definition(), detConstruction->GetLCMaterial());
+    fThreshold = std::max(fThreshold, rangeEnergy);
+  }
+  
+  // Ranges from three decades below the threshold up to it. Condensed
+  // electrons are below the production cut, where the restricted range is
+  // the full (CSDA) one, and unlike GetCSDARange it needs no extra tables.
+  fHasRanges = false;
+  if (fThreshold > 0. && detConstruction) {
+    fLogEnergyMin = std::log(fThreshold * 1.0e-3);
+    fLogEnergyStep = (std::log(fThreshold) - fLogEnergyMin) / (kRangePoints - 1);
+    fHasRanges = true;
+    for (G4int i = 0; i < kRangePoints; i++) {
+      G4double range = calculator.GetRangeFromRestricteDEDX(
+        std::exp(fLogEnergyMin + i * fLogEnergyStep), G4Electron::Definition(), detConstruction->GetLCMaterial());
+      if (!(range > 0.)) {
+        fHasRanges = false;
+        break;
+      }
+      fLogRanges[i] = std::log(range);
+    }
+  }
+  
+  if (isMaster) {
+    G4AutoLock lock(&totalsMutex);
+    runTotals = LCCondensationTotals();
+  }
+}
+
+G4bool LCCondensation::Condense(const G4Track* track) {
+  if (track->GetParentID() == 0 || track->GetDefinition() != G4Electron::Definition()) return false;
+  if (track->GetKineticEnergy() >= fThreshold) return false;
+  G4VPhysicalVolume* volume = track->GetVolume();
+  if (!volume || volume->GetLogicalVolume()->GetName() != "LCCell") return false;
+  
+  // Reference sample, tracked as without condensation
+  if (fCandidates++ % kSampleEvery == 0) {
+    fSampledTracks.insert(track->GetTrackID());
+    fTotals.sampled++;
+    return false;
+  }
+  
+  fTotals.condensed++;
+  fTotals.condensedEnergy += track->GetKineticEnergy();
+  return true;
+}
+
+G4double LCCondensation::GetEffectiveLength(G4double energy) const {
+  if (!fHasRanges || energy <= 0.) return 0.;
+  
+  // Linear in log(range) vs log(E), extrapolated below the lowest point
+  G4double x = (std::log(energy) - fLogEnergyMin) / fLogEnergyStep;
+  G4int index = std::min(std::max(G4int(std::floor(x)), 0), kRangePoints - 2);
+  G4double fraction = x - index;
+  return std::exp(fLogRanges[index] + fraction * (fLogRanges[index + 1] - fLogRanges[index]));
+}
+
+void LCCondensation::CountStep(const G4Track* track, G4bool inCell) {
+  if (inCell) fTotals.cellSteps++;
+  if (!fSampledTracks.empty() && fSampledTracks.count(track->GetTrackID())) fTotals.sampledSteps++;
+}
+
+void LCCondensation::EndRun() {
+  G4AutoLock lock(&totalsMutex);
+  runTotals.condensed += fTotals.condensed;
+  runTotals.condensedEnergy += fTotals.condensedEnergy;
+  runTotals.sampled += fTotals.sampled;
+  runTotals.sampledSteps += fTotals.sampledSteps;
+  runTotals.cellSteps += fTotals.cellSteps;
+  fTotals = LCCondensationTotals();
+}
+
+LCCondensationTotals LCCondensation::GetRunTotals() {
+  G4AutoLock lock(&totalsMutex);
+  return runTotals;
+}
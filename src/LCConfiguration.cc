@@ -0,0 +1,120 @@
+// LCConfiguration.cc - Immutable, versioned snapshots of the settings the worker threads run with
+#include "LCConfiguration.hh"
+#include "LCCocktailGenerator.hh"
+#include "LCDetectorConstruction.hh"
+#include "G4SystemOfUnits.hh"
+#include <iomanip>
+#include <sstream>
+
+std::atomic<const LCConfigSnapshot*> LCConfiguration::fCurrent(nullptr);
+std::vector<std::unique_ptr<const LCConfigSnapshot>> LCConfiguration::fSnapshots;
+
+namespace {
+  G4String Describe(const LCConfigSnapshot& config) {
+    std::ostringstream out;
+    out << std::setprecision(17);
+    out << "particle=" << config.particleName << "\n";
+    out << "energy_MeV=" << config.particleEnergy/MeV << "\n";
+    out << "glassFilter=" << config.glassFilter << "," << config.glassFilterModel
+        << "," << config.glassFilterTableDir << "\n";
+    out << "bunch=" << config.bunchPrimaries << (config.bunchPoisson ? "p" : "f") << "," << config.bunchCount
+        << "," << config.bunchSpacing/ns << "," << config.bunchLength/ns << "\n";
+    out << "timeline=" << config.timelineRate/hertz << "," << config.timelineBinWidth/ns
+        << "," << config.timelineWindow/ns << "\n";
+    out << "cocktail=" << config.cocktailEnabled << "\n";
+    if (config.cocktailEnabled && config.cocktail) out << config.cocktail->GetDescription();
+    out << "angular=" << config.angularMode << "," << config.angularThetaMin/deg << "," << config.angularThetaMax/deg;
+    for (const auto& point : config.angularPoints) {
+      out << ";" << point.theta/deg << "/" << point.phi/deg << "/" << point.weight;
+    }
+    out << "\n";
+    out << "bias_V=" << config.bias/volt << "\n";
+    out << "field_V_per_um=" << config.electricField/(volt/um) << "\n";
+    out << "cell_mm=" << config.cellWidth/mm << "x" << config.cellLength/mm << "\n";
+    out << "thickness_um=" << config.cellThickness/um << "\n";
+    out << "electrode_mm=" << config.electrodeThickness/mm << "\n";
+    out << "cellMaxStep_um=" << config.cellMaxStep/um << "\n";
+    out << "fidelity=" << config.fidelity << "\n";
+    out << "transport=" << config.transportModel << "\n";
+    out << "biasing=" << config.biasingEnabled << "," << config.gammaBiasFactor << "," << config.neutronBiasFactor << "\n";
+    out << "condense=" << config.condenseEnergy/keV << "keV," << config.condenseRange/um << "um\n";
+    out << "recordSteps=" << config.stepRecording << "\n";
+    out << "recordWaveforms=" << config.waveformRecording << "," << config.waveformTimeStep/ns
+        << "," << config.waveformCurrentStep/ampere << "\n";
+    out << "memoryBudget=" << config.memoryBudget << "\n";
+    return out.str();
+  }
+}
+
+const LCConfigSnapshot* LCConfiguration::Publish(const LCDetectorConstruction* detConstruction) {
+  LCGlobalManager* global = LCGlobalManager::Instance();
+  auto config = std::make_unique<LCConfigSnapshot>();
+  
+  config->particleName = global->GetParticleType();
+  config->particleEnergy = global->GetParticleEnergy();
+  config->glassFilter = global->IsGlassFilterEnabled();
+  config->glassFilterModel = global->GetGlassFilterModel();
+  config->glassFilterTableDir = global->GetGlassFilterTableDir();
+  config->bunchPrimaries = global->GetBunchPrimaries();
+  config->bunchPoisson = global->IsBunchPoisson();
+  config->bunchCount = global->GetBunchCount();
+  config->bunchSpacing = global->GetBunchSpacing();
+  config->bunchLength = global->GetBunchLength();
+  config->timelineRate = global->GetTimelineRate();
+  config->timelineBinWidth = global->GetTimelineBinWidth();
+  config->timelineWindow = global->GetTimelineWindow();
+  config->cocktailEnabled = global->IsCocktailEnabled();
+  config->cocktail = global->GetCocktail();
+  config->angularMode = global->GetAngularMode();
+  config->angularThetaMin = global->GetAngularThetaMin();
+  config->angularThetaMax = global->GetAngularThetaMax();
+  config->angularPoints = global->GetAngularPoints();
+  config->angularPointTable = global->GetAngularPointTable();
+  
+  if (detConstruction) {
+    config->bias = detConstruction->GetBias();
+    config->electricField = detConstruction->GetElectricField();
+    config->cellWidth = detConstruction->GetLCWidth();
+    config->cellLength = detConstruction->GetLCLength();
+    config->cellThickness = detConstruction->GetLCThickness();
+    config->electrodeThickness = detConstruction->GetElectrodeThickness();
+    config->fidelity = detConstruction->GetGeometryFidelity();
+  }
+  
+  config->cellMaxStep = global->GetCellMaxStep();
+  config->transportModel = global->GetTransportModel();
+  config->biasingEnabled = global->IsBiasingEnabled();
+  config->gammaBiasFactor = global->GetGammaBiasFactor();
+  config->neutronBiasFactor = global->GetNeutronBiasFactor();
+  config->condenseEnergy = global->GetCondenseEnergy();
+  config->condenseRange = global->GetCondenseRange();
+  config->stepRecording = global->IsStepRecordingEnabled();
+  config->waveformRecording = global->IsWaveformRecordingEnabled();
+  config->waveformTimeStep = global->GetWaveformTimeStep();
+  config->waveformCurrentStep = global->GetWaveformCurrentStep();
+  config->memoryBudget = global->GetMemoryBudget();
+  config->description = Describe(*config);
+  
+  const LCConfigSnapshot* current = fCurrent.load(std::memory_order_relaxed);
+  if (current && current->description == config->description) return current;
+  
+  config->epoch = current ? current->epoch + 1 : 1;
+  fSnapshots.push_back(std::move(config));
+  const LCConfigSnapshot* published = fSnapshots.back().get();
+  fCurrent.store(published, std::memory_order_release);
+  return published;
+}
+
+const LCConfigSnapshot* LCConfiguration::ForRun() {
+  const LCConfigSnapshot* config = Current();
+  if (!config) {
+    G4Exception("LCConfiguration::ForRun()", "LCConfig001", FatalException,
+                "No configuration published: run-time code called outside a run");
+  }
+  return config;
+}
+
+unsigned long LCConfiguration::CurrentEpoch() {
+  const LCConfigSnapshot* config = Current();
+  return config ? config->epoch : 0;
+}
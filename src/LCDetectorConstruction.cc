@@ -1,5 +1,7 @@
 // LCDetectorConstruction.cc - Modified for perpendicular beam incidence with selective electrode interactions
 #include "LCDetectorConstruction.hh"
+#include "LCBiasingOperator.hh"
+#include "LCGlobalManager.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4NistManager.hh"
 #include "G4VisAttributes.hh"
@@ -10,9 +12,16 @@
 #include "G4UserLimits.hh"
 #include "G4Material.hh"
 #include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4RunManager.hh"
 #include "G4ProductionCuts.hh"
 
+#include <algorithm>
+
 LCDetectorConstruction::LCDetectorConstruction() :
+  worldPhysical(nullptr),
+  lcCellLimits(nullptr),
+  electrodeLimits(nullptr),
   fElectricField(nullptr),
   fEquation(nullptr),
   fStepper(nullptr),
@@ -24,8 +33,10 @@ LCDetectorConstruction::LCDetectorConstruction() :
   lcSizeX(15.0*mm),    // 15 mm width
   lcSizeY(25.0*mm),    // 25 mm length
   lcSizeZ(100.0*um),   // 100 microns thickness
+  electrodeThickness(1.0*mm),  // 1 mm glass
   electricFieldStrength(3.0*volt/um), // 3 V/μm field strength
-  biasVoltage(300*volt)  // Initialize with 300V bias
+  biasVoltage(300*volt),  // Initialize with 300V bias
+  fFidelity("full")
 {
   DefineMaterials();
 }
@@ -50,34 +61,7 @@ void LCDetectorConstruction::SetBias(G4double biasVoltage) {
   if (fElectricField && fFieldManager) {
     // For G4UniformElectricField, we can't update it directly
     // We need to create a new field and set it to the field manager
-    
-    // Delete the old field objects
-    delete fChordFinder;
-    delete fIntegratorDriver;
-    delete fStepper;
-    delete fEquation;
-    delete fElectricField;
-    
-    // Create new field with updated strength
-    G4ThreeVector fieldVector(0.0, electricFieldStrength, 0.0);
-    fElectricField = new G4UniformElectricField(fieldVector);
-    
-    // Recreate equation of motion with new electric field
-    fEquation = new G4EqMagElectricField(fElectricField);
-    
-    // Recreate stepper
-    G4int nvar = 8;
-    fStepper = new G4ClassicalRK4(fEquation, nvar);
-    
-    // Recreate driver
-    fIntegratorDriver = new G4MagInt_Driver(fMinStep, fStepper, fStepper->GetNumberOfVariables());
-    
-    // Recreate chord finder
-    fChordFinder = new G4ChordFinder(fIntegratorDriver);
-    
-    // Update field manager
-    fFieldManager->SetDetectorField(fElectricField);
-    fFieldManager->SetChordFinder(fChordFinder);
+    SetupElectricField();
     
     G4cout << "Electric field updated to " << electricFieldStrength/(volt/um) 
            << " V/μm = " << electricFieldStrength * lcSizeZ/volt << " V across detector" << G4endl;
@@ -95,6 +79,7 @@ void LCDetectorConstruction::DefineMaterials() {
   wireConnectionMaterial = nistManager->FindOrBuildMaterial("G4_Cu");  // Copper wires
   electrodeConnectorMaterial = nistManager->FindOrBuildMaterial("G4_Ag");  // Silver contacts
   electrometerCaseMaterial = nistManager->FindOrBuildMaterial("G4_Al");    // Aluminum case
+  vacuumMaterial = nistManager->FindOrBuildMaterial("G4_Galactic");
   
   // FIXED: Use the standard glass material directly - we'll use physics process controls
   // rather than trying to modify the material composition
@@ -114,7 +99,79 @@ void LCDetectorConstruction::DefineMaterials() {
   liquidCrystalMaterial->AddElement(elN, 1);
 }
 
+G4bool LCDetectorConstruction::SetCellDimensions(G4double width, G4double length, G4double thickness) {
+  if (!CheckDimensions(width, length, thickness, electrodeThickness)) return false;
+  lcSizeX = width;
+  lcSizeY = length;
+  lcSizeZ = thickness;
+  RequestGeometryRebuild();
+  return true;
+}
+
+G4bool LCDetectorConstruction::SetElectrodeThickness(G4double thickness) {
+  if (!CheckDimensions(lcSizeX, lcSizeY, lcSizeZ, thickness)) return false;
+  electrodeThickness = thickness;
+  RequestGeometryRebuild();
+  return true;
+}
+
+G4bool LCDetectorConstruction::CheckDimensions(G4double width, G4double length, G4double thickness,
+                                               G4double electrode) const {
+  if (width <= 0. || length <= 0. || thickness <= 0. || electrode <= 0.) {
+    G4cerr << "ERROR: Cell dimensions and electrode thickness must be positive" << G4endl;
+    return false;
+  }
+  // The gun sits 15 mm upstream of the cell centre (LCPrimaryGeneratorAction)
+  if (thickness/2 + electrode >= 15.0*mm) {
+    G4cerr << "ERROR: The front electrode would reach the beam source 15 mm upstream of the cell centre" << G4endl;
+    return false;
+  }
+  // Electrodes overhang the cell by 1 mm; the electrometer box starts at x = 60 mm
+  if (width/2 + 1.0*mm >= 60.0*mm || length/2 + 1.0*mm >= 150.0*mm) {
+    G4cerr << "ERROR: The electrodes would overlap the electrometer box or leave the world" << G4endl;
+    return false;
+  }
+  return true;
+}
+
+void LCDetectorConstruction::SetGeometryFidelity(const G4String& fidelity) {
+  LCGlobalManager::Instance()->SetGeometryFidelity(fidelity);
+  if (fidelity == fFidelity) return;
+  fFidelity = fidelity;
+  G4cout << "Geometry fidelity set to " << fFidelity << G4endl;
+  
+  // Rebuilt at the next run, as for new dimensions
+  if (worldPhysical) {
+    G4RunManager::GetRunManager()->ReinitializeGeometry(true);
+    worldPhysical = nullptr;
+  }
+}
+
+void LCDetectorConstruction::RequestGeometryRebuild() {
+  // Field strength follows from the bias across the new thickness
+  electricFieldStrength = biasVoltage / lcSizeZ;
+  
+  G4cout << "LC cell set to " << lcSizeX/mm << " mm x " << lcSizeY/mm << " mm x " << lcSizeZ/um
+         << " um, electrodes " << electrodeThickness/mm << " mm; field " << electricFieldStrength/(volt/um)
+         << " V/um at " << biasVoltage/volt << " V" << G4endl;
+  
+  // Before initialization Construct() picks the values up anyway. Afterwards
+  // only the geometry is rebuilt at the next run: the old volumes are deleted
+  // and the workers are told to pick up the new world.
+  if (worldPhysical) {
+    G4RunManager::GetRunManager()->ReinitializeGeometry(true);
+    worldPhysical = nullptr;
+  }
+}
+
 void LCDetectorConstruction::SetupElectricField() {
+  // Drop the previous field objects when the field is rebuilt (bias or geometry change)
+  delete fChordFinder;
+  delete fIntegratorDriver;
+  delete fStepper;
+  delete fEquation;
+  delete fElectricField;
+  
   // Create uniform electric field along y-axis (perpendicular to large face)
   G4ThreeVector fieldVector(0.0, electricFieldStrength, 0.0);
   fElectricField = new G4UniformElectricField(fieldVector);
@@ -139,13 +196,36 @@ void LCDetectorConstruction::SetupElectricField() {
 }
 
 G4VPhysicalVolume* LCDetectorConstruction::Construct() {
-  // World volume
+  // Fixed for this geometry (/LC/detector/fidelity rebuilds it)
+  fFidelity = LCGlobalManager::Instance()->GetGeometryFidelity();
+  topWireLogical = bottomWireLogical = electrometerLogical = nullptr;
+  
+  // The cell may have been resized since the bias was set
+  electricFieldStrength = biasVoltage / lcSizeZ;
+  
+  // ITO Glass electrodes (front and back along Y-axis)
+  // Slightly larger than LC cell (by 2mm in X and Z dimensions)
+  G4double electrodeSizeX = lcSizeX + 2.0*mm;
+  G4double electrodeSizeY = electrodeThickness;
+  G4double electrodeSizeZ = lcSizeY + 2.0*mm;
+  
+  // World volume: 30 cm of air, or for the minimal fidelity a vacuum box just
+  // large enough for the electrodes and the beam source in front of them
   G4double worldSizeX = 30.0*cm;
   G4double worldSizeY = 30.0*cm;
   G4double worldSizeZ = 30.0*cm;
+  G4Material* worldFill = worldMaterial;
+  if (fFidelity == "minimal") {
+    // The gun sits 15 mm (18 mm with the glass filter) upstream of the cell
+    const G4double sourceClearance = 25.0*mm;
+    const G4double margin = 5.0*mm;
+    G4double halfSize = std::max({ electrodeSizeX/2, electrodeSizeZ/2, sourceClearance }) + margin;
+    worldSizeX = worldSizeY = worldSizeZ = 2 * halfSize;
+    worldFill = vacuumMaterial;
+  }
   
   worldSolid = new G4Box("World", worldSizeX/2, worldSizeY/2, worldSizeZ/2);
-  worldLogical = new G4LogicalVolume(worldSolid, worldMaterial, "World");
+  worldLogical = new G4LogicalVolume(worldSolid, worldFill, "World");
   worldPhysical = new G4PVPlacement(0, G4ThreeVector(), worldLogical, "World", 0, false, 0);
   
   // Liquid crystal cell - reoriented for perpendicular incidence
@@ -154,32 +234,38 @@ G4VPhysicalVolume* LCDetectorConstruction::Construct() {
   lcCellLogical = new G4LogicalVolume(lcCellSolid, liquidCrystalMaterial, "LCCell");
   lcCellPhysical = new G4PVPlacement(0, G4ThreeVector(0, 0, 0), lcCellLogical, "LCCell", worldLogical, false, 0);
   
-  // ITO Glass electrodes (front and back along Y-axis)
-  // Slightly larger than LC cell (by 2mm in X and Z dimensions)
-  G4double electrodeSizeX = lcSizeX + 2.0*mm;
-  G4double electrodeSizeY = 1.0*mm;  // Electrode thickness
-  G4double electrodeSizeZ = lcSizeY + 2.0*mm;
+  // Step limit in the cell (/LC/physics/cellMaxStep), to keep the depth of
+  // the deposits resolved when delta electrons are condensed
+  if (!lcCellLimits) lcCellLimits = new G4UserLimits();
+  lcCellLogical->SetUserLimits(lcCellLimits);
+  SetCellMaxStep(LCGlobalManager::Instance()->GetCellMaxStep());
   
   // Front electrode (facing the beam)
   electrodeTopSolid = new G4Box("ElectrodeFront", electrodeSizeX/2, electrodeSizeY/2, electrodeSizeZ/2);
   electrodeTopLogical = new G4LogicalVolume(electrodeTopSolid, electrodeMaterial, "ElectrodeFront");
   
   // FIXED: Create a region for special physics cuts for electrodes
-  G4Region* electrodeRegion = new G4Region("ElectrodeRegion");
-  
-  // Set very high production cuts for this region to minimize secondary particle production
-  G4ProductionCuts* electrodeCuts = new G4ProductionCuts();
-  electrodeCuts->SetProductionCut(1.0*km); // Effectively disable secondary production
-  electrodeRegion->SetProductionCuts(electrodeCuts);
+  // (kept across geometry rebuilds, which only replace its volumes)
+  G4Region* electrodeRegion = G4RegionStore::GetInstance()->GetRegion("ElectrodeRegion", false);
+  if (!electrodeRegion) {
+    electrodeRegion = new G4Region("ElectrodeRegion");
+    
+    // Set very high production cuts for this region to minimize secondary particle production
+    G4ProductionCuts* electrodeCuts = new G4ProductionCuts();
+    electrodeCuts->SetProductionCut(1.0*km); // Effectively disable secondary production
+    electrodeRegion->SetProductionCuts(electrodeCuts);
+  }
   
   // Add logical volumes to region
   electrodeTopLogical->SetRegion(electrodeRegion);
   electrodeRegion->AddRootLogicalVolume(electrodeTopLogical);
   
   // Add user limits to minimize interactions but preserve electric field
-  G4UserLimits* electrodePhysicsLimits = new G4UserLimits();
-  electrodePhysicsLimits->SetMaxAllowedStep(10.0*m);  // Large step for protons (jump through)
-  electrodeTopLogical->SetUserLimits(electrodePhysicsLimits);
+  if (!electrodeLimits) {
+    electrodeLimits = new G4UserLimits();
+    electrodeLimits->SetMaxAllowedStep(10.0*m);  // Large step for protons (jump through)
+  }
+  electrodeTopLogical->SetUserLimits(electrodeLimits);
   
   electrodeTopPhysical = new G4PVPlacement(0, G4ThreeVector(0, -lcSizeZ/2 - electrodeSizeY/2, 0), 
                          electrodeTopLogical, "ElectrodeFront", worldLogical, false, 0);
@@ -191,49 +277,52 @@ G4VPhysicalVolume* LCDetectorConstruction::Construct() {
   // Apply the same region and limits to the back electrode
   electrodeBottomLogical->SetRegion(electrodeRegion);
   electrodeRegion->AddRootLogicalVolume(electrodeBottomLogical);
-  electrodeBottomLogical->SetUserLimits(electrodePhysicsLimits);
+  electrodeBottomLogical->SetUserLimits(electrodeLimits);
   
   electrodeBottomPhysical = new G4PVPlacement(0, G4ThreeVector(0, lcSizeZ/2 + electrodeSizeY/2, 0), 
                             electrodeBottomLogical, "ElectrodeBack", worldLogical, false, 0);
   
-  // Wire connections to the electrometer (copper wires)
-  G4double wireRadius = 0.5*mm;
-  G4double wireLength = 50.0*mm;
-  
-  // Front wire (from front electrode to electrometer)
-  topWireSolid = new G4Tubs("FrontWire", 0, wireRadius, wireLength/2, 0, 360*deg);
-  topWireLogical = new G4LogicalVolume(topWireSolid, wireConnectionMaterial, "FrontWireLogical");
-  
-  // Position the front wire
-  G4RotationMatrix* frontWireRot = new G4RotationMatrix();
-  frontWireRot->rotateZ(90*deg);
-  frontWireRot->rotateX(30*deg);
-  G4ThreeVector frontWirePos(electrodeSizeX/2 - 2*mm, -lcSizeZ/2 - electrodeSizeY, wireLength/4);
-  topWirePhysical = new G4PVPlacement(frontWireRot, frontWirePos, topWireLogical, "FrontWire", worldLogical, false, 0);
-  
-  // Back wire (from back electrode to electrometer)
-  bottomWireSolid = new G4Tubs("BackWire", 0, wireRadius, wireLength/2, 0, 360*deg);
-  bottomWireLogical = new G4LogicalVolume(bottomWireSolid, wireConnectionMaterial, "BackWireLogical");
-  
-  // Position the back wire
-  G4RotationMatrix* backWireRot = new G4RotationMatrix();
-  backWireRot->rotateZ(90*deg);
-  backWireRot->rotateX(-30*deg);
-  G4ThreeVector backWirePos(-electrodeSizeX/2 + 2*mm, lcSizeZ/2 + electrodeSizeY, wireLength/4);
-  bottomWirePhysical = new G4PVPlacement(backWireRot, backWirePos, bottomWireLogical, "BackWire", worldLogical, false, 0);
-  
-  // Electrometer device (simplified as a box)
-  G4double electrometerSizeX = 8.0*cm;
-  G4double electrometerSizeY = 6.0*cm;
-  G4double electrometerSizeZ = 3.0*cm;
-  
-  // Create and position the electrometer to the right of the detector
-  electrometerSolid = new G4Box("Electrometer", electrometerSizeX/2, electrometerSizeY/2, electrometerSizeZ/2);
-  electrometerLogical = new G4LogicalVolume(electrometerSolid, electrometerCaseMaterial, "ElectrometerLogical");
-  
-  // Position the electrometer to the right of the detector setup
-  G4ThreeVector electrometerPos(10.0*cm, 0, 0);
-  electrometerPhysical = new G4PVPlacement(0, electrometerPos, electrometerLogical, "Electrometer", worldLogical, false, 0);
+  // Wires and electrometer box: full fidelity only
+  if (fFidelity == "full") {
+    // Wire connections to the electrometer (copper wires)
+    G4double wireRadius = 0.5*mm;
+    G4double wireLength = 50.0*mm;
+  
+    // Front wire (from front electrode to electrometer)
+    topWireSolid = new G4Tubs("FrontWire", 0, wireRadius, wireLength/2, 0, 360*deg);
+    topWireLogical = new G4LogicalVolume(topWireSolid, wireConnectionMaterial, "FrontWireLogical");
+  
+    // Position the front wire
+    G4RotationMatrix* frontWireRot = new G4RotationMatrix();
+    frontWireRot->rotateZ(90*deg);
+    frontWireRot->rotateX(30*deg);
+    G4ThreeVector frontWirePos(electrodeSizeX/2 - 2*mm, -lcSizeZ/2 - electrodeSizeY, wireLength/4);
+    topWirePhysical = new G4PVPlacement(frontWireRot, frontWirePos, topWireLogical, "FrontWire", worldLogical, false, 0);
+  
+    // Back wire (from back electrode to electrometer)
+    bottomWireSolid = new G4Tubs("BackWire", 0, wireRadius, wireLength/2, 0, 360*deg);
+    bottomWireLogical = new G4LogicalVolume(bottomWireSolid, wireConnectionMaterial, "BackWireLogical");
+  
+    // Position the back wire
+    G4RotationMatrix* backWireRot = new G4RotationMatrix();
+    backWireRot->rotateZ(90*deg);
+    backWireRot->rotateX(-30*deg);
+    G4ThreeVector backWirePos(-electrodeSizeX/2 + 2*mm, lcSizeZ/2 + electrodeSizeY, wireLength/4);
+    bottomWirePhysical = new G4PVPlacement(backWireRot, backWirePos, bottomWireLogical, "BackWire", worldLogical, false, 0);
+  
+    // Electrometer device (simplified as a box)
+    G4double electrometerSizeX = 8.0*cm;
+    G4double electrometerSizeY = 6.0*cm;
+    G4double electrometerSizeZ = 3.0*cm;
+  
+    // Create and position the electrometer to the right of the detector
+    electrometerSolid = new G4Box("Electrometer", electrometerSizeX/2, electrometerSizeY/2, electrometerSizeZ/2);
+    electrometerLogical = new G4LogicalVolume(electrometerSolid, electrometerCaseMaterial, "ElectrometerLogical");
+  
+    // Position the electrometer to the right of the detector setup
+    G4ThreeVector electrometerPos(10.0*cm, 0, 0);
+    electrometerPhysical = new G4PVPlacement(0, electrometerPos, electrometerLogical, "Electrometer", worldLogical, false, 0);
+  }
   
   // Set up electric field
   SetupElectricField();
@@ -247,12 +336,16 @@ G4VPhysicalVolume* LCDetectorConstruction::Construct() {
   electrodeTopLogical->SetVisAttributes(electrodeVisAtt);
   electrodeBottomLogical->SetVisAttributes(electrodeVisAtt);
   
-  G4VisAttributes* wireVisAtt = new G4VisAttributes(G4Colour(0.8, 0.5, 0.2));  // Copper color
-  topWireLogical->SetVisAttributes(wireVisAtt);
-  bottomWireLogical->SetVisAttributes(wireVisAtt);
+  if (topWireLogical && bottomWireLogical) {
+    G4VisAttributes* wireVisAtt = new G4VisAttributes(G4Colour(0.8, 0.5, 0.2));  // Copper color
+    topWireLogical->SetVisAttributes(wireVisAtt);
+    bottomWireLogical->SetVisAttributes(wireVisAtt);
+  }
   
-  G4VisAttributes* electrometerVisAtt = new G4VisAttributes(G4Colour(0.4, 0.4, 0.4));  // Dark gray
-  electrometerLogical->SetVisAttributes(electrometerVisAtt);
+  if (electrometerLogical) {
+    G4VisAttributes* electrometerVisAtt = new G4VisAttributes(G4Colour(0.4, 0.4, 0.4));  // Dark gray
+    electrometerLogical->SetVisAttributes(electrometerVisAtt);
+  }
   
   // Print detector information
   G4cout << "\n--------- 5CB Liquid Crystal Detector Parameters ---------" << G4endl;
@@ -262,9 +355,29 @@ G4VPhysicalVolume* LCDetectorConstruction::Construct() {
   G4cout << "Electric field strength: " << electricFieldStrength/(volt/um) << " V/μm = " 
          << electricFieldStrength * lcSizeZ/volt << " V across detector" << G4endl;
   G4cout << "Active volume: " << (lcSizeX*lcSizeY*lcSizeZ)/mm3 << " mm³" << G4endl;
-  G4cout << "Electrometer connections: Explicitly modeled with wires" << G4endl;
+  G4cout << "Geometry fidelity: " << fFidelity << " (world " << worldSizeX/mm << " mm, "
+         << worldFill->GetName() << ")" << G4endl;
+  if (electrometerLogical) {
+    G4cout << "Electrometer connections: Explicitly modeled with wires" << G4endl;
+  }
   G4cout << "Bias voltage: " << biasVoltage/volt << " V" << G4endl;
   G4cout << "----------------------------------------------------------\n" << G4endl;
   
   return worldPhysical;
 }
+
+void LCDetectorConstruction::SetCellMaxStep(G4double maxStep) {
+  if (!lcCellLimits) return;  // applied in Construct()
+  lcCellLimits->SetMaxAllowedStep(maxStep > 0. ? maxStep : DBL_MAX);
+}
+
+void LCDetectorConstruction::ConstructSDandField() {
+  // Cross-section biasing for gammas and neutrons (one operator per thread,
+  // re-attached when the geometry is rebuilt), restricted to the LC cell and
+  // the electrodes
+  static G4ThreadLocal LCBiasingOperator* biasingOperator = nullptr;
+  if (!biasingOperator) biasingOperator = new LCBiasingOperator();
+  biasingOperator->AttachTo(lcCellLogical);
+  biasingOperator->AttachTo(electrodeTopLogical);
+  biasingOperator->AttachTo(electrodeBottomLogical);
+}
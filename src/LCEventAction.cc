@@ -1,10 +1,24 @@
 // LCEventAction.cc - Enhanced for electrometer current measurement with memory limits
 #include "LCEventAction.hh"
+#include "LCRunAction.hh"
+#include "LCEventInformation.hh"
+#include "LCStepRecorder.hh"
+#include "LCWaveformRecorder.hh"
+#include "LCTimeline.hh"
+#include "LCMemoryTracker.hh"
+#include "LCReadoutModel.hh"
+#include "LCEventArena.hh"
+#include "LCHistograms.hh"
+#include "LCRunTermination.hh"
+#include "LCRunStatistics.hh"
+#include "LCConfiguration.hh"
+#include "LCProfiler.hh"
 #include "G4Event.hh"
 #include "G4RunManager.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4UnitsTable.hh"
 #include "G4AnalysisManager.hh"
+#include "Randomize.hh"
 #include <algorithm>
 #include <numeric>
 
@@ -14,17 +28,23 @@ namespace {
   const G4double picoampere = 1.0e-12 * ampere;
 }
 
-// Define a maximum number of current samples to store
-const G4int MAX_CURRENT_SAMPLES = 100000;
-
-LCEventAction::LCEventAction() 
+LCEventAction::LCEventAction(LCRunAction* runAction) 
   : G4UserEventAction(),
+    fRunAction(runAction),
+    fReadoutModel(nullptr),
     fTotalEnergyDeposit(0.),
     fTotalCharge(0.),
     fTotalElectrons(0),
     fTotalIons(0),
+    fWeightedEnergyDeposit(0.),
+    fHistoryWeight(1.),
+    fCurrentProfile(LCEventArena::Instance()),
     fMaxCurrent(0.),
-    fTotalCurrentIntegral(0.)
+    fTotalCurrentIntegral(0.),
+    fProfileCapacity(LCMemoryTracker::kDefaultProfileCapacity),
+    fProfileStride(1),
+    fSampleCounter(0),
+    fProfileHighWater(0)
 {
 }
 
@@ -38,17 +58,38 @@ void LCEventAction::BeginOfEventAction(const G4Event*) {
   fTotalCharge = 0.;
   fTotalElectrons = 0;
   fTotalIons = 0;
+  fWeightedEnergyDeposit = 0.;
+  fHistoryWeight = 1.;
   
-  // Clear electrometer data
-  fCurrentProfile.clear();
+  // Clear electrometer data. The arena containers hand back their memory
+  // before the arena is rewound for this event.
+  std::pmr::vector<CurrentSample>(fCurrentProfile.get_allocator()).swap(fCurrentProfile);
+  if (fReadoutModel) fReadoutModel->ReleasePulses();
+  LCEventArena::Instance()->Reset();
   fMaxCurrent = 0.;
   fTotalCurrentIntegral = 0.;
+  
+  // Buffer capacities from the memory budget
+  LCMemoryTracker* memoryTracker = LCMemoryTracker::Instance();
+  fProfileCapacity = memoryTracker->GetProfileCapacity();
+  fProfileStride = 1;
+  fSampleCounter = 0;
+  fCurrentProfile.reserve(std::min(fProfileHighWater, fProfileCapacity));
+  if (fReadoutModel) fReadoutModel->BeginEvent(memoryTracker->GetPulseCapacity());
+  
+  LC_PROFILE_BEGIN_EVENT();
 }
 
 void LCEventAction::AddCurrentPulse(G4double time, G4double current) {
-  // Add a single current pulse to the electrometer reading
-  // Only add if we haven't reached the limit
-  if (fCurrentProfile.size() < MAX_CURRENT_SAMPLES) {
+  // Add a single current pulse to the electrometer reading. Once the profile
+  // is full it is coarsened rather than truncated, so it still spans the event.
+  if (fSampleCounter++ % fProfileStride == 0) {
+    if (fCurrentProfile.size() >= fProfileCapacity) {
+      CoarsenProfile();
+    } else if (fCurrentProfile.size() == fCurrentProfile.capacity()) {
+      // Grow at most to the capacity, not past it
+      fCurrentProfile.reserve(std::min(fProfileCapacity, std::max<size_t>(16, 2 * fCurrentProfile.size())));
+    }
     fCurrentProfile.push_back(CurrentSample(time, current));
   }
   
@@ -65,10 +106,17 @@ void LCEventAction::AddCurrentPulse(G4double time, G4double current) {
 void LCEventAction::AddTimeProfile(G4double time, G4double current) {
   // This provides more detailed time profile for the electrometer
   // For example, tracking the current as charges drift over time
-  // Only add if we're below the limit
-  if (fCurrentProfile.size() < MAX_CURRENT_SAMPLES) {
-    AddCurrentPulse(time, current);
+  AddCurrentPulse(time, current);
+}
+
+void LCEventAction::CoarsenProfile() {
+  // Keep every other sample and from now on only every other new one
+  size_t kept = 0;
+  for (size_t i = 0; i < fCurrentProfile.size(); i += 2) {
+    fCurrentProfile[kept++] = fCurrentProfile[i];
   }
+  fCurrentProfile.erase(fCurrentProfile.begin() + kept, fCurrentProfile.end());
+  fProfileStride *= 2;
 }
 
 G4double LCEventAction::GetAverageElectrometerCurrent() const {
@@ -87,19 +135,64 @@ G4double LCEventAction::GetPeakElectrometerCurrent() const {
   return fMaxCurrent;
 }
 
+G4double LCEventAction::GetEventWeight() const {
+  // Without a deposit the primaries crossed or interacted elsewhere, with a
+  // survival weight above 1 or an interaction weight below it
+  if (fTotalEnergyDeposit <= 0.) return fHistoryWeight;
+  return fWeightedEnergyDeposit / fTotalEnergyDeposit;
+}
+
+void LCEventAction::BookNtuple() {
+  G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+  analysisManager->CreateNtuple("LCData", "Liquid Crystal Detector Data");
+  analysisManager->CreateNtupleDColumn("Edep");             // keV
+  analysisManager->CreateNtupleDColumn("Charge");           // pC
+  analysisManager->CreateNtupleIColumn("ElectronCount");    // number
+  analysisManager->CreateNtupleIColumn("IonCount");         // number
+  analysisManager->CreateNtupleDColumn("AvgCurrent");       // pA
+  analysisManager->CreateNtupleDColumn("PeakCurrent");      // pA
+  analysisManager->CreateNtupleDColumn("FinalTime");        // ns
+  analysisManager->CreateNtupleDColumn("FinalCurrent");     // pA
+  analysisManager->CreateNtupleDColumn("Weight");           // event weight
+  analysisManager->CreateNtupleIColumn("NPrimaries");       // number
+  analysisManager->CreateNtupleIColumn("SourceID");         // cocktail source, -1 beam, -2 mixed
+  analysisManager->CreateNtupleDColumn("Theta");            // deg, incidence angle to the beam axis
+  analysisManager->CreateNtupleDColumn("Phi");              // deg
+  analysisManager->CreateNtupleIColumn("ConfigEpoch");      // LCConfiguration epoch, 0 outside a run
+  analysisManager->FinishNtuple();
+}
+
 void LCEventAction::EndOfEventAction(const G4Event* event) {
+  LC_PROFILE_SCOPE(kProfileEndOfEvent);
+  
   // Get analysis manager
   G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
   
   // Calculate average and peak electrometer currents
   G4double avgCurrent = GetAverageElectrometerCurrent();
   G4double peakCurrent = GetPeakElectrometerCurrent();
+  G4double weight = GetEventWeight();
+  
+  // Primaries in this event (more than one in bunch mode)
+  G4int nPrimaries = 1;
+  G4int sourceID = LCEventInformation::kBeamSource;
+  G4double theta = 0., phi = 0.;
+  auto eventInfo = dynamic_cast<const LCEventInformation*>(event->GetUserInformation());
+  if (eventInfo) {
+    nPrimaries = eventInfo->GetNumberOfPrimaries();
+    sourceID = eventInfo->GetSourceID();
+    theta = eventInfo->GetTheta();
+    phi = eventInfo->GetPhi();
+  }
   
-  // Fill histograms with accumulated values
-  analysisManager->FillH1(0, fTotalEnergyDeposit/keV);
-  analysisManager->FillH1(1, fTotalCharge/picocoulomb);
-  analysisManager->FillH1(2, avgCurrent/picoampere);
-  analysisManager->FillH1(3, peakCurrent/picoampere);
+  // Fill histograms with accumulated values (thread-local, exported at end of run)
+  LCHistograms* histograms = LCHistograms::Instance();
+  histograms->H1(LCHistograms::kEdep).Fill(fTotalEnergyDeposit/keV, weight);
+  histograms->H1(LCHistograms::kCharge).Fill(fTotalCharge/picocoulomb, weight);
+  histograms->H1(LCHistograms::kAvgCurrent).Fill(avgCurrent/picoampere, weight);
+  histograms->H1(LCHistograms::kPeakCurrent).Fill(peakCurrent/picoampere, weight);
+  histograms->H2(LCHistograms::kEdepVsTheta).Fill(theta/deg, fTotalEnergyDeposit/keV, weight);
+  histograms->H2(LCHistograms::kChargeVsTheta).Fill(theta/deg, fTotalCharge/picocoulomb, weight);
   
   // Fill ntuple
   analysisManager->FillNtupleDColumn(0, fTotalEnergyDeposit/keV);
@@ -119,9 +212,10 @@ void LCEventAction::EndOfEventAction(const G4Event* event) {
     
     // Fill time profile histogram - limit the number of points for memory
     G4int stepSize = std::max(1, static_cast<G4int>(fCurrentProfile.size() / 1000));
+    LCFastH2& currentTime = histograms->H2(LCHistograms::kCurrentTime);
     for(size_t i = 0; i < fCurrentProfile.size(); i += stepSize) {
       const auto& sample = fCurrentProfile[i];
-      analysisManager->FillH2(0, sample.time/ns, sample.current/picoampere);
+      currentTime.Fill(sample.time/ns, sample.current/picoampere, weight);
     }
     
     // Fill the last sample point for this event
@@ -130,8 +224,62 @@ void LCEventAction::EndOfEventAction(const G4Event* event) {
     analysisManager->FillNtupleDColumn(7, lastSample.current/picoampere);
   }
   
+  analysisManager->FillNtupleDColumn(8, weight);
+  analysisManager->FillNtupleIColumn(9, nPrimaries);
+  analysisManager->FillNtupleIColumn(10, sourceID);
+  analysisManager->FillNtupleDColumn(11, theta/deg);
+  analysisManager->FillNtupleDColumn(12, phi/deg);
+  analysisManager->FillNtupleIColumn(13, static_cast<G4int>(LCConfiguration::CurrentEpoch()));
   analysisManager->AddNtupleRow();
   
+  // Weighted run totals for the report
+  if (fRunAction) {
+    fRunAction->AddEventTally(weight, nPrimaries, fProfileStride > 1);
+  }
+  
+  // Streaming statistics for the run summary
+  const G4double observables[kNumberOfRunObservables] = {
+    fTotalEnergyDeposit, fTotalCharge, avgCurrent, peakCurrent
+  };
+  LCRunStatistics::Instance()->AddEvent(observables, weight);
+  
+  // Adaptive runs: this thread stops after this event once the target
+  // precision or time budget has been reached (by any thread)
+  if (LCRunTermination::Instance()->AddEvent(observables, weight)) {
+    G4RunManager::GetRunManager()->AbortRun(true);
+  }
+  
+  // Buffer sizes for the memory report
+  fProfileHighWater = std::max(fProfileHighWater, fCurrentProfile.size());
+  LCMemoryTracker* memoryTracker = LCMemoryTracker::Instance();
+  LCEventArena* arena = LCEventArena::Instance();
+  memoryTracker->Track(kPoolCurrentProfile, fCurrentProfile.capacity() * sizeof(CurrentSample));
+  if (fReadoutModel) memoryTracker->Track(kPoolCurrentPulses, fReadoutModel->GetPulseBytes());
+  memoryTracker->Track(kPoolEventArena, arena->GetBlockSize() + arena->GetOverflowBytes());
+  memoryTracker->CountEvent();
+  
+  // Flush this event's deposits to the step record
+  LCStepRecorder* stepRecorder = LCStepRecorder::Instance();
+  if (stepRecorder->IsRecording()) {
+    stepRecorder->EndEvent(event);
+  }
+  
+  // Full electrometer waveform (sorted by time above) to the waveform stream
+  LCWaveformRecorder* waveformRecorder = LCWaveformRecorder::Instance();
+  if (waveformRecorder->IsRecording() && waveformRecorder->BeginEvent(event->GetEventID())) {
+    for (const auto& sample : fCurrentProfile) {
+      waveformRecorder->AddSample(sample.time, sample.current);
+    }
+    waveformRecorder->EndEvent();
+  }
+  
+  // Continuous beam: this event's drifts go to the run's merged trace
+  // (no snapshot in the offline tools, which never run a timeline)
+  const LCConfigSnapshot* config = LCConfiguration::Current();
+  if (fReadoutModel && config && config->timelineRate > 0.) {
+    LCTimeline::Instance()->AddEvent(event->GetEventID(), G4UniformRand(), *fReadoutModel);
+  }
+  
   // Print periodic update
   G4int eventID = event->GetEventID();
   if (eventID % 100 == 0) {
@@ -144,8 +292,8 @@ void LCEventAction::EndOfEventAction(const G4Event* event) {
     
     // Report number of current samples
     G4cout << "    Electrometer recorded " << fCurrentProfile.size();
-    if (fCurrentProfile.size() >= MAX_CURRENT_SAMPLES) {
-      G4cout << " (limit reached)";
+    if (fProfileStride > 1) {
+      G4cout << " (coarsened, 1 in " << fProfileStride << " kept)";
     }
     G4cout << " current samples" << G4endl;
   }
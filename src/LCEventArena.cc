@@ -0,0 +1,56 @@
+// LCEventArena.cc - Per-thread monotonic arena for the transient readout containers of one event
+#include "LCEventArena.hh"
+
+namespace {
+  // Initial block; enough for typical MIP events, grown on demand
+  const std::size_t kInitialBlockSize = 256 * 1024;
+}
+
+G4ThreadLocal LCEventArena* LCEventArena::fInstance = nullptr;
+
+LCEventArena* LCEventArena::Instance() {
+  if (!fInstance) {
+    fInstance = new LCEventArena();
+  }
+  return fInstance;
+}
+
+LCEventArena::LCEventArena()
+: fBlock(new std::byte[kInitialBlockSize]),
+  fBlockSize(kInitialBlockSize),
+  fGrowthCount(0)
+{
+  fMonotonic.emplace(fBlock.get(), fBlockSize, &fUpstream);
+}
+
+LCEventArena::~LCEventArena()
+{
+  fMonotonic.reset();
+}
+
+void LCEventArena::Reset() {
+  // Drop the heap overflow chunks; if there were any, enlarge the block so
+  // that an event of the same size fits next time
+  std::size_t overflow = fUpstream.GetBytes();
+  fMonotonic.reset();
+  fUpstream.ResetBytes();
+  if (overflow > 0) {
+    fBlockSize += overflow;
+    fBlock.reset(new std::byte[fBlockSize]);
+    fGrowthCount++;
+  }
+  fMonotonic.emplace(fBlock.get(), fBlockSize, &fUpstream);
+}
+
+void* LCEventArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+  return fMonotonic->allocate(bytes, alignment);
+}
+
+void* LCEventArena::CountingUpstream::do_allocate(std::size_t bytes, std::size_t alignment) {
+  fBytes += bytes;
+  return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void LCEventArena::CountingUpstream::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+  std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
@@ -0,0 +1,25 @@
+// LCEventInformation.cc - Per-event information attached by the primary generator
+#include "LCEventInformation.hh"
+#include "G4SystemOfUnits.hh"
+
+G4ThreadLocal G4Allocator<LCEventInformation>* LCEventInformationAllocator = nullptr;
+
+LCEventInformation::LCEventInformation(G4int nPrimaries, G4int sourceID)
+: G4VUserEventInformation(),
+  fNumberOfPrimaries(nPrimaries),
+  fSourceID(sourceID),
+  fTheta(0.),
+  fPhi(0.)
+{
+}
+
+LCEventInformation::~LCEventInformation()
+{
+}
+
+void LCEventInformation::Print() const
+{
+  G4cout << "Primaries in this event: " << fNumberOfPrimaries
+         << ", source ID: " << fSourceID
+         << ", incidence theta/phi: " << fTheta/deg << "/" << fPhi/deg << " deg" << G4endl;
+}
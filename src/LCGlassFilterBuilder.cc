@@ -0,0 +1,175 @@
+// LCGlassFilterBuilder.cc - Builds glass filter transfer tables from a slab simulation
+#include "LCGlassFilterBuilder.hh"
+#include "LCGlassFilterTable.hh"
+#include "LCPhysicsList.hh"
+
+#include "G4RunManager.hh"
+#include "G4VUserDetectorConstruction.hh"
+#include "G4VUserActionInitialization.hh"
+#include "G4VUserPrimaryGeneratorAction.hh"
+#include "G4UserSteppingAction.hh"
+#include "G4UserEventAction.hh"
+#include "G4UserStackingAction.hh"
+#include "G4ParticleGun.hh"
+#include "G4ParticleTable.hh"
+#include "G4NistManager.hh"
+#include "G4Box.hh"
+#include "G4LogicalVolume.hh"
+#include "G4PVPlacement.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4Event.hh"
+#include "G4SystemOfUnits.hh"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+namespace {
+  // Fate of the primary in the current event, filled by the stepping action
+  struct SlabTally {
+    LCGlassFilterTable* table = nullptr;
+    G4int energyIndex = 0;
+    G4double energy = 0.;
+    G4bool transmitted = false;
+    G4double exitEnergy = 0.;
+    G4double exitTheta = 0.;
+  };
+  
+  // Laterally large glass slab centred at the origin, thickness along Y like the real filter
+  class SlabConstruction : public G4VUserDetectorConstruction {
+    public:
+      G4VPhysicalVolume* Construct() override {
+        G4NistManager* nist = G4NistManager::Instance();
+        G4double worldSize = 1.0*m;
+        auto worldBox = new G4Box("World", 0.5*worldSize, 0.5*worldSize, 0.5*worldSize);
+        auto worldLV = new G4LogicalVolume(worldBox, nist->FindOrBuildMaterial("G4_Galactic"), "World");
+        auto worldPV = new G4PVPlacement(nullptr, G4ThreeVector(), worldLV, "World", nullptr, false, 0);
+        
+        auto slabBox = new G4Box("Filter", 0.45*worldSize, 0.5*LCGlassFilterTable::GetSlabThickness(), 0.45*worldSize);
+        auto slabLV = new G4LogicalVolume(slabBox, nist->FindOrBuildMaterial(LCGlassFilterTable::GetSlabMaterial()), "Filter");
+        new G4PVPlacement(nullptr, G4ThreeVector(), slabLV, "Filter", worldLV, false, 0);
+        return worldPV;
+      }
+  };
+  
+  // Pencil beam 1 mm in front of the slab, along +Y
+  class SlabGun : public G4VUserPrimaryGeneratorAction {
+    public:
+      SlabGun(const G4String& particleName, SlabTally* tally) : fTally(tally), fGun(new G4ParticleGun(1)) {
+        fGun->SetParticleDefinition(G4ParticleTable::GetParticleTable()->FindParticle(particleName));
+        fGun->SetParticleMomentumDirection(G4ThreeVector(0., 1., 0.));
+        fGun->SetParticlePosition(G4ThreeVector(0., -0.5*LCGlassFilterTable::GetSlabThickness() - 1.0*mm, 0.));
+      }
+      ~SlabGun() override { delete fGun; }
+      void GeneratePrimaries(G4Event* event) override {
+        fGun->SetParticleEnergy(fTally->energy);
+        fGun->GeneratePrimaryVertex(event);
+      }
+    private:
+      SlabTally* fTally;
+      G4ParticleGun* fGun;
+  };
+  
+  // Only the primary is followed - secondaries made in the filter are not tabulated
+  class SlabStacking : public G4UserStackingAction {
+    public:
+      G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track) override {
+        return track->GetParentID() == 0 ? fUrgent : fKill;
+      }
+  };
+  
+  // Records the primary leaving the back face of the slab; leaving through the
+  // front (backscatter) or never leaving counts as stopped
+  class SlabStepping : public G4UserSteppingAction {
+    public:
+      explicit SlabStepping(SlabTally* tally) : fTally(tally) {}
+      void UserSteppingAction(const G4Step* step) override {
+        G4StepPoint* post = step->GetPostStepPoint();
+        if (post->GetStepStatus() != fGeomBoundary) return;
+        if (step->GetPreStepPoint()->GetPhysicalVolume()->GetName() != "Filter") return;
+        
+        if (post->GetPosition().y() > 0.) {
+          fTally->transmitted = true;
+          fTally->exitEnergy = post->GetKineticEnergy();
+          fTally->exitTheta = std::acos(std::min(1.0, post->GetMomentumDirection().y()));
+        }
+        step->GetTrack()->SetTrackStatus(fStopAndKill);
+      }
+    private:
+      SlabTally* fTally;
+  };
+  
+  class SlabEvents : public G4UserEventAction {
+    public:
+      explicit SlabEvents(SlabTally* tally) : fTally(tally) {}
+      void BeginOfEventAction(const G4Event*) override { fTally->transmitted = false; }
+      void EndOfEventAction(const G4Event*) override {
+        if (fTally->transmitted) {
+          fTally->table->Fill(fTally->energyIndex, fTally->exitEnergy, fTally->exitTheta);
+        } else {
+          fTally->table->FillStopped(fTally->energyIndex);
+        }
+      }
+    private:
+      SlabTally* fTally;
+  };
+  
+  class SlabActionInitialization : public G4VUserActionInitialization {
+    public:
+      SlabActionInitialization(const G4String& particleName, SlabTally* tally)
+      : fParticleName(particleName), fTally(tally) {}
+      void Build() const override {
+        SetUserAction(new SlabGun(fParticleName, fTally));
+        SetUserAction(new SlabStacking());
+        SetUserAction(new SlabStepping(fTally));
+        SetUserAction(new SlabEvents(fTally));
+      }
+    private:
+      G4String fParticleName;
+      SlabTally* fTally;
+  };
+}
+
+G4int LCGlassFilterBuilder::Build(const G4String& particleName, G4int eventsPerEnergy, const G4String& directory)
+{
+  std::vector<G4double> energies = LCGlassFilterTable::DefaultEnergyGrid();
+  LCGlassFilterTable table(particleName, energies);
+  SlabTally tally;
+  tally.table = &table;
+  
+  G4cout << "Building glass filter table for " << particleName << ": "
+         << LCGlassFilterTable::GetSlabThickness()/mm << " mm " << LCGlassFilterTable::GetSlabMaterial()
+         << ", " << energies.size() << " energies x " << eventsPerEnergy << " events" << G4endl;
+  
+  // The slab simulation always runs sequentially
+  auto runManager = new G4RunManager();
+  runManager->SetUserInitialization(new SlabConstruction());
+  runManager->SetUserInitialization(new LCPhysicsList());
+  
+  // Particles exist once the physics list is set
+  if (!G4ParticleTable::GetParticleTable()->FindParticle(particleName)) {
+    G4cerr << "ERROR: Unknown particle for glass filter table: " << particleName << G4endl;
+    delete runManager;
+    return 1;
+  }
+  
+  runManager->SetUserInitialization(new SlabActionInitialization(particleName, &tally));
+  runManager->Initialize();
+  
+  for (size_t i = 0; i < energies.size(); i++) {
+    tally.energyIndex = static_cast<G4int>(i);
+    tally.energy = energies[i];
+    runManager->BeamOn(eventsPerEnergy);
+    G4cout << "  " << energies[i]/MeV << " MeV done" << G4endl;
+  }
+  delete runManager;
+  
+  table.Finalize();
+  std::error_code ec;
+  std::filesystem::create_directories(directory.c_str(), ec);
+  G4String fileName = LCGlassFilterTable::GetFileName(directory, particleName);
+  if (!table.Save(fileName)) return 1;
+  
+  G4cout << "Glass filter table written to " << fileName << G4endl;
+  return 0;
+}
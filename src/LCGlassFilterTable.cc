@@ -0,0 +1,256 @@
+// LCGlassFilterTable.cc - Tabulated transfer of beam particles through the glass filter
+#include "LCGlassFilterTable.hh"
+#include "LCGlobalManager.hh"
+#include "LCPhysicsList.hh"
+#include "LCResultCache.hh"
+#include "G4AutoLock.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <sstream>
+
+namespace {
+  G4Mutex tableMutex = G4MUTEX_INITIALIZER;
+  
+  const G4int kFileVersion = 1;
+  
+  // Relative energy loss: bin 0 below kMinLoss (no loss), then log bins up to 1
+  const G4int kLossBins = 50;
+  const G4double kMinLoss = 1.0e-6;
+  
+  // Angle to the beam: bin 0 below kMinAngle (unscattered), then log bins up to 90 deg
+  const G4int kAngleBins = 30;
+  const G4double kMinAngle = 1.0e-4;  // rad
+  
+  const G4int kCells = (kLossBins + 1) * (kAngleBins + 1) + 1;
+  const G4int kStoppedCell = kCells - 1;
+  
+  G4double LogBinEdge(G4double min, G4double max, G4int nBins, G4int i) {
+    return min * std::pow(max / min, G4double(i) / nBins);
+  }
+  
+  // Uniform in log within a log bin, uniform in [0, min) for the first bin
+  G4double SampleLogBin(G4double min, G4double max, G4int nBins, G4int bin) {
+    if (bin == 0) return min * G4UniformRand();
+    G4double low = LogBinEdge(min, max, nBins, bin - 1);
+    G4double high = LogBinEdge(min, max, nBins, bin);
+    return low * std::pow(high / low, G4UniformRand());
+  }
+}
+
+LCGlassFilterTable::LCGlassFilterTable(const G4String& particleName, const std::vector<G4double>& energies)
+: fParticleName(particleName),
+  fEnergies(energies),
+  fCounts(energies.size(), std::vector<G4double>(kCells, 0.)),
+  fTables(energies.size())
+{
+}
+
+LCGlassFilterTable::~LCGlassFilterTable()
+{
+}
+
+G4double LCGlassFilterTable::GetSlabThickness() {
+  // Same as the source offset applied by the generator with the filter on
+  return 3.0*mm;
+}
+
+G4String LCGlassFilterTable::GetSlabMaterial() {
+  return "G4_GLASS_PLATE";
+}
+
+std::vector<G4double> LCGlassFilterTable::DefaultEnergyGrid() {
+  // 8 points per decade
+  std::vector<G4double> energies;
+  const G4int nPoints = 7 * 8 + 1;
+  for (G4int i = 0; i < nPoints; i++) {
+    energies.push_back(LogBinEdge(1.0*keV, 10.0*GeV, nPoints - 1, i));
+  }
+  return energies;
+}
+
+G4int LCGlassFilterTable::LossBin(G4double loss) const {
+  if (loss < kMinLoss) return 0;
+  G4int bin = 1 + G4int(kLossBins * std::log(loss / kMinLoss) / std::log(1.0 / kMinLoss));
+  return std::min(bin, kLossBins);
+}
+
+G4int LCGlassFilterTable::AngleBin(G4double theta) const {
+  if (theta < kMinAngle) return 0;
+  G4int bin = 1 + G4int(kAngleBins * std::log(theta / kMinAngle) / std::log(halfpi / kMinAngle));
+  return std::min(bin, kAngleBins);
+}
+
+void LCGlassFilterTable::Fill(G4int energyIndex, G4double energyOut, G4double theta) {
+  G4double loss = 1.0 - energyOut / fEnergies[energyIndex];
+  if (loss < 0.) loss = 0.;
+  fCounts[energyIndex][LossBin(loss) * (kAngleBins + 1) + AngleBin(theta)] += 1.;
+}
+
+void LCGlassFilterTable::FillStopped(G4int energyIndex) {
+  fCounts[energyIndex][kStoppedCell] += 1.;
+}
+
+void LCGlassFilterTable::Finalize() {
+  std::ostringstream signature;
+  signature << fParticleName;
+  for (size_t i = 0; i < fEnergies.size(); i++) {
+    fTables[i].Build(fCounts[i]);
+    for (size_t j = 0; j < fCounts[i].size(); j++) {
+      if (fCounts[i][j] > 0.) signature << ";" << i << ":" << j << "=" << fCounts[i][j];
+    }
+  }
+  fSignature = LCResultCache::HashString(signature.str());
+}
+
+G4String LCGlassFilterTable::GetFileName(const G4String& directory, const G4String& particleName) {
+  return directory + "/glass_filter_" + particleName + ".lcft";
+}
+
+G4bool LCGlassFilterTable::Save(const G4String& fileName) const {
+  std::ofstream out(fileName);
+  if (!out.is_open()) {
+    G4cerr << "ERROR: Could not write glass filter table: " << fileName << G4endl;
+    return false;
+  }
+  
+  // Text format: header, grid, then the non-empty cells of each grid energy
+  out << std::setprecision(10);
+  out << "LCGlassFilterTable " << kFileVersion << "\n";
+  out << "particle " << fParticleName << "\n";
+  out << "slab " << GetSlabMaterial() << " " << GetSlabThickness()/mm << "\n";
+  out << "physics " << LCPhysicsList::GetConfigurationTag(false) << "\n";
+  out << "bins " << kLossBins << " " << kMinLoss << " " << kAngleBins << " " << kMinAngle << "\n";
+  out << "energies " << fEnergies.size();
+  for (G4double energy : fEnergies) out << " " << energy/MeV;
+  out << "\n";
+  for (size_t i = 0; i < fEnergies.size(); i++) {
+    out << "row " << i;
+    for (size_t j = 0; j < fCounts[i].size(); j++) {
+      if (fCounts[i][j] > 0.) out << " " << j << ":" << fCounts[i][j];
+    }
+    out << "\n";
+  }
+  return static_cast<G4bool>(out);
+}
+
+LCGlassFilterTable* LCGlassFilterTable::Load(const G4String& fileName) {
+  std::ifstream in(fileName);
+  if (!in.is_open()) return nullptr;
+  
+  std::string tag, particle, material, physics;
+  G4int version = 0, lossBins = 0, angleBins = 0;
+  G4double thickness = 0., minLoss = 0., minAngle = 0.;
+  size_t nEnergies = 0;
+  
+  in >> tag >> version;
+  if (tag != "LCGlassFilterTable" || version != kFileVersion) {
+    G4cerr << "WARNING: " << fileName << " is not a version " << kFileVersion << " glass filter table" << G4endl;
+    return nullptr;
+  }
+  in >> tag >> particle;
+  in >> tag >> material >> thickness;
+  in >> tag;
+  std::getline(in >> std::ws, physics);
+  in >> tag >> lossBins >> minLoss >> angleBins >> minAngle;
+  
+  // Tables built for another slab, physics list or binning are stale
+  if (material != GetSlabMaterial() || std::abs(thickness*mm - GetSlabThickness()) > 1e-9*mm ||
+      physics != LCPhysicsList::GetConfigurationTag(false) ||
+      lossBins != kLossBins || angleBins != kAngleBins) {
+    G4cerr << "WARNING: Glass filter table " << fileName << " does not match the current "
+           << "filter/physics setup - rebuild it with --build-filter-table " << particle << G4endl;
+    return nullptr;
+  }
+  
+  in >> tag >> nEnergies;
+  std::vector<G4double> energies(nEnergies);
+  for (auto& energy : energies) {
+    in >> energy;
+    energy *= MeV;
+  }
+  if (!in) return nullptr;
+  
+  auto table = new LCGlassFilterTable(particle, energies);
+  std::string line;
+  std::getline(in, line);
+  while (std::getline(in, line)) {
+    std::istringstream iss(line);
+    size_t row = 0;
+    if (!(iss >> tag >> row) || tag != "row" || row >= nEnergies) continue;
+    std::string cell;
+    while (iss >> cell) {
+      size_t colon = cell.find(':');
+      if (colon == std::string::npos) continue;
+      G4int index = std::stoi(cell.substr(0, colon));
+      if (index >= 0 && index < kCells) table->fCounts[row][index] = std::stod(cell.substr(colon + 1));
+    }
+  }
+  table->Finalize();
+  return table;
+}
+
+const LCGlassFilterTable* LCGlassFilterTable::Get(const G4String& particleName) {
+  G4AutoLock lock(&tableMutex);
+  
+  // Tables are kept for the whole session, keyed by file
+  static std::map<G4String, std::unique_ptr<LCGlassFilterTable>> tables;
+  G4String fileName = GetFileName(LCGlobalManager::Instance()->GetGlassFilterTableDir(), particleName);
+  auto it = tables.find(fileName);
+  if (it == tables.end()) {
+    LCGlassFilterTable* table = Load(fileName);
+    if (table) {
+      G4cout << "Loaded glass filter table " << fileName << G4endl;
+    } else {
+      G4cout << "No glass filter table for " << particleName << " (" << fileName << ")"
+             << " - using the simple filter model" << G4endl;
+    }
+    it = tables.emplace(fileName, std::unique_ptr<LCGlassFilterTable>(table)).first;
+  }
+  return it->second.get();
+}
+
+void LCGlassFilterTable::SampleCell(G4int energyIndex, G4double& loss, G4double& theta, G4bool& stopped) const {
+  G4int cell = fTables[energyIndex].Sample();
+  stopped = (cell == kStoppedCell);
+  if (stopped) return;
+  
+  loss = SampleLogBin(kMinLoss, 1.0, kLossBins, cell / (kAngleBins + 1));
+  theta = SampleLogBin(kMinAngle, halfpi, kAngleBins, cell % (kAngleBins + 1));
+  if (cell / (kAngleBins + 1) == 0) loss = 0.;
+}
+
+G4bool LCGlassFilterTable::Sample(G4double energyIn, G4double& energyOut, G4double& theta) const {
+  // Pick one of the two neighbouring grid energies, linearly in log(E), and
+  // apply its relative energy loss to the actual energy
+  G4int n = static_cast<G4int>(fEnergies.size());
+  G4int index = 0;
+  if (energyIn >= fEnergies[n - 1]) {
+    index = n - 1;
+  } else if (energyIn > fEnergies[0]) {
+    G4int upper = G4int(std::upper_bound(fEnergies.begin(), fEnergies.end(), energyIn) - fEnergies.begin());
+    G4double fraction = std::log(energyIn / fEnergies[upper - 1]) / std::log(fEnergies[upper] / fEnergies[upper - 1]);
+    index = (G4UniformRand() < fraction) ? upper : upper - 1;
+  }
+  
+  // Grid points without statistics fall back to the nearest filled one below
+  while (index > 0 && fTables[index].IsEmpty()) index--;
+  if (fTables[index].IsEmpty()) {
+    energyOut = energyIn;
+    theta = 0.;
+    return true;
+  }
+  
+  G4double loss = 0.;
+  G4bool stopped = false;
+  SampleCell(index, loss, theta, stopped);
+  if (stopped) return false;
+  
+  energyOut = energyIn * (1.0 - loss);
+  return true;
+}
@@ -1,5 +1,6 @@
 // LCGlobalManager.cc
 #include "LCGlobalManager.hh"
+#include "LCCocktailGenerator.hh"
 
 // Initialize static member
 LCGlobalManager* LCGlobalManager::fInstance = nullptr;
@@ -13,7 +14,56 @@ LCGlobalManager* LCGlobalManager::Instance() {
 
 LCGlobalManager::LCGlobalManager()
 : fParticleName("proton"),
-  fParticleEnergy(0.5*GeV)
+  fParticleEnergy(0.5*GeV),
+  fGlassFilterEnabled(false),
+  fGlassFilterModel("simple"),
+  fGlassFilterTableDir("lc_filter_tables"),
+  fRandomSeed(0),
+  fRandomSeedFixed(false),
+  fStepRecordingEnabled(false),
+  fWaveformRecordingEnabled(false),
+  fWaveformTimeStep(1.*picosecond),
+  fWaveformCurrentStep(1.0e-15*ampere),
+  fTransportModel("constant"),
+  fMemoryBudget(0),
+  fBiasingEnabled(false),
+  fGammaBiasFactor(1.0),
+  fNeutronBiasFactor(1.0),
+  fBunchPrimaries(1.0),
+  fBunchPoisson(false),
+  fBunchCount(1),
+  fBunchSpacing(0.),
+  fBunchLength(0.),
+  fTimelineRate(0.),
+  fTimelineBinWidth(10.*us),
+  fTimelineWindow(1.*s),
+  fCocktailEnabled(false),
+  fCocktail(new LCCocktailGenerator()),
+  fAngularMode("off"),
+  fAngularThetaMin(0.),
+  fAngularThetaMax(90.*deg),
+  fTargetPrecision(0.),
+  fTargetObservables("Charge"),
+  fTimeBudget(0.),
+  fMinAdaptiveEvents(1000),
+  fCampaignStore("campaign"),
+  fCondenseEnergy(0.),
+  fCondenseRange(0.),
+  fCellMaxStep(0.),
+  fGeometryFidelity("full")
 {
     // Default values
 }
+
+void LCGlobalManager::AddAngularPoint(G4double theta, G4double phi, G4double weight) {
+    fAngularPoints.push_back({theta, phi, weight});
+    
+    std::vector<G4double> weights;
+    for (const auto& point : fAngularPoints) weights.push_back(point.weight);
+    fAngularPointTable.Build(weights);
+}
+
+void LCGlobalManager::ClearAngularPoints() {
+    fAngularPoints.clear();
+    fAngularPointTable.Build(std::vector<G4double>());
+}
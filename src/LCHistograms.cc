@@ -0,0 +1,198 @@
+// LCHistograms.cc - Thread-local fixed-binning histograms exported to the analysis manager at end of run
+#include "LCHistograms.hh"
+#include "G4AnalysisManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4AutoLock.hh"
+#include <algorithm>
+
+// Define units for convenience
+namespace {
+  const G4double picocoulomb = 1.0e-12 * coulomb;
+  const G4double picoampere = 1.0e-12 * ampere;
+}
+
+void LCFastH1::Book(G4int nBins, G4double min, G4double max) {
+  fNbins = nBins;
+  fNcells = nBins + 2;
+  fMin = min;
+  fMax = max;
+  fInvWidth = nBins / (max - min);
+  fCells.assign(3 * fNcells, 0.);
+}
+
+void LCFastH1::Reset() {
+  std::fill(fCells.begin(), fCells.end(), 0.);
+}
+
+G4double LCFastH1::BinCenter(G4int bin) const {
+  // Under/overflow are exported half a bin outside the axis
+  return fMin + (bin - 0.5) / fInvWidth;
+}
+
+void LCFastH1::Export(G4int id) const {
+  if (fCells.empty()) return; // not booked on this thread
+  tools::histo::h1d* h1 = G4AnalysisManager::Instance()->GetH1(id);
+  if (!h1) return;
+  
+  // Bin sums are added as they are, so errors and entries survive; the
+  // x moments (mean, RMS) are taken at the bin centres
+  for (G4int bin = 0; bin < fNcells; bin++) {
+    G4double entries = GetBinEntries(bin);
+    if (entries == 0.) continue;
+    unsigned int oldEntries;
+    G4double sumW, sumW2, sumXW, sumX2W;
+    h1->get_bin_content(bin, oldEntries, sumW, sumW2, sumXW, sumX2W);
+    G4double x = BinCenter(bin);
+    G4double w = GetBinContent(bin);
+    h1->set_bin_content(bin, oldEntries + static_cast<unsigned int>(entries),
+                        sumW + w, sumW2 + GetBinError2(bin),
+                        sumXW + w * x, sumX2W + w * x * x);
+  }
+}
+
+void LCFastH2::Book(G4int nBinsX, G4double minX, G4double maxX,
+                    G4int nBinsY, G4double minY, G4double maxY) {
+  fX.Book(nBinsX, minX, maxX);
+  fY.Book(nBinsY, minY, maxY);
+  fStrideX = nBinsY + 2;
+  fNcells = (nBinsX + 2) * (nBinsY + 2);
+  fCells.assign(3 * fNcells, 0.);
+}
+
+void LCFastH2::Reset() {
+  std::fill(fCells.begin(), fCells.end(), 0.);
+}
+
+void LCFastH2::Export(G4int id) const {
+  if (fCells.empty()) return;
+  tools::histo::h2d* h2 = G4AnalysisManager::Instance()->GetH2(id);
+  if (!h2) return;
+  
+  for (size_t cell = 0; cell < fNcells; cell++) {
+    G4double entries = fCells[2*fNcells + cell];
+    if (entries == 0.) continue;
+    unsigned int binX = static_cast<unsigned int>(cell) / fStrideX;
+    unsigned int binY = static_cast<unsigned int>(cell) % fStrideX;
+    unsigned int oldEntries;
+    G4double sumW, sumW2, sumXW, sumX2W, sumYW, sumY2W;
+    h2->get_bin_content(binX, binY, oldEntries, sumW, sumW2, sumXW, sumX2W, sumYW, sumY2W);
+    G4double x = fX.BinCenter(binX);
+    G4double y = fY.BinCenter(binY);
+    G4double w = fCells[cell];
+    h2->set_bin_content(binX, binY, oldEntries + static_cast<unsigned int>(entries),
+                        sumW + w, sumW2 + fCells[fNcells + cell],
+                        sumXW + w * x, sumX2W + w * x * x,
+                        sumYW + w * y, sumY2W + w * y * y);
+  }
+}
+
+G4ThreadLocal LCHistograms* LCHistograms::fInstance = nullptr;
+std::vector<G4double> LCHistograms::fProcessTotal;
+
+namespace {
+  G4Mutex processTotalMutex = G4MUTEX_INITIALIZER;
+}
+
+LCHistograms* LCHistograms::Instance() {
+  if (!fInstance) {
+    fInstance = new LCHistograms();
+  }
+  return fInstance;
+}
+
+void LCHistograms::Book() {
+  G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+  LCHistograms* histograms = Instance();
+  
+  // Each histogram is booked twice with the same binning: in the analysis
+  // manager (for output) and as the fast copy that is actually filled
+  auto bookH1 = [&](H1ID id, const G4String& name, const G4String& title,
+                    G4int nBins, G4double min, G4double max) {
+    analysisManager->CreateH1(name, title, nBins, min, max);
+    histograms->fH1[id].Book(nBins, min, max);
+  };
+  auto bookH2 = [&](H2ID id, const G4String& name, const G4String& title,
+                    G4int nBinsX, G4double minX, G4double maxX,
+                    G4int nBinsY, G4double minY, G4double maxY) {
+    analysisManager->CreateH2(name, title, nBinsX, minX, maxX, nBinsY, minY, maxY);
+    histograms->fH2[id].Book(nBinsX, minX, maxX, nBinsY, minY, maxY);
+  };
+  
+  // Histogram for energy deposition
+  bookH1(kEdep, "Edep", "Energy Deposit in Liquid Crystal", 100, 0., 500*keV);
+  
+  // Histogram for charge collection
+  bookH1(kCharge, "Charge", "Charge Collected", 100, 0., 100*picocoulomb);
+  
+  // Histograms for electrometer current
+  bookH1(kAvgCurrent, "AvgCurrent", "Average Electrometer Current", 100, 0., 1000*picoampere);
+  bookH1(kPeakCurrent, "PeakCurrent", "Peak Electrometer Current", 100, 0., 5000*picoampere);
+  
+  // 2D histogram for current vs time
+  bookH2(kCurrentTime, "CurrentTime", "Electrometer Current vs Time",
+         1000, 0., 1000*ns,  // Time bins
+         100, 0., 1000*picoampere); // Current bins
+  
+  // Histogram for spatial distribution of charge
+  bookH2(kChargeDist, "ChargeDist", "Charge Distribution in XY",
+         100, -10*mm, 10*mm,
+         100, -15*mm, 15*mm);
+  
+  // Response vs incidence angle (angular mode), 5 deg bins
+  bookH2(kEdepVsTheta, "EdepVsTheta", "Energy Deposit vs Incidence Angle;theta [deg];Edep [keV]",
+         18, 0., 90.,
+         100, 0., 500.);
+  bookH2(kChargeVsTheta, "ChargeVsTheta", "Charge Collected vs Incidence Angle;theta [deg];Charge [pC]",
+         18, 0., 90.,
+         100, 0., 100.);
+}
+
+void LCHistograms::Reset() {
+  for (auto& h1 : fH1) h1.Reset();
+  for (auto& h2 : fH2) h2.Reset();
+}
+
+void LCHistograms::Export() {
+  for (G4int id = 0; id < kNumberOfH1; id++) fH1[id].Export(id);
+  for (G4int id = 0; id < kNumberOfH2; id++) fH2[id].Export(id);
+  Reset();
+}
+
+G4int LCHistograms::GetNumberOfCells() {
+  size_t cells = 0;
+  for (auto& h1 : fH1) cells += h1.GetContents().size();
+  for (auto& h2 : fH2) cells += h2.GetContents().size();
+  return static_cast<G4int>(cells);
+}
+
+void LCHistograms::AddToProcessTotal() {
+  G4AutoLock lock(&processTotalMutex);
+  fProcessTotal.resize(GetNumberOfCells(), 0.);
+  
+  // Same order as SetContents: all H1 then all H2, bins in storage order
+  size_t cell = 0;
+  auto add = [&](std::vector<G4double>& contents) {
+    for (G4double value : contents) fProcessTotal[cell++] += value;
+  };
+  for (auto& h1 : fH1) add(h1.GetContents());
+  for (auto& h2 : fH2) add(h2.GetContents());
+  Reset();
+}
+
+void LCHistograms::AppendProcessTotal(std::vector<G4double>& cells) {
+  G4AutoLock lock(&processTotalMutex);
+  
+  // Empty when this rank simulated no events
+  fProcessTotal.resize(GetNumberOfCells(), 0.);
+  cells.insert(cells.end(), fProcessTotal.begin(), fProcessTotal.end());
+  fProcessTotal.clear();
+}
+
+void LCHistograms::SetContents(const G4double* cells) {
+  auto set = [&](std::vector<G4double>& contents) {
+    std::copy(cells, cells + contents.size(), contents.begin());
+    cells += contents.size();
+  };
+  for (auto& h1 : fH1) set(h1.GetContents());
+  for (auto& h2 : fH2) set(h2.GetContents());
+}
@@ -0,0 +1,101 @@
+// LCMPIManager.cc - Process-level MPI state: event split, per-rank seeds and reduction to rank 0
+#include "LCMPIManager.hh"
+#include <cstdint>
+#include <cstdlib>
+
+#ifdef LC_USE_MPI
+#include <mpi.h>
+#endif
+
+LCMPIManager* LCMPIManager::fInstance = nullptr;
+
+LCMPIManager* LCMPIManager::Instance() {
+  if (!fInstance) {
+    fInstance = new LCMPIManager();
+  }
+  return fInstance;
+}
+
+void LCMPIManager::Initialize(int* argc, char*** argv) {
+#ifdef LC_USE_MPI
+  if (fInitialized) return;
+  
+  // Worker threads never call MPI
+  int provided = 0;
+  MPI_Init_thread(argc, argv, MPI_THREAD_FUNNELED, &provided);
+  MPI_Comm_rank(MPI_COMM_WORLD, &fRank);
+  MPI_Comm_size(MPI_COMM_WORLD, &fSize);
+  fInitialized = true;
+  
+  if (fRank == 0) {
+    G4cout << "MPI: " << fSize << " ranks" << G4endl;
+    if (provided < MPI_THREAD_FUNNELED) {
+      G4cerr << "Warning: MPI library does not provide MPI_THREAD_FUNNELED" << G4endl;
+    }
+  }
+#else
+  (void)argc;
+  (void)argv;
+  G4cerr << "Warning: built without LC_USE_MPI - running as a single process" << G4endl;
+#endif
+}
+
+void LCMPIManager::Finalize() {
+#ifdef LC_USE_MPI
+  if (!fInitialized) return;
+  MPI_Finalize();
+  fInitialized = false;
+#endif
+}
+
+G4int LCMPIManager::GetEventShare(G4int nEvents) const {
+  G4int share = nEvents / fSize;
+  if (fRank < nEvents % fSize) share++;
+  return share;
+}
+
+long LCMPIManager::BroadcastSeed(long seed) const {
+#ifdef LC_USE_MPI
+  if (fInitialized) MPI_Bcast(&seed, 1, MPI_LONG, 0, MPI_COMM_WORLD);
+#endif
+  return seed;
+}
+
+long LCMPIManager::GetRankSeed(long seed) const {
+  if (fRank == 0) return seed;
+  
+  // splitmix64 of (seed, rank): reproducible and decorrelated between ranks
+  std::uint64_t z = static_cast<std::uint64_t>(seed) + static_cast<std::uint64_t>(fRank) * 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z ^= z >> 31;
+  return static_cast<long>(z & 0x7fffffffULL);
+}
+
+void LCMPIManager::ReduceSum(std::vector<G4double>& values) const {
+#ifdef LC_USE_MPI
+  if (!fInitialized || fSize < 2) return;
+  G4int count = static_cast<G4int>(values.size());
+  if (fRank == 0) {
+    MPI_Reduce(MPI_IN_PLACE, values.data(), count, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  } else {
+    MPI_Reduce(values.data(), nullptr, count, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  }
+#else
+  (void)values;
+#endif
+}
+
+void LCMPIManager::Broadcast(std::vector<G4double>& values) const {
+#ifdef LC_USE_MPI
+  if (!fInitialized || fSize < 2) return;
+  MPI_Bcast(values.data(), static_cast<G4int>(values.size()), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+#else
+  (void)values;
+#endif
+}
+
+G4String LCMPIManager::GetFileSuffix() const {
+  if (fRank == 0) return "";
+  return "_rank" + std::to_string(fRank);
+}
@@ -0,0 +1,133 @@
+// LCMemoryTracker.cc - Per-thread accounting of the simulation's own buffers and memory budget
+#include "LCMemoryTracker.hh"
+#include "LCConfiguration.hh"
+#include "G4AutoLock.hh"
+#include "G4Threading.hh"
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace {
+  G4Mutex reportMutex = G4MUTEX_INITIALIZER;
+  std::vector<LCThreadMemoryReport> publishedReports;
+  
+  const char* kPoolNames[kNumberOfMemoryPools] = {
+    "CurrentProfile", "CurrentPulses", "StepRecords", "EventArena", "WaveformBlocks"
+  };
+  
+  // Element sizes, to turn byte shares into capacities
+  const std::size_t kProfileSampleSize = 2 * sizeof(G4double);
+  const std::size_t kPulseSize = 3 * sizeof(G4double);
+  
+  // Smallest useful capacities, kept even if the budget is tighter
+  const std::size_t kMinProfileCapacity = 1000;
+  const std::size_t kMinPulseCapacity = 1000;
+}
+
+G4ThreadLocal LCMemoryTracker* LCMemoryTracker::fInstance = nullptr;
+
+LCMemoryTracker* LCMemoryTracker::Instance() {
+  if (!fInstance) {
+    fInstance = new LCMemoryTracker();
+  }
+  return fInstance;
+}
+
+LCMemoryTracker::LCMemoryTracker()
+: fEvents(0),
+  fEventAllocations(0),
+  fReadoutAllocations(0),
+  fEventsWithAllocations(0),
+  fHighWater(),
+  fProfileCapacity(kDefaultProfileCapacity),
+  fPulseCapacity(std::numeric_limits<std::size_t>::max()),
+  fStepRecordBudget(0)
+{
+}
+
+const char* LCMemoryTracker::PoolName(LCMemoryPool pool) {
+  return kPoolNames[pool];
+}
+
+void LCMemoryTracker::CountEvent() {
+  fEvents++;
+  fReadoutAllocations += fEventAllocations;
+  if (fEventAllocations > 0) fEventsWithAllocations++;
+  fEventAllocations = 0;
+}
+
+void LCMemoryTracker::BeginRun() {
+  fEvents = 0;
+  fEventAllocations = 0;
+  fReadoutAllocations = 0;
+  fEventsWithAllocations = 0;
+  std::fill(fHighWater, fHighWater + kNumberOfMemoryPools, 0);
+  
+  fProfileCapacity = kDefaultProfileCapacity;
+  fPulseCapacity = std::numeric_limits<std::size_t>::max();
+  fStepRecordBudget = 0;
+  
+  const LCConfigSnapshot* config = LCConfiguration::Current();
+  std::size_t budget = config ? config->memoryBudget : 0;
+  if (budget == 0) return;
+  
+  // Per-thread share: half for the electrometer profile, a quarter each for
+  // the pulse list and the step records. Geant4's own memory (geometry,
+  // physics tables, stacks, histograms) is not part of the budget.
+  G4int nThreads = std::max(1, G4Threading::GetNumberOfRunningWorkerThreads());
+  std::size_t share = budget / nThreads;
+  fProfileCapacity = ProfileCapacityForBudget(budget, nThreads);
+  fPulseCapacity = std::max(kMinPulseCapacity, share / 4 / kPulseSize);
+  fStepRecordBudget = share / 4;
+}
+
+std::size_t LCMemoryTracker::ProfileCapacityForBudget(std::size_t budget, G4int nThreads) {
+  if (budget == 0) return kDefaultProfileCapacity;
+  std::size_t share = budget / std::max(1, nThreads);
+  return std::max(kMinProfileCapacity, std::min(kDefaultProfileCapacity, share / 2 / kProfileSampleSize));
+}
+
+void LCMemoryTracker::EndRun() {
+  if (fEvents == 0) return;
+  
+  LCThreadMemoryReport report;
+  report.threadID = G4Threading::G4GetThreadId();
+  report.events = fEvents;
+  std::copy(fHighWater, fHighWater + kNumberOfMemoryPools, report.highWater);
+  report.readoutAllocations = fReadoutAllocations;
+  report.eventsWithAllocations = fEventsWithAllocations;
+  
+  G4AutoLock lock(&reportMutex);
+  publishedReports.push_back(report);
+}
+
+std::vector<LCThreadMemoryReport> LCMemoryTracker::CollectReports() {
+  G4AutoLock lock(&reportMutex);
+  std::vector<LCThreadMemoryReport> reports;
+  reports.swap(publishedReports);
+  std::sort(reports.begin(), reports.end(),
+            [](const LCThreadMemoryReport& a, const LCThreadMemoryReport& b) {
+              return a.threadID < b.threadID;
+            });
+  return reports;
+}
+
+std::size_t LCMemoryTracker::GetCurrentRSS() {
+  // Second field of /proc/self/statm: resident pages
+  std::size_t pages = 0;
+  FILE* statm = std::fopen("/proc/self/statm", "r");
+  if (statm) {
+    unsigned long size = 0, resident = 0;
+    if (std::fscanf(statm, "%lu %lu", &size, &resident) == 2) pages = resident;
+    std::fclose(statm);
+  }
+  return pages * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+std::size_t LCMemoryTracker::GetPeakRSS() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  return static_cast<std::size_t>(usage.ru_maxrss) * 1024;  // Linux reports kilobytes
+}
@@ -1,17 +1,19 @@
 // LCMessenger.cc - Complete implementation with new commands
 #include "LCMessenger.hh"
-#include "LCPrimaryGeneratorAction.hh"
 #include "LCRunAction.hh"
 #include "LCDetectorConstruction.hh"
 #include "LCGlobalManager.hh"
+#include "LCResultCache.hh"
+#include "LCCocktailGenerator.hh"
+#include "LCRunTermination.hh"
 #include "G4RunManager.hh"
+#include <sstream>
 
-LCMessenger::LCMessenger(LCPrimaryGeneratorAction* primaryAction, LCRunAction* runAction,
-                         LCDetectorConstruction* detConstruction)
+LCMessenger::LCMessenger(LCRunAction* runAction, LCDetectorConstruction* detConstruction)
 : G4UImessenger(),
-  fPrimaryAction(primaryAction),
   fRunAction(runAction),
-  fDetConstruction(detConstruction)
+  fDetConstruction(detConstruction),
+  fResultCache(new LCResultCache())
 {
   // Create main LC directory
   fLCDir = new G4UIdirectory("/LC/");
@@ -30,6 +32,8 @@ LCMessenger::LCMessenger(LCPrimaryGeneratorAction* primaryAction, LCRunAction* r
   fParticleCmd->SetGuidance("Set particle type (e.g., proton, e-, gamma)");
   fParticleCmd->SetParameterName("ParticleType", false);
   fParticleCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  // Workers pick beam settings up from the published configuration
+  fParticleCmd->SetToBeBroadcasted(false);
   
   // Command to set particle energy
   fEnergyCmd = new G4UIcmdWithADoubleAndUnit("/LC/beam/energy", this);
@@ -38,12 +42,29 @@ LCMessenger::LCMessenger(LCPrimaryGeneratorAction* primaryAction, LCRunAction* r
   fEnergyCmd->SetUnitCategory("Energy");
   fEnergyCmd->SetUnitCandidates("eV keV MeV GeV");
   fEnergyCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fEnergyCmd->SetToBeBroadcasted(false);
   
   // Command to set glass filter
   fGlassFilterCmd = new G4UIcmdWithABool("/LC/beam/glassFilter", this);
   fGlassFilterCmd->SetGuidance("Enable/disable glass filter before detector");
   fGlassFilterCmd->SetParameterName("GlassFilter", false);
   fGlassFilterCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fGlassFilterCmd->SetToBeBroadcasted(false);
+  
+  // Commands to select the glass filter model (global settings, set once on the master)
+  fGlassFilterModelCmd = new G4UIcmdWithAString("/LC/beam/glassFilterModel", this);
+  fGlassFilterModelCmd->SetGuidance("Glass filter model: simple energy rules or tabulated slab transfer");
+  fGlassFilterModelCmd->SetGuidance("  table: sample tables made with --build-filter-table (falls back to simple if missing)");
+  fGlassFilterModelCmd->SetParameterName("GlassFilterModel", false);
+  fGlassFilterModelCmd->SetCandidates("simple table");
+  fGlassFilterModelCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fGlassFilterModelCmd->SetToBeBroadcasted(false);
+  
+  fGlassFilterTableDirCmd = new G4UIcmdWithAString("/LC/beam/glassFilterTableDir", this);
+  fGlassFilterTableDirCmd->SetGuidance("Set the directory holding glass filter tables");
+  fGlassFilterTableDirCmd->SetParameterName("GlassFilterTableDir", false);
+  fGlassFilterTableDirCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fGlassFilterTableDirCmd->SetToBeBroadcasted(false);
   
   // Command to set detector bias voltage
   fBiasCmd = new G4UIcmdWithADoubleAndUnit("/LC/detector/bias", this);
@@ -52,6 +73,403 @@ LCMessenger::LCMessenger(LCPrimaryGeneratorAction* primaryAction, LCRunAction* r
   fBiasCmd->SetUnitCategory("Electric potential");
   fBiasCmd->SetUnitCandidates("volt kV");
   fBiasCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  // The detector construction is shared - only the master updates it
+  fBiasCmd->SetToBeBroadcasted(false);
+  
+  // Command to choose how much of the setup is built
+  fFidelityCmd = new G4UIcmdWithAString("/LC/detector/fidelity", this);
+  fFidelityCmd->SetGuidance("Geometry fidelity level (after initialization the geometry is rebuilt before the next run)");
+  fFidelityCmd->SetGuidance("  minimal:  LC cell and electrodes in a vacuum world sized to the setup");
+  fFidelityCmd->SetGuidance("  standard: LC cell and electrodes in the 30 cm air world");
+  fFidelityCmd->SetGuidance("  full:     standard plus wires and electrometer box (default)");
+  fFidelityCmd->SetParameterName("Fidelity", false);
+  fFidelityCmd->SetCandidates("minimal standard full");
+  fFidelityCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fFidelityCmd->SetToBeBroadcasted(false);
+  
+  // Cell dimensions and electrode thickness. After /run/initialize the
+  // geometry is rebuilt before the next run, keeping physics and threads.
+  fCellWidthCmd = new G4UIcmdWithADoubleAndUnit("/LC/detector/cellWidth", this);
+  fCellWidthCmd->SetGuidance("LC cell width (x, across the beam; default 15 mm)");
+  fCellWidthCmd->SetParameterName("Width", false);
+  fCellWidthCmd->SetUnitCategory("Length");
+  fCellWidthCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fCellWidthCmd->SetToBeBroadcasted(false);
+  
+  fCellLengthCmd = new G4UIcmdWithADoubleAndUnit("/LC/detector/cellLength", this);
+  fCellLengthCmd->SetGuidance("LC cell length (z, across the beam; default 25 mm)");
+  fCellLengthCmd->SetParameterName("Length", false);
+  fCellLengthCmd->SetUnitCategory("Length");
+  fCellLengthCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fCellLengthCmd->SetToBeBroadcasted(false);
+  
+  fCellThicknessCmd = new G4UIcmdWithADoubleAndUnit("/LC/detector/cellThickness", this);
+  fCellThicknessCmd->SetGuidance("LC cell thickness (y, along the beam and the field; default 100 um)");
+  fCellThicknessCmd->SetGuidance("The field is recomputed from the bias: E = bias / thickness");
+  fCellThicknessCmd->SetParameterName("Thickness", false);
+  fCellThicknessCmd->SetUnitCategory("Length");
+  fCellThicknessCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fCellThicknessCmd->SetToBeBroadcasted(false);
+  
+  fElectrodeThicknessCmd = new G4UIcmdWithADoubleAndUnit("/LC/detector/electrodeThickness", this);
+  fElectrodeThicknessCmd->SetGuidance("Glass electrode thickness (default 1 mm)");
+  fElectrodeThicknessCmd->SetParameterName("ElectrodeThickness", false);
+  fElectrodeThicknessCmd->SetUnitCategory("Length");
+  fElectrodeThicknessCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fElectrodeThicknessCmd->SetToBeBroadcasted(false);
+  
+  fTransportCmd = new G4UIcmdWithAString("/LC/detector/transport", this);
+  fTransportCmd->SetGuidance("Charge transport model of the readout");
+  fTransportCmd->SetGuidance("  constant:  constant mobilities, fixed 80% collection efficiency (default)");
+  fTransportCmd->SetGuidance("  tabulated: field-dependent mobility, columnar recombination and drift");
+  fTransportCmd->SetGuidance("             losses, from lookup tables built once per configuration");
+  fTransportCmd->SetParameterName("Transport", false);
+  fTransportCmd->SetCandidates("constant tabulated");
+  fTransportCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fTransportCmd->SetToBeBroadcasted(false);
+  
+  // Create directory for result cache commands
+  fCacheDir = new G4UIdirectory("/LC/cache/");
+  fCacheDir->SetGuidance("Result cache for repeated simulation points");
+  
+  // Command to set the cache location
+  fCacheDirCmd = new G4UIcmdWithAString("/LC/cache/dir", this);
+  fCacheDirCmd->SetGuidance("Set the directory holding cached results");
+  fCacheDirCmd->SetParameterName("CacheDir", false);
+  fCacheDirCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fCacheDirCmd->SetToBeBroadcasted(false);
+  
+  // Cache-aware replacement for /run/beamOn
+  fCacheBeamOnCmd = new G4UIcmdWithAnInteger("/LC/cache/beamOn", this);
+  fCacheBeamOnCmd->SetGuidance("Like /run/beamOn, but reuse stored results for an identical configuration");
+  fCacheBeamOnCmd->SetGuidance("Only the events missing from the cache are simulated, with fresh seeds");
+  fCacheBeamOnCmd->SetParameterName("NumberOfEvents", false);
+  fCacheBeamOnCmd->SetRange("NumberOfEvents > 0");
+  fCacheBeamOnCmd->AvailableForStates(G4State_Idle);
+  fCacheBeamOnCmd->SetToBeBroadcasted(false);
+  
+  // Create directory for adaptive run commands
+  fRunDir = new G4UIdirectory("/LC/run/");
+  fRunDir->SetGuidance("Runs that stop on a statistical precision target or a time budget");
+  
+  fTargetPrecisionCmd = new G4UIcmdWithADouble("/LC/run/targetPrecision", this);
+  fTargetPrecisionCmd->SetGuidance("Relative standard error of the mean at which beamOnAdaptive stops");
+  fTargetPrecisionCmd->SetGuidance("(all observables from /LC/run/observables); 0 = no precision target");
+  fTargetPrecisionCmd->SetParameterName("Precision", false);
+  fTargetPrecisionCmd->SetRange("Precision >= 0 && Precision < 1");
+  fTargetPrecisionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fTargetPrecisionCmd->SetToBeBroadcasted(false);
+  
+  fTargetObservablesCmd = new G4UIcmdWithAString("/LC/run/observables", this);
+  fTargetObservablesCmd->SetGuidance("Observables the precision target applies to, e.g. \"Charge AvgCurrent\"");
+  fTargetObservablesCmd->SetGuidance("Any of: Edep Charge AvgCurrent PeakCurrent (per-event means)");
+  fTargetObservablesCmd->SetParameterName("Observables", false);
+  fTargetObservablesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fTargetObservablesCmd->SetToBeBroadcasted(false);
+  
+  fTimeBudgetCmd = new G4UIcmdWithADoubleAndUnit("/LC/run/timeBudget", this);
+  fTimeBudgetCmd->SetGuidance("Wall-clock time after which beamOnAdaptive stops; 0 = no budget");
+  fTimeBudgetCmd->SetParameterName("Budget", false);
+  fTimeBudgetCmd->SetDefaultUnit("s");
+  fTimeBudgetCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fTimeBudgetCmd->SetToBeBroadcasted(false);
+  
+  fMinEventsCmd = new G4UIcmdWithAnInteger("/LC/run/minEvents", this);
+  fMinEventsCmd->SetGuidance("Events before the precision target is checked (default 1000)");
+  fMinEventsCmd->SetParameterName("MinEvents", false);
+  fMinEventsCmd->SetRange("MinEvents >= 2");
+  fMinEventsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fMinEventsCmd->SetToBeBroadcasted(false);
+  
+  fAdaptiveBeamOnCmd = new G4UIcmdWithAnInteger("/LC/run/beamOnAdaptive", this);
+  fAdaptiveBeamOnCmd->SetGuidance("Like /run/beamOn, but stop early once the precision target or time budget");
+  fAdaptiveBeamOnCmd->SetGuidance("is reached; the argument is the maximum number of events");
+  fAdaptiveBeamOnCmd->SetParameterName("MaxEvents", false);
+  fAdaptiveBeamOnCmd->SetRange("MaxEvents > 0");
+  fAdaptiveBeamOnCmd->AvailableForStates(G4State_Idle);
+  fAdaptiveBeamOnCmd->SetToBeBroadcasted(false);
+  
+  // Create directory for LC cell physics approximations
+  fPhysicsDir = new G4UIdirectory("/LC/physics/");
+  fPhysicsDir->SetGuidance("Delta-electron condensation and step limit in the LC cell");
+  
+  fCondenseEnergyCmd = new G4UIcmdWithADoubleAndUnit("/LC/physics/condenseEnergy", this);
+  fCondenseEnergyCmd->SetGuidance("Delta electrons created in the LC cell below this kinetic energy are not");
+  fCondenseEnergyCmd->SetGuidance("tracked but deposited in place as one deposit; 0 = off");
+  fCondenseEnergyCmd->SetParameterName("Energy", false);
+  fCondenseEnergyCmd->SetDefaultUnit("keV");
+  fCondenseEnergyCmd->SetRange("Energy >= 0");
+  fCondenseEnergyCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fCondenseEnergyCmd->SetToBeBroadcasted(false);
+  
+  fCondenseRangeCmd = new G4UIcmdWithADoubleAndUnit("/LC/physics/condenseRange", this);
+  fCondenseRangeCmd->SetGuidance("Same as condenseEnergy, for the energy of an electron with this range in 5CB");
+  fCondenseRangeCmd->SetGuidance("(range-to-energy as for production cuts); the larger threshold applies; 0 = off");
+  fCondenseRangeCmd->SetParameterName("Range", false);
+  fCondenseRangeCmd->SetDefaultUnit("um");
+  fCondenseRangeCmd->SetRange("Range >= 0");
+  fCondenseRangeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fCondenseRangeCmd->SetToBeBroadcasted(false);
+  
+  fCellMaxStepCmd = new G4UIcmdWithADoubleAndUnit("/LC/physics/cellMaxStep", this);
+  fCellMaxStepCmd->SetGuidance("Maximum step length of all particles in the LC cell; 0 = no limit");
+  fCellMaxStepCmd->SetParameterName("MaxStep", false);
+  fCellMaxStepCmd->SetDefaultUnit("um");
+  fCellMaxStepCmd->SetRange("MaxStep >= 0");
+  fCellMaxStepCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  // The detector construction is shared - only the master updates it
+  fCellMaxStepCmd->SetToBeBroadcasted(false);
+  
+  // Create directory for campaign store commands
+  fCampaignDir = new G4UIdirectory("/LC/campaign/");
+  fCampaignDir->SetGuidance("Store of all finished runs, queried with LCCampaignQuery");
+  
+  fCampaignStoreCmd = new G4UIcmdWithAString("/LC/campaign/store", this);
+  fCampaignStoreCmd->SetGuidance("Directory of the campaign store every finished run is appended to");
+  fCampaignStoreCmd->SetGuidance("(default ./campaign; \"none\" = do not record runs)");
+  fCampaignStoreCmd->SetParameterName("StoreDir", false);
+  fCampaignStoreCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fCampaignStoreCmd->SetToBeBroadcasted(false);
+  
+  // Create directory for recording commands
+  fRecordDir = new G4UIdirectory("/LC/record/");
+  fRecordDir->SetGuidance("Recording of LC cell deposits and electrometer waveforms");
+  
+  // Command to enable step recording
+  fRecordStepsCmd = new G4UIcmdWithABool("/LC/record/steps", this);
+  fRecordStepsCmd->SetGuidance("Write LC cell energy deposits of each event to <output>_steps_t<thread>.lcs");
+  fRecordStepsCmd->SetGuidance("Replay them through the readout model with LCReplay");
+  fRecordStepsCmd->SetParameterName("RecordSteps", false);
+  fRecordStepsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fRecordStepsCmd->SetToBeBroadcasted(false);
+  
+  // Commands for the compressed waveform stream
+  fRecordWaveformsCmd = new G4UIcmdWithABool("/LC/record/waveforms", this);
+  fRecordWaveformsCmd->SetGuidance("Write the electrometer waveform of each event to <output>_waveforms_t<thread>.lcw");
+  fRecordWaveformsCmd->SetGuidance("Inspect or export them with LCWaveformDump");
+  fRecordWaveformsCmd->SetParameterName("RecordWaveforms", false);
+  fRecordWaveformsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fRecordWaveformsCmd->SetToBeBroadcasted(false);
+  
+  fWaveformTimeStepCmd = new G4UIcmdWithADoubleAndUnit("/LC/record/waveformTimeStep", this);
+  fWaveformTimeStepCmd->SetGuidance("Time resolution the waveform samples are stored with (default 1 ps)");
+  fWaveformTimeStepCmd->SetParameterName("TimeStep", false);
+  fWaveformTimeStepCmd->SetUnitCategory("Time");
+  fWaveformTimeStepCmd->SetRange("TimeStep > 0");
+  fWaveformTimeStepCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fWaveformTimeStepCmd->SetToBeBroadcasted(false);
+  
+  fWaveformCurrentStepCmd = new G4UIcmdWithADouble("/LC/record/waveformCurrentStep", this);
+  fWaveformCurrentStepCmd->SetGuidance("Current resolution the waveform samples are stored with, in pA (default 0.001 pA)");
+  fWaveformCurrentStepCmd->SetParameterName("CurrentStep", false);
+  fWaveformCurrentStepCmd->SetRange("CurrentStep > 0");
+  fWaveformCurrentStepCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fWaveformCurrentStepCmd->SetToBeBroadcasted(false);
+  
+  // Create directory for variance reduction commands
+  fBiasingDir = new G4UIdirectory("/LC/bias/");
+  fBiasingDir->SetGuidance("Cross-section biasing of gammas and neutrons in the LC cell and electrodes");
+  fBiasingDir->SetGuidance("Results stay unbiased through the event weight (ntuple column Weight)");
+  
+  // Command to enable biasing
+  fBiasingEnableCmd = new G4UIcmdWithABool("/LC/bias/enable", this);
+  fBiasingEnableCmd->SetGuidance("Enable/disable cross-section biasing");
+  fBiasingEnableCmd->SetParameterName("Biasing", false);
+  fBiasingEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fBiasingEnableCmd->SetToBeBroadcasted(false);
+  
+  // Cross-section factors
+  fGammaBiasCmd = new G4UIcmdWithADouble("/LC/bias/gammaFactor", this);
+  fGammaBiasCmd->SetGuidance("Factor applied to all gamma interaction cross sections");
+  fGammaBiasCmd->SetParameterName("GammaFactor", false);
+  fGammaBiasCmd->SetRange("GammaFactor > 0");
+  fGammaBiasCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fGammaBiasCmd->SetToBeBroadcasted(false);
+  
+  fNeutronBiasCmd = new G4UIcmdWithADouble("/LC/bias/neutronFactor", this);
+  fNeutronBiasCmd->SetGuidance("Factor applied to all neutron interaction cross sections");
+  fNeutronBiasCmd->SetParameterName("NeutronFactor", false);
+  fNeutronBiasCmd->SetRange("NeutronFactor > 0");
+  fNeutronBiasCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fNeutronBiasCmd->SetToBeBroadcasted(false);
+  
+  // Create directory for bunch mode commands
+  fBunchDir = new G4UIdirectory("/LC/beam/bunch/");
+  fBunchDir->SetGuidance("Several beam primaries per event with a bunch time structure");
+  
+  fBunchPrimariesCmd = new G4UIcmdWithADouble("/LC/beam/bunch/primaries", this);
+  fBunchPrimariesCmd->SetGuidance("Number of primaries per event (mean if Poisson mode is on)");
+  fBunchPrimariesCmd->SetParameterName("Primaries", false);
+  fBunchPrimariesCmd->SetRange("Primaries >= 0");
+  fBunchPrimariesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fBunchPrimariesCmd->SetToBeBroadcasted(false);
+  
+  fBunchPoissonCmd = new G4UIcmdWithABool("/LC/beam/bunch/poisson", this);
+  fBunchPoissonCmd->SetGuidance("Draw the number of primaries from a Poisson distribution");
+  fBunchPoissonCmd->SetGuidance("Events that draw none are kept and counted in the report");
+  fBunchPoissonCmd->SetParameterName("Poisson", false);
+  fBunchPoissonCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fBunchPoissonCmd->SetToBeBroadcasted(false);
+  
+  fBunchCountCmd = new G4UIcmdWithAnInteger("/LC/beam/bunch/count", this);
+  fBunchCountCmd->SetGuidance("Number of microbunches per event; primaries are spread uniformly over them");
+  fBunchCountCmd->SetParameterName("Count", false);
+  fBunchCountCmd->SetRange("Count >= 1");
+  fBunchCountCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fBunchCountCmd->SetToBeBroadcasted(false);
+  
+  fBunchSpacingCmd = new G4UIcmdWithADoubleAndUnit("/LC/beam/bunch/spacing", this);
+  fBunchSpacingCmd->SetGuidance("Time between microbunches");
+  fBunchSpacingCmd->SetParameterName("Spacing", false);
+  fBunchSpacingCmd->SetUnitCategory("Time");
+  fBunchSpacingCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fBunchSpacingCmd->SetToBeBroadcasted(false);
+  
+  fBunchLengthCmd = new G4UIcmdWithADoubleAndUnit("/LC/beam/bunch/length", this);
+  fBunchLengthCmd->SetGuidance("Gaussian time spread (sigma) of the primaries within a microbunch");
+  fBunchLengthCmd->SetParameterName("Length", false);
+  fBunchLengthCmd->SetUnitCategory("Time");
+  fBunchLengthCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fBunchLengthCmd->SetToBeBroadcasted(false);
+  
+  // Create directory for continuous-beam timeline commands
+  fTimelineDir = new G4UIdirectory("/LC/beam/timeline/");
+  fTimelineDir->SetGuidance("Continuous beam: one electrometer trace per run from events arriving at a fixed rate");
+  
+  fTimelineRateCmd = new G4UIcmdWithADoubleAndUnit("/LC/beam/timeline/rate", this);
+  fTimelineRateCmd->SetGuidance("Event rate of the beam; 0 = off (default). Writes <output>_timeline.lcw,");
+  fTimelineRateCmd->SetGuidance("readable with LCWaveformDump");
+  fTimelineRateCmd->SetParameterName("Rate", false);
+  fTimelineRateCmd->SetUnitCategory("Frequency");
+  fTimelineRateCmd->SetRange("Rate >= 0");
+  fTimelineRateCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fTimelineRateCmd->SetToBeBroadcasted(false);
+  
+  fTimelineBinWidthCmd = new G4UIcmdWithADoubleAndUnit("/LC/beam/timeline/binWidth", this);
+  fTimelineBinWidthCmd->SetGuidance("Sampling interval of the trace (default 10 us); the trace covers the");
+  fTimelineBinWidthCmd->SetGuidance("whole beam time plus the longest drift, so keep it well above the");
+  fTimelineBinWidthCmd->SetGuidance("run length divided by the number of samples you can store");
+  fTimelineBinWidthCmd->SetParameterName("BinWidth", false);
+  fTimelineBinWidthCmd->SetUnitCategory("Time");
+  fTimelineBinWidthCmd->SetRange("BinWidth > 0");
+  fTimelineBinWidthCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fTimelineBinWidthCmd->SetToBeBroadcasted(false);
+  
+  fTimelineWindowCmd = new G4UIcmdWithADoubleAndUnit("/LC/beam/timeline/window", this);
+  fTimelineWindowCmd->SetGuidance("Beam time the merge waits for events finished out of order (default 1 s);");
+  fTimelineWindowCmd->SetGuidance("charge of events later than this is merged late and counted");
+  fTimelineWindowCmd->SetParameterName("Window", false);
+  fTimelineWindowCmd->SetUnitCategory("Time");
+  fTimelineWindowCmd->SetRange("Window > 0");
+  fTimelineWindowCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fTimelineWindowCmd->SetToBeBroadcasted(false);
+  
+  // Create directory for memory commands
+  fMemoryDir = new G4UIdirectory("/LC/memory/");
+  fMemoryDir->SetGuidance("Memory accounting and budget of the per-thread buffers");
+  
+  fMemoryBudgetCmd = new G4UIcmdWithADouble("/LC/memory/budget", this);
+  fMemoryBudgetCmd->SetGuidance("Memory budget in MB for the electrometer profiles, pulse lists and");
+  fMemoryBudgetCmd->SetGuidance("step records of all threads; 0 = no budget. When a buffer reaches its");
+  fMemoryBudgetCmd->SetGuidance("share, profiles are coarsened instead of growing. Applies from the next run.");
+  fMemoryBudgetCmd->SetParameterName("BudgetMB", false);
+  fMemoryBudgetCmd->SetRange("BudgetMB >= 0");
+  fMemoryBudgetCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fMemoryBudgetCmd->SetToBeBroadcasted(false);
+  
+  // Create directory for angular response commands
+  fAngularDir = new G4UIdirectory("/LC/beam/angular/");
+  fAngularDir->SetGuidance("Incidence angle sampled per event around the beam axis");
+  
+  fAngularModeCmd = new G4UIcmdWithAString("/LC/beam/angular/mode", this);
+  fAngularModeCmd->SetGuidance("Incidence angle distribution");
+  fAngularModeCmd->SetGuidance("  off: fixed beam direction");
+  fAngularModeCmd->SetGuidance("  uniformCos: cos(theta) uniform between thetaMin and thetaMax");
+  fAngularModeCmd->SetGuidance("  cosine: cosine law (Lambert) between thetaMin and thetaMax");
+  fAngularModeCmd->SetGuidance("  list: weighted angles from /LC/beam/angular/addAngle");
+  fAngularModeCmd->SetParameterName("Mode", false);
+  fAngularModeCmd->SetCandidates("off uniformCos cosine list");
+  fAngularModeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fAngularModeCmd->SetToBeBroadcasted(false);
+  
+  fAngularThetaMinCmd = new G4UIcmdWithADoubleAndUnit("/LC/beam/angular/thetaMin", this);
+  fAngularThetaMinCmd->SetGuidance("Smallest incidence angle for the uniformCos and cosine modes");
+  fAngularThetaMinCmd->SetParameterName("ThetaMin", false);
+  fAngularThetaMinCmd->SetDefaultUnit("deg");
+  fAngularThetaMinCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fAngularThetaMinCmd->SetToBeBroadcasted(false);
+  
+  fAngularThetaMaxCmd = new G4UIcmdWithADoubleAndUnit("/LC/beam/angular/thetaMax", this);
+  fAngularThetaMaxCmd->SetGuidance("Largest incidence angle for the uniformCos and cosine modes");
+  fAngularThetaMaxCmd->SetParameterName("ThetaMax", false);
+  fAngularThetaMaxCmd->SetDefaultUnit("deg");
+  fAngularThetaMaxCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fAngularThetaMaxCmd->SetToBeBroadcasted(false);
+  
+  fAngularAddCmd = new G4UIcmdWithAString("/LC/beam/angular/addAngle", this);
+  fAngularAddCmd->SetGuidance("Add an incidence direction for list mode: <theta> <phi> <unit> [weight]");
+  fAngularAddCmd->SetParameterName("Angle", false);
+  fAngularAddCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fAngularAddCmd->SetToBeBroadcasted(false);
+  
+  fAngularClearCmd = new G4UIcmdWithoutParameter("/LC/beam/angular/clearAngles", this);
+  fAngularClearCmd->SetGuidance("Remove all list mode incidence directions");
+  fAngularClearCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fAngularClearCmd->SetToBeBroadcasted(false);
+  
+  // Create directory for cocktail commands
+  fCocktailDir = new G4UIdirectory("/LC/cocktail/");
+  fCocktailDir->SetGuidance("Weighted mixture of sources replacing the single beam particle");
+  fCocktailDir->SetGuidance("Spectrum and angle commands apply to the last source added");
+  
+  fCocktailEnableCmd = new G4UIcmdWithABool("/LC/cocktail/enable", this);
+  fCocktailEnableCmd->SetGuidance("Generate primaries from the cocktail instead of /LC/beam/particle");
+  fCocktailEnableCmd->SetParameterName("Cocktail", false);
+  fCocktailEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fCocktailEnableCmd->SetToBeBroadcasted(false);
+  
+  fCocktailClearCmd = new G4UIcmdWithoutParameter("/LC/cocktail/clear", this);
+  fCocktailClearCmd->SetGuidance("Remove all cocktail sources");
+  fCocktailClearCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fCocktailClearCmd->SetToBeBroadcasted(false);
+  
+  fCocktailSourceCmd = new G4UIcmdWithAString("/LC/cocktail/addSource", this);
+  fCocktailSourceCmd->SetGuidance("Add a source: <name> <particle> <relative rate>");
+  fCocktailSourceCmd->SetParameterName("Source", false);
+  fCocktailSourceCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fCocktailSourceCmd->SetToBeBroadcasted(false);
+  
+  fCocktailLineCmd = new G4UIcmdWithAString("/LC/cocktail/line", this);
+  fCocktailLineCmd->SetGuidance("Add a line: <energy> <unit> [intensity]");
+  fCocktailLineCmd->SetParameterName("Line", false);
+  fCocktailLineCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fCocktailLineCmd->SetToBeBroadcasted(false);
+  
+  fCocktailBinCmd = new G4UIcmdWithAString("/LC/cocktail/bin", this);
+  fCocktailBinCmd->SetGuidance("Add a flat spectrum bin: <low> <high> <unit> <weight>");
+  fCocktailBinCmd->SetParameterName("Bin", false);
+  fCocktailBinCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fCocktailBinCmd->SetToBeBroadcasted(false);
+  
+  fCocktailBetaCmd = new G4UIcmdWithADoubleAndUnit("/LC/cocktail/beta", this);
+  fCocktailBetaCmd->SetGuidance("Add an allowed beta spectrum with the given endpoint");
+  fCocktailBetaCmd->SetParameterName("Endpoint", false);
+  fCocktailBetaCmd->SetUnitCategory("Energy");
+  fCocktailBetaCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fCocktailBetaCmd->SetToBeBroadcasted(false);
+  
+  fCocktailAngularCmd = new G4UIcmdWithAString("/LC/cocktail/angular", this);
+  fCocktailAngularCmd->SetGuidance("Angular distribution around the beam axis");
+  fCocktailAngularCmd->SetParameterName("Shape", false);
+  fCocktailAngularCmd->SetCandidates("beam isotropic cos2");
+  fCocktailAngularCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fCocktailAngularCmd->SetToBeBroadcasted(false);
+  
+  fCocktailAngularBinCmd = new G4UIcmdWithAString("/LC/cocktail/angularBin", this);
+  fCocktailAngularBinCmd->SetGuidance("Add a flat cos(theta) bin: <cosLow> <cosHigh> <weight>");
+  fCocktailAngularBinCmd->SetParameterName("AngularBin", false);
+  fCocktailAngularBinCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fCocktailAngularBinCmd->SetToBeBroadcasted(false);
 }
 
 LCMessenger::~LCMessenger()
@@ -59,7 +477,67 @@ LCMessenger::~LCMessenger()
   delete fParticleCmd;
   delete fEnergyCmd;
   delete fGlassFilterCmd;
+  delete fGlassFilterModelCmd;
+  delete fGlassFilterTableDirCmd;
   delete fBiasCmd;
+  delete fFidelityCmd;
+  delete fCellWidthCmd;
+  delete fCellLengthCmd;
+  delete fCellThicknessCmd;
+  delete fElectrodeThicknessCmd;
+  delete fTransportCmd;
+  delete fCacheDirCmd;
+  delete fCacheBeamOnCmd;
+  delete fCacheDir;
+  delete fRecordStepsCmd;
+  delete fRecordWaveformsCmd;
+  delete fWaveformTimeStepCmd;
+  delete fWaveformCurrentStepCmd;
+  delete fRecordDir;
+  delete fBiasingEnableCmd;
+  delete fGammaBiasCmd;
+  delete fNeutronBiasCmd;
+  delete fBiasingDir;
+  delete fMemoryBudgetCmd;
+  delete fMemoryDir;
+  delete fTargetPrecisionCmd;
+  delete fTargetObservablesCmd;
+  delete fTimeBudgetCmd;
+  delete fMinEventsCmd;
+  delete fAdaptiveBeamOnCmd;
+  delete fRunDir;
+  delete fCondenseEnergyCmd;
+  delete fCondenseRangeCmd;
+  delete fCellMaxStepCmd;
+  delete fPhysicsDir;
+  delete fCampaignStoreCmd;
+  delete fCampaignDir;
+  delete fAngularModeCmd;
+  delete fAngularThetaMinCmd;
+  delete fAngularThetaMaxCmd;
+  delete fAngularAddCmd;
+  delete fAngularClearCmd;
+  delete fAngularDir;
+  delete fBunchPrimariesCmd;
+  delete fBunchPoissonCmd;
+  delete fBunchCountCmd;
+  delete fBunchSpacingCmd;
+  delete fBunchLengthCmd;
+  delete fBunchDir;
+  delete fTimelineRateCmd;
+  delete fTimelineBinWidthCmd;
+  delete fTimelineWindowCmd;
+  delete fTimelineDir;
+  delete fCocktailEnableCmd;
+  delete fCocktailClearCmd;
+  delete fCocktailSourceCmd;
+  delete fCocktailLineCmd;
+  delete fCocktailBinCmd;
+  delete fCocktailBetaCmd;
+  delete fCocktailAngularCmd;
+  delete fCocktailAngularBinCmd;
+  delete fCocktailDir;
+  delete fResultCache;
   delete fBeamDir;
   delete fDetectorDir;
   delete fLCDir;
@@ -69,7 +547,6 @@ void LCMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
 {
   // Set particle type
   if (command == fParticleCmd) {
-    fPrimaryAction->SetParticleType(newValue);
     fRunAction->SetParticleName(newValue);
     // Update global manager
     LCGlobalManager::Instance()->SetParticleType(newValue);
@@ -79,7 +556,6 @@ void LCMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
   // Set particle energy
   else if (command == fEnergyCmd) {
     G4double energy = fEnergyCmd->GetNewDoubleValue(newValue);
-    fPrimaryAction->SetParticleEnergy(energy);
     fRunAction->SetParticleEnergy(energy);
     // Update global manager
     LCGlobalManager::Instance()->SetParticleEnergy(energy);
@@ -95,12 +571,20 @@ void LCMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
   // Set glass filter
   else if (command == fGlassFilterCmd) {
     G4bool enableFilter = fGlassFilterCmd->GetNewBoolValue(newValue);
-    if (fPrimaryAction) {
-      fPrimaryAction->SetGlassFilter(enableFilter);
-      G4cout << "Glass filter " << (enableFilter ? "enabled" : "disabled") << G4endl;
-    } else {
-      G4cerr << "ERROR: Primary generator action not available for glass filter command" << G4endl;
-    }
+    LCGlobalManager::Instance()->SetGlassFilter(enableFilter);
+    G4cout << "Glass filter " << (enableFilter ? "enabled" : "disabled") << G4endl;
+  }
+  
+  // Set glass filter model
+  else if (command == fGlassFilterModelCmd) {
+    LCGlobalManager::Instance()->SetGlassFilterModel(newValue);
+    G4cout << "Glass filter model set to " << newValue << G4endl;
+  }
+  
+  // Set glass filter table directory
+  else if (command == fGlassFilterTableDirCmd) {
+    LCGlobalManager::Instance()->SetGlassFilterTableDir(newValue);
+    G4cout << "Glass filter tables will be read from " << newValue << G4endl;
   }
   
   // Set detector bias voltage
@@ -113,4 +597,333 @@ void LCMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
       G4cerr << "ERROR: Detector construction not available for bias command" << G4endl;
     }
   }
+  
+  // Set geometry fidelity level
+  else if (command == fFidelityCmd) {
+    if (fDetConstruction) {
+      fDetConstruction->SetGeometryFidelity(newValue);
+    } else {
+      G4cerr << "ERROR: Detector construction not available for fidelity command" << G4endl;
+    }
+  }
+  
+  // Set cell dimensions (rebuilds the geometry after initialization)
+  else if (command == fCellWidthCmd || command == fCellLengthCmd || command == fCellThicknessCmd) {
+    if (fDetConstruction) {
+      G4double value = G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue);
+      G4double width = (command == fCellWidthCmd) ? value : fDetConstruction->GetLCWidth();
+      G4double length = (command == fCellLengthCmd) ? value : fDetConstruction->GetLCLength();
+      G4double thickness = (command == fCellThicknessCmd) ? value : fDetConstruction->GetLCThickness();
+      if (!fDetConstruction->SetCellDimensions(width, length, thickness)) {
+        G4cerr << "ERROR: " << command->GetCommandPath() << " " << newValue << " ignored" << G4endl;
+      }
+    } else {
+      G4cerr << "ERROR: Detector construction not available for cell dimension commands" << G4endl;
+    }
+  }
+  
+  // Set electrode thickness (rebuilds the geometry after initialization)
+  else if (command == fElectrodeThicknessCmd) {
+    if (fDetConstruction) {
+      if (!fDetConstruction->SetElectrodeThickness(fElectrodeThicknessCmd->GetNewDoubleValue(newValue))) {
+        G4cerr << "ERROR: " << command->GetCommandPath() << " " << newValue << " ignored" << G4endl;
+      }
+    } else {
+      G4cerr << "ERROR: Detector construction not available for electrode thickness command" << G4endl;
+    }
+  }
+  
+  // Set charge transport model (applied by each thread at the next run)
+  else if (command == fTransportCmd) {
+    LCGlobalManager::Instance()->SetTransportModel(newValue);
+    G4cout << "Charge transport model set to " << newValue << G4endl;
+  }
+  
+  // Set result cache directory
+  else if (command == fCacheDirCmd) {
+    fResultCache->SetCacheDirectory(newValue);
+    G4cout << "Result cache directory set to " << newValue << G4endl;
+  }
+  
+  // Cached beamOn
+  else if (command == fCacheBeamOnCmd) {
+    G4int nEvents = fCacheBeamOnCmd->GetNewIntValue(newValue);
+    fResultCache->BeamOn(nEvents, fRunAction, fDetConstruction);
+  }
+  
+  // Adaptive run length
+  else if (command == fTargetPrecisionCmd) {
+    G4double precision = fTargetPrecisionCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->SetTargetPrecision(precision);
+    G4cout << "Target relative standard error set to " << precision << G4endl;
+  }
+  else if (command == fTargetObservablesCmd) {
+    std::istringstream iss(newValue);
+    G4String name;
+    G4int count = 0;
+    while (iss >> name) {
+      if (LCRunStatistics::ObservableFromName(name) < 0) {
+        G4cerr << "ERROR: Unknown observable " << name << " (Edep, Charge, AvgCurrent, PeakCurrent)" << G4endl;
+        return;
+      }
+      count++;
+    }
+    if (count == 0) {
+      G4cerr << "ERROR: No observables given" << G4endl;
+      return;
+    }
+    LCGlobalManager::Instance()->SetTargetObservables(newValue);
+    G4cout << "Precision target applies to: " << newValue << G4endl;
+  }
+  else if (command == fTimeBudgetCmd) {
+    G4double budget = fTimeBudgetCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->SetTimeBudget(budget);
+    G4cout << "Run time budget set to " << budget/s << " s" << G4endl;
+  }
+  else if (command == fMinEventsCmd) {
+    G4int events = fMinEventsCmd->GetNewIntValue(newValue);
+    LCGlobalManager::Instance()->SetMinAdaptiveEvents(events);
+    G4cout << "Precision target checked from " << events << " events" << G4endl;
+  }
+  else if (command == fAdaptiveBeamOnCmd) {
+    LCGlobalManager* global = LCGlobalManager::Instance();
+    if (global->GetTargetPrecision() <= 0. && global->GetTimeBudget() <= 0.) {
+      G4cerr << "ERROR: Set /LC/run/targetPrecision and/or /LC/run/timeBudget first" << G4endl;
+      return;
+    }
+    G4int maxEvents = fAdaptiveBeamOnCmd->GetNewIntValue(newValue);
+    LCRunTermination* termination = LCRunTermination::Instance();
+    termination->SetArmed(true);
+    G4RunManager::GetRunManager()->BeamOn(maxEvents);
+    termination->SetArmed(false);
+  }
+  
+  // Delta-electron condensation and cell step limit
+  else if (command == fCondenseEnergyCmd) {
+    G4double energy = fCondenseEnergyCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->SetCondenseEnergy(energy);
+    G4cout << "Delta-electron condensation below " << energy/keV << " keV" << (energy > 0. ? "" : " (off)") << G4endl;
+  }
+  else if (command == fCondenseRangeCmd) {
+    G4double range = fCondenseRangeCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->SetCondenseRange(range);
+    G4cout << "Delta-electron condensation below a range of " << range/um << " um" << (range > 0. ? "" : " (off)") << G4endl;
+  }
+  else if (command == fCellMaxStepCmd) {
+    G4double maxStep = fCellMaxStepCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->SetCellMaxStep(maxStep);
+    if (fDetConstruction) fDetConstruction->SetCellMaxStep(maxStep);
+    G4cout << "LC cell step limit " << (maxStep > 0. ? G4UIcommand::ConvertToString(maxStep/um) + " um" : G4String("off")) << G4endl;
+  }
+  
+  // Campaign store
+  else if (command == fCampaignStoreCmd) {
+    LCGlobalManager::Instance()->SetCampaignStore(newValue);
+    G4cout << "Campaign store set to " << newValue << G4endl;
+  }
+  
+  // Step recording
+  else if (command == fRecordStepsCmd) {
+    G4bool enable = fRecordStepsCmd->GetNewBoolValue(newValue);
+    LCGlobalManager::Instance()->SetStepRecording(enable);
+    G4cout << "Step recording " << (enable ? "enabled" : "disabled") << G4endl;
+  }
+  
+  // Waveform recording
+  else if (command == fRecordWaveformsCmd) {
+    G4bool enable = fRecordWaveformsCmd->GetNewBoolValue(newValue);
+    LCGlobalManager::Instance()->SetWaveformRecording(enable);
+    G4cout << "Waveform recording " << (enable ? "enabled" : "disabled") << G4endl;
+  }
+  else if (command == fWaveformTimeStepCmd) {
+    G4double step = fWaveformTimeStepCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->SetWaveformTimeStep(step);
+    G4cout << "Waveform time step set to " << step/ns << " ns" << G4endl;
+  }
+  else if (command == fWaveformCurrentStepCmd) {
+    G4double step = fWaveformCurrentStepCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->SetWaveformCurrentStep(step*1.0e-12*ampere);
+    G4cout << "Waveform current step set to " << step << " pA" << G4endl;
+  }
+  
+  // Cross-section biasing
+  else if (command == fBiasingEnableCmd) {
+    G4bool enable = fBiasingEnableCmd->GetNewBoolValue(newValue);
+    LCGlobalManager::Instance()->SetBiasingEnabled(enable);
+    G4cout << "Cross-section biasing " << (enable ? "enabled" : "disabled") << G4endl;
+  }
+  else if (command == fGammaBiasCmd) {
+    G4double factor = fGammaBiasCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->SetGammaBiasFactor(factor);
+    G4cout << "Gamma cross-section factor set to " << factor << G4endl;
+  }
+  else if (command == fNeutronBiasCmd) {
+    G4double factor = fNeutronBiasCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->SetNeutronBiasFactor(factor);
+    G4cout << "Neutron cross-section factor set to " << factor << G4endl;
+  }
+  
+  // Bunch mode
+  else if (command == fBunchPrimariesCmd) {
+    G4double primaries = fBunchPrimariesCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->SetBunchPrimaries(primaries);
+    G4cout << "Primaries per event set to " << primaries << G4endl;
+  }
+  else if (command == fBunchPoissonCmd) {
+    G4bool poisson = fBunchPoissonCmd->GetNewBoolValue(newValue);
+    LCGlobalManager::Instance()->SetBunchPoisson(poisson);
+    G4cout << "Primaries per event " << (poisson ? "Poisson-distributed" : "fixed") << G4endl;
+  }
+  else if (command == fBunchCountCmd) {
+    G4int count = fBunchCountCmd->GetNewIntValue(newValue);
+    LCGlobalManager::Instance()->SetBunchCount(count);
+    G4cout << "Microbunches per event set to " << count << G4endl;
+  }
+  else if (command == fBunchSpacingCmd) {
+    G4double spacing = fBunchSpacingCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->SetBunchSpacing(spacing);
+    G4cout << "Microbunch spacing set to " << spacing/ns << " ns" << G4endl;
+  }
+  else if (command == fBunchLengthCmd) {
+    G4double length = fBunchLengthCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->SetBunchLength(length);
+    G4cout << "Microbunch length set to " << length/ns << " ns" << G4endl;
+  }
+  
+  // Continuous-beam timeline
+  else if (command == fTimelineRateCmd) {
+    G4double rate = fTimelineRateCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->SetTimelineRate(rate);
+    if (rate > 0.) G4cout << "Continuous-beam timeline at " << rate/hertz << " events/s" << G4endl;
+    else G4cout << "Continuous-beam timeline disabled" << G4endl;
+  }
+  else if (command == fTimelineBinWidthCmd) {
+    G4double width = fTimelineBinWidthCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->SetTimelineBinWidth(width);
+    G4cout << "Timeline sampling interval set to " << width/us << " us" << G4endl;
+  }
+  else if (command == fTimelineWindowCmd) {
+    G4double window = fTimelineWindowCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->SetTimelineWindow(window);
+    G4cout << "Timeline reorder window set to " << window/s << " s" << G4endl;
+  }
+  
+  // Memory budget
+  else if (command == fMemoryBudgetCmd) {
+    G4double budget = fMemoryBudgetCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->SetMemoryBudget(static_cast<std::size_t>(budget * 1024. * 1024.));
+    if (budget > 0.) G4cout << "Memory budget set to " << budget << " MB" << G4endl;
+    else G4cout << "Memory budget disabled" << G4endl;
+  }
+  
+  // Angular response mode
+  else if (command == fAngularModeCmd) {
+    LCGlobalManager* global = LCGlobalManager::Instance();
+    if (newValue == "list" && global->GetAngularPoints().empty()) {
+      G4cerr << "ERROR: List mode needs incidence angles - use /LC/beam/angular/addAngle first" << G4endl;
+      return;
+    }
+    global->SetAngularMode(newValue);
+    G4cout << "Angular mode set to " << newValue << G4endl;
+  }
+  else if (command == fAngularThetaMinCmd || command == fAngularThetaMaxCmd) {
+    G4double theta = G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue);
+    if (theta < 0. || theta > 90.*deg) {
+      G4cerr << "ERROR: Incidence angles must be between 0 and 90 deg" << G4endl;
+      return;
+    }
+    LCGlobalManager* global = LCGlobalManager::Instance();
+    if (command == fAngularThetaMinCmd) global->SetAngularThetaMin(theta);
+    else global->SetAngularThetaMax(theta);
+    G4cout << "Incidence angle range: " << global->GetAngularThetaMin()/deg << " - "
+           << global->GetAngularThetaMax()/deg << " deg" << G4endl;
+  }
+  else if (command == fAngularAddCmd) {
+    std::istringstream iss(newValue);
+    G4double theta = 0., phi = 0., weight = 1.;
+    G4String unit;
+    if (!(iss >> theta >> phi >> unit)) {
+      G4cerr << "ERROR: Usage: /LC/beam/angular/addAngle <theta> <phi> <unit> [weight]" << G4endl;
+      return;
+    }
+    iss >> weight;
+    G4double unitValue = G4UIcommand::ValueOf(unit);
+    LCGlobalManager::Instance()->AddAngularPoint(theta * unitValue, phi * unitValue, weight);
+    G4cout << "Incidence angle theta=" << theta << " phi=" << phi << " " << unit
+           << " added (weight " << weight << ")" << G4endl;
+  }
+  else if (command == fAngularClearCmd) {
+    LCGlobalManager* global = LCGlobalManager::Instance();
+    global->ClearAngularPoints();
+    if (global->GetAngularMode() == "list") global->SetAngularMode("off");
+    G4cout << "Incidence angle list cleared" << G4endl;
+  }
+  
+  // Cocktail
+  else if (command == fCocktailEnableCmd) {
+    G4bool enable = fCocktailEnableCmd->GetNewBoolValue(newValue);
+    LCCocktailGenerator* cocktail = LCGlobalManager::Instance()->GetCocktail();
+    if (enable && !cocktail->IsReady()) {
+      G4cerr << "ERROR: Cocktail needs at least one source, each with an energy spectrum" << G4endl;
+      return;
+    }
+    LCGlobalManager::Instance()->SetCocktailEnabled(enable);
+    if (enable) cocktail->Print();
+    else G4cout << "Cocktail disabled" << G4endl;
+  }
+  else if (command == fCocktailClearCmd) {
+    LCGlobalManager::Instance()->GetCocktail()->Clear();
+    LCGlobalManager::Instance()->SetCocktailEnabled(false);
+    G4cout << "Cocktail cleared" << G4endl;
+  }
+  else if (command == fCocktailSourceCmd) {
+    std::istringstream iss(newValue);
+    G4String name, particle;
+    G4double rate = 0.;
+    if (!(iss >> name >> particle >> rate)) {
+      G4cerr << "ERROR: Usage: /LC/cocktail/addSource <name> <particle> <rate>" << G4endl;
+      return;
+    }
+    if (LCGlobalManager::Instance()->GetCocktail()->AddSource(name, particle, rate)) {
+      G4cout << "Cocktail source " << name << " (" << particle << ") added" << G4endl;
+    }
+  }
+  else if (command == fCocktailLineCmd) {
+    std::istringstream iss(newValue);
+    G4double energy = 0., intensity = 1.;
+    G4String unit;
+    if (!(iss >> energy >> unit)) {
+      G4cerr << "ERROR: Usage: /LC/cocktail/line <energy> <unit> [intensity]" << G4endl;
+      return;
+    }
+    iss >> intensity;
+    LCGlobalManager::Instance()->GetCocktail()->AddLine(energy * G4UIcommand::ValueOf(unit), intensity);
+  }
+  else if (command == fCocktailBinCmd) {
+    std::istringstream iss(newValue);
+    G4double low = 0., high = 0., weight = 0.;
+    G4String unit;
+    if (!(iss >> low >> high >> unit >> weight)) {
+      G4cerr << "ERROR: Usage: /LC/cocktail/bin <low> <high> <unit> <weight>" << G4endl;
+      return;
+    }
+    G4double unitValue = G4UIcommand::ValueOf(unit);
+    LCGlobalManager::Instance()->GetCocktail()->AddBin(low * unitValue, high * unitValue, weight);
+  }
+  else if (command == fCocktailBetaCmd) {
+    G4double endpoint = fCocktailBetaCmd->GetNewDoubleValue(newValue);
+    LCGlobalManager::Instance()->GetCocktail()->AddBetaSpectrum(endpoint);
+  }
+  else if (command == fCocktailAngularCmd) {
+    LCGlobalManager::Instance()->GetCocktail()->SetAngularDistribution(newValue);
+  }
+  else if (command == fCocktailAngularBinCmd) {
+    std::istringstream iss(newValue);
+    G4double cosLow = 0., cosHigh = 0., weight = 0.;
+    if (!(iss >> cosLow >> cosHigh >> weight)) {
+      G4cerr << "ERROR: Usage: /LC/cocktail/angularBin <cosLow> <cosHigh> <weight>" << G4endl;
+      return;
+    }
+    LCGlobalManager::Instance()->GetCocktail()->AddAngularBin(cosLow, cosHigh, weight);
+  }
 }
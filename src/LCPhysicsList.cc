@@ -8,8 +8,17 @@
 #include "G4HadronPhysicsFTFP_BERT.hh"
 #include "G4IonPhysics.hh"
 #include "G4StoppingPhysics.hh"
+#include "G4GenericBiasingPhysics.hh"
+#include "G4StepLimiterPhysics.hh"
+#include "LCGlobalManager.hh"
 
 #include "G4SystemOfUnits.hh"
+#include "G4UIcommand.hh"
+
+namespace {
+  // Production cut applied to gamma, e-, e+ and proton
+  const G4double kProductionCut = 0.01*mm;
+}
 
 LCPhysicsList::LCPhysicsList() : G4VModularPhysicsList()
 {
@@ -36,6 +45,17 @@ LCPhysicsList::LCPhysicsList() : G4VModularPhysicsList()
   
   // Ion Physics
   RegisterPhysics(new G4IonPhysics(verb));
+  
+  // Biasing wrappers for neutral particles - always present, so biasing can
+  // be switched on with /LC/bias/... after initialization. They act only in
+  // volumes with an LCBiasingOperator and are analog while it is disabled.
+  auto biasingPhysics = new G4GenericBiasingPhysics();
+  biasingPhysics->Bias("gamma");
+  biasingPhysics->Bias("neutron");
+  RegisterPhysics(biasingPhysics);
+  
+  // User step limits (LC cell max step, /LC/physics/cellMaxStep)
+  RegisterPhysics(new G4StepLimiterPhysics());
 }
 
 LCPhysicsList::~LCPhysicsList()
@@ -46,8 +66,28 @@ void LCPhysicsList::SetCuts()
 {
   // Set lower production cut for better accuracy
   // Note: This will slow down the simulation slightly
-  SetCutValue(0.01*mm, "gamma");
-  SetCutValue(0.01*mm, "e-");
-  SetCutValue(0.01*mm, "e+");
-  SetCutValue(0.01*mm, "proton");
+  SetCutValue(kProductionCut, "gamma");
+  SetCutValue(kProductionCut, "e-");
+  SetCutValue(kProductionCut, "e+");
+  SetCutValue(kProductionCut, "proton");
+}
+
+G4String LCPhysicsList::GetConfigurationTag(G4bool withCellSettings)
+{
+  G4String tag = "FTFP_BERT+EMopt4+EmExtra+Decay+Stopping+Ion+Biasing+StepLimiter;cut="
+                 + G4UIcommand::ConvertToString(kProductionCut/mm) + "mm";
+  
+  // Approximations in the LC cell that change the results
+  if (!withCellSettings) return tag;
+  LCGlobalManager* global = LCGlobalManager::Instance();
+  if (global->GetCellMaxStep() > 0.) {
+    tag += ";cellMaxStep=" + G4UIcommand::ConvertToString(global->GetCellMaxStep()/um) + "um";
+  }
+  if (global->GetCondenseEnergy() > 0.) {
+    tag += ";condenseE=" + G4UIcommand::ConvertToString(global->GetCondenseEnergy()/keV) + "keV";
+  }
+  if (global->GetCondenseRange() > 0.) {
+    tag += ";condenseR=" + G4UIcommand::ConvertToString(global->GetCondenseRange()/um) + "um";
+  }
+  return tag;
 }
@@ -1,5 +1,9 @@
 // LCPrimaryGeneratorAction.cc - Modified for perpendicular incidence
 #include "LCPrimaryGeneratorAction.hh"
+#include "LCEventInformation.hh"
+#include "LCConfiguration.hh"
+#include "LCCocktailGenerator.hh"
+#include "LCGlassFilterTable.hh"
 
 #include "G4LogicalVolumeStore.hh"
 #include "G4LogicalVolume.hh"
@@ -10,6 +14,9 @@
 #include "G4ParticleDefinition.hh"
 #include "G4SystemOfUnits.hh"
 #include "Randomize.hh"
+#include "G4Poisson.hh"
+#include <algorithm>
+#include <cmath>
 
 LCPrimaryGeneratorAction::LCPrimaryGeneratorAction()
 : G4VUserPrimaryGeneratorAction(),
@@ -18,11 +25,12 @@ LCPrimaryGeneratorAction::LCPrimaryGeneratorAction()
   fParticleEnergy(0.5*GeV),
   fParticleName("proton"),
   fBeamDirection(G4ThreeVector(0.,1.,0.)),
-  fGlassFilterEnabled(false)
+  fGlassFilterEnabled(false),
+  fConfig(nullptr)
 {
   G4int n_particle = 1;
   fParticleGun = new G4ParticleGun(n_particle);
-
+  
   // Default particle kinematic
   G4ParticleTable* particleTable = G4ParticleTable::GetParticleTable();
   G4ParticleDefinition* particle = particleTable->FindParticle(fParticleName);
@@ -42,12 +50,125 @@ void LCPrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 {
   // This function is called at the beginning of each event
   
-  // Update energy in case it has been changed
-  fParticleGun->SetParticleEnergy(fParticleEnergy);
+  // Settings published by the master for this run - one atomic load, and the
+  // gun is only reconfigured when the epoch has moved on
+  const LCConfigSnapshot* config = LCConfiguration::ForRun();
+  if (config != fConfig) ApplyConfiguration(config);
   
   // Update direction in case it has been changed
   fParticleGun->SetParticleMomentumDirection(fBeamDirection);
+  
+  // Number of primaries in this event - one unless bunch mode is configured
+  G4double meanPrimaries = config->bunchPrimaries;
+  G4int nPrimaries = config->bunchPoisson ? G4int(G4Poisson(meanPrimaries))
+                                          : G4int(std::lround(meanPrimaries));
+  
+  G4int nBunches = std::max(1, config->bunchCount);
+  G4double bunchSpacing = config->bunchSpacing;
+  G4double bunchLength = config->bunchLength;
+  
+  // Cocktail mode: each primary comes from a randomly chosen source
+  const LCCocktailGenerator* cocktail = config->cocktailEnabled ? config->cocktail : nullptr;
+  G4ParticleDefinition* beamParticle = fParticleGun->GetParticleDefinition();
+  G4int eventSourceID = LCEventInformation::kBeamSource;
+  
+  // Angular mode: one incidence direction per event, shared by its primaries
+  G4ThreeVector eventDirection = fBeamDirection;
+  G4double theta = 0., phi = 0.;
+  if (config->IsAngularModeEnabled()) eventDirection = SampleIncidence(theta, phi);
+  
+  for (G4int i = 0; i < nPrimaries; i++) {
+    // Time offset: a random microbunch of the train, Gaussian within the bunch
+    G4double time = 0.;
+    if (nBunches > 1) time += G4int(G4UniformRand() * nBunches) * bunchSpacing;
+    if (bunchLength > 0.) time += G4RandGauss::shoot(0., bunchLength);
+    
+    if (cocktail) {
+      G4int sourceID = cocktail->SampleSource();
+      const LCCocktailSource& source = cocktail->GetSource(sourceID);
+      fParticleGun->SetParticleDefinition(source.particle);
+      GeneratePrimary(anEvent, time, source.particle->GetParticleName(), cocktail->SampleEnergy(sourceID),
+                      cocktail->SampleDirection(sourceID, eventDirection));
+      
+      if (i == 0) eventSourceID = sourceID;
+      else if (sourceID != eventSourceID) eventSourceID = LCEventInformation::kMixedSources;
+    } else {
+      GeneratePrimary(anEvent, time, fParticleName, fParticleEnergy, eventDirection);
+    }
+  }
+  
+  // Restore the beam settings for the next event
+  if (cocktail) {
+    fParticleGun->SetParticleDefinition(beamParticle);
+    fParticleGun->SetParticleMomentumDirection(fBeamDirection);
+  }
+  
+  auto eventInfo = new LCEventInformation(nPrimaries, eventSourceID);
+  eventInfo->SetIncidence(theta, phi);
+  anEvent->SetUserInformation(eventInfo);
+}
+
+void LCPrimaryGeneratorAction::ApplyConfiguration(const LCConfigSnapshot* config)
+{
+  fConfig = config;
+  fFilterTables.clear();
+  if (config->particleName != fParticleName) SetParticleType(config->particleName);
+  fParticleEnergy = config->particleEnergy;
+  fGlassFilterEnabled = config->glassFilter;
+}
 
+const LCGlassFilterTable* LCPrimaryGeneratorAction::GetFilterTable(const G4ParticleDefinition* particle)
+{
+  for (const auto& entry : fFilterTables) {
+    if (entry.first == particle) return entry.second;
+  }
+  
+  // First primary of this particle under this configuration: the shared
+  // table store takes a lock, so it is only asked here
+  const LCGlassFilterTable* table = LCGlassFilterTable::Get(particle->GetParticleName());
+  fFilterTables.emplace_back(particle, table);
+  return table;
+}
+
+G4ThreeVector LCPrimaryGeneratorAction::SampleIncidence(G4double& theta, G4double& phi) const
+{
+  const G4String& mode = fConfig->angularMode;
+  
+  theta = 0.;
+  phi = twopi * G4UniformRand();
+  if (mode == "list") {
+    const LCAliasTable& table = fConfig->angularPointTable;
+    if (table.IsEmpty()) {
+      phi = 0.;
+      return fBeamDirection;
+    }
+    const LCIncidenceAngle& point = fConfig->angularPoints[table.Sample()];
+    theta = point.theta;
+    phi = point.phi;
+  } else {
+    // uniformCos: isotropic flux through a point; cosine: Lambert law (flux
+    // through a plane), i.e. cos^2(theta) uniform
+    G4double cosMax = std::cos(fConfig->angularThetaMin);
+    G4double cosMin = std::cos(fConfig->angularThetaMax);
+    G4double cosTheta = 0.;
+    if (mode == "cosine") {
+      cosTheta = std::sqrt(cosMin*cosMin + G4UniformRand() * (cosMax*cosMax - cosMin*cosMin));
+    } else {
+      cosTheta = cosMin + G4UniformRand() * (cosMax - cosMin);
+    }
+    theta = std::acos(cosTheta);
+  }
+  
+  G4ThreeVector direction(std::sin(theta)*std::cos(phi), std::sin(theta)*std::sin(phi), std::cos(theta));
+  return direction.rotateUz(fBeamDirection);
+}
+
+void LCPrimaryGeneratorAction::GeneratePrimary(G4Event* anEvent, G4double time, const G4String& particleName,
+                                               G4double energy, const G4ThreeVector& direction)
+{
+  fParticleGun->SetParticleEnergy(energy);
+  fParticleGun->SetParticleMomentumDirection(direction);
+  
   // Base position settings
   G4double x0 = 0;
   G4double y0 = -15.0*mm; // Position beam 15mm before the detector in Y direction
@@ -66,29 +187,46 @@ void LCPrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
   
   // If glass filter is enabled, modify beam energy according to filter attenuation
   if (fGlassFilterEnabled) {
+    // Tabulated slab transfer when selected and a table exists for this particle
+    const LCGlassFilterTable* table = nullptr;
+    if (fConfig->glassFilterModel == "table") {
+      table = GetFilterTable(fParticleGun->GetParticleDefinition());
+    }
+    
+    if (table) {
+      G4double filteredEnergy = energy;
+      G4double theta = 0.;
+      if (!table->Sample(energy, filteredEnergy, theta)) {
+        return;  // Stopped in the filter - nothing reaches the detector
+      }
+      G4double phi = twopi * G4UniformRand();
+      G4ThreeVector scattered(std::sin(theta)*std::cos(phi), std::sin(theta)*std::sin(phi), std::cos(theta));
+      fParticleGun->SetParticleEnergy(filteredEnergy);
+      fParticleGun->SetParticleMomentumDirection(scattered.rotateUz(direction));
+    }
     // Simplified glass filter energy reduction - more sophisticated model could be used
-    if (fParticleName == "gamma") {
+    else if (particleName == "gamma") {
       // Approximate exponential attenuation for gammas
       G4double attenuation = G4RandExponential::shoot(2.0);
-      G4double attenuatedEnergy = fParticleEnergy * std::exp(-attenuation);
+      G4double attenuatedEnergy = energy * std::exp(-attenuation);
       fParticleGun->SetParticleEnergy(attenuatedEnergy);
     }
-    else if (fParticleName == "e-" || fParticleName == "e+") {
+    else if (particleName == "e-" || particleName == "e+") {
       // Electrons and positrons lose significant energy
-      G4double attenuatedEnergy = fParticleEnergy * 0.6; // 40% energy loss
+      G4double attenuatedEnergy = energy * 0.6; // 40% energy loss
       fParticleGun->SetParticleEnergy(attenuatedEnergy);
     }
-    else if (fParticleName == "alpha") {
+    else if (particleName == "alpha") {
       // Alpha particles are completely stopped by glass
       fParticleGun->SetParticleEnergy(0.001*MeV); // Effectively stopped
     }
-    else if (fParticleName == "neutron") {
+    else if (particleName == "neutron") {
       // Neutrons have minimal interaction with glass
       // No change to energy
     }
     else {
       // Default basic energy reduction for other particles
-      G4double attenuatedEnergy = fParticleEnergy * 0.9; // 10% energy loss
+      G4double attenuatedEnergy = energy * 0.9; // 10% energy loss
       fParticleGun->SetParticleEnergy(attenuatedEnergy);
     }
     
@@ -97,6 +235,7 @@ void LCPrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
   }
   
   fParticleGun->SetParticlePosition(G4ThreeVector(x0, y0, z0));
+  fParticleGun->SetParticleTime(time);
   fParticleGun->GeneratePrimaryVertex(anEvent);
 }
 
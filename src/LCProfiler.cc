@@ -0,0 +1,183 @@
+// LCProfiler.cc - Cycle-counter profile of the stepping and event hot paths
+#include "LCProfiler.hh"
+
+#ifdef LC_ENABLE_PROFILING
+
+#include "LCStepRecorder.hh"
+#include "G4AutoLock.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Threading.hh"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <utility>
+
+namespace {
+  const char* kRegionNames[kNumberOfProfileRegions] = {
+    "SteppingAction", "ElectrodePath", "CellPath", "DepositInCell", "EndOfEventAction"
+  };
+  
+  // One thread's profile of one run, in seconds
+  struct ThreadProfile {
+    G4int threadID;
+    std::vector<LCProfileStepEntry> steps;
+    std::uint64_t regionCalls[kNumberOfProfileRegions];
+    G4double regionSeconds[kNumberOfProfileRegions];
+  };
+  
+  G4Mutex profileMutex = G4MUTEX_INITIALIZER;
+  std::vector<ThreadProfile> publishedProfiles;
+}
+
+G4ThreadLocal LCProfiler* LCProfiler::fInstance = nullptr;
+
+LCProfiler* LCProfiler::Instance() {
+  if (!fInstance) {
+    fInstance = new LCProfiler();
+  }
+  return fInstance;
+}
+
+LCProfiler::LCProfiler()
+: fLastVolume(0),
+  fLastStepEnd(0),
+  fRunStartCycles(0)
+{
+  BeginRun();
+}
+
+void LCProfiler::BeginRun() {
+  // Volumes may be rebuilt between runs, so their pointers are not kept
+  fVolumes.clear();
+  fLastVolume = 0;
+  std::fill(fRegionCalls, fRegionCalls + kNumberOfProfileRegions, 0);
+  std::fill(fRegionCycles, fRegionCycles + kNumberOfProfileRegions, 0);
+  fRunStart = std::chrono::steady_clock::now();
+  fRunStartCycles = LCProfileClock();
+  fLastStepEnd = fRunStartCycles;
+}
+
+void LCProfiler::AddStep(const G4LogicalVolume* volume, G4int category, std::uint64_t now) {
+  // Steps come in runs in the same volume; there are only a few volumes
+  if (fLastVolume >= fVolumes.size() || fVolumes[fLastVolume].volume != volume) {
+    fLastVolume = 0;
+    while (fLastVolume < fVolumes.size() && fVolumes[fLastVolume].volume != volume) fLastVolume++;
+    if (fLastVolume == fVolumes.size()) {
+      fVolumes.push_back({volume, std::vector<std::uint64_t>(kNumberOfCategories, 0),
+                          std::vector<std::uint64_t>(kNumberOfCategories, 0)});
+    }
+  }
+  VolumeCounts& counts = fVolumes[fLastVolume];
+  counts.steps[category]++;
+  counts.cycles[category] += now - fLastStepEnd;
+}
+
+void LCProfiler::EndRun() {
+  if (fVolumes.empty() && fRegionCalls[kProfileEndOfEvent] == 0) return;
+  
+  // Clock rate over this run
+  G4double elapsed = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - fRunStart).count();
+  std::uint64_t cycles = LCProfileClock() - fRunStartCycles;
+  G4double secondsPerCycle = (cycles > 0 && elapsed > 0.) ? elapsed / cycles : 0.;
+  
+  ThreadProfile profile;
+  profile.threadID = G4Threading::G4GetThreadId();
+  for (const auto& counts : fVolumes) {
+    for (G4int category = 0; category < kNumberOfCategories; category++) {
+      if (counts.steps[category] == 0) continue;
+      profile.steps.push_back({counts.volume ? counts.volume->GetName() : G4String("(none)"), category,
+                               counts.steps[category], counts.cycles[category] * secondsPerCycle});
+    }
+  }
+  for (G4int region = 0; region < kNumberOfProfileRegions; region++) {
+    profile.regionCalls[region] = fRegionCalls[region];
+    profile.regionSeconds[region] = fRegionCycles[region] * secondsPerCycle;
+  }
+  
+  G4AutoLock lock(&profileMutex);
+  publishedProfiles.push_back(std::move(profile));
+}
+
+G4bool LCProfiler::WriteReport(const G4String& fileName) {
+  std::vector<ThreadProfile> profiles;
+  {
+    G4AutoLock lock(&profileMutex);
+    profiles.swap(publishedProfiles);
+  }
+  if (profiles.empty()) return false;
+  
+  // Sum over threads
+  std::map<std::pair<G4String, G4int>, std::pair<std::uint64_t, G4double>> steps;
+  std::uint64_t regionCalls[kNumberOfProfileRegions] = {};
+  G4double regionSeconds[kNumberOfProfileRegions] = {};
+  std::uint64_t totalSteps = 0;
+  G4double totalSeconds = 0.;
+  for (const auto& profile : profiles) {
+    for (const auto& entry : profile.steps) {
+      auto& sum = steps[{entry.volume, entry.category}];
+      sum.first += entry.steps;
+      sum.second += entry.seconds;
+      totalSteps += entry.steps;
+      totalSeconds += entry.seconds;
+    }
+    for (G4int region = 0; region < kNumberOfProfileRegions; region++) {
+      regionCalls[region] += profile.regionCalls[region];
+      regionSeconds[region] += profile.regionSeconds[region];
+    }
+  }
+  
+  // Most expensive first
+  std::vector<LCProfileStepEntry> merged;
+  for (const auto& sum : steps) {
+    merged.push_back({sum.first.first, sum.first.second, sum.second.first, sum.second.second});
+  }
+  std::sort(merged.begin(), merged.end(),
+            [](const LCProfileStepEntry& a, const LCProfileStepEntry& b) { return a.seconds > b.seconds; });
+  
+  std::ofstream out(fileName);
+  if (!out.is_open()) {
+    G4cerr << "Warning: Could not open profile report: " << fileName << G4endl;
+    return false;
+  }
+  out << std::fixed;
+  out << "LC hot-path profile (times summed over " << profiles.size() << " threads)\n";
+  out << "=================================================\n";
+  out << "Steps per volume and particle; time is Geant4's, from the end of one\n";
+  out << "stepping action to the start of the next (including track setup)\n";
+  out << std::left << std::setw(20) << "volume" << std::setw(10) << "particle" << std::right
+      << std::setw(14) << "steps" << std::setw(8) << "%steps" << std::setw(12) << "time_s"
+      << std::setw(8) << "%time" << std::setw(10) << "ns/step" << "\n";
+  for (const auto& entry : merged) {
+    out << std::left << std::setw(20) << entry.volume
+        << std::setw(10) << LCStepRecorder::CategoryName(static_cast<std::uint8_t>(entry.category)) << std::right
+        << std::setw(14) << entry.steps
+        << std::setw(8) << std::setprecision(1) << (totalSteps ? 100. * entry.steps / totalSteps : 0.)
+        << std::setw(12) << std::setprecision(4) << entry.seconds
+        << std::setw(8) << std::setprecision(1) << (totalSeconds > 0. ? 100. * entry.seconds / totalSeconds : 0.)
+        << std::setw(10) << std::setprecision(0) << (entry.steps ? 1.e9 * entry.seconds / entry.steps : 0.) << "\n";
+  }
+  out << std::left << std::setw(30) << "total" << std::right << std::setw(14) << totalSteps
+      << std::setw(8) << "" << std::setw(12) << std::setprecision(4) << totalSeconds << "\n";
+  out << "-------------------------------------------------\n";
+  out << "Our own code (nested: the paths are part of SteppingAction), with the\n";
+  out << "time relative to the Geant4 step time above\n";
+  out << std::left << std::setw(20) << "region" << std::right << std::setw(14) << "calls"
+      << std::setw(12) << "time_s" << std::setw(10) << "ns/call" << std::setw(10) << "%G4time" << "\n";
+  for (G4int region = 0; region < kNumberOfProfileRegions; region++) {
+    out << std::left << std::setw(20) << kRegionNames[region] << std::right
+        << std::setw(14) << regionCalls[region]
+        << std::setw(12) << std::setprecision(4) << regionSeconds[region]
+        << std::setw(10) << std::setprecision(0)
+        << (regionCalls[region] ? 1.e9 * regionSeconds[region] / regionCalls[region] : 0.)
+        << std::setw(10) << std::setprecision(1)
+        << (totalSeconds > 0. ? 100. * regionSeconds[region] / totalSeconds : 0.) << "\n";
+  }
+  out << "=================================================\n";
+  out.close();
+  
+  G4cout << "Hot-path profile saved to: " << fileName << G4endl;
+  return true;
+}
+
+#endif
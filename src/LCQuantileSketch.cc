@@ -0,0 +1,126 @@
+// LCQuantileSketch.cc - Mergeable quantile sketch with a relative accuracy guarantee
+#include "LCQuantileSketch.hh"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+  // Magnitudes below this count as zero (keeps the bucket index in range)
+  const G4double kMinMagnitude = 1.0e-300;
+  
+  G4int ClampIndex(G4int index, G4int range) {
+    return index < -range ? -range : (index > range ? range : index);
+  }
+}
+
+LCQuantileSketch::LCQuantileSketch(G4double relativeAccuracy)
+  : fAccuracy(relativeAccuracy),
+    fGamma((1. + relativeAccuracy) / (1. - relativeAccuracy)),
+    fInvLogGamma(1. / std::log(fGamma)),
+    fZeroWeight(0.),
+    fTotalWeight(0.)
+{}
+
+G4int LCQuantileSketch::Index(G4double magnitude) const {
+  return static_cast<G4int>(std::ceil(std::log(magnitude) * fInvLogGamma));
+}
+
+G4double LCQuantileSketch::Value(G4int index) const {
+  // Midpoint (in relative terms) of (gamma^(i-1), gamma^i]
+  return 2. * std::pow(fGamma, index) / (fGamma + 1.);
+}
+
+void LCQuantileSketch::Add(G4double x, G4double weight) {
+  if (!(weight > 0.) || !std::isfinite(x)) return;
+  fTotalWeight += weight;
+  
+  G4double magnitude = std::fabs(x);
+  if (magnitude < kMinMagnitude) {
+    fZeroWeight += weight;
+    return;
+  }
+  
+  std::map<G4int, G4double>& buckets = x > 0. ? fPositive : fNegative;
+  buckets[Index(magnitude)] += weight;
+  if (buckets.size() > kMaxBuckets) Collapse(buckets);
+}
+
+void LCQuantileSketch::Collapse(std::map<G4int, G4double>& buckets) {
+  // Fold the lowest buckets into the first one that is kept
+  while (buckets.size() > kMaxBuckets) {
+    auto lowest = buckets.begin();
+    auto next = std::next(lowest);
+    next->second += lowest->second;
+    buckets.erase(lowest);
+  }
+}
+
+void LCQuantileSketch::Merge(const LCQuantileSketch& other) {
+  // Sketches of one run share the accuracy; bucket indices then line up
+  for (const auto& bucket : other.fPositive) fPositive[bucket.first] += bucket.second;
+  for (const auto& bucket : other.fNegative) fNegative[bucket.first] += bucket.second;
+  if (fPositive.size() > kMaxBuckets) Collapse(fPositive);
+  if (fNegative.size() > kMaxBuckets) Collapse(fNegative);
+  fZeroWeight += other.fZeroWeight;
+  fTotalWeight += other.fTotalWeight;
+}
+
+void LCQuantileSketch::AppendDense(std::vector<G4double>& values) const {
+  std::size_t start = values.size();
+  values.resize(start + GetDenseSize(), 0.);
+  G4double* dense = values.data() + start;
+  dense[0] = fZeroWeight;
+  dense[1] = fTotalWeight;
+  G4double* positive = dense + 2 + kDenseRange;
+  G4double* negative = positive + 2 * kDenseRange + 1;
+  for (const auto& bucket : fPositive) {
+    positive[ClampIndex(bucket.first, kDenseRange)] += bucket.second;
+  }
+  for (const auto& bucket : fNegative) {
+    negative[ClampIndex(bucket.first, kDenseRange)] += bucket.second;
+  }
+}
+
+void LCQuantileSketch::SetFromDense(const G4double* values) {
+  Reset();
+  fZeroWeight = values[0];
+  fTotalWeight = values[1];
+  const G4double* positive = values + 2 + kDenseRange;
+  const G4double* negative = positive + 2 * kDenseRange + 1;
+  for (G4int index = -kDenseRange; index <= kDenseRange; index++) {
+    if (positive[index] > 0.) fPositive[index] = positive[index];
+    if (negative[index] > 0.) fNegative[index] = negative[index];
+  }
+  if (fPositive.size() > kMaxBuckets) Collapse(fPositive);
+  if (fNegative.size() > kMaxBuckets) Collapse(fNegative);
+}
+
+void LCQuantileSketch::Reset() {
+  fPositive.clear();
+  fNegative.clear();
+  fZeroWeight = 0.;
+  fTotalWeight = 0.;
+}
+
+G4double LCQuantileSketch::Quantile(G4double q) const {
+  if (fTotalWeight <= 0.) return 0.;
+  q = std::min(1., std::max(0., q));
+  G4double rank = q * fTotalWeight;
+  
+  // Ascending values: most negative first, then zero, then positive
+  G4double cumulative = 0.;
+  for (auto bucket = fNegative.rbegin(); bucket != fNegative.rend(); ++bucket) {
+    cumulative += bucket->second;
+    if (cumulative >= rank) return -Value(bucket->first);
+  }
+  cumulative += fZeroWeight;
+  if (cumulative >= rank && fZeroWeight > 0.) return 0.;
+  for (const auto& bucket : fPositive) {
+    cumulative += bucket.second;
+    if (cumulative >= rank) return Value(bucket.first);
+  }
+  
+  // Rounding in the cumulative sum: the largest value
+  if (!fPositive.empty()) return Value(fPositive.rbegin()->first);
+  if (fZeroWeight > 0.) return 0.;
+  return -Value(fNegative.begin()->first);
+}
@@ -0,0 +1,249 @@
+// LCReadoutModel.cc - Charge collection and electrometer response model
+#include "LCReadoutModel.hh"
+#include "LCEventAction.hh"
+#include "LCEventArena.hh"
+#include "LCTransportTables.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Define units for convenience
+namespace {
+  const G4double femtoampere = 1.0e-15 * ampere;
+}
+
+LCReadoutModel::LCReadoutModel()
+: fElectricField(3.0*volt/um),
+  fCellThickness(100.0*um),
+  fMobilityElectron(1.0e-6*cm2/volt/s),  // Electron mobility in LC
+  fMobilityIon(1.0e-8*cm2/volt/s),       // Ion mobility in LC
+  fRecombinationCoef(0.),                // Langevin, from the mobilities (~2e-13 cm3/s)
+  fCollectionEfficiency(0.8),            // 80% charge collection efficiency
+  fEnergyPerIonization(30.0*eV),         // ~30 eV per ionization
+  // Tabulated transport model
+  fUseTransportTables(false),
+  fSaturationVelocityElectron(1.0*mm/s),
+  fSaturationVelocityIon(10.0*um/s),
+  fIntrinsicIonDensity(1.0e13/cm3),      // Typical free ion content of 5CB
+  fColumnRadius(0.1*um),
+  fRelativePermittivity(11.0),           // 5CB, mean of parallel (19) and perpendicular (7)
+  fTransportTables(nullptr),
+  fFieldCoordinate(0.),
+  // Electrometer parameters
+  fElectrometerResistance(1.0e9*ohm),    // 1 GΩ input resistance
+  fElectrometerCapacitance(10.0*picofarad), // 10 pF input capacitance
+  fElectrometerTimeConstant(1.0e9*ohm * 10.0*picofarad), // RC time constant
+  fElectrometerSamplingRate(1.0e6*hertz), // 1 MHz sampling rate
+  fCurrentPulses(LCEventArena::Instance()),
+  fPulseCapacity(std::numeric_limits<std::size_t>::max()),
+  fPulseHighWater(0),
+  fRecordDrifts(false)
+{
+}
+
+LCReadoutModel::~LCReadoutModel()
+{
+}
+
+void LCReadoutModel::SetElectrometer(G4double resistance, G4double capacitance) {
+  fElectrometerResistance = resistance;
+  fElectrometerCapacitance = capacitance;
+  fElectrometerTimeConstant = resistance * capacitance;
+}
+
+void LCReadoutModel::SetTransportModel(const G4String& model) {
+  fUseTransportTables = (model == "tabulated");
+  fTransportTables = nullptr;
+}
+
+void LCReadoutModel::UpdateTransportTables() {
+  LCTransportParameters parameters;
+  parameters.cellThickness = fCellThickness;
+  parameters.mobilityElectron = fMobilityElectron;
+  parameters.mobilityIon = fMobilityIon;
+  parameters.saturationVelocityElectron = fSaturationVelocityElectron;
+  parameters.saturationVelocityIon = fSaturationVelocityIon;
+  parameters.recombinationCoef = fRecombinationCoef;
+  parameters.intrinsicIonDensity = fIntrinsicIonDensity;
+  parameters.columnRadius = fColumnRadius;
+  parameters.relativePermittivity = fRelativePermittivity;
+  fTransportTables = LCTransportTables::Get(parameters);
+  fFieldCoordinate = fTransportTables->FieldCoordinate(fElectricField);
+}
+
+void LCReadoutModel::ReleasePulses() {
+  fPulseHighWater = std::max(fPulseHighWater, fCurrentPulses.size());
+  std::pmr::vector<CurrentPulse>(fCurrentPulses.get_allocator()).swap(fCurrentPulses);
+}
+
+void LCReadoutModel::BeginEvent(std::size_t pulseCapacity) {
+  fCurrentPulses.clear();
+  fPulseCapacity = pulseCapacity;
+  fCurrentPulses.reserve(std::min(fPulseHighWater, fPulseCapacity));
+  fChargeDrifts.clear();
+}
+
+LCDepositReadout LCReadoutModel::ProcessDeposit(G4double energyDeposit, G4double y, G4double t0,
+                                                LCEventAction* eventAction, G4double trackLength) {
+  LCDepositReadout readout;
+  
+  // Calculate ionization events
+  readout.ionizationEvents = CalculateIonizationEvents(energyDeposit);
+  
+  G4double electronTransitTime, ionTransitTime;
+  G4double electronCharge, ionCharge;
+  if (fUseTransportTables) {
+    if (!fTransportTables) UpdateTransportTables();
+    
+    // Pairs escaping recombination in the column, and the part of their
+    // charge the drifting electrons and ions induce before being lost
+    G4double pairDensity = trackLength > 0. ? readout.ionizationEvents / trackLength : 0.;
+    LCTransportLookup transport = fTransportTables->Lookup(y, fFieldCoordinate, pairDensity);
+    G4double pairs = readout.ionizationEvents * transport.escape;
+    readout.collectedElectrons = G4int(pairs * transport.electronCollection);
+    readout.collectedIons = G4int(pairs * transport.ionCollection);
+    readout.charge = CalculateCharge(readout.collectedElectrons + readout.collectedIons);
+    electronTransitTime = transport.electronTransit;
+    ionTransitTime = transport.ionTransit;
+    electronCharge = CalculateCharge(readout.collectedElectrons);
+    ionCharge = CalculateCharge(readout.collectedIons);
+  } else {
+    // Apply collection efficiency
+    readout.collectedElectrons = G4int(readout.ionizationEvents * fCollectionEfficiency);
+    readout.collectedIons = readout.collectedElectrons; // Same number collected
+    
+    // Calculate charge
+    readout.charge = CalculateCharge(readout.collectedElectrons);
+    
+    // Distance to electrodes (for transit time calculation), along Y-axis
+    G4double distanceToAnode = (fCellThickness/2.0) - y;
+    G4double distanceToCathode = (fCellThickness/2.0) + y;
+    
+    // Transit times
+    electronTransitTime = distanceToAnode / (fMobilityElectron * fElectricField);
+    ionTransitTime = distanceToCathode / (fMobilityIon * fElectricField);
+    electronCharge = CalculateCharge(readout.collectedElectrons);
+    ionCharge = CalculateCharge(readout.collectedIons);
+  }
+  
+  // Current contribution. With the tables, carriers that induce no charge
+  // (lost, or created at their own electrode) give no pulse.
+  G4bool electronPulse = !fUseTransportTables || readout.collectedElectrons > 0;
+  G4bool ionPulse = !fUseTransportTables || readout.collectedIons > 0;
+  readout.totalCurrent = 0.;
+  if (electronPulse) readout.totalCurrent += CalculateCurrentPulse(readout.collectedElectrons, electronTransitTime);
+  if (ionPulse) readout.totalCurrent += CalculateCurrentPulse(readout.collectedIons, ionTransitTime);
+  
+  // Update event action
+  eventAction->AddEdep(energyDeposit);
+  eventAction->AddCharge(readout.charge);
+  eventAction->AddElectronCount(readout.collectedElectrons);
+  eventAction->AddIonCount(readout.collectedIons);
+  
+  // Simulate electrometer response for electrons and ions
+  if (electronPulse) SimulateElectrometerResponse(electronCharge, electronTransitTime, t0, eventAction);
+  if (ionPulse) SimulateElectrometerResponse(ionCharge, ionTransitTime, t0, eventAction);
+  
+  return readout;
+}
+
+G4int LCReadoutModel::CalculateIonizationEvents(G4double energyDeposit) {
+  // Calculate mean number of ionization events
+  G4double meanIonizations = energyDeposit / fEnergyPerIonization;
+  
+  // Apply statistical fluctuations (Poisson distribution)
+  G4int actualIonizations = G4int(meanIonizations + 0.5);  // Simple rounding as fallback
+  
+  // Add statistical fluctuations with normal distribution
+  G4double sigma = std::sqrt(meanIonizations);  // Poisson variance = mean
+  actualIonizations += G4int(G4RandGauss::shoot(0., sigma));
+  if (actualIonizations < 0) actualIonizations = 0;  // Ensure non-negative
+  
+  return actualIonizations;
+}
+
+G4double LCReadoutModel::CalculateCharge(G4int numElectrons) {
+  // Convert number of electrons to charge
+  return numElectrons * 1.602e-19 * coulomb;
+}
+
+G4double LCReadoutModel::CalculateCurrentPulse(G4int numCharges, G4double transitTime) {
+  // Simple current model: Q/t
+  G4double charge = numCharges * 1.602e-19 * coulomb;
+  
+  // Apply statistical fluctuations to transit time
+  G4double actualTransitTime = G4RandGauss::shoot(transitTime, 0.1*transitTime);
+  if (actualTransitTime <= 0) actualTransitTime = transitTime; // Avoid negative time
+  
+  return charge / actualTransitTime;
+}
+
+void LCReadoutModel::SimulateElectrometerResponse(G4double charge, G4double transitTime, G4double t0,
+                                                  LCEventAction* eventAction) {
+  // Determine when this charge would reach the electrode
+  G4double arrivalTime = t0 + transitTime;
+  
+  // Store the current pulse information (up to the budgeted capacity)
+  if (fCurrentPulses.size() < fPulseCapacity) {
+    fCurrentPulses.push_back(CurrentPulse(arrivalTime, charge, transitTime));
+  }
+  if (fRecordDrifts) {
+    fChargeDrifts.push_back({t0, transitTime, charge});
+  }
+  
+  // Calculate the current at this time
+  G4double instantCurrent = CalculateElectrometerCurrent(charge, transitTime);
+  
+  // Add to the electrometer current reading in event action
+  eventAction->AddCurrentPulse(arrivalTime, instantCurrent);
+  
+  // Now simulate the time profile by adding multiple samples
+  // This models the electrometer's response over time
+  
+  // Number of samples based on electrometer sampling rate and transit time
+  // MEMORY OPTIMIZATION: Limit the number of time samples to a reasonable amount
+  const G4int MAX_TIME_SAMPLES_PER_PULSE = 100;
+  G4int desiredSamples = static_cast<G4int>(transitTime * fElectrometerSamplingRate);
+  G4int numSamples = std::min(MAX_TIME_SAMPLES_PER_PULSE, std::max(10, desiredSamples));
+  
+  // Calculate sample step size based on limited number
+  G4double timeStep = transitTime / numSamples;
+  
+  for(G4int i=0; i<numSamples; i++) {
+    // Calculate time for this sample
+    G4double sampleTime = arrivalTime + i * timeStep;
+    
+    // Calculate current at this time based on electrometer model
+    // Here we use a simple exponential decay model based on RC time constant
+    G4double timeSinceArrival = sampleTime - arrivalTime;
+    G4double decayFactor = std::exp(-timeSinceArrival / fElectrometerTimeConstant);
+    
+    // Current decreases exponentially after initial pulse
+    G4double sampleCurrent = instantCurrent * decayFactor;
+    
+    // Add noise to the reading (typical electrometer noise is in femtoamperes)
+    G4double noise = G4RandGauss::shoot(0.0, 10.0*femtoampere);
+    sampleCurrent += noise;
+    
+    // Add this sample to the time profile
+    eventAction->AddTimeProfile(sampleTime, sampleCurrent);
+  }
+}
+
+G4double LCReadoutModel::CalculateElectrometerCurrent(G4double charge, G4double transitTime) {
+  // Base current: I = Q/t
+  G4double baseCurrent = charge / transitTime;
+  
+  // Apply electrometer response characteristics
+  // 1. Input impedance effect: Reduces current slightly
+  G4double impedanceEffect = 1.0 - std::exp(-transitTime / fElectrometerTimeConstant);
+  
+  // 2. Apply measurement uncertainty
+  G4double uncertainty = 0.01; // 1% uncertainty
+  G4double measuredCurrent = baseCurrent * impedanceEffect * 
+                            (1.0 + G4RandGauss::shoot(0.0, uncertainty));
+  
+  return measuredCurrent;
+}
@@ -0,0 +1,360 @@
+// LCResultCache.cc - Content-addressed store of finished simulation outputs
+#include "LCResultCache.hh"
+#include "LCRunAction.hh"
+#include "LCDetectorConstruction.hh"
+#include "LCGlobalManager.hh"
+#include "LCCocktailGenerator.hh"
+#include "LCGlassFilterTable.hh"
+#include "LCPhysicsList.hh"
+#include "LCMPIManager.hh"
+#include "LCMemoryTracker.hh"
+#include "G4RunManager.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <set>
+#include <iomanip>
+#include <cstdint>
+
+#ifndef LC_BUILD_ID
+#define LC_BUILD_ID "unknown"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+  const char* const kManifestName = "manifest.txt";
+  
+  // Outcome of the last BeamOn, in the working directory (read by LCSweep)
+  const char* const kStatusFileName = "lc_cache_status.txt";
+  
+  // One line: "hit", "partial", "miss" or "uncached", then the events simulated
+  void WriteStatus(const char* status, G4int simulatedEvents) {
+    if (!LCMPIManager::Instance()->IsRoot()) return;
+    std::ofstream out(kStatusFileName);
+    out << status << " " << simulatedEvents << "\n";
+  }
+  
+  // MPI runs: the events stored for this configuration as rank 0 sees them
+  // on all ranks - the same count everywhere, or 0 (start the entries over)
+  // if any rank's entry holds different events or segments than rank 0's
+  G4int AgreeOnStoredEvents(G4int storedEvents, size_t nSegments) {
+    LCMPIManager* mpi = LCMPIManager::Instance();
+    std::vector<G4double> stored(2 * mpi->GetSize(), 0.);
+    stored[2 * mpi->GetRank()] = storedEvents;
+    stored[2 * mpi->GetRank() + 1] = static_cast<G4double>(nSegments);
+    mpi->ReduceSum(stored);
+    
+    std::vector<G4double> agreed(1, 0.);
+    if (mpi->IsRoot()) {
+      G4bool same = true;
+      for (G4int rank = 1; rank < mpi->GetSize(); rank++) {
+        same = same && stored[2 * rank] == stored[0] && stored[2 * rank + 1] == stored[1];
+      }
+      agreed[0] = same ? stored[0] : 0.;
+    }
+    mpi->Broadcast(agreed);
+    return static_cast<G4int>(agreed[0]);
+  }
+  
+  // Name a segment's files are restored under: segment 0 keeps the original
+  // name, later segments get "_seg<k>" inserted after the run's base name
+  G4String RestoredName(const G4String& fileName, const G4String& baseName, G4int index) {
+    if (index == 0) return fileName;
+    return baseName + "_seg" + std::to_string(index) + fileName.substr(baseName.size());
+  }
+}
+
+LCResultCache::LCResultCache()
+: fCacheDirectory("lc_cache")
+{
+}
+
+LCResultCache::~LCResultCache()
+{
+}
+
+G4String LCResultCache::HashString(const G4String& text) {
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : text) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  
+  std::ostringstream out;
+  out << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return out.str();
+}
+
+G4String LCResultCache::BuildConfigurationKey(const LCDetectorConstruction* detConstruction) const {
+  LCGlobalManager* global = LCGlobalManager::Instance();
+  
+  // One "name=value" line per parameter, in a fixed order, so that the same
+  // configuration always produces the same text (and therefore the same hash)
+  std::ostringstream key;
+  key << std::setprecision(10);
+  key << "beam.particle=" << global->GetParticleType() << "\n";
+  key << "beam.energy_MeV=" << global->GetParticleEnergy()/MeV << "\n";
+  key << "beam.glassFilter=" << (global->IsGlassFilterEnabled() ? 1 : 0) << "\n";
+  if (global->IsGlassFilterEnabled() && global->GetGlassFilterModel() == "table") {
+    // The outcome depends on the table contents, not just on the model choice
+    std::set<G4String> particles;
+    if (global->IsCocktailEnabled()) {
+      const LCCocktailGenerator* cocktail = global->GetCocktail();
+      for (G4int i = 0; i < cocktail->GetNumberOfSources(); i++) {
+        particles.insert(cocktail->GetSource(i).particle->GetParticleName());
+      }
+    } else {
+      particles.insert(global->GetParticleType());
+    }
+    for (const auto& particle : particles) {
+      const LCGlassFilterTable* table = LCGlassFilterTable::Get(particle);
+      key << "beam.glassFilterTable." << particle << "=" << (table ? table->GetSignature() : "none") << "\n";
+    }
+  }
+  if (global->IsCocktailEnabled()) {
+    key << "beam.cocktail:\n" << global->GetCocktail()->GetDescription();
+  }
+  if (global->IsAngularModeEnabled()) {
+    key << "beam.angular=" << global->GetAngularMode() << "," << global->GetAngularThetaMin()/deg
+        << "," << global->GetAngularThetaMax()/deg;
+    if (global->GetAngularMode() == "list") {
+      for (const auto& point : global->GetAngularPoints()) {
+        key << ";" << point.theta/deg << "/" << point.phi/deg << "/" << point.weight;
+      }
+    }
+    key << "\n";
+  }
+  if (global->IsBunchModeEnabled()) {
+    key << "beam.bunch=" << global->GetBunchPrimaries() << (global->IsBunchPoisson() ? "p" : "f")
+        << "," << global->GetBunchCount() << "," << global->GetBunchSpacing()/ns
+        << "," << global->GetBunchLength()/ns << "\n";
+  }
+  if (global->IsTimelineEnabled()) {
+    key << "beam.timeline=" << global->GetTimelineRate()/hertz << "," << global->GetTimelineBinWidth()/ns
+        << "," << global->GetTimelineWindow()/ns << "\n";
+  }
+  // Recordings add output files, which an entry stored without them cannot
+  // restore; only enabled ones are tagged, so existing entries stay valid
+  if (global->IsStepRecordingEnabled()) {
+    key << "record.steps=1\n";
+  }
+  if (global->IsWaveformRecordingEnabled()) {
+    key << "record.waveforms=" << global->GetWaveformTimeStep()/ns << ","
+        << global->GetWaveformCurrentStep()/(1.0e-12*ampere) << "\n";
+  }
+  if (detConstruction) {
+    key << "detector.bias_V=" << detConstruction->GetBias()/volt << "\n";
+    key << "detector.size_mm=" << detConstruction->GetLCWidth()/mm << "x"
+        << detConstruction->GetLCLength()/mm << "x"
+        << detConstruction->GetLCThickness()/mm << "\n";
+    // Only non-default electrodes are tagged, so existing entries stay valid
+    if (detConstruction->GetElectrodeThickness() != 1.0*mm) {
+      key << "detector.electrode_mm=" << detConstruction->GetElectrodeThickness()/mm << "\n";
+    }
+    // Only reduced geometries are tagged, so existing full-model entries stay valid
+    if (detConstruction->GetGeometryFidelity() != "full") {
+      key << "detector.fidelity=" << detConstruction->GetGeometryFidelity() << "\n";
+    }
+  }
+  // A memory budget coarsens the electrometer profile (and with it AvgCurrent)
+  // once its per-thread capacity is below the default; only then is it tagged
+  std::size_t profileCapacity = LCMemoryTracker::ProfileCapacityForBudget(
+    global->GetMemoryBudget(), G4RunManager::GetRunManager()->GetNumberOfThreads());
+  if (profileCapacity != LCMemoryTracker::kDefaultProfileCapacity) {
+    key << "readout.profileCapacity=" << profileCapacity << "\n";
+  }
+  // Only the non-default transport model is tagged, so existing entries stay valid
+  if (global->GetTransportModel() != "constant") {
+    key << "readout.transport=" << global->GetTransportModel() << "\n";
+  }
+  key << "physics=" << LCPhysicsList::GetConfigurationTag() << "\n";
+  if (global->IsBiasingEnabled()) {
+    key << "biasing.gammaFactor=" << global->GetGammaBiasFactor() << "\n";
+    key << "biasing.neutronFactor=" << global->GetNeutronBiasFactor() << "\n";
+  }
+  key << "seed=" << global->GetRandomSeed() << "\n";
+  // Each MPI rank caches its own share of the run
+  LCMPIManager* mpi = LCMPIManager::Instance();
+  if (mpi->IsActive()) {
+    key << "mpi=" << mpi->GetRank() << "/" << mpi->GetSize() << "\n";
+  }
+  key << "build=" << LC_BUILD_ID << "\n";
+  return key.str();
+}
+
+std::vector<LCResultCache::Segment> LCResultCache::ReadManifest(const G4String& entryDir) const {
+  std::vector<Segment> segments;
+  std::ifstream manifest(fs::path(entryDir.c_str()) / kManifestName);
+  if (!manifest.is_open()) return segments;
+  
+  std::string line;
+  while (std::getline(manifest, line)) {
+    std::istringstream iss(line);
+    std::string tag;
+    iss >> tag;
+    if (tag != "segment") continue;
+    
+    Segment segment;
+    std::string baseName;
+    if (iss >> segment.index >> segment.events >> segment.seeds[0] >> segment.seeds[1] >> baseName) {
+      segment.baseName = baseName;
+      segments.push_back(segment);
+    }
+  }
+  return segments;
+}
+
+void LCResultCache::WriteManifest(const G4String& entryDir, const G4String& key,
+                                  const std::vector<Segment>& segments) const {
+  // Write to a temporary file and rename, so concurrent readers never see
+  // a half-written manifest
+  fs::path manifestPath = fs::path(entryDir.c_str()) / kManifestName;
+  fs::path tmpPath = manifestPath;
+  tmpPath += ".tmp";
+  
+  {
+    std::ofstream manifest(tmpPath);
+    manifest << "# LCDetector result cache entry\n";
+    std::istringstream keyLines(key);
+    std::string line;
+    while (std::getline(keyLines, line)) {
+      manifest << "# " << line << "\n";
+    }
+    for (const auto& segment : segments) {
+      manifest << "segment " << segment.index << " " << segment.events << " "
+               << segment.seeds[0] << " " << segment.seeds[1] << " "
+               << segment.baseName << "\n";
+    }
+  }
+  fs::rename(tmpPath, manifestPath);
+}
+
+void LCResultCache::RestoreSegments(const G4String& entryDir, const std::vector<Segment>& segments) const {
+  for (const auto& segment : segments) {
+    fs::path segmentDir = fs::path(entryDir.c_str()) / ("seg" + std::to_string(segment.index));
+    std::error_code ec;
+    for (const auto& file : fs::directory_iterator(segmentDir, ec)) {
+      G4String name = file.path().filename().string();
+      fs::copy_file(file.path(), RestoredName(name, segment.baseName, segment.index).c_str(),
+                    fs::copy_options::overwrite_existing, ec);
+      if (ec) {
+        G4cerr << "Warning: Could not restore cached file " << file.path() << ": " << ec.message() << G4endl;
+      }
+    }
+  }
+}
+
+void LCResultCache::BeamOn(G4int nEvents, const LCRunAction* runAction,
+                           const LCDetectorConstruction* detConstruction) {
+  G4RunManager* runManager = G4RunManager::GetRunManager();
+  
+  // Without a fixed seed every run is a different sample, which no cache
+  // entry can stand in for
+  if (!LCGlobalManager::Instance()->IsRandomSeedFixed()) {
+    G4cout << "Result cache: random seed not fixed (--seed) - running " << nEvents
+           << " events without caching" << G4endl;
+    runManager->BeamOn(nEvents);
+    WriteStatus("uncached", nEvents);
+    return;
+  }
+  
+  G4String key = BuildConfigurationKey(detConstruction);
+  G4String hash = HashString(key);
+  G4String entryDir = (fs::path(fCacheDirectory.c_str()) / hash.c_str()).string();
+  
+  std::vector<Segment> segments = ReadManifest(entryDir);
+  G4int storedEvents = 0;
+  for (const auto& segment : segments) storedEvents += segment.events;
+  
+  // MPI runs: every rank has to run (or skip) the same runs, whose end is
+  // collective, so no rank decides on its own entry alone
+  if (LCMPIManager::Instance()->IsActive()) {
+    if (AgreeOnStoredEvents(storedEvents, segments.size()) != storedEvents) {
+      G4cout << "Result cache: entries differ between MPI ranks - starting this one over" << G4endl;
+      segments.clear();
+      storedEvents = 0;
+    }
+  }
+  
+  G4cout << "\n==== RESULT CACHE ====" << G4endl;
+  G4cout << "Configuration hash: " << hash << G4endl;
+  G4cout << "Stored events: " << storedEvents << ", requested: " << nEvents << G4endl;
+  
+  // Full hit - nothing to simulate
+  if (storedEvents >= nEvents && !segments.empty()) {
+    G4cout << "Cache hit - restoring " << segments.size() << " stored segment(s), skipping simulation" << G4endl;
+    G4cout << "======================\n" << G4endl;
+    RestoreSegments(entryDir, segments);
+    WriteStatus("hit", 0);
+    return;
+  }
+  
+  G4int missingEvents = nEvents - storedEvents;
+  Segment segment;
+  segment.index = static_cast<G4int>(segments.size());
+  segment.events = missingEvents;
+  
+  // Every segment is seeded from the configuration hash (which includes the
+  // seed) and its index alone, so what is stored under the key does not
+  // depend on the runs that came before it in the macro
+  G4String seedHash = HashString(hash + "/" + std::to_string(segment.index));
+  std::uint64_t seedBits = std::stoull(seedHash, nullptr, 16);
+  segment.seeds[0] = static_cast<long>(seedBits & 0x7fffffff) + 1;
+  segment.seeds[1] = static_cast<long>((seedBits >> 32) & 0x7fffffff) + 1;
+  long engineSeeds[3] = { segment.seeds[0], segment.seeds[1], 0 };  // zero-terminated for the engine
+  G4Random::setTheSeeds(engineSeeds, -1);
+  if (segment.index > 0) {
+    G4cout << "Partial hit - topping up " << missingEvents << " events with seeds "
+           << segment.seeds[0] << " " << segment.seeds[1] << G4endl;
+  } else {
+    G4cout << "Cache miss - simulating " << missingEvents << " events with seeds "
+           << segment.seeds[0] << " " << segment.seeds[1] << G4endl;
+  }
+  G4cout << "======================\n" << G4endl;
+  
+  runManager->BeamOn(missingEvents);
+  WriteStatus(segment.index > 0 ? "partial" : "miss", missingEvents);
+  
+  // Store the outputs this run declared
+  segment.baseName = runAction->GetCurrentFileName();
+  fs::path segmentDir = fs::path(entryDir.c_str()) / ("seg" + std::to_string(segment.index));
+  std::error_code ec;
+  fs::remove_all(segmentDir, ec);  // left over from an entry that was started over
+  fs::create_directories(segmentDir, ec);
+  if (ec) {
+    G4cerr << "Warning: Could not create cache directory " << segmentDir << ": " << ec.message() << G4endl;
+    return;
+  }
+  
+  G4int storedFiles = 0;
+  for (const auto& fileName : LCRunAction::GetOutputFiles()) {
+    fs::path file(fileName.c_str());
+    fs::copy_file(file, segmentDir / file.filename(), fs::copy_options::overwrite_existing, ec);
+    if (ec) {
+      // An incomplete segment would restore as a partial run
+      G4cerr << "Warning: Could not cache output file " << fileName << ": " << ec.message()
+             << " - segment not stored" << G4endl;
+      return;
+    }
+    storedFiles++;
+  }
+  
+  if (storedFiles == 0) {
+    G4cerr << "Warning: No output files found for " << segment.baseName << " - nothing cached" << G4endl;
+    return;
+  }
+  
+  segments.push_back(segment);
+  WriteManifest(entryDir, key, segments);
+  G4cout << "Stored " << storedFiles << " file(s) as cache segment " << segment.index
+         << " in " << segmentDir.string() << G4endl;
+  
+  // Bring the earlier segments back next to the new one
+  if (segment.index > 0) {
+    RestoreSegments(entryDir, segments);
+  }
+}
@@ -6,22 +6,80 @@
 #include "G4UnitsTable.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4AnalysisManager.hh"
+#include "G4AccumulableManager.hh"
+#include "G4Threading.hh"
+#include "G4EventManager.hh"
+#include "G4AutoLock.hh"
+#include "LCEventAction.hh"
+#include "LCSteppingAction.hh"
+#include "LCCocktailGenerator.hh"
+#include "LCMemoryTracker.hh"
 #include "LCGlobalManager.hh"
+#include "LCStepRecorder.hh"
+#include "LCWaveformRecorder.hh"
+#include "LCTimeline.hh"
+#include "LCHistograms.hh"
+#include "LCMPIManager.hh"
+#include "LCRunTermination.hh"
+#include "LCRunStatistics.hh"
+#include "LCDetectorConstruction.hh"
+#include "LCPhysicsList.hh"
+#include "LCCampaignStore.hh"
+#include "LCCondensation.hh"
+#include "LCConfiguration.hh"
+#include "LCProfiler.hh"
+#include <ctime>
+#include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <exception>
 #include <thread>
 #include <chrono>
-#include <mutex>
+#include <cmath>
+#include <algorithm>
 
-std::mutex filenameMutex;
+namespace {
+  // Event count plus the weight and primary totals, ahead of the histogram
+  // cells and the observable summaries in the MPI reduction
+  const size_t kNumberOfRunSums = 6;
+  
+  // Quantiles written to the run summary
+  const G4double kSummaryQuantiles[] = { 0.05, 0.25, 0.50, 0.75, 0.95, 0.99 };
+  const char* kSummaryQuantileNames[] = { "p05", "p25", "p50", "p75", "p95", "p99" };
+  
+  G4String JsonString(const G4String& text) {
+    G4String quoted = "\"";
+    for (char c : text) {
+      if (c == '"' || c == '\\') quoted += '\\';
+      quoted += c;
+    }
+    return quoted + "\"";
+  }
+  
+  // JSON has no inf/nan
+  void WriteJsonNumber(std::ostream& out, G4double value) {
+    if (std::isfinite(value)) out << value;
+    else out << "null";
+  }
+  
+  // Output files of the current run (LCRunAction::DeclareOutputFile)
+  G4Mutex outputFilesMutex = G4MUTEX_INITIALIZER;
+  std::vector<G4String> outputFiles;
+}
 
 LCRunAction::LCRunAction()
 : G4UserRunAction(),
   fParticleName("proton"),
   fParticleEnergy(15*GeV),
   fFilenameGenerated(false),
-  fCurrentFileName("")
+  fCurrentFileName(""),
+  fConfig(nullptr),
+  fRunWallTime(0.),
+  fSumWeight(0.),
+  fSumWeight2(0.),
+  fSumPrimaries(0.),
+  fSumEmptyEvents(0.),
+  fSumCoarsenedEvents(0.)
 {
   // Create analysis manager
   auto analysisManager = G4AnalysisManager::Instance();
@@ -33,6 +91,15 @@ LCRunAction::LCRunAction()
   
   // Also set up CSV output for easier Linux processing
   analysisManager->SetActivation(true);
+  
+  // Weight totals, merged from the workers into the master (the weighted
+  // observable means come from LCRunStatistics)
+  auto accumulableManager = G4AccumulableManager::Instance();
+  accumulableManager->RegisterAccumulable(fSumWeight);
+  accumulableManager->RegisterAccumulable(fSumWeight2);
+  accumulableManager->RegisterAccumulable(fSumPrimaries);
+  accumulableManager->RegisterAccumulable(fSumEmptyEvents);
+  accumulableManager->RegisterAccumulable(fSumCoarsenedEvents);
 }
 
 LCRunAction::~LCRunAction()
@@ -48,25 +115,71 @@ void LCRunAction::BeginOfRunAction(const G4Run* run)
   // Inform the runManager to save random number seed
   G4RunManager::GetRunManager()->SetRandomNumberStore(false);
   
+  // Output files are declared afresh by each run
+  if (IsMaster()) {
+    G4AutoLock lock(&outputFilesMutex);
+    outputFiles.clear();
+  }
+  
+  // Settings of this run: the master publishes them (under a new epoch if
+  // anything changed) before the workers start, which then read them lock-free
+  if (IsMaster()) {
+    LCConfiguration::Publish(dynamic_cast<const LCDetectorConstruction*>(
+      G4RunManager::GetRunManager()->GetUserDetectorConstruction()));
+  }
+  fConfig = LCConfiguration::ForRun();
+  
+  // Reset weighted totals
+  G4AccumulableManager::Instance()->Reset();
+  
+  // Buffer high-water marks and budgeted capacities for this run
+  LCMemoryTracker::Instance()->BeginRun();
+
+#ifdef LC_ENABLE_PROFILING
+  // Step and hot-path profile of this thread
+  LCProfiler::Instance()->BeginRun();
+#endif
+
+  // Thread-local histogram contents start empty for each run
+  LCHistograms::Instance()->Reset();
+  
+  // Streaming statistics for the run summary
+  LCRunStatistics::Instance()->BeginRun();
+  
+  // Readout constants of the current bias and cell (no stepping action on an MT master)
+  if (auto steppingAction = dynamic_cast<LCSteppingAction*>(G4EventManager::GetEventManager()->GetUserSteppingAction())) {
+    steppingAction->BeginRun();
+  }
+  
+  // Delta-electron condensation threshold and step counts
+  LCCondensation::Instance()->BeginRun(IsMaster());
+  
+  // Adaptive runs: targets and clock, shared by all threads
+  if (IsMaster()) {
+    LCRunTermination::Instance()->BeginRun();
+    fRunStart = std::chrono::steady_clock::now();
+  }
+  
   try {
-    // Lock mutex to ensure thread-safe access to global manager and file creation
-    std::lock_guard<std::mutex> lock(filenameMutex);
-    
     // Get analysis manager
     auto analysisManager = G4AnalysisManager::Instance();
     
-    // Get latest settings from global manager
-    G4String particleName = LCGlobalManager::Instance()->GetParticleType();
-    G4double particleEnergy = LCGlobalManager::Instance()->GetParticleEnergy();
-    
-    // Set local values to match global
-    fParticleName = particleName;
-    fParticleEnergy = particleEnergy;
+    // Set local values to match the published configuration
+    fParticleName = fConfig->particleName;
+    fParticleEnergy = fConfig->particleEnergy;
     
     // Generate filename using CURRENT energy values
     G4String baseFileName = "LC_" + fParticleName + "_" 
                     + G4UIcommand::ConvertToString(fParticleEnergy/MeV) + "MeV";
     
+    // A cocktail has no single particle or energy
+    if (fConfig->cocktailEnabled) {
+      baseFileName = "LC_cocktail";
+    }
+    
+    // MPI runs: ranks other than 0 write their own files
+    baseFileName += LCMPIManager::Instance()->GetFileSuffix();
+    
     // Full filename with extension
     G4String fullFileName = baseFileName + ".root";
     fCurrentFileName = baseFileName; // Store current filename base
@@ -75,48 +188,61 @@ void LCRunAction::BeginOfRunAction(const G4Run* run)
     G4cout << "\n==== SIMULATION FILE OUTPUT DETAILS ====" << G4endl;
     G4cout << "Particle type: " << fParticleName << G4endl;
     G4cout << "Particle energy: " << fParticleEnergy/MeV << " MeV" << G4endl;
+    G4cout << "Configuration epoch: " << fConfig->epoch << G4endl;
     G4cout << "Output ROOT file: " << fullFileName << G4endl;
     G4cout << "========================================\n" << G4endl;
     
     // Set and open the file
     analysisManager->SetFileName(fullFileName);
     analysisManager->OpenFile();
+    if (IsMaster()) DeclareOutputFile(fullFileName);
     
     // Create ntuple 
-    analysisManager->CreateNtuple("LCData", "Liquid Crystal Detector Data");
-    analysisManager->CreateNtupleDColumn("Edep");         // keV
-    analysisManager->CreateNtupleDColumn("Charge");       // pC
-    analysisManager->CreateNtupleIColumn("ElectronCount"); // number
-    analysisManager->CreateNtupleIColumn("IonCount");     // number
-    analysisManager->CreateNtupleDColumn("AvgCurrent");   // pA
-    analysisManager->CreateNtupleDColumn("PeakCurrent");  // pA
-    analysisManager->CreateNtupleDColumn("FinalTime");    // ns
-    analysisManager->CreateNtupleDColumn("FinalCurrent"); // pA
-    analysisManager->FinishNtuple();
-    
-    // Also create a text file for electrometer readings
-    std::string electroFile = baseFileName + "_electrometer.dat";
-    std::ofstream outFile(electroFile);
-    if (!outFile.is_open()) {
-      G4cerr << "Warning: Could not open electrometer data file: " << electroFile << G4endl;
-      G4cerr << "Continuing without electrometer data output..." << G4endl;
-    } else {
-      outFile << "# 5CB Liquid Crystal Detector with Electrometer\n";
-      outFile << "# Particle: " << fParticleName << "\n";
-      outFile << "# Energy: " << fParticleEnergy/MeV << " MeV\n";
-      outFile << "# \n";
-      outFile << "# Column 1: Event ID\n";
-      outFile << "# Column 2: Energy Deposit (keV)\n";
-      outFile << "# Column 3: Charge (pC)\n";
-      outFile << "# Column 4: Average Current (pA)\n";
-      outFile << "# Column 5: Peak Current (pA)\n";
-      outFile << "# \n";
-      outFile.close();
+    LCEventAction::BookNtuple();
+    
+    // Also create a text file for electrometer readings (one per run, from the master)
+    if (IsMaster()) {
+      std::string electroFile = baseFileName + "_electrometer.dat";
+      std::ofstream outFile(electroFile);
+      if (!outFile.is_open()) {
+        G4cerr << "Warning: Could not open electrometer data file: " << electroFile << G4endl;
+        G4cerr << "Continuing without electrometer data output..." << G4endl;
+      } else {
+        outFile << "# 5CB Liquid Crystal Detector with Electrometer\n";
+        outFile << "# Particle: " << fParticleName << "\n";
+        outFile << "# Energy: " << fParticleEnergy/MeV << " MeV\n";
+        outFile << "# Configuration epoch: " << fConfig->epoch << "\n";
+        outFile << "# \n";
+        outFile << "# Column 1: Event ID\n";
+        outFile << "# Column 2: Energy Deposit (keV)\n";
+        outFile << "# Column 3: Charge (pC)\n";
+        outFile << "# Column 4: Average Current (pA)\n";
+        outFile << "# Column 5: Peak Current (pA)\n";
+        if (fConfig->waveformRecording) {
+          outFile << "# Waveforms: " << baseFileName << "_waveforms_t<thread>.lcw (read with LCWaveformDump)\n";
+        }
+        if (fConfig->timelineRate > 0.) {
+          outFile << "# Continuous-beam timeline: " << baseFileName << "_timeline.lcw at "
+                  << fConfig->timelineRate/hertz << " events/s (read with LCWaveformDump)\n";
+        }
+        outFile << "# \n";
+        outFile.close();
+        DeclareOutputFile(electroFile);
+      }
+    }
+    
+    // Step records and waveforms share the output file base
+    LCStepRecorder::Instance()->BeginRun(baseFileName);
+    LCWaveformRecorder::Instance()->BeginRun(baseFileName);
+    
+    // The continuous-beam trace is merged from all threads into one file
+    if (IsMaster()) {
+      LCTimeline::Instance()->BeginRun(baseFileName, run->GetRunID());
     }
     
     // Set flag that filename has been generated
     fFilenameGenerated = true;
-    
+  
   } catch (const std::exception& e) {
     G4cerr << "Analysis Error in BeginOfRunAction: " << e.what() << G4endl;
     G4cerr << "Continuing without analysis output..." << G4endl;
@@ -128,11 +254,67 @@ void LCRunAction::BeginOfRunAction(const G4Run* run)
 
 void LCRunAction::EndOfRunAction(const G4Run* run)
 {
+  // Close this thread's step record and waveform files
+  LCStepRecorder::Instance()->EndRun();
+  LCWaveformRecorder::Instance()->EndRun();
+  
+  // All workers have handed over their events by the time the master ends
+  if (IsMaster()) {
+    LCTimeline::Instance()->EndRun();
+  }
+  
+  // Publish this thread's buffer high-water marks for the report
+  LCMemoryTracker::Instance()->EndRun();
+
+#ifdef LC_ENABLE_PROFILING
+  // ... and its profile, which the master merges below
+  LCProfiler::Instance()->EndRun();
+#endif
+
+  // Adaptive runs: this thread's last statistics (workers end before the master)
+  LCRunTermination::Instance()->EndRun();
+  
+  // Run summary statistics of this thread, merged by the master below
+  LCRunStatistics::Instance()->EndRun();
+  
+  // Condensation counts of this thread, for the report
+  LCCondensation::Instance()->EndRun();
+  
   G4int nofEvents = run->GetNumberOfEvent();
+  
+  // Merge weighted totals from the workers
+  G4AccumulableManager::Instance()->Merge();
+  
+  // Run summary statistics of all threads
+  LCObservableSummary summaries[kNumberOfRunObservables];
+  if (IsMaster()) {
+    LCRunStatistics::CollectMerged(summaries);
+  }
+  
+  // MPI runs: threads that simulated events hand their histograms to the
+  // rank total, then the master combines all ranks (and their summary
+  // statistics) on rank 0. Every rank's master has to take part, so this
+  // comes before the empty-run check.
+  LCMPIManager* mpi = LCMPIManager::Instance();
+  if (mpi->IsActive()) {
+    if (!IsMaster() || !G4Threading::IsMultithreadedApplication()) {
+      LCHistograms::Instance()->AddToProcessTotal();
+    }
+    if (IsMaster()) {
+      nofEvents = ReduceRanks(nofEvents, summaries);
+    }
+  }
+  
   if (nofEvents == 0) return;
   
   // Print run summary
   G4cout << "### Run " << run->GetRunID() << " ended. Number of events: " << nofEvents << G4endl;
+  if (IsMaster()) {
+    fRunWallTime = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - fRunStart).count();
+    if (fRunWallTime > 0.) {
+      G4cout << "### Event rate: " << nofEvents / fRunWallTime << " events/s" << G4endl;
+    }
+  }
   
   try {
     // Try-catch everything to avoid segfaults
@@ -142,37 +324,31 @@ void LCRunAction::EndOfRunAction(const G4Run* run)
       
       // Save histograms and ntuple
       if (analysisManager && analysisManager->IsOpenFile()) {
+        // Hand the thread-local histogram contents over before they are written/merged
+        LCHistograms::Instance()->Export();
         analysisManager->Write();
         analysisManager->CloseFile();
       }
       
-      // Generate additional electrometer report
-      G4String reportFile = fCurrentFileName + "_electrometer_report.txt";
-      
-      std::ofstream report(reportFile);
-      if (!report.is_open()) {
-        G4cerr << "Warning: Could not open report file: " << reportFile << G4endl;
-      } else {
-        report << "=================================================\n";
-        report << "    5CB LIQUID CRYSTAL DETECTOR REPORT\n";
-        report << "=================================================\n";
-        report << "Particle type: " << fParticleName << "\n";
-        report << "Particle energy: " << fParticleEnergy/MeV << " MeV\n";
-        report << "Number of events: " << nofEvents << "\n";
-        report << "-------------------------------------------------\n";
-        report << "Electrometer measurements:\n";
-        report << "  Detailed data available in: " << fCurrentFileName << ".root\n";
-        report << "  CSV data available in: " << fCurrentFileName << ".csv\n";
-        report << "-------------------------------------------------\n";
-        
-        report << "Notes: This simulation includes explicit modeling of\n";
-        report << "electrometer connected to both sides of the 5CB cell.\n";
-        report << "=================================================\n";
-        report.close();
-        
-        // Print analysis summary
-        G4cout << "Analysis results saved to file: " << fCurrentFileName << ".root" << G4endl;
-        G4cout << "Electrometer report saved to: " << reportFile << G4endl;
+      // Electrometer report - written once, from the merged totals
+      if (IsMaster() && mpi->IsRoot()) {
+        WriteReport(nofEvents, summaries);
+      }
+
+#ifdef LC_ENABLE_PROFILING
+      // Profile of all threads, one per rank
+      if (IsMaster()) {
+        LCProfiler::WriteReport(fCurrentFileName + "_profile.txt");
+        DeclareOutputFile(fCurrentFileName + "_profile.txt");
+      }
+#endif
+
+      // Machine-readable summary and campaign record of the whole run
+      if (IsMaster() && mpi->IsRoot()) {
+        if (summaries[kObservableEdep].moments.GetCount() > 0) {
+          WriteSummary(run->GetRunID(), summaries);
+          RecordCampaignRun(run->GetRunID(), summaries);
+        }
       }
       
       // Only clear data if analysis manager exists and is valid
@@ -200,6 +376,444 @@ void LCRunAction::EndOfRunAction(const G4Run* run)
   std::this_thread::sleep_for(std::chrono::milliseconds(200));
 }
 
+void LCRunAction::WriteReport(G4int nofEvents, const LCObservableSummary summaries[])
+{
+  // Generate additional electrometer report
+  G4String reportFile = fCurrentFileName + "_electrometer_report.txt";
+  
+  std::ofstream report(reportFile);
+  if (!report.is_open()) {
+    G4cerr << "Warning: Could not open report file: " << reportFile << G4endl;
+  } else {
+    DeclareOutputFile(reportFile);
+    report << "=================================================\n";
+    report << "    5CB LIQUID CRYSTAL DETECTOR REPORT\n";
+    report << "=================================================\n";
+    report << "Particle type: " << fParticleName << "\n";
+    report << "Particle energy: " << fParticleEnergy/MeV << " MeV\n";
+    report << "Number of events: " << nofEvents << "\n";
+    report << "Configuration epoch: " << fConfig->epoch << "\n";
+    LCMPIManager* mpi = LCMPIManager::Instance();
+    if (mpi->IsActive()) {
+      report << "MPI ranks: " << mpi->GetSize() << " (totals and histograms summed over ranks;"
+             << " ntuples per rank, rank N > 0 in " << fCurrentFileName << "_rank<N>.root)\n";
+    }
+    // Throughput of this geometry fidelity, for choosing production settings
+    auto detConstruction = dynamic_cast<const LCDetectorConstruction*>(
+      G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    G4String fidelity = detConstruction ? detConstruction->GetGeometryFidelity() : G4String("full");
+    report << "Geometry fidelity: " << fidelity;
+    if (fidelity == "minimal") report << " (cell and electrodes, vacuum world)\n";
+    else if (fidelity == "standard") report << " (cell and electrodes, air world)\n";
+    else report << " (cell, electrodes, wires and electrometer, air world)\n";
+    report << "Charge transport: " << fConfig->transportModel;
+    if (fConfig->transportModel == "tabulated") report << " (field-dependent mobility, recombination, drift losses)\n";
+    else report << " (constant mobilities, fixed collection efficiency)\n";
+    report << "Event rate: ";
+    if (fRunWallTime > 0.) {
+      report << nofEvents / fRunWallTime << " events/s (" << fRunWallTime << " s wall clock"
+             << (mpi->IsActive() ? ", all ranks" : "") << ")\n";
+    } else {
+      report << "n/a\n";
+    }
+    report << "Number of primaries: " << fSumPrimaries.GetValue()
+           << " (" << fSumPrimaries.GetValue() / nofEvents << " per event)\n";
+    // Empty Poisson bunches add no primaries but do count as events
+    if (fSumEmptyEvents.GetValue() > 0.) {
+      report << "Events without primaries: " << fSumEmptyEvents.GetValue()
+             << " (empty Poisson bunches, included in per-event means)\n";
+    }
+    report << "-------------------------------------------------\n";
+    report << "Electrometer measurements:\n";
+    report << "  Detailed data available in: " << fCurrentFileName << ".root\n";
+    report << "  CSV data available in: " << fCurrentFileName << ".csv\n";
+    report << "-------------------------------------------------\n";
+    
+    // Cocktail sources, to decode the SourceID ntuple column
+    LCGlobalManager* global = LCGlobalManager::Instance();
+    if (global->IsCocktailEnabled()) {
+      const LCCocktailGenerator* cocktail = global->GetCocktail();
+      G4double totalRate = 0.;
+      for (G4int id = 0; id < cocktail->GetNumberOfSources(); id++) totalRate += cocktail->GetSource(id).rate;
+      report << "Source cocktail (ntuple column SourceID):\n";
+      for (G4int id = 0; id < cocktail->GetNumberOfSources(); id++) {
+        const LCCocktailSource& source = cocktail->GetSource(id);
+        report << "  " << id << ": " << source.name << " (" << source.particle->GetParticleName()
+               << "), fraction " << source.rate / totalRate << "\n";
+      }
+      report << "-------------------------------------------------\n";
+    }
+    
+    // Incidence angles, to read the Theta/Phi columns and the *VsTheta histograms
+    if (global->IsAngularModeEnabled()) {
+      report << "Angular mode: " << global->GetAngularMode();
+      if (global->GetAngularMode() == "list") {
+        report << ", " << global->GetAngularPoints().size() << " directions (theta/phi deg, weight):\n";
+        for (const auto& point : global->GetAngularPoints()) {
+          report << "  " << point.theta/deg << " / " << point.phi/deg << ", " << point.weight << "\n";
+        }
+      } else {
+        report << ", theta " << global->GetAngularThetaMin()/deg << " - "
+               << global->GetAngularThetaMax()/deg << " deg\n";
+      }
+      report << "-------------------------------------------------\n";
+    }
+    
+    // Continuous beam: the merged electrometer trace
+    if (fConfig->timelineRate > 0.) {
+      LCTimeline* timeline = LCTimeline::Instance();
+      report << "Continuous-beam timeline: " << timeline->GetRate()/hertz << " events/s, "
+             << timeline->GetBinWidth()/us << " us samples\n";
+      report << "  Trace: " << timeline->GetFileName() << " (" << timeline->GetDuration()/s << " s)\n";
+      report << "  Mean electrometer current: " << timeline->GetMeanCurrent()/(1.0e-12*ampere) << " pA\n";
+      report << "  Peak electrometer current: " << timeline->GetPeakCurrent()/(1.0e-12*ampere) << " pA\n";
+      report << "  Charge drifts merged late: " << timeline->GetLateDrifts()
+             << " (peak " << timeline->GetPeakPendingSteps() << " pending current steps)\n";
+      report << "-------------------------------------------------\n";
+    }
+    
+    // Per-event means (sum of w x over the event count), in the summary units
+    const LCRunningStat& edep = summaries[kObservableEdep].tally;
+    const LCRunningStat& charge = summaries[kObservableCharge].tally;
+    G4double sumWeight2 = fSumWeight2.GetValue();
+    report << "Event weights:\n";
+    if (global->IsBiasingEnabled()) {
+      report << "  Cross-section biasing: gamma x" << global->GetGammaBiasFactor()
+             << ", neutron x" << global->GetNeutronBiasFactor() << "\n";
+    } else {
+      report << "  Cross-section biasing: off\n";
+    }
+    report << "  Sum of event weights: " << fSumWeight.GetValue() << "\n";
+    report << "  Effective number of events: "
+           << (sumWeight2 > 0. ? fSumWeight.GetValue() * fSumWeight.GetValue() / sumWeight2 : 0.) << "\n";
+    report << "  Mean energy deposit per event: " << edep.GetMean()
+           << " +/- " << edep.GetStandardError() << " " << LCRunStatistics::ObservableUnitName(kObservableEdep) << "\n";
+    report << "  Mean charge per event: " << charge.GetMean()
+           << " +/- " << charge.GetStandardError() << " " << LCRunStatistics::ObservableUnitName(kObservableCharge) << "\n";
+    report << "-------------------------------------------------\n";
+    
+    // Adaptive run length: why the run stopped and the precision reached
+    LCRunTermination* termination = LCRunTermination::Instance();
+    if (termination->IsArmed()) {
+      const char* reasons[] = { "event limit", "precision target reached", "time budget used" };
+      report << "Run termination (beamOnAdaptive): " << reasons[termination->GetReason()]
+             << " after " << nofEvents << " events, " << termination->GetElapsedSeconds() << " s\n";
+      if (termination->GetTargetPrecision() > 0.) {
+        report << "  Target relative standard error: " << termination->GetTargetPrecision() << "\n";
+      }
+      if (termination->GetTimeBudget() > 0.) {
+        report << "  Time budget: " << termination->GetTimeBudget() << " s\n";
+      }
+      report << "  Relative standard error of the mean (* = targeted):\n";
+      for (G4int observable = 0; observable < kNumberOfRunObservables; observable++) {
+        report << "    " << LCRunStatistics::ObservableName(observable)
+               << (termination->IsSelected(observable) ? "*" : "") << ": "
+               << termination->GetStat(observable).GetRelativeError() << "\n";
+      }
+      report << "-------------------------------------------------\n";
+    }
+    
+    // Step limit and delta-electron condensation in the LC cell
+    LCCondensation* condensation = LCCondensation::Instance();
+    if (condensation->IsActive() || global->GetCellMaxStep() > 0.) {
+      report << "LC cell stepping" << (mpi->IsActive() ? " (rank 0)" : "") << ":\n";
+      report << "  Step limit: ";
+      if (global->GetCellMaxStep() > 0.) report << global->GetCellMaxStep()/um << " um\n";
+      else report << "none\n";
+      if (condensation->IsActive()) {
+        LCCondensationTotals totals = LCCondensation::GetRunTotals();
+        report << "  Delta electrons deposited in place below " << condensation->GetThreshold()/keV << " keV: "
+               << totals.condensed << " (" << totals.condensedEnergy/keV << " keV)\n";
+        report << "  Steps taken in the LC cell: " << totals.cellSteps << "\n";
+        if (totals.sampled > 0) {
+          // Tracked 1-in-N sample of the same electrons
+          G4double stepsPerTrack = static_cast<G4double>(totals.sampledSteps) / totals.sampled;
+          G4double stepsSaved = stepsPerTrack * totals.condensed;
+          report << "  Reference sample (1 in " << LCCondensation::kSampleEvery << " tracked): "
+                 << totals.sampled << " electrons, " << stepsPerTrack << " steps each\n";
+          report << "  Estimated steps saved: " << stepsSaved;
+          if (totals.cellSteps + stepsSaved > 0.) {
+            report << " (" << 100. * stepsSaved / (totals.cellSteps + stepsSaved) << "% of the steps without condensation)";
+          }
+          report << "\n";
+        }
+      }
+      report << "-------------------------------------------------\n";
+    }
+    
+    // Per-thread high-water marks of the simulation's own buffers
+    const G4double megabyte = 1024. * 1024.;
+    LCMemoryTracker* memoryTracker = LCMemoryTracker::Instance();
+    report << "Memory (per-thread buffer high-water marks, MB" << (mpi->IsActive() ? ", rank 0" : "") << "):\n";
+    if (global->GetMemoryBudget() > 0) {
+      report << "  Budget: " << global->GetMemoryBudget() / megabyte << " MB"
+             << " (profile capacity " << memoryTracker->GetProfileCapacity() << " samples,"
+             << " pulse capacity " << memoryTracker->GetPulseCapacity() << ")\n";
+      // AvgCurrent of these events is the mean of the samples that were kept
+      report << "  Electrometer profile coarsened in " << fSumCoarsenedEvents.GetValue() << " of "
+             << nofEvents << " events" << (fSumCoarsenedEvents.GetValue() > 0. ? " (AvgCurrent affected)" : "") << "\n";
+    } else {
+      report << "  Budget: none\n";
+    }
+    report << "  thread  events";
+    for (G4int pool = 0; pool < kNumberOfMemoryPools; pool++) {
+      report << "  " << LCMemoryTracker::PoolName(static_cast<LCMemoryPool>(pool));
+    }
+#ifdef LC_COUNT_ALLOCATIONS
+    report << "  ReadoutAllocations(events)";
+#endif
+    report << "\n";
+    for (const auto& threadReport : LCMemoryTracker::CollectReports()) {
+      report << "  " << threadReport.threadID << "  " << threadReport.events;
+      for (G4int pool = 0; pool < kNumberOfMemoryPools; pool++) {
+        report << "  " << threadReport.highWater[pool] / megabyte;
+      }
+#ifdef LC_COUNT_ALLOCATIONS
+      report << "  " << threadReport.readoutAllocations << "(" << threadReport.eventsWithAllocations << ")";
+#endif
+      report << "\n";
+    }
+    report << "  Process RSS: " << LCMemoryTracker::GetCurrentRSS() / megabyte << " MB"
+           << " (peak " << LCMemoryTracker::GetPeakRSS() / megabyte << " MB)\n";
+    report << "-------------------------------------------------\n";
+    
+    if (fidelity == "full") {
+      report << "Notes: This simulation includes explicit modeling of\n";
+      report << "electrometer connected to both sides of the 5CB cell.\n";
+    } else {
+      report << "Notes: Wires and electrometer box not modeled (" << fidelity << " fidelity).\n";
+    }
+    report << "=================================================\n";
+    report.close();
+    
+    // Print analysis summary
+    G4cout << "Analysis results saved to file: " << fCurrentFileName << ".root" << G4endl;
+    G4cout << "Electrometer report saved to: " << reportFile << G4endl;
+  }
+
+}
+
+void LCRunAction::WriteSummary(G4int runID, const LCObservableSummary summaries[])
+{
+  const LCRunningStat& events = summaries[kObservableEdep].moments;
+  G4String summaryFile = fCurrentFileName + "_summary.json";
+  std::ofstream out(summaryFile);
+  if (!out.is_open()) {
+    G4cerr << "Warning: Could not open run summary file: " << summaryFile << G4endl;
+    return;
+  }
+  DeclareOutputFile(summaryFile);
+  
+  LCGlobalManager* global = LCGlobalManager::Instance();
+  auto detConstruction = dynamic_cast<const LCDetectorConstruction*>(
+    G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  
+  out << std::setprecision(10);
+  out << "{\n";
+  out << "  \"format\": \"LCDetector run summary\",\n";
+  out << "  \"version\": 1,\n";
+  out << "  \"run_id\": " << runID << ",\n";
+  out << "  \"config_epoch\": " << fConfig->epoch << ",\n";
+  out << "  \"particle\": " << JsonString(global->IsCocktailEnabled() ? G4String("cocktail") : fParticleName) << ",\n";
+  out << "  \"energy_MeV\": " << fParticleEnergy/MeV << ",\n";
+  if (detConstruction) {
+    out << "  \"bias_V\": " << detConstruction->GetBias()/volt << ",\n";
+  }
+  out << "  \"physics\": " << JsonString(LCPhysicsList::GetConfigurationTag()) << ",\n";
+  out << "  \"transport\": " << JsonString(fConfig->transportModel) << ",\n";
+  if (detConstruction) {
+    out << "  \"fidelity\": " << JsonString(detConstruction->GetGeometryFidelity()) << ",\n";
+    out << "  \"cell_mm\": [" << detConstruction->GetLCWidth()/mm << ", " << detConstruction->GetLCLength()/mm
+        << ", " << detConstruction->GetLCThickness()/mm << "],\n";
+    out << "  \"electrode_mm\": " << detConstruction->GetElectrodeThickness()/mm << ",\n";
+  }
+  out << "  \"seed\": " << global->GetRandomSeed() << ",\n";
+  out << "  \"seed_fixed\": " << (global->IsRandomSeedFixed() ? "true" : "false") << ",\n";
+  LCMPIManager* mpi = LCMPIManager::Instance();
+  if (mpi->IsActive()) {
+    out << "  \"mpi_ranks\": " << mpi->GetSize() << ",\n";
+  }
+  out << "  \"events\": " << events.GetCount() << ",\n";
+  out << "  \"sum_weights\": " << events.GetSumOfWeights() << ",\n";
+  out << "  \"effective_events\": " << events.GetEffectiveCount() << ",\n";
+  out << "  \"wall_time_s\": " << fRunWallTime << ",\n";
+  out << "  \"events_per_second\": ";
+  WriteJsonNumber(out, fRunWallTime > 0. ? events.GetCount() / fRunWallTime : std::nan(""));
+  out << ",\n";
+  if (fConfig->timelineRate > 0.) {
+    LCTimeline* timeline = LCTimeline::Instance();
+    out << "  \"timeline\": {\"rate_hz\": " << timeline->GetRate()/hertz
+        << ", \"duration_s\": " << timeline->GetDuration()/s
+        << ", \"mean_current_pA\": " << timeline->GetMeanCurrent()/(1.0e-12*ampere)
+        << ", \"peak_current_pA\": " << timeline->GetPeakCurrent()/(1.0e-12*ampere)
+        << ", \"late_drifts\": " << timeline->GetLateDrifts() << "},\n";
+  }
+  out << "  \"quantile_relative_accuracy\": "
+      << summaries[kObservableEdep].quantiles.GetRelativeAccuracy() << ",\n";
+  out << "  \"observables\": {\n";
+  for (G4int observable = 0; observable < kNumberOfRunObservables; observable++) {
+    const LCObservableSummary& summary = summaries[observable];
+    const LCRunningStat& moments = summary.moments;
+    out << "    " << JsonString(LCRunStatistics::ObservableName(observable)) << ": {\n";
+    out << "      \"unit\": " << JsonString(LCRunStatistics::ObservableUnitName(observable)) << ",\n";
+    out << "      \"mean\": ";
+    WriteJsonNumber(out, summary.tally.GetMean());
+    out << ",\n      \"std\": ";
+    WriteJsonNumber(out, moments.GetStandardDeviation());
+    out << ",\n      \"stderr\": ";
+    WriteJsonNumber(out, summary.tally.GetStandardError());
+    out << ",\n      \"min\": ";
+    WriteJsonNumber(out, summary.min);
+    out << ",\n      \"max\": ";
+    WriteJsonNumber(out, summary.max);
+    out << ",\n      \"quantiles\": {";
+    for (std::size_t i = 0; i < sizeof(kSummaryQuantiles) / sizeof(kSummaryQuantiles[0]); i++) {
+      // Clamped to the exact range, which the sketch only knows to its accuracy
+      G4double value = std::min(summary.max, std::max(summary.min, summary.quantiles.Quantile(kSummaryQuantiles[i])));
+      out << (i > 0 ? ", " : "") << "\"" << kSummaryQuantileNames[i] << "\": ";
+      WriteJsonNumber(out, value);
+    }
+    out << "}\n    }" << (observable + 1 < kNumberOfRunObservables ? "," : "") << "\n";
+  }
+  out << "  }\n";
+  out << "}\n";
+  out.close();
+  
+  G4cout << "Run summary saved to: " << summaryFile << G4endl;
+}
+
+void LCRunAction::RecordCampaignRun(G4int runID, const LCObservableSummary summaries[])
+{
+  LCGlobalManager* global = LCGlobalManager::Instance();
+  if (!global->IsCampaignStoreEnabled()) return;
+  
+  auto detConstruction = dynamic_cast<const LCDetectorConstruction*>(
+    G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  const LCRunningStat& events = summaries[kObservableEdep].moments;
+  
+  // Finishing time, UTC
+  std::time_t now = std::time(nullptr);
+  std::tm utc;
+  gmtime_r(&now, &utc);
+  char timestamp[32];
+  std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
+  
+  LCCampaignRecord record;
+  record.Set("time", std::string(timestamp));
+  record.Set("run", static_cast<long>(runID));
+  record.Set("config_epoch", static_cast<long>(fConfig->epoch));
+  record.Set("particle", global->IsCocktailEnabled() ? std::string("cocktail") : std::string(fParticleName));
+  record.Set("energy_MeV", fParticleEnergy/MeV);
+  record.Set("bias_V", detConstruction ? detConstruction->GetBias()/volt : std::nan(""));
+  record.Set("physics", std::string(LCPhysicsList::GetConfigurationTag()));
+  record.Set("transport", std::string(fConfig->transportModel));
+  record.Set("fidelity", detConstruction ? std::string(detConstruction->GetGeometryFidelity()) : std::string("full"));
+  record.Set("thickness_um", detConstruction ? detConstruction->GetLCThickness()/um : std::nan(""));
+  record.Set("seed", global->GetRandomSeed());
+  record.Set("seed_fixed", std::string(global->IsRandomSeedFixed() ? "true" : "false"));
+  LCMPIManager* mpi = LCMPIManager::Instance();
+  if (mpi->IsActive()) {
+    record.Set("mpi_ranks", static_cast<long>(mpi->GetSize()));
+  }
+  record.Set("events", static_cast<long>(events.GetCount()));
+  record.Set("sum_weights", events.GetSumOfWeights());
+  record.Set("events_per_second", fRunWallTime > 0. ? events.GetCount() / fRunWallTime : std::nan(""));
+  if (fConfig->memoryBudget > 0) {
+    // Per worker thread, as in the result cache key
+    std::size_t profileCapacity = LCMemoryTracker::ProfileCapacityForBudget(
+      fConfig->memoryBudget, G4RunManager::GetRunManager()->GetNumberOfThreads());
+    record.Set("profile_capacity", static_cast<long>(profileCapacity));
+    record.Set("coarsened_events", static_cast<long>(fSumCoarsenedEvents.GetValue()));
+  }
+  for (G4int observable = 0; observable < kNumberOfRunObservables; observable++) {
+    std::string name = LCRunStatistics::ObservableName(observable);
+    const LCRunningStat& moments = summaries[observable].moments;
+    record.Set(name + "_mean", summaries[observable].tally.GetMean());
+    record.Set(name + "_std", moments.GetStandardDeviation());
+    record.Set(name + "_stderr", summaries[observable].tally.GetStandardError());
+    record.Set(name + "_p50", summaries[observable].quantiles.Quantile(0.5));
+    record.Set(name + "_min", summaries[observable].min);
+    record.Set(name + "_max", summaries[observable].max);
+  }
+  record.Set("output", std::filesystem::absolute(std::string(fCurrentFileName)).string());
+  
+  std::string error;
+  LCCampaignStore store(global->GetCampaignStore());
+  if (store.Append(record, &error)) {
+    G4cout << "Run recorded in campaign store: " << store.GetLogPath() << G4endl;
+  } else {
+    G4cerr << "Warning: Could not record the run in the campaign store (" << error << ")" << G4endl;
+  }
+}
+
+G4int LCRunAction::ReduceRanks(G4int nofEvents, LCObservableSummary summaries[])
+{
+  std::vector<G4double> sums = {
+    static_cast<G4double>(nofEvents),
+    fSumWeight.GetValue(), fSumWeight2.GetValue(), fSumPrimaries.GetValue(),
+    fSumEmptyEvents.GetValue(), fSumCoarsenedEvents.GetValue()
+  };
+  LCHistograms* histograms = LCHistograms::Instance();
+  histograms->AppendProcessTotal(sums);
+  std::size_t summaryStart = sums.size();
+  
+  LCMPIManager* mpi = LCMPIManager::Instance();
+  for (G4int observable = 0; observable < kNumberOfRunObservables; observable++) {
+    summaries[observable].AppendForReduction(sums, mpi->GetRank(), mpi->GetSize());
+  }
+  mpi->ReduceSum(sums);
+  if (!mpi->IsRoot()) return nofEvents;
+  
+  // Rank 0 continues with the totals of the whole run
+  fSumWeight = sums[1];
+  fSumWeight2 = sums[2];
+  fSumPrimaries = sums[3];
+  fSumEmptyEvents = sums[4];
+  fSumCoarsenedEvents = sums[5];
+  histograms->SetContents(sums.data() + kNumberOfRunSums);
+  std::size_t summarySize = LCObservableSummary::GetReductionSize(mpi->GetSize());
+  for (G4int observable = 0; observable < kNumberOfRunObservables; observable++) {
+    summaries[observable].SetFromReduction(sums.data() + summaryStart + observable * summarySize, mpi->GetSize());
+  }
+  return static_cast<G4int>(sums[0]);
+}
+
+void LCRunAction::ReduceEmptyRun()
+{
+  // Same layout as ReduceRanks, all zero (never rank 0, which always has events)
+  std::vector<G4double> sums(kNumberOfRunSums, 0.);
+  LCHistograms::Instance()->AppendProcessTotal(sums);
+  LCMPIManager* mpi = LCMPIManager::Instance();
+  LCObservableSummary empty;
+  for (G4int observable = 0; observable < kNumberOfRunObservables; observable++) {
+    empty.AppendForReduction(sums, mpi->GetRank(), mpi->GetSize());
+  }
+  mpi->ReduceSum(sums);
+}
+
+void LCRunAction::DeclareOutputFile(const G4String& fileName)
+{
+  G4AutoLock lock(&outputFilesMutex);
+  if (std::find(outputFiles.begin(), outputFiles.end(), fileName) == outputFiles.end()) {
+    outputFiles.push_back(fileName);
+  }
+}
+
+std::vector<G4String> LCRunAction::GetOutputFiles()
+{
+  G4AutoLock lock(&outputFilesMutex);
+  return outputFiles;
+}
+
+void LCRunAction::AddEventTally(G4double weight, G4int nPrimaries, G4bool profileCoarsened)
+{
+  fSumPrimaries += nPrimaries;
+  if (nPrimaries == 0) fSumEmptyEvents += 1.;
+  if (profileCoarsened) fSumCoarsenedEvents += 1.;
+  fSumWeight += weight;
+  fSumWeight2 += weight * weight;
+}
+
 // Add special handling for SetParticleEnergy
 void LCRunAction::SetParticleEnergy(G4double energy)
 {
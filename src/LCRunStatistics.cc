@@ -0,0 +1,139 @@
+// LCRunStatistics.cc - Streaming per-run statistics of the per-event observables, merged over threads
+#include "LCRunStatistics.hh"
+#include "G4AutoLock.hh"
+#include "G4SystemOfUnits.hh"
+#include <algorithm>
+#include <vector>
+
+namespace {
+  G4Mutex summaryMutex = G4MUTEX_INITIALIZER;
+  std::vector<LCObservableSummary> publishedSummaries;   // kNumberOfRunObservables per thread
+  
+  const char* observableNames[kNumberOfRunObservables] = { "Edep", "Charge", "AvgCurrent", "PeakCurrent" };
+  const char* unitNames[kNumberOfRunObservables] = { "keV", "pC", "pA", "pA" };
+  const G4double units[kNumberOfRunObservables] = {
+    keV, 1.0e-12 * coulomb, 1.0e-12 * ampere, 1.0e-12 * ampere
+  };
+  
+  // Per MPI rank in a reduction: the two LCRunningStat states, min and max
+  const std::size_t kRangeOffset = 2*LCRunningStat::kStateSize;
+  const std::size_t kRankSlotSize = kRangeOffset + 2;
+}
+
+void LCObservableSummary::Add(G4double x, G4double weight) {
+  if (moments.GetCount() == 0) {
+    min = max = x;
+  } else {
+    min = std::min(min, x);
+    max = std::max(max, x);
+  }
+  moments.Add(x, weight);
+  tally.Add(weight * x);
+  quantiles.Add(x, weight);
+}
+
+void LCObservableSummary::Merge(const LCObservableSummary& other) {
+  if (other.moments.GetCount() == 0) return;
+  if (moments.GetCount() == 0) {
+    min = other.min;
+    max = other.max;
+  } else {
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+  }
+  moments.Merge(other.moments);
+  tally.Merge(other.tally);
+  quantiles.Merge(other.quantiles);
+}
+
+std::size_t LCObservableSummary::GetReductionSize(G4int nRanks) {
+  return nRanks * kRankSlotSize + LCQuantileSketch::GetDenseSize();
+}
+
+void LCObservableSummary::AppendForReduction(std::vector<G4double>& values, G4int rank, G4int nRanks) const {
+  std::size_t start = values.size();
+  values.resize(start + nRanks * kRankSlotSize, 0.);
+  G4double* slot = values.data() + start + rank * kRankSlotSize;
+  moments.GetState(slot);
+  tally.GetState(slot + LCRunningStat::kStateSize);
+  slot[kRangeOffset] = min;
+  slot[kRangeOffset + 1] = max;
+  quantiles.AppendDense(values);
+}
+
+void LCObservableSummary::SetFromReduction(const G4double* values, G4int nRanks) {
+  Reset();
+  for (G4int rank = 0; rank < nRanks; rank++) {
+    const G4double* slot = values + rank * kRankSlotSize;
+    LCObservableSummary part;
+    part.moments.SetState(slot);
+    part.tally.SetState(slot + LCRunningStat::kStateSize);
+    part.min = slot[kRangeOffset];
+    part.max = slot[kRangeOffset + 1];
+    Merge(part);
+  }
+  quantiles.SetFromDense(values + nRanks * kRankSlotSize);
+}
+
+void LCObservableSummary::Reset() {
+  moments.Reset();
+  tally.Reset();
+  min = max = 0.;
+  quantiles.Reset();
+}
+
+G4ThreadLocal LCRunStatistics* LCRunStatistics::fInstance = nullptr;
+
+LCRunStatistics* LCRunStatistics::Instance() {
+  if (!fInstance) {
+    fInstance = new LCRunStatistics();
+  }
+  return fInstance;
+}
+
+G4int LCRunStatistics::ObservableFromName(const G4String& name) {
+  for (G4int i = 0; i < kNumberOfRunObservables; i++) {
+    if (name == observableNames[i]) return i;
+  }
+  return -1;
+}
+
+const char* LCRunStatistics::ObservableName(G4int observable) {
+  return observableNames[observable];
+}
+
+G4double LCRunStatistics::ObservableUnit(G4int observable) {
+  return units[observable];
+}
+
+const char* LCRunStatistics::ObservableUnitName(G4int observable) {
+  return unitNames[observable];
+}
+
+void LCRunStatistics::BeginRun() {
+  for (auto& summary : fSummaries) summary.Reset();
+}
+
+void LCRunStatistics::AddEvent(const G4double values[kNumberOfRunObservables], G4double weight) {
+  // Kept in output units, so the sketch buckets line up with what is written
+  for (G4int i = 0; i < kNumberOfRunObservables; i++) {
+    fSummaries[i].Add(values[i] / units[i], weight);
+  }
+}
+
+void LCRunStatistics::EndRun() {
+  if (fSummaries[0].moments.GetCount() == 0) return;
+  
+  G4AutoLock lock(&summaryMutex);
+  publishedSummaries.insert(publishedSummaries.end(), fSummaries, fSummaries + kNumberOfRunObservables);
+}
+
+void LCRunStatistics::CollectMerged(LCObservableSummary merged[kNumberOfRunObservables]) {
+  for (G4int i = 0; i < kNumberOfRunObservables; i++) merged[i].Reset();
+  
+  G4AutoLock lock(&summaryMutex);
+  for (std::size_t i = 0; i < publishedSummaries.size(); i++) {
+    merged[i % kNumberOfRunObservables].Merge(publishedSummaries[i]);
+  }
+  publishedSummaries.clear();
+}
@@ -0,0 +1,134 @@
+// LCRunTermination.cc - Adaptive run length: stop on a target statistical precision or a time budget
+#include "LCRunTermination.hh"
+#include "LCGlobalManager.hh"
+#include "G4SystemOfUnits.hh"
+#include <algorithm>
+#include <sstream>
+
+namespace {
+  // Events or seconds between two merges of a thread's statistics
+  const G4int kFlushEvents = 64;
+  const G4double kFlushSeconds = 1.0;
+  
+  // Statistics of a thread since its last merge
+  struct ThreadState {
+    LCRunningStat pending[kNumberOfRunObservables];
+    G4int events = 0;
+    std::chrono::steady_clock::time_point lastFlush;
+  };
+  G4ThreadLocal ThreadState* threadState = nullptr;
+}
+
+LCRunTermination* LCRunTermination::fInstance = nullptr;
+
+LCRunTermination* LCRunTermination::Instance() {
+  if (!fInstance) {
+    fInstance = new LCRunTermination();
+  }
+  return fInstance;
+}
+
+LCRunTermination::LCRunTermination()
+: fArmed(false),
+  fTargetPrecision(0.),
+  fTimeBudget(0.),
+  fMinEvents(0),
+  fStop(false),
+  fReason(kEventLimit)
+{
+  for (G4int i = 0; i < kNumberOfRunObservables; i++) fSelected[i] = false;
+}
+
+void LCRunTermination::BeginRun() {
+  if (!fArmed) return;
+  
+  LCGlobalManager* global = LCGlobalManager::Instance();
+  fTargetPrecision = global->GetTargetPrecision();
+  fTimeBudget = global->GetTimeBudget() / s;
+  fMinEvents = global->GetMinAdaptiveEvents();
+  for (G4int i = 0; i < kNumberOfRunObservables; i++) fSelected[i] = false;
+  std::istringstream names(global->GetTargetObservables());
+  G4String name;
+  while (names >> name) {
+    G4int observable = LCRunStatistics::ObservableFromName(name);
+    if (observable >= 0) fSelected[observable] = true;
+  }
+  
+  for (auto& stat : fStats) stat.Reset();
+  fStop = false;
+  fReason = kEventLimit;
+  fStart = std::chrono::steady_clock::now();
+  fEnd = fStart;
+}
+
+G4bool LCRunTermination::AddEvent(const G4double values[kNumberOfRunObservables], G4double weight) {
+  if (!fArmed) return false;
+  
+  auto now = std::chrono::steady_clock::now();
+  if (!threadState) {
+    threadState = new ThreadState();
+    threadState->lastFlush = now;
+  }
+  
+  // Mean of w x (sum of w x over the event count), as in the report and run summary
+  for (G4int i = 0; i < kNumberOfRunObservables; i++) {
+    threadState->pending[i].Add(weight * values[i]);
+  }
+  threadState->events++;
+  
+  if (fTimeBudget > 0. && std::chrono::duration<G4double>(now - fStart).count() >= fTimeBudget) {
+    G4int expected = kEventLimit;
+    fReason.compare_exchange_strong(expected, kTimeBudgetUsed);
+    fStop = true;
+  }
+  
+  if (threadState->events >= kFlushEvents ||
+      std::chrono::duration<G4double>(now - threadState->lastFlush).count() >= kFlushSeconds) {
+    std::lock_guard<std::mutex> lock(fMutex);
+    Flush(threadState->pending);
+    CheckPrecision();
+    threadState->events = 0;
+    threadState->lastFlush = now;
+  }
+  
+  return fStop;
+}
+
+void LCRunTermination::EndRun() {
+  if (!fArmed) return;
+  
+  std::lock_guard<std::mutex> lock(fMutex);
+  if (threadState) {
+    Flush(threadState->pending);
+    threadState->events = 0;
+  }
+  fEnd = std::max(fEnd, std::chrono::steady_clock::now());
+}
+
+G4double LCRunTermination::GetElapsedSeconds() const {
+  return std::chrono::duration<G4double>(fEnd - fStart).count();
+}
+
+void LCRunTermination::Flush(LCRunningStat* pending) {
+  for (G4int i = 0; i < kNumberOfRunObservables; i++) {
+    fStats[i].Merge(pending[i]);
+    pending[i].Reset();
+  }
+}
+
+void LCRunTermination::CheckPrecision() {
+  if (fTargetPrecision <= 0. || fStop) return;
+  if (fStats[0].GetCount() < fMinEvents) return;
+  
+  G4bool anySelected = false;
+  for (G4int i = 0; i < kNumberOfRunObservables; i++) {
+    if (!fSelected[i]) continue;
+    anySelected = true;
+    if (fStats[i].GetRelativeError() > fTargetPrecision) return;
+  }
+  if (!anySelected) return;
+  
+  G4int expected = kEventLimit;
+  fReason.compare_exchange_strong(expected, kPrecisionReached);
+  fStop = true;
+}
@@ -0,0 +1,32 @@
+// LCStackingAction.cc - Deposits low-energy delta electrons in the LC cell in place (see LCCondensation)
+#include "LCStackingAction.hh"
+#include "LCSteppingAction.hh"
+#include "LCCondensation.hh"
+#include "G4Track.hh"
+
+LCStackingAction::LCStackingAction(LCSteppingAction* steppingAction)
+: G4UserStackingAction(),
+  fSteppingAction(steppingAction),
+  fCondensation(LCCondensation::Instance())
+{}
+
+LCStackingAction::~LCStackingAction()
+{}
+
+G4ClassificationOfNewTrack LCStackingAction::ClassifyNewTrack(const G4Track* track)
+{
+  if (!fCondensation->IsActive() || !fCondensation->Condense(track)) return fUrgent;
+  
+  // The whole kinetic energy, as one deposit where the electron was created,
+  // over its range so that columnar recombination sees its pair density
+  G4double time = track->GetGlobalTime();
+  G4double energy = track->GetKineticEnergy();
+  fSteppingAction->DepositInCell(energy, track->GetPosition(), time, track->GetWeight(),
+                                 track->GetDefinition(), fCondensation->GetEffectiveLength(energy));
+  return fKill;
+}
+
+void LCStackingAction::PrepareNewEvent()
+{
+  fCondensation->BeginEvent();
+}
@@ -0,0 +1,259 @@
+// LCStepRecorder.cc - Binary record of LC cell energy deposits for offline readout replay
+#include "LCStepRecorder.hh"
+#include "LCConfiguration.hh"
+#include "LCMemoryTracker.hh"
+#include "LCRunAction.hh"
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4Threading.hh"
+#include "G4UIcommand.hh"
+#include "G4SystemOfUnits.hh"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+  const char kMagic[8] = {'L', 'C', 'S', 'T', 'E', 'P', 'S', '\0'};
+  const std::uint32_t kVersion = 2;
+  // Packed on disk: 6 floats + 1 category byte (5 floats in version 1)
+  const std::uint32_t kRecordSize = 6*sizeof(float) + sizeof(std::uint8_t);
+  const std::uint32_t kRecordSizeV1 = 5*sizeof(float) + sizeof(std::uint8_t);
+  
+  template <typename T>
+  void WriteValue(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+  
+  template <typename T>
+  G4bool ReadValue(std::ifstream& in, T& value) {
+    return static_cast<G4bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+  }
+  
+  const char* kCategoryNames[kNumberOfCategories] = {
+    "e-", "e+", "gamma", "proton", "alpha", "ion", "neutron", "other"
+  };
+}
+
+G4ThreadLocal LCStepRecorder* LCStepRecorder::fInstance = nullptr;
+
+LCStepRecorder* LCStepRecorder::Instance() {
+  if (!fInstance) {
+    fInstance = new LCStepRecorder();
+  }
+  return fInstance;
+}
+
+LCStepRecorder::LCStepRecorder()
+: fRecording(false),
+  fEventsWritten(0),
+  fCellThickness(0.),
+  fElectricField(0.),
+  fBias(0.),
+  fConfigEpoch(0)
+{
+}
+
+LCStepRecorder::~LCStepRecorder()
+{
+  EndRun();
+}
+
+void LCStepRecorder::BeginRun(const G4String& baseName) {
+  EndRun();
+  const LCConfigSnapshot* config = LCConfiguration::ForRun();
+  fRecording = config->stepRecording;
+  if (!fRecording) return;
+  
+  fBaseName = baseName;
+  fDeposits.clear();
+  fEventsWritten = 0;
+  
+  // Readout conditions published for this run
+  fCellThickness = config->cellThickness;
+  fElectricField = config->electricField;
+  fBias = config->bias;
+  fConfigEpoch = config->epoch;
+}
+
+void LCStepRecorder::OpenFile() {
+  G4int threadID = std::max(0, G4Threading::G4GetThreadId());
+  fFileName = fBaseName + "_steps_t" + G4UIcommand::ConvertToString(threadID) + ".lcs";
+  
+  fFile.open(fFileName, std::ios::binary | std::ios::trunc);
+  if (!fFile.is_open()) {
+    G4cerr << "Warning: Could not open step record file: " << fFileName << G4endl;
+    G4cerr << "Continuing without step recording..." << G4endl;
+    fRecording = false;
+    return;
+  }
+  LCRunAction::DeclareOutputFile(fFileName);
+  
+  fFile.write(kMagic, sizeof(kMagic));
+  WriteValue(fFile, kVersion);
+  WriteValue(fFile, kRecordSize);
+  WriteValue(fFile, static_cast<float>(fCellThickness/um));
+  WriteValue(fFile, static_cast<float>(fElectricField/(volt/um)));
+  WriteValue(fFile, static_cast<float>(fBias/volt));
+  WriteValue(fFile, static_cast<std::uint32_t>(fConfigEpoch));
+}
+
+void LCStepRecorder::EndRun() {
+  if (fFile.is_open()) {
+    fFile.close();
+    G4cout << "Step records for " << fEventsWritten << " events written to " << fFileName << G4endl;
+  }
+  fRecording = false;
+  fDeposits.clear();
+}
+
+void LCStepRecorder::AddDeposit(const G4ThreeVector& position, G4double time, G4double edep,
+                                G4double length, std::uint8_t category) {
+  LCStepRecord record;
+  record.x = static_cast<float>(position.x()/mm);
+  record.y = static_cast<float>(position.y()/mm);
+  record.z = static_cast<float>(position.z()/mm);
+  record.time = static_cast<float>(time/ns);
+  record.edep = static_cast<float>(edep/keV);
+  record.length = static_cast<float>(length/mm);
+  record.category = category;
+  fDeposits.push_back(record);
+}
+
+void LCStepRecorder::EndEvent(const G4Event* event) {
+  if (!fRecording) return;
+  if (!fFile.is_open()) {
+    OpenFile();
+    if (!fRecording) return;
+  }
+  
+  // Events without deposits are kept so the replay sees the same event count
+  G4double t0 = event->GetPrimaryVertex() ? event->GetPrimaryVertex()->GetT0() : 0.;
+  WriteValue(fFile, static_cast<std::uint32_t>(event->GetEventID()));
+  WriteValue(fFile, static_cast<std::uint32_t>(fDeposits.size()));
+  WriteValue(fFile, static_cast<float>(t0/ns));
+  for (const auto& record : fDeposits) {
+    WriteValue(fFile, record.x);
+    WriteValue(fFile, record.y);
+    WriteValue(fFile, record.z);
+    WriteValue(fFile, record.time);
+    WriteValue(fFile, record.edep);
+    WriteValue(fFile, record.length);
+    WriteValue(fFile, record.category);
+  }
+  
+  // Deposits cannot be dropped, but a large event's buffer is released
+  // rather than kept for the rest of the run when it exceeds the budget
+  LCMemoryTracker* memoryTracker = LCMemoryTracker::Instance();
+  std::size_t bytes = fDeposits.capacity() * sizeof(LCStepRecord);
+  memoryTracker->Track(kPoolStepRecords, bytes);
+  fDeposits.clear();
+  if (memoryTracker->GetStepRecordBudget() > 0 && bytes > memoryTracker->GetStepRecordBudget()) {
+    fDeposits.shrink_to_fit();
+  }
+  fEventsWritten++;
+}
+
+std::uint8_t LCStepRecorder::Categorize(const G4ParticleDefinition* particle) {
+  G4int pdg = particle->GetPDGEncoding();
+  switch (pdg) {
+    case 11:         return kCategoryElectron;
+    case -11:        return kCategoryPositron;
+    case 22:         return kCategoryGamma;
+    case 2212:       return kCategoryProton;
+    case 1000020040: return kCategoryAlpha;
+    case 2112:       return kCategoryNeutron;
+    default:         break;
+  }
+  if (particle->IsGeneralIon() || pdg > 1000000000) return kCategoryIon;
+  return kCategoryOther;
+}
+
+const char* LCStepRecorder::CategoryName(std::uint8_t category) {
+  return category < kNumberOfCategories ? kCategoryNames[category] : "unknown";
+}
+
+G4int LCStepRecorder::CategoryFromName(const G4String& name) {
+  for (G4int i = 0; i < kNumberOfCategories; i++) {
+    if (name == kCategoryNames[i]) return i;
+  }
+  return -1;
+}
+
+LCStepReader::LCStepReader()
+: fVersion(0),
+  fFileSize(0),
+  fCellThickness(0.),
+  fElectricField(0.),
+  fBias(0.),
+  fConfigEpoch(0)
+{
+}
+
+LCStepReader::~LCStepReader()
+{
+}
+
+G4bool LCStepReader::Open(const G4String& fileName) {
+  fFile.open(fileName, std::ios::binary);
+  if (!fFile.is_open()) {
+    G4cerr << "ERROR: Could not open step record file: " << fileName << G4endl;
+    return false;
+  }
+  fFile.seekg(0, std::ios::end);
+  fFileSize = static_cast<std::uint64_t>(fFile.tellg());
+  fFile.seekg(0, std::ios::beg);
+  
+  char magic[8];
+  std::uint32_t version = 0, recordSize = 0, epoch = 0;
+  float thickness = 0.f, field = 0.f, bias = 0.f;
+  fFile.read(magic, sizeof(magic));
+  if (!fFile || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+      !ReadValue(fFile, version) || !ReadValue(fFile, recordSize) ||
+      !((version == kVersion && recordSize == kRecordSize) ||
+        (version == 1 && recordSize == kRecordSizeV1))) {
+    G4cerr << "ERROR: " << fileName << " is not a version 1 or " << kVersion << " step record file" << G4endl;
+    fFile.close();
+    return false;
+  }
+  ReadValue(fFile, thickness);
+  ReadValue(fFile, field);
+  ReadValue(fFile, bias);
+  ReadValue(fFile, epoch);
+  
+  fVersion = version;
+  fCellThickness = thickness*um;
+  fElectricField = field*(volt/um);
+  fBias = bias*volt;
+  fConfigEpoch = epoch;
+  return static_cast<G4bool>(fFile);
+}
+
+G4bool LCStepReader::ReadEvent(LCRecordedEvent& event) {
+  std::uint32_t nDeposits = 0;
+  if (!ReadValue(fFile, event.eventID) || !ReadValue(fFile, nDeposits) ||
+      !ReadValue(fFile, event.t0)) {
+    return false;
+  }
+  
+  // A corrupt count must not size the vector beyond what the file can hold
+  std::uint64_t remaining = fFileSize - static_cast<std::uint64_t>(fFile.tellg());
+  std::uint32_t recordSize = (fVersion > 1) ? kRecordSize : kRecordSizeV1;
+  if (nDeposits > remaining / recordSize) {
+    G4cerr << "WARNING: Step record for event " << event.eventID << " claims " << nDeposits
+           << " deposits, more than the rest of the file holds" << G4endl;
+    return false;
+  }
+  
+  event.deposits.resize(nDeposits);
+  for (auto& record : event.deposits) {
+    record.length = 0.f;
+    if (!ReadValue(fFile, record.x) || !ReadValue(fFile, record.y) ||
+        !ReadValue(fFile, record.z) || !ReadValue(fFile, record.time) ||
+        !ReadValue(fFile, record.edep) || (fVersion > 1 && !ReadValue(fFile, record.length)) ||
+        !ReadValue(fFile, record.category)) {
+      G4cerr << "WARNING: Truncated step record for event " << event.eventID << G4endl;
+      return false;
+    }
+  }
+  return true;
+}
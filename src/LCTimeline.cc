@@ -0,0 +1,209 @@
+// LCTimeline.cc - Continuous-beam electrometer trace merged in time order across events and threads
+#include "LCTimeline.hh"
+#include "LCConfiguration.hh"
+#include "LCGlobalManager.hh"
+#include "LCReadoutModel.hh"
+#include "LCRunAction.hh"
+#include "G4SystemOfUnits.hh"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+  const G4double picoampere = 1.0e-12 * ampere;
+  const G4double femtoampere = 1.0e-15 * ampere;
+  
+  // Electrometer noise per sample, as in the per-event profiles
+  const G4double kNoise = 10.0*femtoampere;
+  
+  // Decay of the reading digitised after the last drift has ended
+  const G4double kDecayTimeConstants = 5.;
+}
+
+LCTimeline* LCTimeline::fInstance = nullptr;
+
+LCTimeline* LCTimeline::Instance() {
+  if (!fInstance) {
+    fInstance = new LCTimeline();
+  }
+  return fInstance;
+}
+
+LCTimeline::LCTimeline()
+: fActive(false),
+  fRate(0.),
+  fBinWidth(0.),
+  fWindow(0.),
+  fTimeConstant(0.),
+  fFilterGain(1.),
+  fNextEventID(0),
+  fLatestArrival(0.),
+  fLastStepTime(0.),
+  fNextBin(0),
+  fInputCurrent(0.),
+  fReading(0.),
+  fNoise(0., kNoise),
+  fSumReading(0.),
+  fPeakCurrent(0.),
+  fLateDrifts(0),
+  fPeakPendingSteps(0)
+{
+}
+
+void LCTimeline::BeginRun(const G4String& baseName, G4int runID) {
+  std::lock_guard<std::mutex> lock(fMutex);
+  const LCConfigSnapshot* config = LCConfiguration::ForRun();
+  fActive = config->timelineRate > 0.;
+  fRate = config->timelineRate;
+  if (!fActive) return;
+  
+  fBinWidth = config->timelineBinWidth;
+  fWindow = config->timelineWindow;
+  fTimeConstant = 0.;
+  fFilterGain = 1.;
+  fNextEventID = 0;
+  fEventsAhead.clear();
+  fLatestArrival = 0.;
+  fLastStepTime = 0.;
+  fSteps = decltype(fSteps)();
+  fNextBin = 0;
+  fInputCurrent = 0.;
+  fReading = 0.;
+  fSumReading = 0.;
+  fPeakCurrent = 0.;
+  fLateDrifts = 0;
+  fPeakPendingSteps = 0;
+  
+  // Noise drawn in bin order from its own engine, so the trace does not
+  // depend on which thread digitises which bins
+  std::seed_seq seed{ static_cast<long>(LCGlobalManager::Instance()->GetRandomSeed()), static_cast<long>(runID) };
+  fNoiseEngine.seed(seed);
+  fNoise.reset();
+  
+  LCWaveformHeader header;
+  header.timeStep = fBinWidth/ns;
+  header.currentStep = config->waveformCurrentStep/picoampere;
+  header.configEpoch = static_cast<std::uint32_t>(config->epoch);
+  header.threadID = 0;
+  fFileName = baseName + "_timeline.lcw";
+  std::string error;
+  if (!fWriter.Open(fFileName, header, &error)) {
+    G4cerr << "Warning: Could not open timeline file: " << error << G4endl;
+    G4cerr << "Continuing without the continuous-beam timeline..." << G4endl;
+    fActive = false;
+    return;
+  }
+  LCRunAction::DeclareOutputFile(fFileName);
+  fWriter.BeginEvent(0);
+}
+
+void LCTimeline::AddEvent(G4int eventID, G4double slotFraction, const LCReadoutModel& model) {
+  std::lock_guard<std::mutex> lock(fMutex);
+  if (!fActive) return;
+  
+  // All threads run the same electrometer model
+  if (fTimeConstant <= 0.) {
+    fTimeConstant = model.GetElectrometerTimeConstant();
+    fFilterGain = -std::expm1(-fBinWidth / fTimeConstant);
+  }
+  
+  G4double arrival = (eventID + slotFraction) / fRate;
+  G4double digitised = fNextBin * fBinWidth;
+  for (const auto& drift : model.GetChargeDrifts()) {
+    if (drift.duration <= 0.) continue;
+    G4double start = arrival + drift.start;
+    G4double current = drift.charge / drift.duration;
+    if (start < digitised) fLateDrifts++;
+    fSteps.push({start, current});
+    fSteps.push({start + drift.duration, -current});
+    fLastStepTime = std::max(fLastStepTime, start + drift.duration);
+  }
+  fPeakPendingSteps = std::max(fPeakPendingSteps, fSteps.size());
+  fLatestArrival = std::max(fLatestArrival, arrival);
+  
+  // Move the frontier past every event handed over without a gap
+  if (eventID >= fNextEventID) fEventsAhead.insert(eventID);
+  
+  // Events more than the reorder window behind the newest are not waited for
+  G4double windowStart = std::floor((fLatestArrival - fWindow) * fRate);
+  if (windowStart > fNextEventID) {
+    fNextEventID = static_cast<G4int>(windowStart);
+    fEventsAhead.erase(fEventsAhead.begin(), fEventsAhead.lower_bound(fNextEventID));
+  }
+  while (!fEventsAhead.empty() && *fEventsAhead.begin() == fNextEventID) {
+    fEventsAhead.erase(fEventsAhead.begin());
+    fNextEventID++;
+  }
+  
+  // No charge of events from the frontier on comes before its slot
+  Advance(fNextEventID / fRate);
+}
+
+void LCTimeline::EndRun() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  if (!fActive) return;
+  
+  // Everything is handed over: the rest of the last beam slot, the drifts
+  // still running and the decay of the reading
+  G4double end = std::max(fLastStepTime, (std::floor(fLatestArrival * fRate) + 1.) / fRate);
+  if (fTimeConstant > 0.) end += kDecayTimeConstants * fTimeConstant;
+  Advance(end + fBinWidth);
+  
+  if (fNextBin % kSegmentBins != 0) fWriter.EndEvent();
+  std::uint64_t rawBytes = fWriter.GetRawBytes();
+  if (!fWriter.Close()) {
+    G4cerr << "Warning: Error while writing timeline file " << fFileName << G4endl;
+  }
+  G4cout << "Continuous-beam timeline: " << fNextBin << " samples (" << GetDuration()/s << " s) written to "
+         << fFileName << " (" << fWriter.GetFileBytes() << " bytes, " << rawBytes << " before compression)" << G4endl;
+  if (fLateDrifts > 0) {
+    G4cout << "Warning: " << fLateDrifts << " charge drifts arrived after the reorder window"
+           << " and were added at the time they were merged" << G4endl;
+  }
+  
+  // Steps and out-of-order events are not needed until the next run
+  fSteps = decltype(fSteps)();
+  fEventsAhead.clear();
+  fActive = false;
+}
+
+G4double LCTimeline::GetMeanCurrent() const {
+  return fNextBin > 0 ? fSumReading / fNextBin : 0.;
+}
+
+void LCTimeline::Advance(G4double time) {
+  while ((fNextBin + 1) * fBinWidth <= time) {
+    G4double binStart = fNextBin * fBinWidth;
+    G4double binEnd = binStart + fBinWidth;
+    
+    // Charge of the piecewise constant drift current in this bin; late
+    // steps take effect at the start of the bin
+    G4double charge = 0.;
+    G4double t = binStart;
+    while (!fSteps.empty() && fSteps.top().time < binEnd) {
+      G4double stepTime = std::max(t, fSteps.top().time);
+      charge += fInputCurrent * (stepTime - t);
+      t = stepTime;
+      fInputCurrent += fSteps.top().current;
+      fSteps.pop();
+    }
+    if (fSteps.empty()) fInputCurrent = 0.;   // no rounding residue once all drifts ended
+    charge += fInputCurrent * (binEnd - t);
+    
+    // First-order RC response of the electrometer
+    fReading += fFilterGain * (charge / fBinWidth - fReading);
+    WriteBin(fReading + fNoise(fNoiseEngine));
+    fNextBin++;
+  }
+}
+
+void LCTimeline::WriteBin(G4double current) {
+  fWriter.AddSample(fNextBin * fBinWidth / ns, current / picoampere);
+  fSumReading += current;
+  fPeakCurrent = std::max(fPeakCurrent, current);
+  
+  // Segments end after every kSegmentBins samples
+  if ((fNextBin + 1) % kSegmentBins == 0) {
+    fWriter.EndEvent();
+    fWriter.BeginEvent(static_cast<std::uint32_t>((fNextBin + 1) / kSegmentBins));
+  }
+}
@@ -0,0 +1,27 @@
+// LCTrackingAction.cc - Collects the weight changes of every track into the event weight (biasing)
+#include "LCTrackingAction.hh"
+#include "LCEventAction.hh"
+#include "G4Track.hh"
+
+LCTrackingAction::LCTrackingAction(LCEventAction* eventAction)
+: G4UserTrackingAction(),
+  fEventAction(eventAction),
+  fStartWeight(1.0)
+{}
+
+LCTrackingAction::~LCTrackingAction()
+{}
+
+void LCTrackingAction::PreUserTrackingAction(const G4Track* track)
+{
+  fStartWeight = track->GetWeight();
+}
+
+void LCTrackingAction::PostUserTrackingAction(const G4Track* track)
+{
+  // Unchanged for all tracks of an analog run
+  G4double weight = track->GetWeight();
+  if (weight != fStartWeight && fStartWeight > 0.) {
+    fEventAction->MultiplyHistoryWeight(weight / fStartWeight);
+  }
+}
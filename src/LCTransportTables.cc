@@ -0,0 +1,175 @@
+// LCTransportTables.cc - Precomputed drift, trapping and recombination tables for the LC cell readout
+#include "LCTransportTables.hh"
+#include "G4AutoLock.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+namespace {
+  G4Mutex tablesMutex = G4MUTEX_INITIALIZER;
+  
+  // Log-spaced axes: log10 of the field in V/um and of the density in pairs/um
+  const G4double kLogFieldMin = -3.;
+  const G4double kLogFieldStep = 0.05;
+  const G4double kLogDensityMin = -1.;
+  const G4double kLogDensityStep = 0.1;
+  
+  G4double Clamp(G4double value, G4double low, G4double high) {
+    return std::min(high, std::max(low, value));
+  }
+  
+  G4double FieldAt(G4int node) {
+    return std::pow(10., kLogFieldMin + node*kLogFieldStep) * volt/um;
+  }
+  
+  G4double DensityAt(G4int node) {
+    return std::pow(10., kLogDensityMin + node*kLogDensityStep) / um;
+  }
+  
+  // Induced charge of carriers drifting over a fraction of the cell with
+  // attenuation length lambda (Hecht); the plain fraction without trapping
+  G4double Hecht(G4double fraction, G4double thickness, G4double lambda) {
+    if (!std::isfinite(lambda)) return fraction;
+    return -(lambda/thickness) * std::expm1(-fraction*thickness/lambda);
+  }
+}
+
+G4bool LCTransportParameters::operator==(const LCTransportParameters& other) const {
+  return cellThickness == other.cellThickness &&
+         mobilityElectron == other.mobilityElectron &&
+         mobilityIon == other.mobilityIon &&
+         saturationVelocityElectron == other.saturationVelocityElectron &&
+         saturationVelocityIon == other.saturationVelocityIon &&
+         recombinationCoef == other.recombinationCoef &&
+         intrinsicIonDensity == other.intrinsicIonDensity &&
+         columnRadius == other.columnRadius &&
+         relativePermittivity == other.relativePermittivity;
+}
+
+const LCTransportTables* LCTransportTables::Get(const LCTransportParameters& parameters) {
+  G4AutoLock lock(&tablesMutex);
+  
+  // Tables are kept for the whole session; a sweep builds one set per point
+  static std::vector<std::unique_ptr<LCTransportTables>> tables;
+  for (const auto& table : tables) {
+    if (table->fParameters == parameters) return table.get();
+  }
+  tables.emplace_back(new LCTransportTables(parameters));
+  return tables.back().get();
+}
+
+LCTransportTables::LCTransportTables(const LCTransportParameters& parameters)
+: fParameters(parameters),
+  fRecombinationCoef(parameters.recombinationCoef)
+{
+  // Langevin: recombination limited by the carriers' drift in each other's field
+  if (fRecombinationCoef <= 0.) {
+    fRecombinationCoef = eplus * (parameters.mobilityElectron + parameters.mobilityIon) /
+                         (epsilon0 * parameters.relativePermittivity);
+  }
+  
+  fElectronTransit.resize(kFieldNodes * kDepthNodes);
+  fIonTransit.resize(kFieldNodes * kDepthNodes);
+  fElectronCollection.resize(kFieldNodes * kDepthNodes);
+  fIonCollection.resize(kFieldNodes * kDepthNodes);
+  fEscape.resize(kFieldNodes * kDensityNodes);
+  
+  G4double halfThickness = 0.5 * parameters.cellThickness;
+  for (G4int i = 0; i < kFieldNodes; i++) {
+    G4double field = FieldAt(i);
+    for (G4int j = 0; j < kDepthNodes; j++) {
+      G4double y = (static_cast<G4double>(j) / (kDepthNodes - 1) - 0.5) * parameters.cellThickness;
+      LCTransportLookup node = Evaluate(std::min(halfThickness, y), field, 0.);
+      fElectronTransit[i*kDepthNodes + j] = node.electronTransit;
+      fIonTransit[i*kDepthNodes + j] = node.ionTransit;
+      fElectronCollection[i*kDepthNodes + j] = node.electronCollection;
+      fIonCollection[i*kDepthNodes + j] = node.ionCollection;
+    }
+    for (G4int k = 0; k < kDensityNodes; k++) {
+      fEscape[i*kDensityNodes + k] = Escape(field, DensityAt(k));
+    }
+  }
+}
+
+G4double LCTransportTables::DriftVelocity(G4double mobility, G4double saturation, G4double field) const {
+  G4double velocity = mobility * field;
+  if (saturation > 0.) velocity /= 1. + velocity / saturation;
+  return velocity;
+}
+
+G4double LCTransportTables::Escape(G4double field, G4double pairDensity) const {
+  if (pairDensity <= 0. || fParameters.columnRadius <= 0.) return 1.;
+  G4double radius = fParameters.columnRadius;
+  G4double density = pairDensity / (pi * radius * radius);
+  G4double separation = 2. * radius /
+    (DriftVelocity(fParameters.mobilityElectron, fParameters.saturationVelocityElectron, field) +
+     DriftVelocity(fParameters.mobilityIon, fParameters.saturationVelocityIon, field));
+  return 1. / (1. + fRecombinationCoef * density * separation);
+}
+
+LCTransportLookup LCTransportTables::Evaluate(G4double y, G4double field, G4double pairDensity) const {
+  G4double thickness = fParameters.cellThickness;
+  G4double toAnode = Clamp(0.5 - y/thickness, 0., 1.);   // fraction of the cell
+  G4double toCathode = 1. - toAnode;
+  
+  G4double electronVelocity = DriftVelocity(fParameters.mobilityElectron, fParameters.saturationVelocityElectron, field);
+  G4double ionVelocity = DriftVelocity(fParameters.mobilityIon, fParameters.saturationVelocityIon, field);
+  
+  // Lifetime against recombination with the intrinsic ions
+  G4double lifetime = std::numeric_limits<G4double>::infinity();
+  if (fParameters.intrinsicIonDensity > 0.) {
+    lifetime = 1. / (fRecombinationCoef * fParameters.intrinsicIonDensity);
+  }
+  
+  LCTransportLookup result;
+  result.electronTransit = toAnode * thickness / electronVelocity;
+  result.ionTransit = toCathode * thickness / ionVelocity;
+  result.electronCollection = Hecht(toAnode, thickness, electronVelocity * lifetime);
+  result.ionCollection = Hecht(toCathode, thickness, ionVelocity * lifetime);
+  result.escape = Escape(field, pairDensity);
+  return result;
+}
+
+G4double LCTransportTables::FieldCoordinate(G4double field) const {
+  if (field <= 0.) return 0.;
+  G4double coordinate = (std::log10(field / (volt/um)) - kLogFieldMin) / kLogFieldStep;
+  return Clamp(coordinate, 0., kFieldNodes - 1);
+}
+
+LCTransportLookup LCTransportTables::Lookup(G4double y, G4double fieldCoordinate, G4double pairDensity) const {
+  G4int i = std::min(static_cast<G4int>(fieldCoordinate), kFieldNodes - 2);
+  G4double wi = fieldCoordinate - i;
+  
+  G4double depth = Clamp((y / fParameters.cellThickness + 0.5) * (kDepthNodes - 1), 0., kDepthNodes - 1);
+  G4int j = std::min(static_cast<G4int>(depth), kDepthNodes - 2);
+  G4double wj = depth - j;
+  
+  // Bilinear weights of the four depth-table nodes
+  std::size_t n00 = i*kDepthNodes + j, n10 = n00 + kDepthNodes;
+  G4double w00 = (1. - wi) * (1. - wj), w01 = (1. - wi) * wj;
+  G4double w10 = wi * (1. - wj), w11 = wi * wj;
+  auto interpolate = [&](const std::vector<G4double>& table) {
+    return w00*table[n00] + w01*table[n00 + 1] + w10*table[n10] + w11*table[n10 + 1];
+  };
+  
+  LCTransportLookup result;
+  result.electronTransit = interpolate(fElectronTransit);
+  result.ionTransit = interpolate(fIonTransit);
+  result.electronCollection = interpolate(fElectronCollection);
+  result.ionCollection = interpolate(fIonCollection);
+  
+  result.escape = 1.;
+  if (pairDensity > 0.) {
+    G4double density = Clamp((std::log10(pairDensity * um) - kLogDensityMin) / kLogDensityStep,
+                             0., kDensityNodes - 1);
+    G4int k = std::min(static_cast<G4int>(density), kDensityNodes - 2);
+    G4double wk = density - k;
+    std::size_t m0 = i*kDensityNodes + k, m1 = m0 + kDensityNodes;
+    result.escape = (1. - wi) * ((1. - wk)*fEscape[m0] + wk*fEscape[m0 + 1]) +
+                    wi * ((1. - wk)*fEscape[m1] + wk*fEscape[m1 + 1]);
+  }
+  return result;
+}
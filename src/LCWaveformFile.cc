@@ -0,0 +1,431 @@
+// LCWaveformFile.cc - Compressed binary stream of per-event electrometer waveforms with an event index
+#include "LCWaveformFile.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+  const char kMagic[8] = {'L', 'C', 'W', 'A', 'V', 'E', 'S', '\0'};
+  const char kIndexMagic[8] = {'L', 'C', 'W', 'I', 'N', 'D', 'E', 'X'};
+  const std::uint32_t kVersion = 1;
+  const std::size_t kHeaderSize = 8 + 2*sizeof(std::uint32_t) + 2*sizeof(double) + 2*sizeof(std::uint32_t);
+  const std::size_t kBlockHeaderSize = 3*sizeof(std::uint32_t);
+  const std::size_t kIndexEntrySize = 2*sizeof(std::uint32_t) + sizeof(std::uint64_t) + 2*sizeof(std::uint32_t);
+  const std::size_t kTailSize = 2*sizeof(std::uint64_t) + 8;
+  
+  // Ticks are kept well inside int64 so differences cannot overflow
+  const double kMaxTicks = 4.0e18;
+  
+  template <typename T>
+  void WriteValue(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+  
+  template <typename T>
+  bool ReadValue(std::ifstream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+  }
+  
+  std::int64_t ToTicks(double value, double step) {
+    double ticks = std::round(value / step);
+    if (!(ticks > -kMaxTicks)) ticks = -kMaxTicks;  // also NaN
+    if (ticks > kMaxTicks) ticks = kMaxTicks;
+    return static_cast<std::int64_t>(ticks);
+  }
+  
+  void PutVarint(std::vector<unsigned char>& out, std::uint64_t value) {
+    while (value >= 0x80) {
+      out.push_back(static_cast<unsigned char>(value | 0x80));
+      value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+  }
+  
+  void PutSigned(std::vector<unsigned char>& out, std::int64_t value) {
+    PutVarint(out, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+  }
+  
+  bool GetVarint(const unsigned char*& in, const unsigned char* end, std::uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && in < end; shift += 7) {
+      unsigned char byte = *in++;
+      value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) return true;
+    }
+    return false;
+  }
+  
+  bool GetSigned(const unsigned char*& in, const unsigned char* end, std::int64_t& value) {
+    std::uint64_t raw = 0;
+    if (!GetVarint(in, end, raw)) return false;
+    value = static_cast<std::int64_t>(raw >> 1) ^ -static_cast<std::int64_t>(raw & 1);
+    return true;
+  }
+  
+  // Byte-oriented LZ77 in the style of LZ4: sequences of a token (literal
+  // count and match length - 4 in four bits each, 15 meaning "continued in
+  // 255-terminated extra bytes"), the literals, and a 16-bit match offset.
+  // The last sequence has literals only. A single-probe hash table keeps it
+  // at a few ns per byte, far below the cost of transporting the event.
+  const std::size_t kMinMatch = 4;
+  const std::size_t kMaxOffset = 65535;
+  const std::size_t kLastLiterals = 5;   // the tail is always stored as literals
+  const int kHashBits = 12;
+  
+  std::uint32_t Read32(const unsigned char* p) {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+  }
+  
+  std::uint32_t HashOf(std::uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - kHashBits);
+  }
+  
+  void PutLength(std::vector<unsigned char>& out, std::size_t length) {
+    for (; length >= 255; length -= 255) out.push_back(255);
+    out.push_back(static_cast<unsigned char>(length));
+  }
+  
+  void PutSequence(std::vector<unsigned char>& out, const unsigned char* literals, std::size_t literalCount,
+                   std::size_t offset, std::size_t matchLength) {
+    std::size_t matchCode = matchLength ? matchLength - kMinMatch : 0;
+    out.push_back(static_cast<unsigned char>((std::min<std::size_t>(literalCount, 15) << 4) |
+                                             std::min<std::size_t>(matchCode, 15)));
+    if (literalCount >= 15) PutLength(out, literalCount - 15);
+    out.insert(out.end(), literals, literals + literalCount);
+    if (!matchLength) return;
+    out.push_back(static_cast<unsigned char>(offset & 0xff));
+    out.push_back(static_cast<unsigned char>(offset >> 8));
+    if (matchCode >= 15) PutLength(out, matchCode - 15);
+  }
+  
+  void Compress(const std::vector<unsigned char>& in, std::vector<unsigned char>& out) {
+    out.clear();
+    const unsigned char* src = in.data();
+    std::size_t size = in.size();
+    std::uint32_t table[1 << kHashBits];   // position + 1, 0 = empty
+    std::fill(table, table + (1 << kHashBits), 0);
+    
+    std::size_t anchor = 0, pos = 0;
+    while (pos + kMinMatch + kLastLiterals <= size) {
+      std::uint32_t sequence = Read32(src + pos);
+      std::uint32_t& slot = table[HashOf(sequence)];
+      std::size_t candidate = slot;
+      slot = static_cast<std::uint32_t>(pos + 1);
+      if (candidate == 0 || pos + 1 - candidate > kMaxOffset || Read32(src + candidate - 1) != sequence) {
+        pos++;
+        continue;
+      }
+      std::size_t match = candidate - 1;
+      std::size_t length = kMinMatch;
+      std::size_t limit = size - kLastLiterals;
+      while (pos + length < limit && src[match + length] == src[pos + length]) length++;
+      PutSequence(out, src + anchor, pos - anchor, pos - match, length);
+      pos += length;
+      anchor = pos;
+    }
+    PutSequence(out, src + anchor, size - anchor, 0, 0);
+  }
+  
+  bool GetLength(const unsigned char*& in, const unsigned char* end, std::size_t& length) {
+    unsigned char byte;
+    do {
+      if (in >= end) return false;
+      byte = *in++;
+      length += byte;
+    } while (byte == 255);
+    return true;
+  }
+  
+  bool Decompress(const unsigned char* in, std::size_t size, std::vector<unsigned char>& out, std::size_t rawSize) {
+    out.resize(rawSize);
+    const unsigned char* end = in + size;
+    std::size_t pos = 0;
+    while (in < end) {
+      unsigned char token = *in++;
+      std::size_t literals = token >> 4;
+      if (literals == 15 && !GetLength(in, end, literals)) return false;
+      if (literals > static_cast<std::size_t>(end - in) || literals > rawSize - pos) return false;
+      std::memcpy(out.data() + pos, in, literals);
+      in += literals;
+      pos += literals;
+      if (in == end) break;
+      
+      if (end - in < 2) return false;
+      std::size_t offset = in[0] | (static_cast<std::size_t>(in[1]) << 8);
+      in += 2;
+      std::size_t length = token & 0x0f;
+      if (length == 15 && !GetLength(in, end, length)) return false;
+      length += kMinMatch;
+      if (offset == 0 || offset > pos || length > rawSize - pos) return false;
+      // Byte by byte: the match may overlap the bytes it produces
+      for (std::size_t i = 0; i < length; i++, pos++) out[pos] = out[pos - offset];
+    }
+    return pos == rawSize;
+  }
+}
+
+LCWaveformWriter::LCWaveformWriter()
+: fBlockFirstEvent(0),
+  fRawBytes(0),
+  fFileBytes(0),
+  fEventID(0),
+  fEventSamples(0),
+  fLastTime(0),
+  fLastCurrent(0)
+{
+}
+
+LCWaveformWriter::~LCWaveformWriter()
+{
+  Close();
+}
+
+bool LCWaveformWriter::Open(const std::string& fileName, const LCWaveformHeader& header, std::string* error) {
+  Close();
+  fFile.open(fileName, std::ios::binary | std::ios::trunc);
+  if (!fFile.is_open()) {
+    if (error) *error = "could not open " + fileName + " for writing";
+    return false;
+  }
+  
+  fHeader = header;
+  fIndex.clear();
+  fBlock.clear();
+  fBlockFirstEvent = 0;
+  fRawBytes = 0;
+  
+  fFile.write(kMagic, sizeof(kMagic));
+  WriteValue(fFile, kVersion);
+  WriteValue(fFile, std::uint32_t(0));
+  WriteValue(fFile, fHeader.timeStep);
+  WriteValue(fFile, fHeader.currentStep);
+  WriteValue(fFile, fHeader.configEpoch);
+  WriteValue(fFile, fHeader.threadID);
+  fFileBytes = kHeaderSize;
+  return static_cast<bool>(fFile);
+}
+
+void LCWaveformWriter::BeginEvent(std::uint32_t eventID) {
+  fEventBuffer.clear();
+  fEventID = eventID;
+  fEventSamples = 0;
+  fLastTime = 0;
+  fLastCurrent = 0;
+}
+
+void LCWaveformWriter::AddSample(double timeNs, double currentPA) {
+  std::int64_t time = ToTicks(timeNs, fHeader.timeStep);
+  std::int64_t current = ToTicks(currentPA, fHeader.currentStep);
+  PutSigned(fEventBuffer, time - fLastTime);
+  PutSigned(fEventBuffer, current - fLastCurrent);
+  fLastTime = time;
+  fLastCurrent = current;
+  fEventSamples++;
+}
+
+void LCWaveformWriter::EndEvent() {
+  if (!IsOpen()) return;
+  
+  LCWaveformIndexEntry entry;
+  entry.eventID = fEventID;
+  entry.samples = fEventSamples;
+  entry.blockOffset = fFileBytes;   // of the block this event goes into
+  entry.eventOffset = static_cast<std::uint32_t>(fBlock.size());
+  fIndex.push_back(entry);
+  
+  PutVarint(fBlock, fEventID);
+  PutVarint(fBlock, fEventSamples);
+  fBlock.insert(fBlock.end(), fEventBuffer.begin(), fEventBuffer.end());
+  if (fBlock.size() >= kBlockSize) FlushBlock();
+}
+
+void LCWaveformWriter::FlushBlock() {
+  if (fBlock.empty()) return;
+  
+  Compress(fBlock, fCompressed);
+  bool stored = fCompressed.size() < fBlock.size();
+  const std::vector<unsigned char>& data = stored ? fCompressed : fBlock;
+  
+  WriteValue(fFile, static_cast<std::uint32_t>(fBlock.size()));
+  WriteValue(fFile, static_cast<std::uint32_t>(data.size()));
+  WriteValue(fFile, static_cast<std::uint32_t>(fIndex.size() - fBlockFirstEvent));
+  fFile.write(reinterpret_cast<const char*>(data.data()), data.size());
+  
+  fRawBytes += fBlock.size();
+  fFileBytes += kBlockHeaderSize + data.size();
+  fBlockFirstEvent = fIndex.size();
+  fBlock.clear();
+}
+
+bool LCWaveformWriter::Close() {
+  if (!IsOpen()) return true;
+  FlushBlock();
+  
+  std::uint64_t indexOffset = fFileBytes;
+  for (const auto& entry : fIndex) {
+    WriteValue(fFile, entry.eventID);
+    WriteValue(fFile, entry.samples);
+    WriteValue(fFile, entry.blockOffset);
+    WriteValue(fFile, entry.eventOffset);
+    WriteValue(fFile, std::uint32_t(0));
+  }
+  WriteValue(fFile, indexOffset);
+  WriteValue(fFile, static_cast<std::uint64_t>(fIndex.size()));
+  fFile.write(kIndexMagic, sizeof(kIndexMagic));
+  fFileBytes += fIndex.size() * kIndexEntrySize + kTailSize;
+  
+  bool good = static_cast<bool>(fFile);
+  fFile.close();
+  return good && !fFile.fail();
+}
+
+bool LCWaveformReader::Open(const std::string& fileName, std::string* error) {
+  fFile.close();
+  fFile.clear();
+  fIndex.clear();
+  fStoredIndex = false;
+  fBlockOffset = UINT64_MAX;
+  
+  fFile.open(fileName, std::ios::binary);
+  if (!fFile.is_open()) {
+    if (error) *error = "could not open " + fileName;
+    return false;
+  }
+  
+  char magic[8];
+  std::uint32_t version = 0, reserved = 0;
+  fFile.read(magic, sizeof(magic));
+  if (!fFile || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+      !ReadValue(fFile, version) || version != kVersion || !ReadValue(fFile, reserved) ||
+      !ReadValue(fFile, fHeader.timeStep) || !ReadValue(fFile, fHeader.currentStep) ||
+      !ReadValue(fFile, fHeader.configEpoch) || !ReadValue(fFile, fHeader.threadID)) {
+    if (error) *error = fileName + " is not a version " + std::to_string(kVersion) + " waveform file";
+    return false;
+  }
+  
+  fFile.seekg(0, std::ios::end);
+  std::uint64_t fileSize = static_cast<std::uint64_t>(fFile.tellg());
+  fFileSize = fileSize;
+  
+  // Index from the tail, if the writer got to write it
+  if (fileSize >= kHeaderSize + kTailSize) {
+    std::uint64_t indexOffset = 0, events = 0;
+    char indexMagic[8];
+    fFile.seekg(fileSize - kTailSize);
+    if (ReadValue(fFile, indexOffset) && ReadValue(fFile, events) &&
+        fFile.read(indexMagic, sizeof(indexMagic)) &&
+        std::memcmp(indexMagic, kIndexMagic, sizeof(kIndexMagic)) == 0 &&
+        indexOffset >= kHeaderSize && events <= fileSize / kIndexEntrySize &&
+        indexOffset + events * kIndexEntrySize + kTailSize == fileSize) {
+      fIndex.resize(events);
+      fFile.seekg(indexOffset);
+      bool good = true;
+      for (auto& entry : fIndex) {
+        good = good && ReadValue(fFile, entry.eventID) && ReadValue(fFile, entry.samples) &&
+               ReadValue(fFile, entry.blockOffset) && ReadValue(fFile, entry.eventOffset) &&
+               ReadValue(fFile, reserved);
+      }
+      if (good) {
+        fStoredIndex = true;
+        return true;
+      }
+      fIndex.clear();
+    }
+  }
+  
+  // No (valid) index: walk the blocks up to the first damaged one
+  fFile.clear();
+  ScanBlocks(fileSize);
+  return true;
+}
+
+bool LCWaveformReader::ScanBlocks(std::uint64_t end) {
+  std::uint64_t offset = kHeaderSize;
+  while (offset + kBlockHeaderSize <= end) {
+    if (!LoadBlock(offset)) return false;
+    
+    const unsigned char* in = fBlock.data();
+    const unsigned char* blockEnd = in + fBlock.size();
+    while (in < blockEnd) {
+      LCWaveformIndexEntry entry;
+      entry.blockOffset = offset;
+      entry.eventOffset = static_cast<std::uint32_t>(in - fBlock.data());
+      std::uint64_t eventID = 0, samples = 0;
+      if (!GetVarint(in, blockEnd, eventID) || !GetVarint(in, blockEnd, samples)) return false;
+      for (std::uint64_t i = 0; i < 2*samples; i++) {
+        std::int64_t delta;
+        if (!GetSigned(in, blockEnd, delta)) return false;
+      }
+      entry.eventID = static_cast<std::uint32_t>(eventID);
+      entry.samples = static_cast<std::uint32_t>(samples);
+      fIndex.push_back(entry);
+    }
+    offset += kBlockHeaderSize + fStored.size();
+  }
+  return true;
+}
+
+bool LCWaveformReader::LoadBlock(std::uint64_t offset) {
+  if (offset == fBlockOffset) return true;
+  fBlockOffset = UINT64_MAX;
+  
+  std::uint32_t rawSize = 0, storedSize = 0, events = 0;
+  fFile.clear();
+  fFile.seekg(offset);
+  if (!ReadValue(fFile, rawSize) || !ReadValue(fFile, storedSize) || !ReadValue(fFile, events) ||
+      storedSize > rawSize) {
+    return false;
+  }
+  // Sizes from a damaged header must not drive the allocations: the stored
+  // bytes have to be in the file, and a sequence expands at most 255-fold
+  if (storedSize > fFileSize - offset - kBlockHeaderSize ||
+      rawSize > static_cast<std::uint64_t>(storedSize) * 255) {
+    return false;
+  }
+  fStored.resize(storedSize);
+  if (!fFile.read(reinterpret_cast<char*>(fStored.data()), storedSize)) return false;
+  
+  if (storedSize == rawSize) {
+    fBlock = fStored;
+  } else if (!Decompress(fStored.data(), storedSize, fBlock, rawSize)) {
+    return false;
+  }
+  fBlockOffset = offset;
+  return true;
+}
+
+bool LCWaveformReader::ReadEvent(std::size_t position, LCWaveformEvent& event) {
+  if (position >= fIndex.size()) return false;
+  const LCWaveformIndexEntry& entry = fIndex[position];
+  if (!LoadBlock(entry.blockOffset) || entry.eventOffset >= fBlock.size()) return false;
+  
+  const unsigned char* in = fBlock.data() + entry.eventOffset;
+  const unsigned char* end = fBlock.data() + fBlock.size();
+  std::uint64_t eventID = 0, samples = 0;
+  if (!GetVarint(in, end, eventID) || !GetVarint(in, end, samples)) return false;
+  
+  // Each sample takes at least two bytes, which bounds a corrupt count
+  if (samples > static_cast<std::uint64_t>(end - in) / 2) return false;
+  
+  event.eventID = static_cast<std::uint32_t>(eventID);
+  event.samples.resize(samples);
+  std::int64_t time = 0, current = 0;
+  for (auto& sample : event.samples) {
+    std::int64_t timeDelta, currentDelta;
+    if (!GetSigned(in, end, timeDelta) || !GetSigned(in, end, currentDelta)) return false;
+    time += timeDelta;
+    current += currentDelta;
+    sample.time = time * fHeader.timeStep;
+    sample.current = current * fHeader.currentStep;
+  }
+  return true;
+}
+
+bool LCWaveformReader::FindEvent(std::uint32_t eventID, LCWaveformEvent& event) {
+  for (std::size_t i = 0; i < fIndex.size(); i++) {
+    if (fIndex[i].eventID == eventID) return ReadEvent(i, event);
+  }
+  return false;
+}
@@ -0,0 +1,74 @@
+// LCWaveformRecorder.cc - Per-thread writer of the compressed electrometer waveform stream
+#include "LCWaveformRecorder.hh"
+#include "LCConfiguration.hh"
+#include "LCMemoryTracker.hh"
+#include "LCRunAction.hh"
+#include "G4Threading.hh"
+#include "G4UIcommand.hh"
+#include <algorithm>
+
+G4ThreadLocal LCWaveformRecorder* LCWaveformRecorder::fInstance = nullptr;
+
+LCWaveformRecorder* LCWaveformRecorder::Instance() {
+  if (!fInstance) {
+    fInstance = new LCWaveformRecorder();
+  }
+  return fInstance;
+}
+
+LCWaveformRecorder::LCWaveformRecorder()
+: fRecording(false)
+{
+}
+
+LCWaveformRecorder::~LCWaveformRecorder()
+{
+  EndRun();
+}
+
+void LCWaveformRecorder::BeginRun(const G4String& baseName) {
+  EndRun();
+  const LCConfigSnapshot* config = LCConfiguration::ForRun();
+  fRecording = config->waveformRecording;
+  if (!fRecording) return;
+  
+  fBaseName = baseName;
+  fHeader.timeStep = config->waveformTimeStep/ns;
+  fHeader.currentStep = config->waveformCurrentStep/(1.0e-12*ampere);
+  fHeader.configEpoch = static_cast<std::uint32_t>(config->epoch);
+  fHeader.threadID = static_cast<std::uint32_t>(std::max(0, G4Threading::G4GetThreadId()));
+}
+
+void LCWaveformRecorder::EndRun() {
+  if (fWriter.IsOpen()) {
+    std::uint64_t events = fWriter.GetEventsWritten();
+    std::uint64_t rawBytes = fWriter.GetRawBytes();
+    if (!fWriter.Close()) {
+      G4cerr << "Warning: Error while writing waveform file " << fFileName << G4endl;
+    }
+    G4cout << "Waveforms for " << events << " events written to " << fFileName
+           << " (" << fWriter.GetFileBytes() << " bytes, " << rawBytes << " before compression)" << G4endl;
+  }
+  fRecording = false;
+}
+
+G4bool LCWaveformRecorder::BeginEvent(G4int eventID) {
+  if (!fWriter.IsOpen()) {
+    fFileName = fBaseName + "_waveforms_t" + G4UIcommand::ConvertToString(static_cast<G4int>(fHeader.threadID)) + ".lcw";
+    std::string error;
+    if (!fWriter.Open(fFileName, fHeader, &error)) {
+      G4cerr << "Warning: Could not open waveform file: " << error << G4endl;
+      G4cerr << "Continuing without waveform recording..." << G4endl;
+      fRecording = false;
+      return false;
+    }
+    LCRunAction::DeclareOutputFile(fFileName);
+  }
+  fWriter.BeginEvent(static_cast<std::uint32_t>(eventID));
+  return true;
+}
+
+void LCWaveformRecorder::EndEvent() {
+  fWriter.EndEvent();
+  LCMemoryTracker::Instance()->Track(kPoolWaveformBlocks, fWriter.GetBufferBytes());
+}
@@ -4,6 +4,8 @@
 #include "LCPhysicsList.hh"
 #include "LCActionInitialization.hh"
 #include "LCGlobalManager.hh"
+#include "LCGlassFilterBuilder.hh"
+#include "LCMPIManager.hh"
 
 // Use multi-threaded run manager if available
 #ifdef G4MULTITHREADED
@@ -12,6 +14,11 @@
 #include "G4RunManager.hh"
 #endif
 
+// LCDetectorMPI: every beamOn is split across the MPI ranks
+#ifdef LC_MPI_MAIN
+#include "LCMPIRunManager.hh"
+#endif
+
 #include "G4UImanager.hh"
 #include "Randomize.hh"
 #include "G4SystemOfUnits.hh"
@@ -30,11 +37,20 @@ int main(int argc, char** argv)
 {
   // Record start time for timing measurement
   auto start = std::chrono::high_resolution_clock::now();
+  
+  LCMPIManager* mpi = LCMPIManager::Instance();
+#ifdef LC_MPI_MAIN
+  mpi->Initialize(&argc, &argv);
+#endif
 
   // Default beam parameters
   G4String particleType = "proton";
   G4double particleEnergy = 0.5*GeV;
   G4String macroFile = "";
+  long fixedSeed = -1;
+  G4String filterTableParticle = "";
+  G4int filterTableEvents = 10000;
+  G4int nThreads = 12;
   
   // Simple command line argument handling
   for (int i = 1; i < argc; i++) {
@@ -56,12 +72,40 @@ int main(int argc, char** argv)
       else if (unit == "eV") particleEnergy = value * eV;
       else particleEnergy = std::stod(energyStr) * MeV; // Default to MeV
     }
+    else if (arg == "--seed" && i+1 < argc) {
+      fixedSeed = std::stol(argv[++i]);
+    }
+    else if (arg == "--threads" && i+1 < argc) {
+      nThreads = std::stoi(argv[++i]);
+    }
+    else if (arg == "--memory-budget" && i+1 < argc) {
+      G4double budgetMB = std::stod(argv[++i]);
+      LCGlobalManager::Instance()->SetMemoryBudget(static_cast<std::size_t>(budgetMB * 1024. * 1024.));
+    }
+    else if (arg == "--build-filter-table" && i+1 < argc) {
+      filterTableParticle = argv[++i];
+    }
+    else if (arg == "--filter-events" && i+1 < argc) {
+      filterTableEvents = std::stoi(argv[++i]);
+    }
+    else if (arg == "--filter-table-dir" && i+1 < argc) {
+      LCGlobalManager::Instance()->SetGlassFilterTableDir(argv[++i]);
+    }
     else if (arg == "--help") {
       G4cout << "Usage: " << argv[0] << " [options] [macro]" << G4endl;
       G4cout << "Options:" << G4endl;
       G4cout << "  --particle TYPE    Set particle type (proton, e-, gamma, etc.)" << G4endl;
       G4cout << "  --energy VALUE     Set particle energy (with unit: 10 MeV, 1 GeV, etc.)" << G4endl;
+      G4cout << "  --seed N           Use a fixed random seed instead of the clock" << G4endl;
+      G4cout << "  --threads N        Worker threads (default 12; per rank with LCDetectorMPI)" << G4endl;
+      G4cout << "  --memory-budget MB Memory budget for the per-thread buffers (see /LC/memory/budget)" << G4endl;
+      G4cout << "  --build-filter-table PARTICLE" << G4endl;
+      G4cout << "                     Build the glass filter transfer table for PARTICLE and exit" << G4endl;
+      G4cout << "  --filter-events N  Events per energy for --build-filter-table (default 10000)" << G4endl;
+      G4cout << "  --filter-table-dir DIR" << G4endl;
+      G4cout << "                     Glass filter table directory (default lc_filter_tables)" << G4endl;
       G4cout << "  --help             Show this help message" << G4endl;
+      mpi->Finalize();
       return 0;
     }
     else if (macroFile.empty() && arg[0] != '-') {
@@ -75,15 +119,33 @@ int main(int argc, char** argv)
     std::ifstream testFile(macroFile.c_str());
     if (!testFile.good()) {
       G4cerr << "Error: Macro file '" << macroFile << "' not found!" << G4endl;
+      mpi->Finalize();
       return 1;
     }
     testFile.close();
   }
 
-  // Set random seed with better entropy source
+  // Set random seed with better entropy source, unless a fixed seed was given
   G4Random::setTheEngine(new CLHEP::RanecuEngine);
   unsigned long seed = static_cast<unsigned long>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+  if (fixedSeed >= 0) seed = static_cast<unsigned long>(fixedSeed);
+  
+  // MPI runs: rank 0's seed, turned into an independent stream per rank
+  seed = static_cast<unsigned long>(mpi->GetRankSeed(mpi->BroadcastSeed(static_cast<long>(seed))));
   G4Random::setTheSeed(seed);
+  LCGlobalManager::Instance()->SetRandomSeed(static_cast<long>(seed), fixedSeed >= 0);
+
+  // Table building mode: simulate the filter slab on its own and exit
+  if (!filterTableParticle.empty()) {
+    // Tables are shared files - built by one rank only
+    G4int status = 0;
+    if (mpi->IsRoot()) {
+      status = LCGlassFilterBuilder::Build(filterTableParticle, filterTableEvents,
+                                           LCGlobalManager::Instance()->GetGlassFilterTableDir());
+    }
+    mpi->Finalize();
+    return status;
+  }
 
   // Construct the run manager
   G4RunManager* runManager = nullptr;
@@ -96,16 +158,23 @@ int main(int argc, char** argv)
     // Create appropriate run manager
     #ifdef G4MULTITHREADED
       G4cout << "Using multi-threaded run manager (optimized)" << G4endl;
+#ifdef LC_MPI_MAIN
+      auto* mtRunManager = new LCMPIRunManager<G4MTRunManager>();
+#else
       auto* mtRunManager = new G4MTRunManager();
+#endif
       runManager = mtRunManager;
       
-      // Use 12 threads as requested
-      G4int nThreads = 12;
+      // 12 threads unless set with --threads
       mtRunManager->SetNumberOfThreads(nThreads);
       G4cout << "Number of threads: " << nThreads << G4endl;
     #else
       G4cout << "Using single-threaded run manager" << G4endl;
+#ifdef LC_MPI_MAIN
+      runManager = new LCMPIRunManager<G4RunManager>();
+#else
       runManager = new G4RunManager();
+#endif
     #endif
 
     // Print banner with actual settings that will be used
@@ -116,6 +185,9 @@ int main(int argc, char** argv)
     G4cout << "    Memory Optimized Build" << G4endl;
     G4cout << "    Particle: " << particleType << G4endl;
     G4cout << "    Energy: " << particleEnergy/MeV << " MeV" << G4endl;
+    if (mpi->IsActive()) {
+      G4cout << "    MPI rank " << mpi->GetRank() << " of " << mpi->GetSize() << G4endl;
+    }
     G4cout << "    VISUALIZATION DISABLED" << G4endl;
     G4cout << "===================================================" << G4endl;
     
@@ -172,13 +244,16 @@ if (analysisManager && analysisManager->IsOpenFile()) {
 std::this_thread::sleep_for(std::chrono::milliseconds(500));
 
 G4cout << "Exiting..." << G4endl;
+    mpi->Finalize();
     exit(0);  // Skip normal cleanup and just exit
     
   } catch (const std::exception& e) {
     G4cerr << "Exception caught: " << e.what() << G4endl;
+    mpi->Finalize();
     return 1;
   } catch (...) {
     G4cerr << "Unknown exception caught!" << G4endl;
+    mpi->Finalize();
     return 1;
   }
 }
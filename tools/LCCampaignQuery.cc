@@ -0,0 +1,146 @@
+// LCCampaignQuery.cc - Lists the runs of a campaign store that match a selection
+//
+// Every finished LCDetector run appends its configuration and summary
+// statistics to the campaign store (/LC/campaign/store, default ./campaign).
+// This tool selects on the indexed fields and prints the chosen columns as a
+// tab-separated table, one run per line in the order the runs finished.
+//
+// Usage: LCCampaignQuery [--store DIR] [--particle P] [--energy E | --energy-range MIN MAX]
+//                        [--bias V] [--physics TAG] [--seed N] [--columns a,b,...] [--count]
+//        LCCampaignQuery --store DIR --rebuild-index
+#include "LCCampaignStore.hh"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+  const char kDefaultColumns[] =
+    "time,particle,energy_MeV,bias_V,physics,seed,events,"
+    "Charge_mean,Charge_stderr,AvgCurrent_mean,PeakCurrent_mean,output";
+  
+  // Relative tolerance of --energy and --bias, for values printed and read back
+  const double kMatchTolerance = 1.0e-9;
+  
+  void PrintUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --store DIR              Campaign store directory (default ./campaign)" << std::endl;
+    std::cout << "  --particle NAME          Only runs with this beam particle (\"cocktail\" for source cocktails)" << std::endl;
+    std::cout << "  --energy E               Only runs at this beam energy (MeV)" << std::endl;
+    std::cout << "  --energy-range MIN MAX   Only runs with MIN <= energy <= MAX (MeV)" << std::endl;
+    std::cout << "  --bias V                 Only runs at this bias (V)" << std::endl;
+    std::cout << "  --physics TAG            Only runs with this physics configuration" << std::endl;
+    std::cout << "  --seed N                 Only runs with this seed" << std::endl;
+    std::cout << "  --columns LIST           Comma-separated fields to print, \"all\" for every field" << std::endl;
+    std::cout << "                           (default " << kDefaultColumns << ")" << std::endl;
+    std::cout << "  --count                  Print the number of matching runs only" << std::endl;
+    std::cout << "  --rebuild-index          Rewrite the index from the run log" << std::endl;
+  }
+  
+  std::vector<std::string> SplitColumns(const std::string& list) {
+    std::vector<std::string> columns;
+    std::istringstream in(list);
+    std::string column;
+    while (std::getline(in, column, ',')) {
+      if (!column.empty()) columns.push_back(column);
+    }
+    return columns;
+  }
+  
+  void SetRange(double value, double& min, double& max) {
+    double tolerance = kMatchTolerance * std::abs(value);
+    min = value - tolerance;
+    max = value + tolerance;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::string storeDir = "campaign";
+  LCCampaignQuery query;
+  std::string columnList = kDefaultColumns;
+  bool countOnly = false;
+  bool rebuild = false;
+  
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = (i+1 < argc);
+    if (arg == "--help" || arg == "-h") { PrintUsage(argv[0]); return 0; }
+    else if (arg == "--store" && hasValue) storeDir = argv[++i];
+    else if (arg == "--particle" && hasValue) query.particle = argv[++i];
+    else if (arg == "--physics" && hasValue) query.physics = argv[++i];
+    else if (arg == "--energy" && hasValue) {
+      query.hasEnergy = true;
+      SetRange(std::atof(argv[++i]), query.energyMinMeV, query.energyMaxMeV);
+    }
+    else if (arg == "--energy-range" && i+2 < argc) {
+      query.hasEnergy = true;
+      query.energyMinMeV = std::atof(argv[++i]);
+      query.energyMaxMeV = std::atof(argv[++i]);
+    }
+    else if (arg == "--bias" && hasValue) {
+      query.hasBias = true;
+      SetRange(std::atof(argv[++i]), query.biasMinV, query.biasMaxV);
+    }
+    else if (arg == "--seed" && hasValue) {
+      query.hasSeed = true;
+      query.seed = std::atol(argv[++i]);
+    }
+    else if (arg == "--columns" && hasValue) columnList = argv[++i];
+    else if (arg == "--count") countOnly = true;
+    else if (arg == "--rebuild-index") rebuild = true;
+    else {
+      std::cerr << "ERROR: Unknown or incomplete option: " << arg << std::endl;
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+  
+  LCCampaignStore store(storeDir);
+  if (rebuild) {
+    std::cout << "Indexed " << store.RebuildIndex() << " runs in " << store.GetIndexPath() << std::endl;
+    return 0;
+  }
+  
+  auto start = std::chrono::steady_clock::now();
+  std::vector<LCCampaignRecord> records = store.Query(query);
+  double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  
+  if (countOnly) {
+    std::cout << records.size() << std::endl;
+    return 0;
+  }
+  
+  // "all": every field that occurs, in order of first appearance
+  std::vector<std::string> columns;
+  if (columnList == "all") {
+    for (const auto& record : records) {
+      for (const auto& field : record.GetFields()) {
+        bool known = false;
+        for (const auto& column : columns) known = known || column == field.first;
+        if (!known) columns.push_back(field.first);
+      }
+    }
+  } else {
+    columns = SplitColumns(columnList);
+  }
+  
+  for (std::size_t i = 0; i < columns.size(); i++) {
+    std::cout << (i > 0 ? "\t" : "") << columns[i];
+  }
+  std::cout << "\n";
+  for (const auto& record : records) {
+    for (std::size_t i = 0; i < columns.size(); i++) {
+      std::string value = record.Get(columns[i]);
+      std::cout << (i > 0 ? "\t" : "") << (value.empty() ? "-" : value);
+    }
+    std::cout << "\n";
+  }
+  std::cerr << "# " << records.size() << " matching runs in " << store.GetLogPath()
+            << " (" << milliseconds << " ms)" << std::endl;
+  return 0;
+}
@@ -0,0 +1,551 @@
+// LCRegression.cc - Fixed-seed regression check of LCDetector's output and speed against stored baselines
+//
+// A case is a short macro <cases>/<case>.mac. It is run by LCDetector with a
+// fixed seed and thread count in its own work directory <work>/<case>, and
+// its runs are read back from the campaign store there (one record per
+// /run/beamOn). The output is compared with <baselines>/<case>.baseline,
+// which is kept in the repository:
+//
+//   - the runs must match one to one (particle, energy, bias, events)
+//   - a checksum per run over the observables' minima and maxima must be
+//     identical: with the per-event seeds fixed these do not depend on the
+//     order in which the threads' results are merged
+//   - means, standard deviations and medians must agree within --tolerance
+//     (relative), which only has to absorb that merge order
+//
+// and the speed with <timing-baselines>/<case>.timing:
+//
+//   - events/s may not drop, and the wall time of the case (for the
+//     "startup" case: start-up alone) may not grow, by more than
+//     --perf-tolerance
+//
+// Timings depend on the machine and the build, so timing baselines are made
+// on the machine that checks them and are not kept in the repository.
+// --bless runs the cases and writes the baselines (--no-timing: the output
+// baselines only, --timing-only: the timing baselines only). A case without
+// an output baseline fails; one without a timing baseline is not timed, and
+// with --timing-only skipped. If every case is skipped the exit code is 77
+// (ctest's SKIP_RETURN_CODE), 1 if any case failed and 0 otherwise.
+//
+// Consistency cases (--consistency OBSERVABLE) need no baseline: the runs of
+// a case must agree with each other instead, each run's mean of the
+// observable with the first run's within --sigmas combined standard errors.
+// regression/consistency holds such cases, e.g. the same beam analog and
+// biased.
+//
+// Usage: LCRegression [options] [--case NAME ...]
+//        LCRegression [options] --bless [--case NAME ...]
+//        LCRegression [options] --consistency OBSERVABLE [--case NAME ...]
+#include "LCCampaignStore.hh"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+  const int kSkipExitCode = 77;
+  
+  // Fields that identify a run; a mismatch means the case macro changed
+  const char* kConfigFields[] = { "particle", "energy_MeV", "bias_V", "events" };
+  
+  // Statistics compared with the relative tolerance
+  const char* kStatisticSuffixes[] = { "_mean", "_std", "_p50" };
+  
+  // Campaign store fields that differ from one invocation (or machine) to the next
+  const char* kVolatileFields[] = { "time", "output", "events_per_second" };
+  
+  struct CaseResult {
+    double wallSeconds = 0.;
+    std::vector<LCCampaignRecord> runs;
+    long events = 0;
+    double eventsPerSecond = 0.;   // over the runs' own wall times
+  };
+  
+  void PrintUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options] [--case NAME ...]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --case NAME            Run <cases>/NAME.mac (repeatable; default: every case)" << std::endl;
+    std::cout << "  --cases DIR            Directory of the case macros (default ./regression)" << std::endl;
+    std::cout << "  --baselines DIR        Output baseline directory (default <cases>/baselines)" << std::endl;
+    std::cout << "  --timing-baselines DIR Timing baseline directory (default <cases>/timing)" << std::endl;
+    std::cout << "  --work DIR             Work directory, one subdirectory per case (default ./regression_work)" << std::endl;
+    std::cout << "  --exe PATH             LCDetector executable (default: next to LCRegression)" << std::endl;
+    std::cout << "  --seed N               Fixed seed (default 12345)" << std::endl;
+    std::cout << "  --threads N            Worker threads (default 2)" << std::endl;
+    std::cout << "  --tolerance REL        Relative tolerance of means, std and medians (default 1e-6)" << std::endl;
+    std::cout << "  --perf-tolerance FRAC  Allowed loss of events/s and growth of wall time (default 0.25)" << std::endl;
+    std::cout << "  --no-timing            Compare (or bless) the output only, not the speed" << std::endl;
+    std::cout << "  --timing-only          Compare (or bless) the speed only, not the output" << std::endl;
+    std::cout << "  --bless                Write the baselines from this build instead of comparing" << std::endl;
+    std::cout << "  --consistency OBS      Compare the mean of OBS (e.g. Edep) between the runs of each case" << std::endl;
+    std::cout << "                         instead of with the baselines (repeatable)" << std::endl;
+    std::cout << "  --sigmas N             Allowed difference of the means in combined standard errors (default 3)" << std::endl;
+  }
+  
+  bool EndsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
+  
+  // 64-bit FNV-1a, as in the campaign store
+  std::uint64_t Hash(const std::string& text, std::uint64_t hash = 1469598103934665603ULL) {
+    for (char c : text) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+  
+  // Over the run's configuration and the observables' extremes, as stored
+  std::string RunChecksum(const LCCampaignRecord& run) {
+    std::uint64_t hash = Hash("");
+    for (const char* field : kConfigFields) {
+      hash = Hash(std::string(field) + "=" + run.Get(field) + "\n", hash);
+    }
+    for (const auto& field : run.GetFields()) {
+      if (EndsWith(field.first, "_min") || EndsWith(field.first, "_max")) {
+        hash = Hash(field.first + "=" + field.second + "\n", hash);
+      }
+    }
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return text;
+  }
+  
+  bool WithinTolerance(double value, double reference, double tolerance) {
+    if (std::isnan(value) || std::isnan(reference)) return std::isnan(value) && std::isnan(reference);
+    return std::abs(value - reference) <= tolerance * std::max(std::abs(value), std::abs(reference));
+  }
+  
+  // Runs the case macro in a clean work directory; false if LCDetector failed
+  bool RunCase(const std::string& executable, const fs::path& macro, const fs::path& directory,
+               long seed, int threads, CaseResult& result, std::string& error) {
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+    fs::create_directories(directory, ec);
+    if (ec) {
+      error = "could not create " + directory.string();
+      return false;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) {
+      error = std::string("fork failed: ") + std::strerror(errno);
+      return false;
+    }
+    if (pid == 0) {
+      // Child: outputs and the campaign store go to the work directory
+      if (chdir(directory.c_str()) != 0) _exit(127);
+      int log = open("simulation_output.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (log >= 0) {
+        dup2(log, STDOUT_FILENO);
+        dup2(log, STDERR_FILENO);
+        close(log);
+      }
+      std::vector<std::string> args = { executable, "--threads", std::to_string(threads),
+                                        "--seed", std::to_string(seed), macro.string() };
+      std::vector<char*> argv;
+      for (auto& arg : args) argv.push_back(&arg[0]);
+      argv.push_back(nullptr);
+      execv(executable.c_str(), argv.data());
+      _exit(127);
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+      if (errno != EINTR) {
+        error = std::string("waitpid failed: ") + std::strerror(errno);
+        return false;
+      }
+    }
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    // LCDetector exits with 0 after a failed macro command, so check its log too
+    int exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    std::ifstream log(directory / "simulation_output.log");
+    std::string logText((std::istreambuf_iterator<char>(log)), std::istreambuf_iterator<char>());
+    if (exitCode != 0 || logText.find("Error executing macro file") != std::string::npos) {
+      error = "LCDetector failed (exit code " + std::to_string(exitCode) + "), see " +
+              (directory / "simulation_output.log").string();
+      return false;
+    }
+    
+    LCCampaignStore store((directory / "campaign").string());
+    result.runs = store.Query(LCCampaignQuery());
+    double runSeconds = 0.;
+    for (const auto& run : result.runs) {
+      long events = std::atol(run.Get("events").c_str());
+      double rate = run.GetDouble("events_per_second");
+      result.events += events;
+      if (rate > 0.) runSeconds += events / rate;
+    }
+    result.eventsPerSecond = runSeconds > 0. ? result.events / runSeconds : 0.;
+    return true;
+  }
+  
+  LCCampaignRecord BaselineHeader(const std::string& name, long seed, int threads, const CaseResult& result) {
+    LCCampaignRecord header;
+    header.Set("case", name);
+    header.Set("seed", seed);
+    header.Set("threads", static_cast<long>(threads));
+    header.Set("runs", static_cast<long>(result.runs.size()));
+    header.Set("events", result.events);
+    return header;
+  }
+  
+  // Output baseline - first line: the case; then one line per run, in the
+  // order they finished
+  bool WriteBaseline(const fs::path& path, const std::string& name, long seed, int threads,
+                     const CaseResult& result) {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+    out << BaselineHeader(name, seed, threads, result).ToLine() << "\n";
+    for (const auto& run : result.runs) {
+      LCCampaignRecord stored;
+      for (const auto& field : run.GetFields()) {
+        if (std::find_if(std::begin(kVolatileFields), std::end(kVolatileFields),
+                         [&](const char* name) { return field.first == name; }) == std::end(kVolatileFields)) {
+          stored.Set(field.first, field.second);
+        }
+      }
+      stored.Set("checksum", RunChecksum(run));
+      out << stored.ToLine() << "\n";
+    }
+    return out.good();
+  }
+  
+  // Timing baseline - one line: the case and its speed
+  bool WriteTimingBaseline(const fs::path& path, const std::string& name, long seed, int threads,
+                           const CaseResult& result) {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+    LCCampaignRecord timing = BaselineHeader(name, seed, threads, result);
+    timing.Set("events_per_second", result.eventsPerSecond);
+    timing.Set("wall_s", result.wallSeconds);
+    out << timing.ToLine() << "\n";
+    return out.good();
+  }
+  
+  bool ReadBaseline(const fs::path& path, LCCampaignRecord& header, std::vector<LCCampaignRecord>& runs) {
+    std::ifstream in(path);
+    if (!in.is_open()) return false;
+    std::string line;
+    if (!std::getline(in, line) || !LCCampaignRecord::FromLine(line, header)) return false;
+    while (std::getline(in, line)) {
+      if (line.empty()) continue;
+      LCCampaignRecord run;
+      if (!LCCampaignRecord::FromLine(line, run)) return false;
+      runs.push_back(run);
+    }
+    return true;
+  }
+  
+  // Differences from the output baseline, one message each
+  void CompareOutput(const CaseResult& result, const std::vector<LCCampaignRecord>& baseline,
+                     double tolerance, std::vector<std::string>& failures) {
+    if (result.runs.size() != baseline.size()) {
+      failures.push_back(std::to_string(result.runs.size()) + " runs, baseline has " + std::to_string(baseline.size()));
+      return;
+    }
+    
+    for (std::size_t i = 0; i < baseline.size(); i++) {
+      const LCCampaignRecord& run = result.runs[i];
+      const LCCampaignRecord& reference = baseline[i];
+      std::string label = "run " + std::to_string(i) + " (" + reference.Get("particle") + " " +
+                          reference.Get("energy_MeV") + " MeV, " + reference.Get("bias_V") + " V)";
+      
+      bool sameConfig = true;
+      for (const char* field : kConfigFields) {
+        if (run.Get(field) != reference.Get(field)) {
+          failures.push_back(label + ": " + field + " " + run.Get(field) + ", baseline " + reference.Get(field));
+          sameConfig = false;
+        }
+      }
+      if (!sameConfig) continue;
+      
+      for (const auto& field : reference.GetFields()) {
+        bool statistic = std::any_of(std::begin(kStatisticSuffixes), std::end(kStatisticSuffixes),
+                                     [&](const char* suffix) { return EndsWith(field.first, suffix); });
+        if (!statistic) continue;
+        double value = run.GetDouble(field.first);
+        double expected = reference.GetDouble(field.first);
+        if (!WithinTolerance(value, expected, tolerance)) {
+          failures.push_back(label + ": " + field.first + " " + run.Get(field.first) + ", baseline " + field.second);
+        }
+      }
+      
+      std::string checksum = RunChecksum(run);
+      if (checksum != reference.Get("checksum")) {
+        failures.push_back(label + ": checksum " + checksum + ", baseline " + reference.Get("checksum"));
+      }
+    }
+  }
+  
+  // Differences from the timing baseline, one message each
+  void CompareTiming(const CaseResult& result, const LCCampaignRecord& timing,
+                     double perfTolerance, std::vector<std::string>& failures) {
+    double baselineRate = timing.GetDouble("events_per_second");
+    if (result.events > 0 && baselineRate > 0. && result.eventsPerSecond < (1. - perfTolerance) * baselineRate) {
+      std::ostringstream message;
+      message << "throughput " << result.eventsPerSecond << " events/s, baseline " << baselineRate;
+      failures.push_back(message.str());
+    }
+    double baselineWall = timing.GetDouble("wall_s");
+    if (baselineWall > 0. && result.wallSeconds > (1. + perfTolerance) * baselineWall) {
+      std::ostringstream message;
+      message << "wall time " << result.wallSeconds << " s, baseline " << baselineWall << " s";
+      failures.push_back(message.str());
+    }
+  }
+  
+  // Differences of the runs' means from the first run's, one message each
+  void CompareRuns(const CaseResult& result, const std::vector<std::string>& observables,
+                   double sigmas, std::vector<std::string>& failures) {
+    if (result.runs.size() < 2) {
+      failures.push_back(std::to_string(result.runs.size()) + " run(s), a consistency case needs at least two");
+      return;
+    }
+    
+    const LCCampaignRecord& reference = result.runs.front();
+    for (std::size_t i = 1; i < result.runs.size(); i++) {
+      const LCCampaignRecord& run = result.runs[i];
+      for (const auto& observable : observables) {
+        double mean = run.GetDouble(observable + "_mean");
+        double expected = reference.GetDouble(observable + "_mean");
+        double error = std::hypot(run.GetDouble(observable + "_stderr"), reference.GetDouble(observable + "_stderr"));
+        if (!(std::abs(mean - expected) <= sigmas * error)) {
+          std::ostringstream message;
+          message << "run " << i << ": " << observable << "_mean " << mean << ", run 0 " << expected
+                  << " (combined standard error " << error << ")";
+          failures.push_back(message.str());
+        }
+      }
+    }
+  }
+  
+  // Baselines have to come from the same seed and thread count
+  bool SameSettings(const LCCampaignRecord& header, long seed, int threads) {
+    return std::atol(header.Get("seed").c_str()) == seed && std::atoi(header.Get("threads").c_str()) == threads;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<std::string> cases;
+  fs::path casesDir = "regression";
+  fs::path baselineDir;
+  fs::path timingDir;
+  fs::path workDir = "regression_work";
+  std::string executable = (fs::absolute(argv[0]).parent_path() / "LCDetector").string();
+  long seed = 12345;
+  int threads = 2;
+  double tolerance = 1.0e-6;
+  double perfTolerance = 0.25;
+  bool output = true;
+  bool timing = true;
+  bool bless = false;
+  std::vector<std::string> consistency;
+  double sigmas = 3.;
+  
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = (i+1 < argc);
+    if (arg == "--help" || arg == "-h") { PrintUsage(argv[0]); return 0; }
+    else if (arg == "--case" && hasValue) cases.push_back(argv[++i]);
+    else if (arg == "--cases" && hasValue) casesDir = argv[++i];
+    else if (arg == "--baselines" && hasValue) baselineDir = argv[++i];
+    else if (arg == "--timing-baselines" && hasValue) timingDir = argv[++i];
+    else if (arg == "--work" && hasValue) workDir = argv[++i];
+    else if (arg == "--exe" && hasValue) executable = fs::absolute(argv[++i]).string();
+    else if (arg == "--seed" && hasValue) seed = std::atol(argv[++i]);
+    else if (arg == "--threads" && hasValue) threads = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--tolerance" && hasValue) tolerance = std::atof(argv[++i]);
+    else if (arg == "--perf-tolerance" && hasValue) perfTolerance = std::atof(argv[++i]);
+    else if (arg == "--no-timing") timing = false;
+    else if (arg == "--timing-only") output = false;
+    else if (arg == "--bless") bless = true;
+    else if (arg == "--consistency" && hasValue) consistency.push_back(argv[++i]);
+    else if (arg == "--sigmas" && hasValue) sigmas = std::atof(argv[++i]);
+    else {
+      std::cerr << "ERROR: Unknown or incomplete option: " << arg << std::endl;
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+  
+  if (!output && !timing) {
+    std::cerr << "ERROR: --no-timing and --timing-only exclude each other" << std::endl;
+    return 1;
+  }
+  if (!consistency.empty()) {
+    if (bless) {
+      std::cerr << "ERROR: Consistency cases have no baselines to bless" << std::endl;
+      return 1;
+    }
+    // The runs are compared with each other, not with baselines
+    output = false;
+    timing = false;
+  }
+  
+  casesDir = fs::absolute(casesDir);
+  if (baselineDir.empty()) baselineDir = casesDir / "baselines";
+  if (timingDir.empty()) timingDir = casesDir / "timing";
+  baselineDir = fs::absolute(baselineDir);
+  timingDir = fs::absolute(timingDir);
+  workDir = fs::absolute(workDir);
+  
+  if (cases.empty()) {
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(casesDir, ec)) {
+      if (entry.path().extension() == ".mac") cases.push_back(entry.path().stem().string());
+    }
+    std::sort(cases.begin(), cases.end());
+  }
+  if (cases.empty()) {
+    std::cerr << "ERROR: No case macros in " << casesDir.string() << " (use --cases)" << std::endl;
+    return 1;
+  }
+  if (access(executable.c_str(), X_OK) != 0) {
+    std::cerr << "ERROR: LCDetector executable not found: " << executable << " (use --exe)" << std::endl;
+    return 1;
+  }
+  if (bless) {
+    std::error_code ec;
+    if (output) fs::create_directories(baselineDir, ec);
+    if (timing) fs::create_directories(timingDir, ec);
+  }
+  
+  int failed = 0;
+  int skipped = 0;
+  for (const auto& name : cases) {
+    fs::path macro = casesDir / (name + ".mac");
+    fs::path baselinePath = baselineDir / (name + ".baseline");
+    fs::path timingPath = timingDir / (name + ".timing");
+    if (!fs::exists(macro)) {
+      std::cout << "[FAIL] " << name << ": no case macro " << macro.string() << std::endl;
+      failed++;
+      continue;
+    }
+    
+    LCCampaignRecord header;
+    std::vector<LCCampaignRecord> baseline;
+    LCCampaignRecord timingBaseline;
+    bool timed = timing;
+    if (!bless) {
+      if (output) {
+        if (!fs::exists(baselinePath)) {
+          std::cout << "[FAIL] " << name << ": no baseline " << baselinePath.string()
+                    << " (make one with --bless --no-timing and commit it)" << std::endl;
+          failed++;
+          continue;
+        }
+        if (!ReadBaseline(baselinePath, header, baseline)) {
+          std::cout << "[FAIL] " << name << ": unreadable baseline " << baselinePath.string() << std::endl;
+          failed++;
+          continue;
+        }
+        if (!SameSettings(header, seed, threads)) {
+          std::cout << "[FAIL] " << name << ": baseline made with --seed " << header.Get("seed")
+                    << " --threads " << header.Get("threads") << std::endl;
+          failed++;
+          continue;
+        }
+      }
+      
+      if (timing) {
+        std::vector<LCCampaignRecord> unused;
+        if (!fs::exists(timingPath)) {
+          timed = false;
+          if (!output) {
+            std::cout << "[SKIP] " << name << ": no timing baseline " << timingPath.string()
+                      << " (make one with --bless --timing-only)" << std::endl;
+            skipped++;
+            continue;
+          }
+        } else if (!ReadBaseline(timingPath, timingBaseline, unused)) {
+          std::cout << "[FAIL] " << name << ": unreadable timing baseline " << timingPath.string() << std::endl;
+          failed++;
+          continue;
+        } else if (!SameSettings(timingBaseline, seed, threads)) {
+          std::cout << "[FAIL] " << name << ": timing baseline made with --seed " << timingBaseline.Get("seed")
+                    << " --threads " << timingBaseline.Get("threads") << std::endl;
+          failed++;
+          continue;
+        }
+      }
+    }
+    
+    CaseResult result;
+    std::string error;
+    if (!RunCase(executable, macro, workDir / name, seed, threads, result, error)) {
+      std::cout << "[FAIL] " << name << ": " << error << std::endl;
+      failed++;
+      continue;
+    }
+    
+    std::ostringstream summary;
+    summary << result.runs.size() << " runs, " << result.events << " events, ";
+    if (result.events > 0) summary << std::fixed << std::setprecision(1) << result.eventsPerSecond << " events/s, ";
+    summary << std::fixed << std::setprecision(2) << result.wallSeconds << " s";
+    
+    if (bless) {
+      bool written = true;
+      if (output && !WriteBaseline(baselinePath, name, seed, threads, result)) {
+        std::cout << "[FAIL] " << name << ": could not write " << baselinePath.string() << std::endl;
+        written = false;
+      }
+      if (timing && !WriteTimingBaseline(timingPath, name, seed, threads, result)) {
+        std::cout << "[FAIL] " << name << ": could not write " << timingPath.string() << std::endl;
+        written = false;
+      }
+      if (!written) {
+        failed++;
+        continue;
+      }
+      std::cout << "[BLESS] " << name << ": " << summary.str() << " -> "
+                << (output ? baselinePath.string() : "") << (output && timing ? ", " : "")
+                << (timing ? timingPath.string() : "") << std::endl;
+      continue;
+    }
+    
+    std::vector<std::string> failures;
+    if (output) CompareOutput(result, baseline, tolerance, failures);
+    if (!consistency.empty()) CompareRuns(result, consistency, sigmas, failures);
+    if (timed) {
+      CompareTiming(result, timingBaseline, perfTolerance, failures);
+      summary << " (baseline ";
+      if (result.events > 0) summary << std::setprecision(1) << timingBaseline.GetDouble("events_per_second") << " events/s, ";
+      summary << std::setprecision(2) << timingBaseline.GetDouble("wall_s") << " s)";
+    } else if (timing) {
+      summary << " (not timed: no timing baseline)";
+    }
+    std::cout << (failures.empty() ? "[PASS] " : "[FAIL] ") << name << ": " << summary.str() << std::endl;
+    for (const auto& failure : failures) {
+      std::cout << "         " << failure << std::endl;
+    }
+    if (!failures.empty()) failed++;
+  }
+  
+  std::cout << "========================================================" << std::endl;
+  std::cout << cases.size() << " case(s): " << failed << " failed, " << skipped << " skipped" << std::endl;
+  std::cout << "========================================================" << std::endl;
+  if (failed > 0) return 1;
+  if (skipped == static_cast<int>(cases.size())) return kSkipExitCode;
+  return 0;
+}
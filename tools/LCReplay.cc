@@ -0,0 +1,185 @@
+// LCReplay.cc - Offline readout replay of recorded LC cell deposits
+//
+// Pushes step record files written with "/LC/record/steps true" through
+// LCReadoutModel with new bias, mobility, collection efficiency or
+// electrometer parameters, without repeating the Geant4 transport. The output
+// ROOT file has the same histograms and LCData ntuple as a full run.
+// Version 1 files carry no step lengths, so the tabulated transport model
+// applies no columnar recombination to their deposits.
+//
+// Usage: LCReplay [options] file.lcs [file.lcs ...]
+#include "LCReadoutModel.hh"
+#include "LCStepRecorder.hh"
+#include "LCEventAction.hh"
+#include "LCSteppingAction.hh"
+#include "LCHistograms.hh"
+#include "LCDetectorConstruction.hh"
+#include "G4Event.hh"
+#include "G4AnalysisManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+  const G4double picocoulomb = 1.0e-12 * coulomb;
+  const G4double picoampere = 1.0e-12 * ampere;
+  
+  void PrintUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options] file.lcs [file.lcs ...]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --bias V             Bias voltage in volts (field = bias / cell thickness)" << std::endl;
+    std::cout << "  --field V/um         Electric field, overrides --bias (default: as recorded)" << std::endl;
+    std::cout << "  --mu-e cm2/Vs        Electron mobility" << std::endl;
+    std::cout << "  --mu-ion cm2/Vs      Ion mobility" << std::endl;
+    std::cout << "  --efficiency f       Charge collection efficiency (0-1, constant transport only)" << std::endl;
+    std::cout << "  --transport model    Charge transport: constant (default) or tabulated" << std::endl;
+    std::cout << "  --ion-density n      Intrinsic ion density of the LC in 1/cm3 (tabulated transport)" << std::endl;
+    std::cout << "  --resistance ohm     Electrometer input resistance" << std::endl;
+    std::cout << "  --capacitance pF     Electrometer input capacitance" << std::endl;
+    std::cout << "  --category name      Only replay deposits of one particle category" << std::endl;
+    std::cout << "                       (e-, e+, gamma, proton, alpha, ion, neutron, other)" << std::endl;
+    std::cout << "  --seed N             Random seed for the readout fluctuations (default 12345)" << std::endl;
+    std::cout << "  --output base        Output file base name (default LC_replay)" << std::endl;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  G4double bias = -1.;
+  G4double field = -1.;
+  G4double mobilityElectron = -1., mobilityIon = -1.;
+  G4double efficiency = -1.;
+  G4String transport = "constant";
+  G4double ionDensity = -1.;
+  G4double resistance = -1., capacitance = -1.;
+  G4int category = -1;
+  long seed = 12345;
+  G4String outputBase = "LC_replay";
+  std::vector<G4String> inputFiles;
+  
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    G4bool hasValue = (i+1 < argc);
+    if (arg == "--help" || arg == "-h") { PrintUsage(argv[0]); return 0; }
+    else if (arg == "--bias" && hasValue) bias = std::atof(argv[++i])*volt;
+    else if (arg == "--field" && hasValue) field = std::atof(argv[++i])*volt/um;
+    else if (arg == "--mu-e" && hasValue) mobilityElectron = std::atof(argv[++i])*cm2/volt/s;
+    else if (arg == "--mu-ion" && hasValue) mobilityIon = std::atof(argv[++i])*cm2/volt/s;
+    else if (arg == "--efficiency" && hasValue) efficiency = std::atof(argv[++i]);
+    else if (arg == "--transport" && hasValue) {
+      transport = argv[++i];
+      if (transport != "constant" && transport != "tabulated") {
+        std::cerr << "ERROR: Unknown transport model: " << transport << std::endl;
+        return 1;
+      }
+    }
+    else if (arg == "--ion-density" && hasValue) ionDensity = std::atof(argv[++i])/cm3;
+    else if (arg == "--resistance" && hasValue) resistance = std::atof(argv[++i])*ohm;
+    else if (arg == "--capacitance" && hasValue) capacitance = std::atof(argv[++i])*picofarad;
+    else if (arg == "--seed" && hasValue) seed = std::atol(argv[++i]);
+    else if (arg == "--output" && hasValue) outputBase = argv[++i];
+    else if (arg == "--category" && hasValue) {
+      category = LCStepRecorder::CategoryFromName(argv[++i]);
+      if (category < 0) {
+        std::cerr << "ERROR: Unknown particle category: " << argv[i] << std::endl;
+        return 1;
+      }
+    }
+    else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+      std::cerr << "ERROR: Unknown or incomplete option: " << arg << std::endl;
+      PrintUsage(argv[0]);
+      return 1;
+    }
+    else inputFiles.push_back(arg);
+  }
+  
+  if (inputFiles.empty()) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  
+  G4Random::setTheSeed(seed);
+  
+  // The stepping action books the same histograms and ntuple as a full run
+  LCDetectorConstruction detConstruction;
+  LCEventAction eventAction;
+  LCSteppingAction steppingAction(&detConstruction, &eventAction);
+  LCReadoutModel* model = steppingAction.GetReadoutModel();
+  
+  auto analysisManager = G4AnalysisManager::Instance();
+  analysisManager->SetVerboseLevel(0);
+  analysisManager->OpenFile(outputBase + ".root");
+  
+  G4int nEvents = 0;
+  G4double sumEdep = 0., sumCharge = 0., sumAvgCurrent = 0., maxPeakCurrent = 0.;
+  
+  for (const auto& fileName : inputFiles) {
+    LCStepReader reader;
+    if (!reader.Open(fileName)) return 1;
+    
+    // Readout conditions: as recorded unless overridden
+    G4double thickness = reader.GetCellThickness();
+    G4double replayField = reader.GetElectricField();
+    if (bias > 0.) replayField = bias / thickness;
+    if (field > 0.) replayField = field;
+    
+    model->SetCellThickness(thickness);
+    model->SetElectricField(replayField);
+    model->SetMobilities(mobilityElectron > 0. ? mobilityElectron : model->GetMobilityElectron(),
+                         mobilityIon > 0. ? mobilityIon : model->GetMobilityIon());
+    if (efficiency >= 0.) model->SetCollectionEfficiency(efficiency);
+    model->SetTransportModel(transport);
+    if (ionDensity >= 0.) model->SetIntrinsicIonDensity(ionDensity);
+    if (resistance > 0. || capacitance > 0.) {
+      model->SetElectrometer(resistance > 0. ? resistance : model->GetElectrometerResistance(),
+                             capacitance > 0. ? capacitance : model->GetElectrometerCapacitance());
+    }
+    
+    G4cout << "Replaying " << fileName << " (recorded at " << reader.GetBias()/volt << " V, "
+           << reader.GetElectricField()/(volt/um) << " V/um, configuration epoch "
+           << reader.GetConfigEpoch() << ") with field "
+           << replayField/(volt/um) << " V/um" << G4endl;
+    
+    LCFastH2& chargeDist = LCHistograms::Instance()->H2(LCHistograms::kChargeDist);
+    LCRecordedEvent recorded;
+    while (reader.ReadEvent(recorded)) {
+      G4Event event(recorded.eventID);
+      eventAction.BeginOfEventAction(&event);
+      
+      for (const auto& deposit : recorded.deposits) {
+        if (category >= 0 && deposit.category != category) continue;
+        LCDepositReadout readout = model->ProcessDeposit(deposit.edep*keV, deposit.y*mm,
+                                                         deposit.time*ns, &eventAction, deposit.length*mm);
+        chargeDist.Fill(deposit.x*mm, deposit.z*mm, readout.collectedElectrons);
+      }
+      
+      nEvents++;
+      sumEdep += eventAction.GetTotalEnergyDeposit();
+      sumCharge += eventAction.GetTotalCharge();
+      sumAvgCurrent += eventAction.GetAverageElectrometerCurrent();
+      maxPeakCurrent = std::max(maxPeakCurrent, eventAction.GetPeakElectrometerCurrent());
+      
+      eventAction.EndOfEventAction(&event);
+    }
+  }
+  
+  LCHistograms::Instance()->Export();
+  analysisManager->Write();
+  analysisManager->CloseFile();
+  
+  G4cout << "\n==== READOUT REPLAY SUMMARY ====" << G4endl;
+  G4cout << "Events replayed: " << nEvents << G4endl;
+  if (nEvents > 0) {
+    G4cout << "Mean energy deposit: " << sumEdep/nEvents/keV << " keV" << G4endl;
+    G4cout << "Mean charge: " << sumCharge/nEvents/picocoulomb << " pC" << G4endl;
+    G4cout << "Mean average current: " << sumAvgCurrent/nEvents/picoampere << " pA" << G4endl;
+    G4cout << "Maximum peak current: " << maxPeakCurrent/picoampere << " pA" << G4endl;
+  }
+  G4cout << "Output written to " << outputBase << ".root" << G4endl;
+  G4cout << "================================" << G4endl;
+  return 0;
+}
@@ -0,0 +1,397 @@
+// LCSweep.cc - Sweep driver: runs LCDetector over a list of beam points within a core budget
+//
+// Every point (particle, energy, events) becomes one LCDetector job in its
+// own output directory <results>/<particle>_<energy>MeV_<n>, n being the
+// point's position in the input, so jobs never share a working directory
+// (not even repeated points) and nothing is copied or deleted afterwards. Jobs are
+// started longest-predicted-first and the next one starts as soon as a
+// running job finishes and frees its cores, instead of in fixed batches.
+//
+// Predicted cost (core-seconds) = events * a * (E/MeV)^b per particle. a and
+// b are fit to the measured times in <results>/sweep_history.txt once it has
+// two different energies for that particle; each finished job is appended
+// to it with the events it actually simulated (from the result cache's
+// lc_cache_status.txt), so predictions improve from one sweep to the next.
+//
+// Usage: LCSweep [options] --points FILE
+//        LCSweep [options] --point "proton 500 MeV 10000" [--point ...]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+  // Written by LCDetector's result cache in the job directory
+  const char* const kCacheStatusFile = "lc_cache_status.txt";
+  
+  struct SweepPoint {
+    std::string particle;
+    double energyMeV = 0.;
+    long events = 0;
+    std::string directory;
+    double predictedCost = 0.;  // core-seconds
+    int threads = 1;
+    pid_t pid = -1;
+    std::chrono::steady_clock::time_point start;
+    double seconds = 0.;
+    int exitCode = -1;
+    std::string cacheStatus = "-";  // result cache outcome (lc_cache_status.txt)
+  };
+  
+  // Per-particle cost model: seconds per event per core = a * (E/MeV)^b
+  struct CostModel {
+    double a = 1.0e-3;
+    double b = 0.6;  // ~100x from 10 MeV to 20 GeV
+    bool fitted = false;
+  };
+  
+  void PrintUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options] --points FILE | --point \"particle energy unit events\" ..." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --points FILE        Sweep points, one \"particle energy unit events\" per line (# comments)" << std::endl;
+    std::cout << "  --point SPEC         Add one point, e.g. \"proton 500 MeV 10000\" (repeatable)" << std::endl;
+    std::cout << "  --cores N            Total core budget (default: all hardware threads)" << std::endl;
+    std::cout << "  --threads-per-job N  Worker threads per job (default: spread the cores over the points)" << std::endl;
+    std::cout << "  --exe PATH           LCDetector executable (default: next to LCSweep)" << std::endl;
+    std::cout << "  --results DIR        Results directory (default ./results)" << std::endl;
+    std::cout << "  --setup FILE         Macro executed in every job before the run (bias, physics...)" << std::endl;
+    std::cout << "  --cache DIR          Result cache directory (default <results>/cache)" << std::endl;
+    std::cout << "  --no-cache           Use /run/beamOn instead of /LC/cache/beamOn" << std::endl;
+    std::cout << "  --campaign DIR       Campaign store the runs are recorded in (default <results>/campaign)" << std::endl;
+    std::cout << "  --fidelity LEVEL     Geometry fidelity: minimal, standard or full (default full);" << std::endl;
+    std::cout << "                       use one results directory per level, the cost fit is per directory" << std::endl;
+    std::cout << "  --seed N             Fixed seeds: job i runs with --seed N+i" << std::endl;
+    std::cout << "  --dry-run            Print the schedule order and predictions only" << std::endl;
+  }
+  
+  double ToMeV(double value, const std::string& unit) {
+    if (unit == "eV") return value * 1.0e-6;
+    if (unit == "keV") return value * 1.0e-3;
+    if (unit == "GeV") return value * 1.0e3;
+    if (unit == "TeV") return value * 1.0e6;
+    return value;  // MeV
+  }
+  
+  bool ParsePoint(const std::string& spec, SweepPoint& point) {
+    std::istringstream in(spec);
+    double energy = 0.;
+    std::string unit;
+    if (!(in >> point.particle >> energy >> unit >> point.events)) return false;
+    point.energyMeV = ToMeV(energy, unit);
+    return point.energyMeV > 0. && point.events > 0;
+  }
+  
+  std::string FormatEnergy(double energyMeV) {
+    std::ostringstream out;
+    out << std::setprecision(10) << energyMeV;
+    return out.str();
+  }
+  
+  // History lines: particle energyMeV events threads seconds
+  std::map<std::string, CostModel> FitCostModels(const fs::path& historyFile) {
+    struct Sums { double n = 0., x = 0., y = 0., xx = 0., xy = 0., xMin = 1e300, xMax = -1e300; };
+    std::map<std::string, Sums> sums;
+    
+    std::ifstream in(historyFile);
+    std::string line;
+    while (std::getline(in, line)) {
+      if (line.empty() || line[0] == '#') continue;
+      std::istringstream fields(line);
+      std::string particle;
+      double energyMeV = 0., events = 0., threads = 0., seconds = 0.;
+      if (!(fields >> particle >> energyMeV >> events >> threads >> seconds)) continue;
+      if (energyMeV <= 0. || events <= 0. || threads <= 0. || seconds <= 0.) continue;
+      
+      double x = std::log(energyMeV);
+      double y = std::log(seconds * threads / events);
+      Sums& s = sums[particle];
+      s.n += 1.; s.x += x; s.y += y; s.xx += x * x; s.xy += x * y;
+      s.xMin = std::min(s.xMin, x);
+      s.xMax = std::max(s.xMax, x);
+    }
+    
+    // Least squares in log-log space; a single energy only fixes the scale
+    std::map<std::string, CostModel> models;
+    for (const auto& entry : sums) {
+      const Sums& s = entry.second;
+      CostModel model;
+      if (s.xMax - s.xMin > 1e-6) {
+        model.b = (s.n * s.xy - s.x * s.y) / (s.n * s.xx - s.x * s.x);
+      }
+      model.a = std::exp((s.y - model.b * s.x) / s.n);
+      model.fitted = true;
+      models[entry.first] = model;
+    }
+    return models;
+  }
+  
+  pid_t LaunchJob(const SweepPoint& point, const std::string& executable, long seed) {
+    pid_t pid = fork();
+    if (pid != 0) return pid;  // parent, or -1 on failure
+    
+    // Child: run inside the job directory with its own log
+    if (chdir(point.directory.c_str()) != 0) _exit(127);
+    int log = open("simulation_output.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (log >= 0) {
+      dup2(log, STDOUT_FILENO);
+      dup2(log, STDERR_FILENO);
+      close(log);
+    }
+    std::vector<std::string> args = { executable, "--threads", std::to_string(point.threads) };
+    if (seed >= 0) {
+      args.push_back("--seed");
+      args.push_back(std::to_string(seed));
+    }
+    args.push_back("run.mac");
+    std::vector<char*> argv;
+    for (auto& arg : args) argv.push_back(&arg[0]);
+    argv.push_back(nullptr);
+    execv(executable.c_str(), argv.data());
+    _exit(127);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<SweepPoint> points;
+  int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  int threadsPerJob = 0;
+  std::string executable = (fs::absolute(argv[0]).parent_path() / "LCDetector").string();
+  fs::path resultsDir = "results";
+  std::string setupMacro;
+  std::string cacheDir;
+  std::string campaignDir;
+  std::string fidelity;
+  bool useCache = true;
+  long seed = -1;
+  bool dryRun = false;
+  
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = (i+1 < argc);
+    if (arg == "--help" || arg == "-h") { PrintUsage(argv[0]); return 0; }
+    else if (arg == "--cores" && hasValue) cores = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--threads-per-job" && hasValue) threadsPerJob = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--exe" && hasValue) executable = fs::absolute(argv[++i]).string();
+    else if (arg == "--results" && hasValue) resultsDir = argv[++i];
+    else if (arg == "--setup" && hasValue) setupMacro = fs::absolute(argv[++i]).string();
+    else if (arg == "--cache" && hasValue) cacheDir = argv[++i];
+    else if (arg == "--no-cache") useCache = false;
+    else if (arg == "--campaign" && hasValue) campaignDir = argv[++i];
+    else if (arg == "--fidelity" && hasValue) fidelity = argv[++i];
+    else if (arg == "--seed" && hasValue) seed = std::atol(argv[++i]);
+    else if (arg == "--dry-run") dryRun = true;
+    else if (arg == "--point" && hasValue) {
+      SweepPoint point;
+      if (!ParsePoint(argv[++i], point)) {
+        std::cerr << "ERROR: Bad point \"" << argv[i] << "\" (expected: particle energy unit events)" << std::endl;
+        return 1;
+      }
+      points.push_back(point);
+    }
+    else if (arg == "--points" && hasValue) {
+      std::ifstream in(argv[++i]);
+      if (!in.is_open()) {
+        std::cerr << "ERROR: Could not open points file: " << argv[i] << std::endl;
+        return 1;
+      }
+      std::string line;
+      while (std::getline(in, line)) {
+        size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '#') continue;
+        SweepPoint point;
+        if (!ParsePoint(line, point)) {
+          std::cerr << "ERROR: Bad line in " << argv[i] << ": " << line << std::endl;
+          return 1;
+        }
+        points.push_back(point);
+      }
+    }
+    else {
+      std::cerr << "ERROR: Unknown or incomplete option: " << arg << std::endl;
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+  
+  if (points.empty()) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  if (!dryRun && access(executable.c_str(), X_OK) != 0) {
+    std::cerr << "ERROR: LCDetector executable not found: " << executable << " (use --exe)" << std::endl;
+    return 1;
+  }
+  
+  resultsDir = fs::absolute(resultsDir);
+  if (cacheDir.empty()) cacheDir = (resultsDir / "cache").string();
+  cacheDir = fs::absolute(cacheDir).string();
+  if (campaignDir.empty()) campaignDir = (resultsDir / "campaign").string();
+  campaignDir = fs::absolute(campaignDir).string();
+  fs::path historyFile = resultsDir / "sweep_history.txt";
+  
+  // Fewer points than cores: give each job a larger share
+  if (threadsPerJob == 0) {
+    threadsPerJob = std::max(1, cores / static_cast<int>(std::min<size_t>(points.size(), cores)));
+  }
+  threadsPerJob = std::min(threadsPerJob, cores);
+  
+  // Predict and order: longest first
+  std::map<std::string, CostModel> models = FitCostModels(historyFile);
+  for (size_t i = 0; i < points.size(); i++) {
+    SweepPoint& point = points[i];
+    const CostModel& model = models[point.particle];
+    point.predictedCost = point.events * model.a * std::pow(point.energyMeV, model.b);
+    point.threads = threadsPerJob;
+    point.directory = (resultsDir / (point.particle + "_" + FormatEnergy(point.energyMeV) + "MeV_" +
+                                     std::to_string(i))).string();
+  }
+  std::stable_sort(points.begin(), points.end(),
+                   [](const SweepPoint& a, const SweepPoint& b) { return a.predictedCost > b.predictedCost; });
+  
+  double totalCost = 0.;
+  for (const auto& point : points) totalCost += point.predictedCost;
+  
+  std::cout << "========================================================" << std::endl;
+  std::cout << "LCSweep: " << points.size() << " points, " << cores << " cores, "
+            << threadsPerJob << " threads per job" << std::endl;
+  std::cout << "Results: " << resultsDir.string() << std::endl;
+  for (const auto& entry : models) {
+    std::cout << "Cost model " << entry.first << ": " << entry.second.a << " s/event * (E/MeV)^"
+              << entry.second.b << (entry.second.fitted ? " (fit to " + historyFile.filename().string() + ")" : " (default)")
+              << std::endl;
+  }
+  std::cout << "Predicted total: " << totalCost << " core-s, ~"
+            << totalCost / (cores / threadsPerJob * threadsPerJob) << " s on this budget" << std::endl;
+  std::cout << "========================================================" << std::endl;
+  for (const auto& point : points) {
+    std::cout << "  " << std::setw(10) << point.particle << std::setw(12) << FormatEnergy(point.energyMeV)
+              << " MeV " << std::setw(10) << point.events << " events  predicted "
+              << point.predictedCost / point.threads << " s" << std::endl;
+  }
+  if (dryRun) return 0;
+  
+  // Job directories and macros
+  std::error_code ec;
+  fs::create_directories(resultsDir, ec);
+  for (auto& point : points) {
+    fs::create_directories(point.directory, ec);
+    if (ec) {
+      std::cerr << "ERROR: Could not create " << point.directory << ": " << ec.message() << std::endl;
+      return 1;
+    }
+    fs::remove(fs::path(point.directory) / kCacheStatusFile, ec);  // from an earlier sweep
+    std::ofstream macro(fs::path(point.directory) / "run.mac");
+    macro << "# Written by LCSweep\n";
+    macro << "/LC/beam/particle " << point.particle << "\n";
+    macro << "/LC/beam/energy " << FormatEnergy(point.energyMeV) << " MeV\n";
+    macro << "/LC/campaign/store " << campaignDir << "\n";
+    if (!fidelity.empty()) macro << "/LC/detector/fidelity " << fidelity << "\n";
+    macro << "/run/initialize\n";
+    if (!setupMacro.empty()) macro << "/control/execute " << setupMacro << "\n";
+    if (useCache) {
+      macro << "/LC/cache/dir " << cacheDir << "\n";
+      macro << "/LC/cache/beamOn " << point.events << "\n";
+    } else {
+      macro << "/run/beamOn " << point.events << "\n";
+    }
+  }
+  
+  // Longest-first with refill: start the next job whenever cores are free
+  auto sweepStart = std::chrono::steady_clock::now();
+  std::map<pid_t, size_t> running;
+  size_t next = 0;
+  int freeCores = cores;
+  int failures = 0;
+  std::ofstream history(historyFile, std::ios::app);
+  
+  while (next < points.size() || !running.empty()) {
+    while (next < points.size() && freeCores >= points[next].threads) {
+      SweepPoint& point = points[next];
+      point.start = std::chrono::steady_clock::now();
+      point.pid = LaunchJob(point, executable, seed >= 0 ? seed + static_cast<long>(next) : -1);
+      if (point.pid < 0) {
+        std::cerr << "ERROR: fork failed for " << point.directory << ": " << std::strerror(errno) << std::endl;
+        failures++;
+        next++;
+        continue;
+      }
+      running[point.pid] = next;
+      freeCores -= point.threads;
+      std::cout << "[start " << next + 1 << "/" << points.size() << "] " << point.particle << " "
+                << FormatEnergy(point.energyMeV) << " MeV, " << point.events << " events" << std::endl;
+      next++;
+    }
+    if (running.empty()) break;
+    
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    auto job = running.find(pid);
+    if (job == running.end()) continue;
+    
+    SweepPoint& point = points[job->second];
+    running.erase(job);
+    freeCores += point.threads;
+    point.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - point.start).count();
+    point.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    
+    // Only simulated events count towards the cost: none for a result
+    // cache hit, the top-up for a partial one (no status file: no cache)
+    long simulatedEvents = point.events;
+    std::ifstream statusFile(fs::path(point.directory) / kCacheStatusFile);
+    std::string outcome;
+    if (statusFile >> outcome >> simulatedEvents) {
+      point.cacheStatus = outcome;
+    }
+    
+    if (point.exitCode == 0 && simulatedEvents > 0) {
+      history << point.particle << " " << FormatEnergy(point.energyMeV) << " " << simulatedEvents << " "
+              << point.threads << " " << point.seconds << std::endl;
+    } else if (point.exitCode != 0) {
+      failures++;
+    }
+    std::cout << "[done] " << point.particle << " " << FormatEnergy(point.energyMeV) << " MeV: "
+              << point.seconds << " s (predicted " << point.predictedCost / point.threads << " s, cache "
+              << point.cacheStatus << ")"
+              << (point.exitCode == 0 ? "" : ", FAILED with exit code " + std::to_string(point.exitCode))
+              << std::endl;
+  }
+  
+  double sweepSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - sweepStart).count();
+  
+  // Summary next to the job directories
+  std::ofstream summary(resultsDir / "sweep_summary.txt");
+  summary << "# LCSweep: " << points.size() << " points, " << cores << " cores, "
+          << threadsPerJob << " threads per job, " << sweepSeconds << " s\n";
+  summary << "# particle energyMeV events threads predicted_s measured_s exit cache directory\n";
+  for (const auto& point : points) {
+    summary << point.particle << " " << FormatEnergy(point.energyMeV) << " " << point.events << " "
+            << point.threads << " " << point.predictedCost / point.threads << " " << point.seconds << " "
+            << point.exitCode << " " << point.cacheStatus << " " << point.directory << "\n";
+  }
+  
+  std::cout << "========================================================" << std::endl;
+  std::cout << "Sweep finished in " << sweepSeconds << " s, " << failures << " failed job(s)" << std::endl;
+  std::cout << "Summary: " << (resultsDir / "sweep_summary.txt").string() << std::endl;
+  std::cout << "========================================================" << std::endl;
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+// LCWaveformDump.cc - Lists and exports the electrometer waveforms of a waveform stream
+//
+// With /LC/record/waveforms true every worker writes the electrometer
+// waveform of each event to <output>_waveforms_t<thread>.lcw. This tool
+// prints a file's header and one line per event, or the samples of chosen
+// events as "event time_ns current_pA" lines, reading only the blocks that
+// hold them.
+//
+// Usage: LCWaveformDump [--event ID ...] [--all] [--summary] FILE...
+#include "LCWaveformFile.hh"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+  void PrintUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options] FILE..." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --event ID    Print the samples of this event (repeatable)" << std::endl;
+    std::cout << "  --all         Print the samples of every event" << std::endl;
+    std::cout << "  --summary     Print the file header and totals only" << std::endl;
+    std::cout << "Without options, prints the header and one line per event" << std::endl;
+    std::cout << "(event, samples, first and last time in ns, peak current in pA)." << std::endl;
+  }
+  
+  void PrintSamples(const LCWaveformEvent& event) {
+    for (const auto& sample : event.samples) {
+      std::cout << event.eventID << "\t" << sample.time << "\t" << sample.current << "\n";
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<std::uint32_t> eventIDs;
+  bool all = false;
+  bool summary = false;
+  std::vector<std::string> files;
+  
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h") { PrintUsage(argv[0]); return 0; }
+    else if (arg == "--event" && i+1 < argc) eventIDs.push_back(std::strtoul(argv[++i], nullptr, 10));
+    else if (arg == "--all") all = true;
+    else if (arg == "--summary") summary = true;
+    else if (!arg.empty() && arg[0] == '-') {
+      std::cerr << "ERROR: Unknown or incomplete option: " << arg << std::endl;
+      PrintUsage(argv[0]);
+      return 1;
+    }
+    else files.push_back(arg);
+  }
+  if (files.empty()) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  
+  int status = 0;
+  for (const auto& fileName : files) {
+    LCWaveformReader reader;
+    std::string error;
+    if (!reader.Open(fileName, &error)) {
+      std::cerr << "ERROR: " << error << std::endl;
+      status = 1;
+      continue;
+    }
+    
+    // Sample output only: no headers, so several files concatenate cleanly
+    if (all || !eventIDs.empty()) {
+      LCWaveformEvent event;
+      if (all) {
+        for (std::size_t i = 0; i < reader.GetNumberOfEvents(); i++) {
+          if (!reader.ReadEvent(i, event)) {
+            std::cerr << "ERROR: Damaged waveform block in " << fileName << std::endl;
+            status = 1;
+            break;
+          }
+          PrintSamples(event);
+        }
+      }
+      for (std::uint32_t eventID : eventIDs) {
+        if (reader.FindEvent(eventID, event)) PrintSamples(event);
+      }
+      continue;
+    }
+    
+    const LCWaveformHeader& header = reader.GetHeader();
+    std::uint64_t samples = 0;
+    for (const auto& entry : reader.GetIndex()) samples += entry.samples;
+    std::cout << "# " << fileName << ": thread " << header.threadID
+              << ", configuration epoch " << header.configEpoch
+              << ", time step " << header.timeStep << " ns, current step " << header.currentStep << " pA\n";
+    std::cout << "# " << reader.GetNumberOfEvents() << " events, " << samples << " samples"
+              << (reader.HasStoredIndex() ? "" : " (no index: file not closed, recovered by scanning)") << "\n";
+    if (summary) continue;
+    
+    std::cout << "# event\tsamples\tfirst_ns\tlast_ns\tpeak_pA\n";
+    LCWaveformEvent event;
+    for (std::size_t i = 0; i < reader.GetNumberOfEvents(); i++) {
+      if (!reader.ReadEvent(i, event)) {
+        std::cerr << "ERROR: Damaged waveform block in " << fileName << std::endl;
+        status = 1;
+        break;
+      }
+      double first = 0., last = 0., peak = 0.;
+      if (!event.samples.empty()) {
+        first = event.samples.front().time;
+        last = event.samples.back().time;
+        peak = event.samples.front().current;
+        for (const auto& sample : event.samples) peak = std::max(peak, sample.current);
+      }
+      std::cout << event.eventID << "\t" << event.samples.size() << "\t" << first << "\t" << last
+                << "\t" << peak << "\n";
+    }
+  }
+  return status;
+}